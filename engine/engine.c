@@ -1,54 +1,26 @@
 #include "engine/engine.h"
 #include "engine/engine_default.h"
+#include "engine/engine_overlay.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <stdarg.h>
+#include <float.h>
+#include <limits.h>
+#include <stddef.h>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#define BE_CLUSTER_SSE
+#include <xmmintrin.h>
+#endif
 
 
 // #define BE_FILE() __builtin_FILE()
 // #define BE_LINE() __builtin_LINE()
 
 #define BE_Message(severity, module, fmt, ...) BE_IMPL_Message(severity, module, __FILE__, __LINE__, fmt, ##__VA_ARGS__)
-void BE_IMPL_Message(int severity, const char* module, const char* file, int line, const char* fmt, ...) {
-    static char last_msg[1024] = "";
-    static int repeat_count = 0;
-
-    char formatted[512];
-    va_list args;
-    va_start(args, fmt);
-    vsnprintf(formatted, sizeof(formatted), fmt, args);
-    va_end(args);
-
-    const char* color_code;
-    const char* label;
-    switch (severity) {
-        case 0:     color_code = "\033[37m"; label = "[INFO]"; break;
-        case 1:     color_code = "\033[35m"; label = "[WARNING]"; break;
-        case 2:     color_code = "\033[31m"; label = "[ERROR]"; break;
-        case 3:     color_code = "\033[91m"; label = "[FATAL]"; break;
-        default:    color_code = "\033[37m"; label = "[INFO]"; break;
-    }
-
-    char full_msg[1024];
-    snprintf(full_msg, sizeof(full_msg), "%s%s\033[0m %s:%d -> %s: %s", color_code, label, file, line, module, formatted);
-
-    if (strcmp(last_msg, full_msg) == 0) {
-        repeat_count++;
-        printf("\r%s (x%d)\033[0m", full_msg, repeat_count + 1);
-        fflush(stdout);
-    } else {
-        if (repeat_count > 0) printf("\n");
-        strcpy(last_msg, full_msg);
-        repeat_count = 0;
-        fprintf(stderr, "%s\033[0m\n", full_msg);
-    }
-
-    if (severity >= 3) exit(1);
-}
-
 #define BE_CheckEngineActive(file, line, _return) do { \
     if (!g_engine) { BE_IMPL_Message(2, "Engine", file, line, "No engine is currently bound"); return _return; } \
 } while (0)
@@ -178,12 +150,30 @@ void BE_Vec3RotateAxis(vec3 in, vec3 axis, float angle_rad, vec3 out) {
 // Time
 // ==============================
 
+// Upper edges in ms, around the common refresh rates
+static const float frameHistogramEdges[FRAME_HISTOGRAM_BINS - 1] = {
+    1000.0f / 240, 1000.0f / 144, 1000.0f / 120, 1000.0f / 90, 1000.0f / 60, 1000.0f / 50, 1000.0f / 30, 1000.0f / 20, 100.0f
+};
+
+void BE_FrameStatsInit(BE_FrameStats* info) {
+    memset(info, 0, sizeof(BE_FrameStats));
+}
+
 float BE_UpdateFrameTimeInfo(BE_FrameStats* info) {
 
-    info->currentTime = clock();
-    info->dt = (float)(info->currentTime - info->previousTime) / CLOCKS_PER_SEC;
+    // The first frame has nothing to measure against
+    info->currentTime = BE_ThreadClockNs();
+    uint64_t elapsed = info->previousTime ? info->currentTime - info->previousTime : 0;
+    info->dt = (float)((double)elapsed * 1e-9);
     info->previousTime = info->currentTime;
 
+    if (elapsed > 0) {
+        info->frameTimes[info->frameTimeIndex] = (float)((double)elapsed * 1e-6);
+        info->frameTimeIndex = (info->frameTimeIndex + 1) % FRAME_TIME_HISTORY;
+        if (info->frameTimeCount < FRAME_TIME_HISTORY)
+            info->frameTimeCount++;
+    }
+
     info->frameCount++;
     info->frameCountFPS++;
     info->fpsTimer += info->dt;
@@ -197,6 +187,8 @@ float BE_UpdateFrameTimeInfo(BE_FrameStats* info) {
         if (info->fpsHistoryCount < FPS_HISTORY_COUNT)
             info->fpsHistoryCount++;
 
+        BE_FrameStatsSummarize(info, &info->frameTime);
+
         info->frameCountFPS = 0;
         info->fpsTimer = 0.0f;
     }
@@ -205,6 +197,75 @@ float BE_UpdateFrameTimeInfo(BE_FrameStats* info) {
 
 }
 
+static int BE_CompareFloat(const void* a, const void* b) {
+    float x = *(const float*)a, y = *(const float*)b;
+    return (x > y) - (x < y);
+}
+
+// Nearest rank on sorted samples
+static float BE_Percentile(const float* sorted, int count, int percent) {
+    int rank = (count * percent + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+void BE_FrameStatsSummarize(const BE_FrameStats* info, BE_FrameTimeSummary* outSummary) {
+    memset(outSummary, 0, sizeof(BE_FrameTimeSummary));
+    int count = info->frameTimeCount;
+    if (count == 0) return;
+
+    // On the stack, the summary is taken inside frames that may not touch the heap
+    float sorted[FRAME_TIME_HISTORY];
+    memcpy(sorted, info->frameTimes, sizeof(float) * count);
+    qsort(sorted, count, sizeof(float), BE_CompareFloat);
+
+    double sum = 0.0;
+    int bin = 0;
+    for (int i = 0; i < count; i++) {
+        sum += sorted[i];
+        while (bin < FRAME_HISTOGRAM_BINS - 1 && sorted[i] > frameHistogramEdges[bin]) bin++;
+        outSummary->histogram[bin]++;
+    }
+
+    outSummary->count = count;
+    outSummary->minMs = sorted[0];
+    outSummary->maxMs = sorted[count - 1];
+    outSummary->avgMs = (float)(sum / count);
+    outSummary->p50Ms = BE_Percentile(sorted, count, 50);
+    outSummary->p95Ms = BE_Percentile(sorted, count, 95);
+    outSummary->p99Ms = BE_Percentile(sorted, count, 99);
+}
+
+float BE_FrameHistogramBinMs(int bin) {
+    if (bin < 0) return 0.0f;
+    return bin < FRAME_HISTOGRAM_BINS - 1 ? frameHistogramEdges[bin] : INFINITY;
+}
+
+void BE_UpdateFrameMemoryInfo(BE_FrameStats* info, const char* file, int line) {
+    BE_MemoryStats stats;
+    BE_MemoryGetStats(&stats);
+
+    info->cpuBytes = stats.totalLive;
+    info->cpuPeakBytes = stats.totalPeak;
+    info->gpuBytes = stats.gpuTotal;
+    info->frameAllocations = stats.totalAllocations - info->allocationMark;
+    info->frameAllocatedBytes = stats.totalBytes - info->allocatedBytesMark;
+    info->allocationMark = stats.totalAllocations;
+    info->allocatedBytesMark = stats.totalBytes;
+
+    if (info->allocationCheck && info->frameAllocations > 0) {
+        BE_IMPL_Message(3, "Memory", file, line, "Frame %d made %llu heap allocations (%llu bytes)", info->frameCount,
+                        (unsigned long long)info->frameAllocations, (unsigned long long)info->frameAllocatedBytes);
+    }
+}
+
+BE_RenderStats g_renderStats;
+
+// Ownership of the context moves between threads under the render thread's lock, so plain counters are safe
+void BE_RenderStatsTake(BE_RenderStats* outStats) {
+    *outStats = g_renderStats;
+    memset(&g_renderStats, 0, sizeof(BE_RenderStats));
+}
+
 // ==============================
 // Joystick
 // ==============================
@@ -259,24 +320,18 @@ float BE_JoystickGetAxis(BE_Joystick* joystick, int axis) {
 // VertexVector
 // ==============================
 
-#define INITIAL_VERTEX_CAPACITY 256
-
 void BE_VertexVectorInit(BE_VertexVector* vec) {
-    vec->data = (BE_Vertex*)malloc(sizeof(BE_Vertex) * INITIAL_VERTEX_CAPACITY);
+    vec->data = NULL;
     vec->size = 0;
-    vec->capacity = INITIAL_VERTEX_CAPACITY;
+    vec->capacity = 0;
 }
 
 void BE_VertexVectorPush(BE_VertexVector* vec, BE_Vertex value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Vertex*)realloc(vec->data, sizeof(BE_Vertex) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    *BE_VertexVectorEmplace(vec, 1) = value;
 }
 
 void BE_VertexVectorFree(BE_VertexVector* vec) {
-    free(vec->data);
+    BE_MemFree(vec->data);
     vec->data = NULL;
     vec->size = 0;
     vec->capacity = 0;
@@ -284,9 +339,8 @@ void BE_VertexVectorFree(BE_VertexVector* vec) {
 
 void BE_VertexVectorCopy(BE_Vertex* vertices, size_t count, BE_VertexVector* outVec) {
     BE_VertexVectorInit(outVec);
-    for (size_t i = 0; i < count; i++) {
-        BE_VertexVectorPush(outVec, vertices[i]);
-    }
+    BE_VertexVectorReserve(outVec, count);
+    BE_VertexVectorAppend(outVec, vertices, count);
 }
 
 // ==============================
@@ -295,7 +349,7 @@ void BE_VertexVectorCopy(BE_Vertex* vertices, size_t count, BE_VertexVector* out
 
 BE_VAO BE_VAOInit(const char* name) {
     BE_VAO vao;
-    vao.name = strdup(name ? name : "new vao");
+    vao.name = BE_MemStrdup(name ? name : "new vao", BE_MEMORY_RENDER);
     glGenVertexArrays(1, &vao.ID);
     return vao;
 }
@@ -374,11 +428,13 @@ BE_VAO BE_VAOInitBillboardQuad(const char* name) {
 }
 
 void BE_VAOBind(BE_VAO* vao) {
+    BE_RENDER_COUNT(stateChanges, 1);
     glBindVertexArray(vao->ID);
 }
 
 void BE_VAODrawQuad(BE_VAO* vao) {
     BE_VAOBind(vao);
+    BE_RENDER_COUNT_DRAW(6);
     glDrawArrays(GL_TRIANGLES, 0, 6);
 }
 
@@ -391,24 +447,18 @@ void BE_VAODelete(BE_VAO* vao) {
     glDeleteVertexArrays(1, &vao->ID);
 }
 
-#define INITIAL_VAO_CAPACITY 16
-
 void BE_VAOVectorInit(BE_VAOVector* vec) {
-    vec->data = (BE_VAO*)malloc(sizeof(BE_VAO) * INITIAL_VAO_CAPACITY);
+    vec->data = NULL;
     vec->size = 0;
-    vec->capacity = INITIAL_VAO_CAPACITY;
+    vec->capacity = 0;
 }
 
 void BE_VAOVectorPush(BE_VAOVector* vec, BE_VAO value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_VAO*)realloc(vec->data, sizeof(BE_VAO) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    *BE_VAOVectorEmplace(vec, 1) = value;
 }
 
 void BE_VAOVectorFree(BE_VAOVector* vec) {
-    free(vec->data);
+    BE_MemFree(vec->data);
     vec->data = NULL;
     vec->size = 0;
     vec->capacity = 0;
@@ -416,9 +466,8 @@ void BE_VAOVectorFree(BE_VAOVector* vec) {
 
 void BE_VAOVectorCopy(BE_VAO* vaos, size_t count, BE_VAOVector* outVec) {
     BE_VAOVectorInit(outVec);
-    for (size_t i = 0; i < count; i++) {
-        BE_VAOVectorPush(outVec, vaos[i]);
-    }
+    BE_VAOVectorReserve(outVec, count);
+    BE_VAOVectorAppend(outVec, vaos, count);
 }
 
 // ==============================
@@ -430,6 +479,8 @@ BE_VBO BE_VBOInitFromData(GLfloat* vertices, GLsizeiptr size) {
     glGenBuffers(1, &vbo.ID);
     glBindBuffer(GL_ARRAY_BUFFER, vbo.ID);
     glBufferData(GL_ARRAY_BUFFER, size, vertices, GL_STATIC_DRAW);
+    vbo.bytes = (size_t)size;
+    BE_GpuMemoryAlloc(BE_MEMORY_MESH, vbo.bytes);
     return vbo;
 }
 
@@ -438,6 +489,8 @@ BE_VBO BE_VBOInitFromVector(BE_VertexVector* vertices) {
     glGenBuffers(1, &vbo.ID);
     glBindBuffer(GL_ARRAY_BUFFER, vbo.ID);
     glBufferData(GL_ARRAY_BUFFER, vertices->size * sizeof(BE_Vertex), vertices->data, GL_STATIC_DRAW);
+    vbo.bytes = vertices->size * sizeof(BE_Vertex);
+    BE_GpuMemoryAlloc(BE_MEMORY_MESH, vbo.bytes);
     return vbo;
 }
 
@@ -451,6 +504,8 @@ void BE_VBOUnbind() {
 
 void BE_VBODelete(BE_VBO* vbo) {
     glDeleteBuffers(1, &vbo->ID);
+    BE_GpuMemoryRelease(BE_MEMORY_MESH, vbo->bytes);
+    vbo->bytes = 0;
 }
 
 void BE_LinkVertexAttribToVBO(BE_VBO* vbo, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset) {
@@ -464,24 +519,18 @@ void BE_LinkVertexAttribToVBO(BE_VBO* vbo, GLuint layout, GLuint numComponents,
 // GLuintVector
 // ==============================
 
-#define INITIAL_GLUINT_CAPACITY 256
-
 void BE_GLuintVectorInit(BE_GLuintVector* vec) {
-    vec->data = (GLuint*)malloc(sizeof(GLuint) * INITIAL_GLUINT_CAPACITY);
+    vec->data = NULL;
     vec->size = 0;
-    vec->capacity = INITIAL_GLUINT_CAPACITY;
+    vec->capacity = 0;
 }
 
 void BE_GLuintVectorPush(BE_GLuintVector* vec, GLuint value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (GLuint*)realloc(vec->data, sizeof(GLuint) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    *BE_GLuintVectorEmplace(vec, 1) = value;
 }
 
 void BE_GLuintVectorFree(BE_GLuintVector* vec) {
-    free(vec->data);
+    BE_MemFree(vec->data);
     vec->data = NULL;
     vec->size = 0;
     vec->capacity = 0;
@@ -489,9 +538,8 @@ void BE_GLuintVectorFree(BE_GLuintVector* vec) {
 
 void BE_GLuintVectorCopy(GLuint* data, size_t count, BE_GLuintVector* outVec) {
     BE_GLuintVectorInit(outVec);
-    for (size_t i = 0; i < count; i++) {
-        BE_GLuintVectorPush(outVec, data[i]);
-    }
+    BE_GLuintVectorReserve(outVec, count);
+    BE_GLuintVectorAppend(outVec, data, count);
 }
 
 // ==============================
@@ -503,6 +551,8 @@ BE_EBO BE_EBOInitFromData(GLuint* indices, GLsizeiptr size) {
     glGenBuffers(1, &ebo.ID);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo.ID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, size, indices, GL_STATIC_DRAW);
+    ebo.bytes = (size_t)size;
+    BE_GpuMemoryAlloc(BE_MEMORY_MESH, ebo.bytes);
     return ebo;
 }
 
@@ -511,6 +561,8 @@ BE_EBO BE_EBOInitFromVector(BE_GLuintVector* indices) {
     glGenBuffers(1, &ebo.ID);
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ebo.ID);
     glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices->size * sizeof(GLuint), indices->data, GL_STATIC_DRAW);
+    ebo.bytes = indices->size * sizeof(GLuint);
+    BE_GpuMemoryAlloc(BE_MEMORY_MESH, ebo.bytes);
     return ebo;
 }
 
@@ -524,6 +576,246 @@ void BE_EBOUnbind() {
 
 void BE_EBODelete(BE_EBO* ebo) {
     glDeleteBuffers(1, &ebo->ID);
+    BE_GpuMemoryRelease(BE_MEMORY_MESH, ebo->bytes);
+    ebo->bytes = 0;
+}
+
+// ==============================
+// Stream Ring
+// ==============================
+
+void BE_StreamRingInit(BE_StreamRing* ring, size_t regionSize) {
+    memset(ring, 0, sizeof(BE_StreamRing));
+    ring->regionSize = regionSize;
+
+    GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glGenBuffers(1, &ring->ID);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, ring->ID);
+    glBufferStorage(GL_COPY_WRITE_BUFFER, regionSize * STREAM_FRAMES, NULL, flags);
+    BE_GpuMemoryAlloc(BE_MEMORY_RENDER, regionSize * STREAM_FRAMES);
+    ring->mapped = (unsigned char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, regionSize * STREAM_FRAMES, flags);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+
+    if (!ring->mapped) {
+        BE_IMPL_Message(1, "Stream", __FILE__, __LINE__, "Failed to map stream buffer, falling back to per buffer uploads");
+    }
+
+    glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &ring->uniformAlign);
+    glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &ring->storageAlign);
+}
+
+// Moves to the next region, only blocks if the GPU is still reading it from STREAM_FRAMES frames ago
+void BE_StreamRingBeginFrame(BE_StreamRing* ring) {
+    BE_PROFILE_FUNCTION();
+    ring->region = (ring->region + 1) % STREAM_FRAMES;
+    ring->offset = 0;
+
+    GLsync fence = ring->fences[ring->region];
+    if (!fence) return;
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+    }
+    glDeleteSync(fence);
+    ring->fences[ring->region] = NULL;
+}
+
+void BE_StreamRingEndFrame(BE_StreamRing* ring) {
+    if (ring->offset > ring->highWater) ring->highWater = ring->offset;
+    if (ring->offset == 0) return;
+    ring->fences[ring->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+// Returns false when the frame's region is full, callers then upload through their own buffer
+bool BE_StreamRingAlloc(BE_StreamRing* ring, size_t size, size_t alignment, BE_StreamAlloc* out) {
+    if (!ring->mapped) return false;
+
+    if (alignment == 0) alignment = 1;
+    size_t offset = (ring->offset + alignment - 1) / alignment * alignment;
+    if (offset + size > ring->regionSize) return false;
+
+    size_t base = ring->regionSize * (size_t)ring->region;
+    out->ptr = ring->mapped + base + offset;
+    out->buffer = ring->ID;
+    out->offset = (GLintptr)(base + offset);
+    out->size = (GLsizeiptr)size;
+
+    ring->offset = offset + size;
+    return true;
+}
+
+void BE_StreamRingFree(BE_StreamRing* ring) {
+    for (int i = 0; i < STREAM_FRAMES; i++) {
+        if (ring->fences[i]) glDeleteSync(ring->fences[i]);
+    }
+    if (ring->mapped) {
+        glBindBuffer(GL_COPY_WRITE_BUFFER, ring->ID);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+    glDeleteBuffers(1, &ring->ID);
+    BE_GpuMemoryRelease(BE_MEMORY_RENDER, ring->regionSize * STREAM_FRAMES);
+    memset(ring, 0, sizeof(BE_StreamRing));
+}
+
+// ==============================
+// GPU Timer
+// ==============================
+
+void BE_GpuTimerInit(BE_GpuTimer* timer) {
+    memset(timer, 0, sizeof(BE_GpuTimer));
+    timer->frameRange = -1;
+    BE_MutexInit(&timer->mutex);
+
+#ifdef BE_PROFILE_ENABLED
+    // Core since 3.3, but a driver may still report a counter with no bits
+    GLint bits = 0;
+    glGetQueryiv(GL_TIMESTAMP, GL_QUERY_COUNTER_BITS, &bits);
+    if (bits <= 0) {
+        BE_IMPL_Message(1, "GpuTimer", __FILE__, __LINE__, "Timestamp queries are not supported, GPU pass times are off");
+        return;
+    }
+
+    for (int i = 0; i < GPU_TIMER_FRAMES; i++) {
+        glGenQueries(GPU_TIMER_MAX_RANGES * 2, timer->frames[i].queries);
+    }
+    timer->supported = true;
+    timer->track = BE_ProfileAddTrack("GPU");
+#endif
+}
+
+void BE_GpuTimerFree(BE_GpuTimer* timer) {
+    if (timer->supported) {
+        for (int i = 0; i < GPU_TIMER_FRAMES; i++) {
+            glDeleteQueries(GPU_TIMER_MAX_RANGES * 2, timer->frames[i].queries);
+        }
+    }
+    BE_MutexFree(&timer->mutex);
+    memset(timer, 0, sizeof(BE_GpuTimer));
+}
+
+static bool BE_GpuTimerFrameAvailable(BE_GpuTimerFrame* frame) {
+    for (int i = 0; i < frame->count; i++) {
+        if (!frame->closed[i]) continue;
+        GLint available = 0;
+        glGetQueryObjectiv(frame->queries[i * 2 + 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available) return false;
+    }
+    return true;
+}
+
+static BE_GpuPassTime* BE_GpuTimerFindPass(BE_GpuTimer* timer, const char* name) {
+    for (int i = 0; i < timer->passCount; i++) {
+        if (timer->passes[i].name == name || strcmp(timer->passes[i].name, name) == 0) return &timer->passes[i];
+    }
+    if (timer->passCount == GPU_TIMER_MAX_PASSES) return NULL;
+
+    BE_GpuPassTime* pass = &timer->passes[timer->passCount++];
+    pass->name = name;
+    pass->lastMs = 0.0f;
+    pass->avgMs = 0.0f;
+    pass->frames = 0;
+    return pass;
+}
+
+// Only called once every query of the frame is available, so no read here waits
+static void BE_GpuTimerResolve(BE_GpuTimer* timer, BE_GpuTimerFrame* frame) {
+    float frameMs[GPU_TIMER_MAX_PASSES] = {0};
+    bool seen[GPU_TIMER_MAX_PASSES] = {0};
+
+    BE_MutexLock(&timer->mutex);
+    for (int i = 0; i < frame->count; i++) {
+        if (!frame->closed[i]) continue;
+        GLuint64 start = 0, end = 0;
+        glGetQueryObjectui64v(frame->queries[i * 2], GL_QUERY_RESULT, &start);
+        glGetQueryObjectui64v(frame->queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+        if (end < start) end = start;
+
+        BE_ProfileTrackEvent(timer->track, frame->names[i], (uint64_t)((int64_t)start + timer->clockOffset),
+                             (uint64_t)((int64_t)end + timer->clockOffset));
+
+        BE_GpuPassTime* pass = BE_GpuTimerFindPass(timer, frame->names[i]);
+        if (!pass) continue;
+        size_t index = (size_t)(pass - timer->passes);
+        frameMs[index] += (float)(end - start) * 1e-6f;
+        seen[index] = true;
+    }
+
+    for (int i = 0; i < timer->passCount; i++) {
+        if (!seen[i]) continue;
+        BE_GpuPassTime* pass = &timer->passes[i];
+        pass->lastMs = frameMs[i];
+        pass->avgMs = pass->frames ? pass->avgMs + (frameMs[i] - pass->avgMs) * GPU_TIMER_SMOOTHING : frameMs[i];
+        pass->frames++;
+    }
+    BE_MutexUnlock(&timer->mutex);
+
+    frame->count = 0;
+    frame->pending = false;
+}
+
+void BE_GpuTimerBeginFrame(BE_GpuTimer* timer) {
+    if (!timer || !timer->supported) return;
+    BE_PROFILE_FUNCTION();
+    if (timer->frameRange >= 0) BE_GpuTimerEndFrame(timer);
+
+    // Lines GPU timestamps up with the CPU clock the profiler uses
+    GLint64 gpuNow = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+    timer->clockOffset = (int64_t)BE_ThreadClockNs() - (int64_t)gpuNow;
+
+    // Oldest first, queries finish in submission order so the first one not ready ends the scan
+    for (int i = 1; i < GPU_TIMER_FRAMES; i++) {
+        BE_GpuTimerFrame* frame = &timer->frames[(timer->frame + i) % GPU_TIMER_FRAMES];
+        if (!frame->pending) continue;
+        if (!BE_GpuTimerFrameAvailable(frame)) break;
+        BE_GpuTimerResolve(timer, frame);
+    }
+
+    timer->frame = (timer->frame + 1) % GPU_TIMER_FRAMES;
+    BE_GpuTimerFrame* frame = &timer->frames[timer->frame];
+    if (frame->pending) timer->dropped++;
+    frame->count = 0;
+    frame->pending = true;
+
+    timer->frameRange = BE_GpuTimerBegin(timer, "Frame");
+}
+
+void BE_GpuTimerEndFrame(BE_GpuTimer* timer) {
+    if (!timer || timer->frameRange < 0) return;
+    BE_GpuTimerEnd(timer, timer->frameRange);
+    timer->frameRange = -1;
+}
+
+int BE_GpuTimerBegin(BE_GpuTimer* timer, const char* name) {
+    if (!timer || !timer->supported) return -1;
+    BE_GpuTimerFrame* frame = &timer->frames[timer->frame];
+    if (!frame->pending || frame->count == GPU_TIMER_MAX_RANGES) return -1;
+
+    int range = frame->count++;
+    frame->names[range] = name;
+    frame->closed[range] = false;
+    glQueryCounter(frame->queries[range * 2], GL_TIMESTAMP);
+    return range;
+}
+
+void BE_GpuTimerEnd(BE_GpuTimer* timer, int range) {
+    if (!timer || range < 0) return;
+    BE_GpuTimerFrame* frame = &timer->frames[timer->frame];
+    if (range >= frame->count || frame->closed[range]) return;
+
+    glQueryCounter(frame->queries[range * 2 + 1], GL_TIMESTAMP);
+    frame->closed[range] = true;
+}
+
+int BE_GpuTimerGetPasses(BE_GpuTimer* timer, BE_GpuPassTime* outPasses, int maxPasses) {
+    if (!timer || !timer->supported) return 0;
+    BE_MutexLock(&timer->mutex);
+    int count = timer->passCount < maxPasses ? timer->passCount : maxPasses;
+    if (count > 0) memcpy(outPasses, timer->passes, sizeof(BE_GpuPassTime) * (size_t)count);
+    BE_MutexUnlock(&timer->mutex);
+    return count;
 }
 
 // ==============================
@@ -531,18 +823,29 @@ void BE_EBODelete(BE_EBO* ebo) {
 // ==============================
 
 char* BE_GetFileContents(const char* filename) {
+    return BE_GetFileBytes(filename, NULL);
+}
+
+// NULL terminated so text files can be used directly, NULL if the file can't be read
+char* BE_GetFileBytes(const char* filename, size_t* outSize) {
     FILE* file = fopen(filename, "rb");
+    if (!file) return NULL;
 
     fseek(file, 0, SEEK_END);
     long length = ftell(file);
     rewind(file);
 
-    char* buffer = (char*)malloc(length + 1);
+    char* buffer = (char*)BE_MemAlloc(length + 1, BE_MEMORY_LOADER);
+    if (!buffer) {
+        fclose(file);
+        return NULL;
+    }
 
-    fread(buffer, 1, length, file);
-    buffer[length] = '\0';
+    size_t read = fread(buffer, 1, length, file);
+    buffer[read] = '\0';
 
     fclose(file);
+    if (outSize) *outSize = read;
     return buffer;
 
 }
@@ -568,7 +871,7 @@ void BE_ShaderGetCompileErrors(unsigned int shader, const char* type) {
 BE_Shader BE_ShaderInit(const char* name, const char* vertexFile, const char* fragmentFile, const char* geometryFile, const char* computeFile) {
     BE_Shader shader = {0};
     
-    shader.name = strdup(name ? name : "new shader");
+    shader.name = BE_MemStrdup(name ? name : "new shader", BE_MEMORY_SHADER);
     
     const char* vertexSource = NULL;
     const char* fragmentSource = NULL;
@@ -624,10 +927,10 @@ BE_Shader BE_ShaderInit(const char* name, const char* vertexFile, const char* fr
     if (geometryFile != NULL) glDeleteShader(geometryShader);
     if (computeFile != NULL) glDeleteShader(computeShader);
 
-    if (vertexFile != NULL) free((void*)vertexSource);
-    if (fragmentFile != NULL) free((void*)fragmentSource);
-    if (geometryFile != NULL) free((void*)geometrySource);
-    if (computeFile != NULL) free((void*)computeSource);
+    if (vertexFile != NULL) BE_MemFree((void*)vertexSource);
+    if (fragmentFile != NULL) BE_MemFree((void*)fragmentSource);
+    if (geometryFile != NULL) BE_MemFree((void*)geometrySource);
+    if (computeFile != NULL) BE_MemFree((void*)computeSource);
 
     // BE_IMPL_Message(0, "Shader", "SHADER", 1, "Shader '%s' loaded successfully", name);
 
@@ -638,7 +941,7 @@ BE_Shader BE_ShaderInit(const char* name, const char* vertexFile, const char* fr
 BE_Shader BE_ShaderInitString(const char* name, const char* vertexSource, const char* fragmentSource, const char* geometrySource, const char* computeSource) {
     BE_Shader shader = {0};
     
-    shader.name = strdup(name ? name : "new shader");
+    shader.name = BE_MemStrdup(name ? name : "new shader", BE_MEMORY_SHADER);
     
     GLuint vertexShader = 0;
     if (vertexSource) {
@@ -692,6 +995,7 @@ BE_Shader BE_ShaderInitString(const char* name, const char* vertexSource, const
 }
 
 void BE_ShaderActivate(BE_Shader* shader) {
+    BE_RENDER_COUNT(stateChanges, 1);
     glUseProgram(shader->ID);
 }
 
@@ -699,24 +1003,21 @@ void BE_ShaderDelete(BE_Shader* shader) {
     glDeleteProgram(shader->ID);
 }
 
-#define INITIAL_SHADER_CAPACITY 8
-
 void BE_ShaderVectorInit(BE_ShaderVector* vec) {
-    vec->data = (BE_Shader*)malloc(sizeof(BE_Shader) * INITIAL_SHADER_CAPACITY);
+    vec->data = NULL;
     vec->size = 0;
-    vec->capacity = INITIAL_SHADER_CAPACITY;
+    vec->capacity = 0;
+    BE_RegistryInit(&vec->registry);
 }
 
 void BE_ShaderVectorPush(BE_ShaderVector* vec, BE_Shader value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Shader*)realloc(vec->data, sizeof(BE_Shader) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    BE_RegistryAdd(&vec->registry, value.name, vec->size);
+    *BE_ShaderVectorEmplace(vec, 1) = value;
 }
 
 void BE_ShaderVectorFree(BE_ShaderVector* vec) {
-    free(vec->data);
+    BE_RegistryFree(&vec->registry);
+    BE_MemFree(vec->data);
     vec->data = NULL;
     vec->size = 0;
     vec->capacity = 0;
@@ -724,6 +1025,7 @@ void BE_ShaderVectorFree(BE_ShaderVector* vec) {
 
 void BE_ShaderVectorCopy(BE_Shader* shaders, size_t count, BE_ShaderVector* outVec) {
     BE_ShaderVectorInit(outVec);
+    BE_ShaderVectorReserve(outVec, count);
     for (size_t i = 0; i < count; i++) {
         BE_ShaderVectorPush(outVec, shaders[i]);
     }
@@ -733,6 +1035,14 @@ void BE_ShaderVectorCopy(BE_Shader* shaders, size_t count, BE_ShaderVector* outV
 // FBO
 // ==============================
 
+// Color plus packed depth stencil, four bytes each
+// What "the screen" is for everything that draws, the window or the offscreen target of a headless engine
+static GLuint defaultFramebuffer = 0;
+
+static size_t BE_FBOBytes(int width, int height) {
+    return BE_GpuTextureBytes(width, height, 1, 8, 1);
+}
+
 BE_FBO BE_FBOInit(int width, int height) {
     BE_FBO fb;
     fb.width = width;
@@ -754,12 +1064,13 @@ BE_FBO BE_FBOInit(int width, int height) {
     glBindRenderbuffer(GL_RENDERBUFFER, fb.rbo);
     glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, fb.rbo);
+    BE_GpuMemoryAlloc(BE_MEMORY_RENDER, BE_FBOBytes(width, height));
 
     if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
         printf("ERROR: Framebuffer is not complete1\n");
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
 
     GLfloat vertices[] = {
         // positions   // texCoords
@@ -785,6 +1096,8 @@ BE_FBO BE_FBOInit(int width, int height) {
 }
 
 void BE_FBOResize(BE_FBO* fbo, int width, int height) {
+    BE_GpuMemoryRelease(BE_MEMORY_RENDER, BE_FBOBytes(fbo->width, fbo->height));
+    BE_GpuMemoryAlloc(BE_MEMORY_RENDER, BE_FBOBytes(width, height));
     fbo->width = width;
     fbo->height = height;
 
@@ -815,28 +1128,33 @@ void BE_FBOResize(BE_FBO* fbo, int width, int height) {
         printf("ERROR: Resized framebuffer is not complete!\n");
     }
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
 }
 
 void BE_FBOBind(BE_FBO* fb) {
+    BE_RENDER_COUNT(stateChanges, 1);
     glBindFramebuffer(GL_FRAMEBUFFER, fb->fbo);
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
 void BE_FBOBindTexture(BE_FBO* fb, BE_Shader* shader) {
+    BE_RENDER_COUNT(textureBinds, 1);
+    BE_RENDER_COUNT(uniformUploads, 1);
     glActiveTexture(GL_TEXTURE0);
     glBindTexture(GL_TEXTURE_2D, fb->texture);
     glUniform1i(glGetUniformLocation(shader->ID, "screenTexture"), 0);
 }
 
 void BE_FBOUnbind() {
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    BE_RENDER_COUNT(stateChanges, 1);
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
 }
 
 void BE_FBODelete(BE_FBO* fb) {
     glDeleteFramebuffers(1, &fb->fbo);
     glDeleteTextures(1, &fb->texture);
     glDeleteRenderbuffers(1, &fb->rbo);
+    BE_GpuMemoryRelease(BE_MEMORY_RENDER, BE_FBOBytes(fb->width, fb->height));
     *fb = (BE_FBO){0};
 }
 
@@ -844,26 +1162,61 @@ void BE_FBODelete(BE_FBO* fb) {
 // Textures
 // ==============================
 
+bool BE_ImageLoad(const char* imageFile, int channels, BE_Image* outImage) {
+    // The flip flag is per thread so loader threads don't race the main one
+    stbi_set_flip_vertically_on_load_thread(true);
+    outImage->pixels = stbi_load(imageFile, &outImage->width, &outImage->height, &outImage->channels, channels);
+    if (!outImage->pixels) {
+        BE_IMPL_Message(2, "Texture", imageFile, 1, "Failed to load texture '%s'", stbi_failure_reason());
+        return false;
+    }
+    if (channels) outImage->channels = channels;
+    return true;
+}
+
+// Images small enough for the atlas are expanded to RGBA, larger ones keep their channels
+bool BE_ImageLoadForAtlas(const char* imageFile, BE_Image* outImage) {
+    int widthImg, heightImg, numColCh;
+    if (!stbi_info(imageFile, &widthImg, &heightImg, &numColCh)) {
+        BE_IMPL_Message(2, "Texture", imageFile, 1, "Failed to load texture '%s'", stbi_failure_reason());
+        return false;
+    }
+
+    bool packed = widthImg <= ATLAS_MAX_ENTRY && heightImg <= ATLAS_MAX_ENTRY;
+    return BE_ImageLoad(imageFile, packed ? 4 : 0, outImage);
+}
+
+void BE_ImageFree(BE_Image* image) {
+    if (image->pixels) stbi_image_free(image->pixels);
+    image->pixels = NULL;
+}
+
 BE_Texture BE_TextureInit(const char* name, const char* imageFile, const char* texType, GLuint slot) {
+    BE_Image image;
+    if (!BE_ImageLoad(imageFile, 0, &image)) exit(1);
+
+    BE_Texture texture = BE_TextureInitFromImage(name, &image, texType, slot);
+    BE_ImageFree(&image);
+
+    // BE_IMPL_Message(0, "Texture", imageFile, 1, "Texture '%s' loaded successfully", name);
+
+    return texture;
+}
+
+BE_Texture BE_TextureInitFromImage(const char* name, BE_Image* image, const char* texType, GLuint slot) {
     BE_Texture texture;
     
-    texture.name = strdup(name ? name : "new texture");
+    texture.name = BE_MemStrdup(name ? name : "new texture", BE_MEMORY_TEXTURE);
+    texture.atlasPage = -1;
+    glm_vec4_copy((vec4){0.0f, 0.0f, 1.0f, 1.0f}, texture.atlasRect);
 
-    texture.type = (char*)malloc(strlen(texType) + 1);
+    texture.type = (char*)BE_MemAlloc(strlen(texType) + 1, BE_MEMORY_TEXTURE);
     if (!texture.type) {
-        BE_IMPL_Message(3, "Texture", imageFile, 1, "Could not allocate memory for texture '%s'", name);
+        BE_IMPL_Message(3, "Texture", "TEXTURE", 1, "Could not allocate memory for texture '%s'", name);
         exit(1);
     }
     strcpy(texture.type, texType);
 
-    int widthImg, heightImg, numColCh;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* bytes = stbi_load(imageFile, &widthImg, &heightImg, &numColCh, 0);
-    if (!bytes) {
-        BE_IMPL_Message(2, "Texture", imageFile, 1, "Failed to load texture '%s'", stbi_failure_reason());
-        exit(1);
-    }
-
     glGenTextures(1, &texture.ID);
     glActiveTexture(GL_TEXTURE0 + slot);
     texture.unit = slot;
@@ -875,22 +1228,24 @@ BE_Texture BE_TextureInit(const char* name, const char* imageFile, const char* t
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
     GLenum format;
-    if (numColCh == 4) format = GL_RGBA;
-    else if (numColCh == 3) format = GL_RGB;
-    else if (numColCh == 1) format = GL_RED;
+    if (image->channels == 4) format = GL_RGBA;
+    else if (image->channels == 3) format = GL_RGB;
+    else if (image->channels == 1) format = GL_RED;
     else {
-        BE_IMPL_Message(2, "Texture", imageFile, 1, "Unsupported color channel count '%d'", numColCh);
-        stbi_image_free(bytes);
+        BE_IMPL_Message(2, "Texture", "TEXTURE", 1, "Unsupported color channel count '%d'", image->channels);
         exit(1);
     }
 
-    glTexImage2D(GL_TEXTURE_2D, 0, format, widthImg, heightImg, 0, format, GL_UNSIGNED_BYTE, bytes);
+    glTexImage2D(GL_TEXTURE_2D, 0, format, image->width, image->height, 0, format, GL_UNSIGNED_BYTE, image->pixels);
     glGenerateMipmap(GL_TEXTURE_2D);
 
-    stbi_image_free(bytes);
-    glBindTexture(GL_TEXTURE_2D, 0);
+    // RGB is padded to four bytes by most drivers
+    int levels = 1;
+    while ((image->width | image->height) >> levels) levels++;
+    texture.gpuBytes = BE_GpuTextureBytes(image->width, image->height, 1, image->channels == 1 ? 1 : 4, levels);
+    BE_GpuMemoryAlloc(BE_MEMORY_TEXTURE, texture.gpuBytes);
 
-    // BE_IMPL_Message(0, "Texture", imageFile, 1, "Texture '%s' loaded successfully", name);
+    glBindTexture(GL_TEXTURE_2D, 0);
 
     return texture;
 }
@@ -898,10 +1253,12 @@ BE_Texture BE_TextureInit(const char* name, const char* imageFile, const char* t
 void BE_TextureSetUniformUnit(BE_Shader* shader, const char* uniform, GLuint unit) {
     GLuint tex0Uni = glGetUniformLocation(shader->ID, uniform);
     BE_ShaderActivate(shader);
+    BE_RENDER_COUNT(uniformUploads, 1);
     glUniform1i(tex0Uni, unit);
 }
 
 void BE_TextureBind(BE_Texture* texture) {
+    BE_RENDER_COUNT(textureBinds, 1);
     glActiveTexture(GL_TEXTURE0 + texture->unit);
     glBindTexture(GL_TEXTURE_2D, texture->ID);
 }
@@ -911,30 +1268,235 @@ void BE_TextureUnbind() {
 }
 
 void BE_TextureDelete(BE_Texture* texture) {
+    // Pages belong to the atlas
+    if (texture->atlasPage >= 0) return;
     glDeleteTextures(1, &texture->ID);
+    BE_GpuMemoryRelease(BE_MEMORY_TEXTURE, texture->gpuBytes);
+    texture->gpuBytes = 0;
+}
+
+BE_Texture BE_TextureInitAtlas(const char* name, const char* imageFile, BE_TextureAtlas* atlas) {
+    BE_Image image;
+    if (!BE_ImageLoadForAtlas(imageFile, &image)) exit(1);
+
+    BE_Texture texture = BE_TextureInitAtlasFromImage(name, &image, atlas);
+    BE_ImageFree(&image);
+    return texture;
+}
+
+BE_Texture BE_TextureInitAtlasFromImage(const char* name, BE_Image* image, BE_TextureAtlas* atlas) {
+    if (image->width > ATLAS_MAX_ENTRY || image->height > ATLAS_MAX_ENTRY || image->channels != 4) {
+        return BE_TextureInitFromImage(name, image, "texture", 0);
+    }
+
+    BE_Texture texture;
+    texture.name = BE_MemStrdup(name ? name : "new texture", BE_MEMORY_TEXTURE);
+    texture.type = BE_MemStrdup("texture", BE_MEMORY_TEXTURE);
+    texture.unit = 0;
+    texture.gpuBytes = 0;
+
+    BE_TextureAtlasInsert(atlas, image->pixels, image->width, image->height, &texture.atlasPage, texture.atlasRect);
+    texture.ID = atlas->pages[texture.atlasPage].ID;
+
+    return texture;
+}
+
+// ==============================
+// Texture Atlas
+// ==============================
+
+#define INITIAL_ATLAS_CAPACITY 2
+
+void BE_TextureAtlasInit(BE_TextureAtlas* atlas, int pageSize) {
+    atlas->pages = (BE_AtlasPage*)BE_MemAlloc(sizeof(BE_AtlasPage) * INITIAL_ATLAS_CAPACITY, BE_MEMORY_TEXTURE);
+    atlas->size = 0;
+    atlas->capacity = INITIAL_ATLAS_CAPACITY;
+    atlas->pageSize = pageSize;
+}
+
+// Bottom-left skyline: lowest resting y first, then the narrowest node to keep gaps small
+bool BE_AtlasPageFind(BE_AtlasPage* page, int pageSize, int width, int height, int* outX, int* outY, size_t* outIndex) {
+    int bestY = INT_MAX;
+    int bestWidth = INT_MAX;
+    bool found = false;
+
+    for (size_t i = 0; i < page->skylineSize; i++) {
+        int x = page->skyline[i].x;
+        if (x + width > pageSize) break;
+
+        // Rest on the highest node under the span
+        int y = 0;
+        int remaining = width;
+        for (size_t j = i; j < page->skylineSize && remaining > 0; j++) {
+            if (page->skyline[j].y > y) y = page->skyline[j].y;
+            remaining -= page->skyline[j].width;
+        }
+        if (y + height > pageSize) continue;
+
+        if (y < bestY || (y == bestY && page->skyline[i].width < bestWidth)) {
+            bestY = y;
+            bestWidth = page->skyline[i].width;
+            *outX = x;
+            *outY = y;
+            *outIndex = i;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+void BE_AtlasPageAdd(BE_AtlasPage* page, size_t index, int x, int y, int width, int height) {
+    if (page->skylineSize >= page->skylineCapacity) {
+        page->skylineCapacity *= 2;
+        page->skyline = (BE_SkylineNode*)BE_MemRealloc(page->skyline, sizeof(BE_SkylineNode) * page->skylineCapacity, BE_MEMORY_TEXTURE);
+    }
+    memmove(&page->skyline[index + 1], &page->skyline[index], sizeof(BE_SkylineNode) * (page->skylineSize - index));
+    page->skyline[index] = (BE_SkylineNode){x, y + height, width};
+    page->skylineSize++;
+
+    // Trim or drop the nodes now covered by the new one
+    size_t i = index + 1;
+    while (i < page->skylineSize) {
+        BE_SkylineNode* prev = &page->skyline[i - 1];
+        BE_SkylineNode* node = &page->skyline[i];
+        int shrink = prev->x + prev->width - node->x;
+        if (shrink <= 0) break;
+
+        if (node->width > shrink) {
+            node->x += shrink;
+            node->width -= shrink;
+            break;
+        }
+        memmove(node, node + 1, sizeof(BE_SkylineNode) * (page->skylineSize - i - 1));
+        page->skylineSize--;
+    }
+
+    // Merge neighbours at the same height
+    for (size_t j = 0; j + 1 < page->skylineSize;) {
+        if (page->skyline[j].y == page->skyline[j + 1].y) {
+            page->skyline[j].width += page->skyline[j + 1].width;
+            memmove(&page->skyline[j + 1], &page->skyline[j + 2], sizeof(BE_SkylineNode) * (page->skylineSize - j - 2));
+            page->skylineSize--;
+        } else {
+            j++;
+        }
+    }
+}
+
+bool BE_TextureAtlasInsert(BE_TextureAtlas* atlas, unsigned char* pixels, int width, int height, int* outPage, vec4 outRect) {
+    int paddedWidth = width + ATLAS_PADDING * 2;
+    int paddedHeight = height + ATLAS_PADDING * 2;
+    if (paddedWidth > atlas->pageSize || paddedHeight > atlas->pageSize) return false;
+
+    // Earlier pages first, so late loads fill the holes left in them
+    int x = 0, y = 0;
+    size_t index = 0;
+    size_t p = 0;
+    for (; p < atlas->size; p++) {
+        if (BE_AtlasPageFind(&atlas->pages[p], atlas->pageSize, paddedWidth, paddedHeight, &x, &y, &index)) break;
+    }
+
+    if (p == atlas->size) {
+        if (atlas->size >= atlas->capacity) {
+            atlas->capacity *= 2;
+            atlas->pages = (BE_AtlasPage*)BE_MemRealloc(atlas->pages, sizeof(BE_AtlasPage) * atlas->capacity, BE_MEMORY_TEXTURE);
+        }
+
+        BE_AtlasPage page = {0};
+        page.skyline = (BE_SkylineNode*)BE_MemAlloc(sizeof(BE_SkylineNode) * 16, BE_MEMORY_TEXTURE);
+        page.skylineCapacity = 16;
+        page.skyline[page.skylineSize++] = (BE_SkylineNode){0, 0, atlas->pageSize};
+
+        glGenTextures(1, &page.ID);
+        glBindTexture(GL_TEXTURE_2D, page.ID);
+        glTexStorage2D(GL_TEXTURE_2D, ATLAS_MIP_LEVELS, GL_RGBA8, atlas->pageSize, atlas->pageSize);
+        BE_GpuMemoryAlloc(BE_MEMORY_TEXTURE, BE_GpuTextureBytes(atlas->pageSize, atlas->pageSize, 1, 4, ATLAS_MIP_LEVELS));
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, ATLAS_MIP_LEVELS - 1);
+        for (int level = 0; level < ATLAS_MIP_LEVELS; level++) {
+            glClearTexImage(page.ID, level, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+        }
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        atlas->pages[atlas->size++] = page;
+        BE_AtlasPageFind(&atlas->pages[p], atlas->pageSize, paddedWidth, paddedHeight, &x, &y, &index);
+    }
+
+    BE_AtlasPage* page = &atlas->pages[p];
+    BE_AtlasPageAdd(page, index, x, y, paddedWidth, paddedHeight);
+
+    // Extrude the border into the padding so filtering and mips never pull in a neighbour
+    unsigned char* padded = (unsigned char*)BE_MemAlloc((size_t)paddedWidth * paddedHeight * 4, BE_MEMORY_TEXTURE);
+    for (int py = 0; py < paddedHeight; py++) {
+        int sy = glm_clamp(py - ATLAS_PADDING, 0, height - 1);
+        for (int px = 0; px < paddedWidth; px++) {
+            int sx = glm_clamp(px - ATLAS_PADDING, 0, width - 1);
+            memcpy(&padded[((size_t)py * paddedWidth + px) * 4], &pixels[((size_t)sy * width + sx) * 4], 4);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glBindTexture(GL_TEXTURE_2D, page->ID);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, paddedWidth, paddedHeight, GL_RGBA, GL_UNSIGNED_BYTE, padded);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    BE_MemFree(padded);
+
+    page->mipsDirty = true;
+
+    float inv = 1.0f / (float)atlas->pageSize;
+    *outPage = (int)p;
+    outRect[0] = (float)(x + ATLAS_PADDING) * inv;
+    outRect[1] = (float)(y + ATLAS_PADDING) * inv;
+    outRect[2] = (float)(x + ATLAS_PADDING + width) * inv;
+    outRect[3] = (float)(y + ATLAS_PADDING + height) * inv;
+    return true;
+}
+
+// Mips are rebuilt once per page before drawing, not per insertion
+void BE_TextureAtlasUpdateMips(BE_TextureAtlas* atlas) {
+    for (size_t p = 0; p < atlas->size; p++) {
+        BE_AtlasPage* page = &atlas->pages[p];
+        if (!page->mipsDirty) continue;
+
+        glBindTexture(GL_TEXTURE_2D, page->ID);
+        glGenerateMipmap(GL_TEXTURE_2D);
+        page->mipsDirty = false;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void BE_TextureAtlasFree(BE_TextureAtlas* atlas) {
+    for (size_t p = 0; p < atlas->size; p++) {
+        glDeleteTextures(1, &atlas->pages[p].ID);
+        BE_GpuMemoryRelease(BE_MEMORY_TEXTURE, BE_GpuTextureBytes(atlas->pageSize, atlas->pageSize, 1, 4, ATLAS_MIP_LEVELS));
+        BE_MemFree(atlas->pages[p].skyline);
+    }
+    BE_MemFree(atlas->pages);
+    atlas->pages = NULL;
+    atlas->size = 0;
+    atlas->capacity = 0;
 }
 
-#define INITIAL_TEXTURE_CAPACITY 8
+#define TEXTURE_PAGE_ELEMENTS 64
 
 void BE_TextureVectorInit(BE_TextureVector* vec) {
-    vec->data = (BE_Texture*)malloc(sizeof(BE_Texture) * INITIAL_TEXTURE_CAPACITY);
-    vec->size = 0;
-    vec->capacity = INITIAL_TEXTURE_CAPACITY;
+    BE_PoolInit(&vec->pool, sizeof(BE_Texture), TEXTURE_PAGE_ELEMENTS, BE_MEMORY_TEXTURE);
+    BE_RegistryInit(&vec->registry);
 }
 
 void BE_TextureVectorPush(BE_TextureVector* vec, BE_Texture value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Texture*)realloc(vec->data, sizeof(BE_Texture) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    BE_RegistryAdd(&vec->registry, value.name, vec->pool.size);
+    *(BE_Texture*)BE_PoolAlloc(&vec->pool) = value;
 }
 
 void BE_TextureVectorFree(BE_TextureVector* vec) {
-    free(vec->data);
-    vec->data = NULL;
-    vec->size = 0;
-    vec->capacity = 0;
+    BE_RegistryFree(&vec->registry);
+    BE_PoolFree(&vec->pool);
 }
 
 void BE_TextureVectorCopy(BE_Texture* textures, size_t count, BE_TextureVector* outVec) {
@@ -948,36 +1510,6 @@ void BE_TextureVectorCopy(BE_Texture* textures, size_t count, BE_TextureVector*
 // Cameras
 // ==============================
 
-BE_Camera BE_CameraInit(const char* name, int width, int height, float fov, float nearPlane, float farPlane, vec3 position, vec3 direction) {
-    BE_Camera camera;
-    camera.name = strdup(name ? name : "new camera");
-    camera.width = width;
-    camera.height = height;
-    glm_vec3_copy(position, camera.position);
-
-    camera.pitch = 0;
-    camera.yaw = 0;
-    camera.roll = 0;
-
-    glm_quat_identity(camera.orientation);
-    vec3 forward = {0,0,-1};
-    vec3 dirNorm;
-    glm_vec3_normalize_to(direction, dirNorm);
-    glm_quat_from_vecs(forward, dirNorm, camera.orientation);
-
-    camera.zoom = 1.0f;
-    camera.fov = fov;
-
-    camera.nearPlane = nearPlane;
-    camera.farPlane = farPlane;
-
-    mat4 mat;
-    glm_mat4_identity(mat);
-    glm_mat4_copy(mat, camera.projPersp);
-    glm_mat4_copy(mat, camera.projOrtho);
-
-    return camera;
-}
 
 void BE_CameraRotate(BE_Camera* camera, vec3 axis, float angle) {
     versor qrot;
@@ -1121,103 +1653,48 @@ void BE_CameraInputsJoystick(BE_Camera* camera, BE_Joystick* joystick, float dt)
 
 void BE_CameraMatrixUploadPersp(BE_Camera* camera, BE_Shader* shader, const char* uniform) {
     BE_ShaderActivate(shader);
+    BE_RENDER_COUNT(uniformUploads, 2);
     glUniform3fv(glGetUniformLocation(shader->ID, "camPos"), 1, (float*)camera->position);
     glUniformMatrix4fv(glGetUniformLocation(shader->ID, uniform), 1, GL_FALSE, (float*)camera->projPersp);
 }
 
 void BE_CameraMatrixUploadOrtho(BE_Camera* camera, BE_Shader* shader, const char* uniform) {
     BE_ShaderActivate(shader);
+    BE_RENDER_COUNT(uniformUploads, 2);
     glUniform3fv(glGetUniformLocation(shader->ID, "camPos"), 1, (float*)camera->position);
     glUniformMatrix4fv(glGetUniformLocation(shader->ID, uniform), 1, GL_FALSE, (float*)camera->projOrtho);
 }
 
 void BE_CameraMatrixUploadCustom(BE_Shader* shader, const char* uniform, vec3 position, mat4 matrix) {
     BE_ShaderActivate(shader);
+    BE_RENDER_COUNT(uniformUploads, 2);
     glUniform3fv(glGetUniformLocation(shader->ID, "camPos"), 1, (float*)position);
     glUniformMatrix4fv(glGetUniformLocation(shader->ID, uniform), 1, GL_FALSE, (float*)matrix);
 }
 
-#define INITIAL_CAMERA_CAPACITY 4
+void BE_CameraVectorDraw(BE_CameraVector* vec, BE_Mesh* mesh, BE_Shader* shader, BE_Camera* selected) {
 
-void BE_CameraVectorInit(BE_CameraVector* vec) {
-    vec->data = (BE_Camera*)malloc(sizeof(BE_Camera) * INITIAL_CAMERA_CAPACITY);
-    vec->size = 0;
-    vec->capacity = INITIAL_CAMERA_CAPACITY;
-}
+    BE_ShaderActivate(shader);
+    BE_RENDER_COUNT(uniformUploads, 1);
+    glUniform3fv(glGetUniformLocation(shader->ID, "color"), 1, (float[]){1.0f, 1.0f, 1.0f});
+    
+    glEnable(GL_DEPTH_TEST);
+    glDisable(GL_CULL_FACE);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glEnable(GL_BLEND);
 
-void BE_CameraVectorPush(BE_CameraVector* vec, BE_Camera value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Camera*)realloc(vec->data, sizeof(BE_Camera) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
-}
+    mat4 model = {0};
+    vec3 ori = {0};
 
-void BE_CameraVectorFree(BE_CameraVector* vec) {
-    free(vec->data);
-    vec->data = NULL;
-    vec->size = 0;
-    vec->capacity = 0;
-}
+    for (size_t i = 0; i < vec->pool.size; i++) {
+        BE_Camera* camera = BE_CameraVectorAt(vec, i);
 
-void BE_CameraVectorCopy(BE_Camera* lights, size_t count, BE_CameraVector* outVec) {
-    BE_CameraVectorInit(outVec);
-    for (size_t i = 0; i < count; i++) {
-        BE_CameraVectorPush(outVec, lights[i]);
-    }
-}
-
-void BE_CameraVectorUpdateMatrix(BE_CameraVector* vec, int width, int height) {
-    
-    mat4 view;
-    mat4 projection;
-    mat4 projView;
-    
-    for (size_t i = 0; i < vec->size; i++) {
-        BE_Camera* camera = &vec->data[i];
-        
-        float fov = camera->fov;
-
-        camera->width = width;
-        camera->height = height;
-
-        vec3 target, forward, up;
-        glm_quat_rotatev(camera->orientation, (vec3){0.0f, 0.0f, -1.0f}, forward);
-        // glm_quat_rotatev(camera->orientation, (vec3){0.0f, 1.0f,  0.0f}, up);
-        glm_vec3_add(camera->position, forward, target);
-        glm_lookat(camera->position, target, (vec3){0,1,0}, view);
-        
-        glm_perspective(glm_rad(fov), (float)camera->width / (float)camera->height, camera->nearPlane, camera->farPlane, projection);
-        glm_mat4_mul(projection, view, projView);
-        glm_mat4_copy(projView, camera->projPersp);
-        glm_mat4_copy(view, camera->viewMatrix);
-
-        glm_ortho(0.0f, (float)camera->width, (float)camera->height, 0.0f, -1.0f, 1.0f, camera->projOrtho);
-
-    }
-}
-
-void BE_CameraVectorDraw(BE_CameraVector* vec, BE_Mesh* mesh, BE_Shader* shader, BE_Camera* selected) {
-
-    BE_ShaderActivate(shader);
-    glUniform3fv(glGetUniformLocation(shader->ID, "color"), 1, (float[]){1.0f, 1.0f, 1.0f});
-    
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glEnable(GL_BLEND);
-
-    mat4 model = {0};
-    vec3 ori = {0};
-
-    for (size_t i = 0; i < vec->size; i++) {
-        BE_Camera* camera = &vec->data[i];
-
-        if (camera == selected) continue;
-        
-        BE_VersorToEuler(camera->orientation, ori);
+        if (camera == selected) continue;
+        
+        BE_VersorToEuler(camera->orientation, ori);
 
         BE_MakeModelMatrix(camera->position, ori, (vec3){0.25f * camera->width/1000 * camera->fov/45, 0.25f * camera->height/1000, 0.2f * camera->zoom}, model);
+        BE_RENDER_COUNT(uniformUploads, 1);
         glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
         BE_MeshDraw(mesh, shader);
 
@@ -1233,7 +1710,7 @@ void BE_CameraVectorDraw(BE_CameraVector* vec, BE_Mesh* mesh, BE_Shader* shader,
 BE_Mesh BE_MeshInitFromVertex(const char* name, BE_VertexVector vertices, BE_GLuintVector indices, BE_TextureVector textures) {
     BE_Mesh mesh;
     
-    mesh.name = strdup(name ? name : "new mesh");
+    mesh.name = BE_MemStrdup(name ? name : "new mesh", BE_MEMORY_MESH);
 
     mesh.vertices = vertices;
     mesh.indices = indices;
@@ -1252,6 +1729,34 @@ BE_Mesh BE_MeshInitFromVertex(const char* name, BE_VertexVector vertices, BE_GLu
     BE_EBOUnbind();
 
     mesh.vao = VAO1;
+    mesh.vbo = VBO1;
+    mesh.ebo = EBO1;
+
+    // Depth passes only read positions, so they get their own tightly packed stream
+    vec3* positions = (vec3*)BE_MemAlloc(sizeof(vec3) * (vertices.size ? vertices.size : 1), BE_MEMORY_MESH);
+    if (!positions) {
+        BE_IMPL_Message(3, "Mesh", "MESH", 1, "Could not allocate memory for mesh '%s' depth stream", mesh.name);
+        exit(1);
+    }
+
+    glm_vec3_broadcast(vertices.size ? FLT_MAX : 0.0f, mesh.bounds[0]);
+    glm_vec3_broadcast(vertices.size ? -FLT_MAX : 0.0f, mesh.bounds[1]);
+    for (size_t i = 0; i < vertices.size; i++) {
+        glm_vec3_copy(vertices.data[i].position, positions[i]);
+        glm_vec3_minv(mesh.bounds[0], positions[i], mesh.bounds[0]);
+        glm_vec3_maxv(mesh.bounds[1], positions[i], mesh.bounds[1]);
+    }
+
+    mesh.depthVao = BE_VAOInit(NULL);
+    BE_VAOBind(&mesh.depthVao);
+    mesh.depthVbo = BE_VBOInitFromData((GLfloat*)positions, vertices.size * sizeof(vec3));
+    BE_EBOBind(&EBO1);
+    BE_LinkVertexAttribToVBO(&mesh.depthVbo, 0, 3, GL_FLOAT, sizeof(vec3), (void*)0);
+    BE_VAOUnbind();
+    BE_VBOUnbind();
+    BE_EBOUnbind();
+
+    BE_MemFree(positions);
 
     return mesh;
 }
@@ -1262,14 +1767,13 @@ BE_Mesh BE_MeshInitFromData(const char* name, const char** texbuffer, int texcou
     BE_GLuintVector inds;
     BE_TextureVector texs;
 
-    BE_Texture textures[texcount];
-    for (int i = 0; i < texcount; i++) {
-        textures[i] = BE_TextureInit(NULL, texbuffer[i*2], texbuffer[i*2+1], i);
-    }
-
     BE_VertexVectorCopy(vertices, vertcount, &verts);
     BE_GLuintVectorCopy(indices, indcount, &inds);
-    BE_TextureVectorCopy(textures, texcount, &texs);
+
+    BE_TextureVectorInit(&texs);
+    for (int i = 0; i < texcount; i++) {
+        BE_TextureVectorPush(&texs, BE_TextureInit(NULL, texbuffer[i*2], texbuffer[i*2+1], i));
+    }
 
     BE_Mesh mesh = BE_MeshInitFromVertex(name, verts, inds, texs);
 
@@ -1283,22 +1787,30 @@ void BE_MeshDraw(BE_Mesh* mesh, BE_Shader* shader) {
     unsigned int numDiffuse = 0;
     unsigned int numSpecular = 0;
 
-    if (mesh->textures.data) {
-        for (unsigned int i = 0; i < mesh->textures.size; i++) {
-            char num[16];
-            char uniformName[256];
-            char* type = mesh->textures.data[i].type;
+    if (mesh->textures.pool.dense) {
+        for (unsigned int i = 0; i < mesh->textures.pool.size; i++) {
+            BE_Texture* texture = BE_TextureVectorAt(&mesh->textures, i);
+            char uniformName[64];
+            char* type = texture->type;
+            unsigned int num = 0;
             if (strcmp(type, "diffuse") == 0) {
-                sprintf(num, "%d", numDiffuse++);
+                num = numDiffuse++;
             } else if (strcmp(type, "specular") == 0) {
-                sprintf(num, "%d", numSpecular++);
+                num = numSpecular++;
             }
-            snprintf(uniformName, sizeof(uniformName), "%s%s", type, num);
+            snprintf(uniformName, sizeof(uniformName), "%s%u", type, num);
             BE_TextureSetUniformUnit(shader, uniformName, i);
-            BE_TextureBind(&mesh->textures.data[i]);
+            BE_TextureBind(texture);
         }
     }
 
+    BE_RENDER_COUNT_DRAW(mesh->indices.size);
+    glDrawElements(GL_TRIANGLES, mesh->indices.size, GL_UNSIGNED_INT, 0);
+}
+
+void BE_MeshDrawDepth(BE_Mesh* mesh) {
+    BE_VAOBind(&mesh->depthVao);
+    BE_RENDER_COUNT_DRAW(mesh->indices.size);
     glDrawElements(GL_TRIANGLES, mesh->indices.size, GL_UNSIGNED_INT, 0);
 }
 
@@ -1309,286 +1821,86 @@ void BE_MeshDrawBillboard(BE_Mesh* mesh, BE_Shader* shader, BE_Texture* texture)
     BE_TextureSetUniformUnit(shader, "diffuse0", texture->unit);
     BE_TextureBind(texture);
 
+    BE_RENDER_COUNT_DRAW(mesh->indices.size);
     glDrawElements(GL_TRIANGLES, mesh->indices.size, GL_UNSIGNED_INT, 0);
 }
 
-int BE_FindOrAddVertex(BE_Vertex* vertices, int* verticesCount, BE_Vertex v) {
-    for (int i = 0; i < *verticesCount; i++) {
-        if (memcmp(&vertices[i], &v, sizeof(BE_Vertex)) == 0) {
-            return i;
-        }
-    }
-
-    int index = (*verticesCount)++;
-    vertices[index] = v;
-    return index;
+void BE_MeshDelete(BE_Mesh* mesh) {
+    BE_VAODelete(&mesh->vao);
+    BE_VBODelete(&mesh->vbo);
+    BE_VAODelete(&mesh->depthVao);
+    BE_VBODelete(&mesh->depthVbo);
+    BE_EBODelete(&mesh->ebo);
+    for (size_t i = 0; i < mesh->textures.pool.size; i++) BE_TextureDelete(BE_TextureVectorAt(&mesh->textures, i));
+    BE_TextureVectorFree(&mesh->textures);
+    BE_VertexVectorFree(&mesh->vertices);
+    BE_GLuintVectorFree(&mesh->indices);
+    BE_MemFree(mesh->name);
+    mesh->name = NULL;
 }
 
-int BE_CountFaceVertices(const char* line) {
-    const char* ptr = line + 2;
-    int count = 0;
-
-    while (*ptr) {
-        while (*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n') ptr++;
-        if (*ptr == '\0') break;
-
-        const char* token_start = ptr;
+BE_Mesh BE_LoadOBJToMesh(const char* name, const char* obj_path) {
+    BE_OBJData data;
+    if (!BE_ParseOBJ(obj_path, &data)) exit(1);
 
-        while (*ptr && *ptr != ' ' && *ptr != '\t' && *ptr != '\r' && *ptr != '\n') ptr++;
+    const char* textures[2] = {data.texturePath, data.textureType};
+    BE_Mesh mesh = BE_MeshInitFromData(name, textures, 1, data.vertices, data.verticesCount, data.indices, data.indicesCount);
 
-        char token[64];
-        size_t len = ptr - token_start;
-        if (len >= sizeof(token)) len = sizeof(token) - 1;
-        memcpy(token, token_start, len);
-        token[len] = '\0';
+    BE_OBJDataFree(&data);
 
-        int vi, vti, vni;
-        if (sscanf(token, "%d/%d/%d", &vi, &vti, &vni) == 3 ||
-            sscanf(token, "%d//%d", &vi, &vni) == 2 ||
-            sscanf(token, "%d/%d", &vi, &vti) == 2 ||
-            sscanf(token, "%d", &vi) == 1) {
-            count++;
-        }
-    }
+    BE_IMPL_Message(0, "Mesh", obj_path, 1, "Mesh '%s' loaded successfully", name);
 
-    return count;
+    return mesh;
 }
 
-void BE_ReplacePathSuffix(const char* path, const char* newsuffix, char* dest, int destsize) {
-    const char* lastSlash = strrchr(path, '/');
-
-    if (!lastSlash) {
-        snprintf(dest, destsize, "%s", newsuffix);
-        return;
-    }
-
-    int dirLen = lastSlash - path + 1;
-
-    if (dirLen >= destsize) dirLen = destsize - 1;
-
-    strncpy(dest, path, dirLen);
-    dest[dirLen] = '\0';
-
-    strncat(dest, newsuffix, destsize - strlen(dest) - 1);
+bool BE_OBJDataLoadImage(BE_OBJData* data) {
+    return BE_ImageLoad(data->texturePath, 0, &data->image);
 }
 
-BE_Mesh BE_LoadOBJToMesh(const char* name, const char* obj_path) {
-    BE_Mesh mesh;
-    
-    mesh.name = strdup(name ? name : "new mesh");
-
-    FILE* file = fopen(obj_path, "r");
-    if (!file) {
-        BE_IMPL_Message(2, "Mesh", obj_path, 1, "Failed to find OBJ file '%s'", obj_path);
-        exit(1);
-    }
-
-    vec3* positions = (vec3*)malloc(sizeof(vec3) * 100000);
-    int positionsCount = 0;
-    if (!positions) {
-        BE_IMPL_Message(3, "Mesh", obj_path, 1, "Could not allocate memory for mesh positions");
-        exit(1);
-    }
-    
-    vec3* normals = (vec3*)malloc(sizeof(vec3) * 100000);
-    int normalsCount = 0;
-    if (!normals) {
-        BE_IMPL_Message(3, "Mesh", obj_path, 1, "Could not allocate memory for mesh normal");
-        exit(1);
-    }
-    
-    vec2* uvs = (vec2*)malloc(sizeof(vec2) * 100000);
-    int uvsCount = 0;
-    if (!uvs) {
-        BE_IMPL_Message(3, "Mesh", obj_path, 1, "Could not allocate memory for mesh uvs");
-        exit(1);
-    }
-
-    BE_Vertex* vertices = (BE_Vertex*)malloc(sizeof(BE_Vertex) * 100000);
-    int verticesCount = 0;
-    if (!vertices) {
-        BE_IMPL_Message(3, "Mesh", obj_path, 1, "Could not allocate memory for mesh vertices");
-        exit(1);
-    }
-    
-    GLuint* indices =  (GLuint*)malloc(sizeof(GLuint) * 100000);
-    int indicesCount = 0;
-    if (!indices) {
-        BE_IMPL_Message(3, "Mesh", obj_path, 1, "Could not allocate memory for mesh indices");
-        exit(1);
-    }
-
-    const char** textures;
-    int texturesCount = 0;
-
-    char line[546];
-    int lineNum = 0;
-
-    while (fgets(line, sizeof(line), file)) {
-        lineNum++;
-        
-        if ( 
-            line[0] == '#' || 
-            line[0] == '\n' || 
-            strncmp(line, "o ", 2) == 0 || 
-            strncmp(line, "s ", 2) == 0
-        ) continue;
-
-        if (strncmp(line, "mtllib ", 7) == 0) {
-            char mtl_file[256] = {0};
-            char mtl_filepath[256] = {0};
-
-            sscanf(line, "mtllib %s", mtl_file);
-            BE_ReplacePathSuffix(obj_path, mtl_file, mtl_filepath, sizeof(mtl_filepath));
-
-            textures = BE_LoadMTLTextures(mtl_filepath, &texturesCount);
-
-        } else if (strncmp(line, "v ", 2) == 0) {
-
-            vec3 v;
-            if (sscanf(line, "v %f %f %f", &v[0], &v[1], &v[2]) == 3) {
-                glm_vec3_copy(v, positions[positionsCount++]);
-            } else {
-                BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Broken position vertex '%s'", line);
-                continue;
-            }
-
-        } else if (strncmp(line, "vt ", 3) == 0) {
-
-            vec2 vt;
-            if (sscanf(line, "vt %f %f", &vt[0], &vt[1]) == 2) {
-                glm_vec2_copy(vt, uvs[uvsCount++]);
-            } else {
-                BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Broken uv vertex '%s'", line);
-                continue;
-            }
-
-        } else if (strncmp(line, "vn ", 3) == 0) {
-
-            vec3 vn;
-            if (sscanf(line, "vn %f %f %f", &vn[0], &vn[1], &vn[2]) == 3) {
-                glm_vec3_copy(vn, normals[normalsCount++]);
-            } else {
-                BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Broken normal vertex '%s'", line);
-                continue;
-            }
-
-        } else if (strncmp(line, "f ", 2) == 0) {
-            
-            int faceVertCount = BE_CountFaceVertices(line);
-
-            char* token = strtok(line+2, " \t\r\n");
-            
-            BE_Vertex* verts = (BE_Vertex*)malloc(sizeof(BE_Vertex) * faceVertCount);
-            int numVerts = 0;
-
-            while (token != NULL) {
-
-                int vi, vti, vni;
-
-                if (sscanf(token, "%d/%d/%d", &vi, &vti, &vni) == 3) {
-
-                    vi--; vti--; vni--;
-                    glm_vec3_copy(positions[vi], verts[numVerts].position);
-                    glm_vec3_copy(normals[vni], verts[numVerts].normal);
-                    glm_vec3_copy((vec3){1.0f,1.0f,1.0f}, verts[numVerts].color);
-                    glm_vec2_copy(uvs[vti], verts[numVerts].texUV);
-
-                } else if (sscanf(token, "%d//%d", &vi, &vni) == 2) {
-
-                    vi--; vni--;
-                    glm_vec3_copy(positions[vi], verts[numVerts].position);
-                    glm_vec3_copy(normals[vni], verts[numVerts].normal);
-                    glm_vec3_copy((vec3){1.0f,1.0f,1.0f}, verts[numVerts].color);
-                    glm_vec2_copy((vec2){0.0f,0.0f}, verts[numVerts].texUV);
-
-                } else if (sscanf(token, "%d/%d", &vi, &vti) == 2) {
-
-                    vi--; vni--;
-                    glm_vec3_copy(positions[vi], verts[numVerts].position);
-                    glm_vec3_copy((vec3){0.0f,0.0f,1.0f}, verts[numVerts].normal);
-                    glm_vec3_copy((vec3){1.0f,1.0f,1.0f}, verts[numVerts].color);
-                    glm_vec2_copy(uvs[vti], verts[numVerts].texUV);
-
-                } else if (sscanf(token, "%d", &vi) == 1) {
-
-                    vi--;
-                    glm_vec3_copy(positions[vi], verts[numVerts].position);
-                    glm_vec3_copy((vec3){0.0f,0.0f,1.0f}, verts[numVerts].normal);
-                    glm_vec3_copy((vec3){1.0f,1.0f,1.0f}, verts[numVerts].color);
-                    glm_vec2_copy((vec2){0.0f,0.0f}, verts[numVerts].texUV);
-
-                } else {
-                    BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Broken face vertex '%s'", token);
-                }
-
-                token = strtok(NULL, " \t\r\n");
-                numVerts++;
-            }
-
-            for (int i = 1; i < numVerts - 1; i++) {
-                int i0 = BE_FindOrAddVertex(vertices, &verticesCount, verts[0]);
-                int i1 = BE_FindOrAddVertex(vertices, &verticesCount, verts[i]);
-                int i2 = BE_FindOrAddVertex(vertices, &verticesCount, verts[i + 1]);
-
-                indices[indicesCount++] = i1;
-                indices[indicesCount++] = i0;
-                indices[indicesCount++] = i2;
-            }
-
-            free(verts);
-            
-        } else {
-            line[strcspn(line, "\n")] = '\0';
-            BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Unsupported OBJ directive '%s'", line);
-            continue;
-        }
-
-    }
-
-    fclose(file);
+void BE_OBJDataFree(BE_OBJData* data) {
+    BE_MemFree(data->vertices);
+    BE_MemFree(data->indices);
+    BE_MemFree(data->texturePath);
+    BE_MemFree(data->textureType);
+    BE_ImageFree(&data->image);
+    memset(data, 0, sizeof(BE_OBJData));
+}
 
-    if (texturesCount == 0) {
-        static const char* fallbackTextures[] = {
-            "res/textures/null.jpg",
-            "diffuse"
-        };
-        textures = fallbackTextures;
-        texturesCount = 2;
-    }
-    
-    mesh = BE_MeshInitFromData(name, textures, 1, vertices, verticesCount, indices, indicesCount);
+// GL half of an OBJ import, expects BE_OBJDataLoadImage to have run
+BE_Mesh BE_MeshInitFromOBJData(const char* name, BE_OBJData* data) {
+    BE_VertexVector verts;
+    BE_GLuintVector inds;
+    BE_TextureVector texs;
 
-    free(positions);
-    free(normals);
-    free(uvs);
-    free(vertices);
-    free(indices);
+    BE_Texture texture = BE_TextureInitFromImage(NULL, &data->image, data->textureType, 0);
 
-    BE_IMPL_Message(0, "Mesh", obj_path, 1, "Mesh '%s' loaded successfully", name);
+    BE_VertexVectorCopy(data->vertices, data->verticesCount, &verts);
+    BE_GLuintVectorCopy(data->indices, data->indicesCount, &inds);
+    BE_TextureVectorCopy(&texture, 1, &texs);
 
-    return mesh;
+    return BE_MeshInitFromVertex(name, verts, inds, texs);
 }
 
 BE_Mesh BE_LoadOBJFromString(const char* name, const char* obj_contents) {
     BE_Mesh mesh;
-    mesh.name = strdup(name ? name : "");
+    mesh.name = BE_MemStrdup(name ? name : "", BE_MEMORY_MESH);
 
     if (!obj_contents) {
         BE_IMPL_Message(2, "Mesh", "OBJ_STRING", 1, "Failed to find OBJ data");
         exit(1);
     }
 
-    // Same allocations as before
-    vec3* positions = (vec3*)malloc(sizeof(vec3) * 100000);
+    // Same limits as BE_ParseOBJ, everything is copied into the mesh at the end
+    BE_ArenaMark scratch = BE_ScratchBegin();
+    vec3* positions = BE_ARENA_NEW(scratch.arena, vec3, 100000);
     int positionsCount = 0;
-    vec3* normals = (vec3*)malloc(sizeof(vec3) * 100000);
+    vec3* normals = BE_ARENA_NEW(scratch.arena, vec3, 100000);
     int normalsCount = 0;
-    vec2* uvs = (vec2*)malloc(sizeof(vec2) * 100000);
+    vec2* uvs = BE_ARENA_NEW(scratch.arena, vec2, 100000);
     int uvsCount = 0;
-    BE_Vertex* vertices = (BE_Vertex*)malloc(sizeof(BE_Vertex) * 100000);
+    BE_Vertex* vertices = BE_ARENA_NEW(scratch.arena, BE_Vertex, 100000);
     int verticesCount = 0;
-    GLuint* indices =  (GLuint*)malloc(sizeof(GLuint) * 100000);
+    GLuint* indices = BE_ARENA_NEW(scratch.arena, GLuint, 100000);
     int indicesCount = 0;
     const char** textures = NULL;
     int texturesCount = 0;
@@ -1642,7 +1954,8 @@ BE_Mesh BE_LoadOBJFromString(const char* name, const char* obj_contents) {
         } else if (strncmp(line, "f ", 2) == 0) {
             int faceVertCount = BE_CountFaceVertices(line);
             char* token = strtok(line + 2, " \t\r\n");
-            BE_Vertex* verts = (BE_Vertex*)malloc(sizeof(BE_Vertex) * faceVertCount);
+            BE_ArenaMark face = BE_ScratchBegin();
+            BE_Vertex* verts = BE_ARENA_NEW(face.arena, BE_Vertex, faceVertCount);
             int numVerts = 0;
 
             while (token != NULL) {
@@ -1694,7 +2007,7 @@ BE_Mesh BE_LoadOBJFromString(const char* name, const char* obj_contents) {
                 indices[indicesCount++] = i2;
             }
 
-            free(verts);
+            BE_ScratchEnd(face);
 
         } else {
             BE_IMPL_Message(1, "Mesh", "OBJ_STRING", lineNum, "Unsupported OBJ directive '%s'", line);
@@ -1709,99 +2022,28 @@ BE_Mesh BE_LoadOBJFromString(const char* name, const char* obj_contents) {
 
     mesh = BE_MeshInitFromData(name, textures, 1, vertices, verticesCount, indices, indicesCount);
 
-    free(positions);
-    free(normals);
-    free(uvs);
-    free(vertices);
-    free(indices);
+    BE_ScratchEnd(scratch);
 
     BE_IMPL_Message(0, "Mesh", "OBJ_STRING", 1, "Mesh '%s' loaded successfully", name);
     
     return mesh;
 }
 
-const char** BE_LoadMTLTextures(const char* mtl_path, int* outCount) {
-
-    FILE* file = fopen(mtl_path, "r");
-    if (!file) {
-        BE_IMPL_Message(2, "Mesh", mtl_path, 1, "Could not open file '%s'", mtl_path);
-        exit(1);
-    }
-    
-    const char** textures = (const char**)malloc(sizeof(char*) * 50);
-    int count = 0;
-    if (!textures) {
-        BE_IMPL_Message(1, "Mesh", mtl_path, 1, "Could not allocate memory for mesh textures");
-        exit(1);
-    }
-
-    char line[256];
-    int lineNum = 0;
-
-    while (fgets(line, sizeof(line), file)) {
-        lineNum++;
-        
-        if ( 
-            line[0] == '#' || 
-            line[0] == '\n'
-        ) continue;
-
-        if (strncmp(line, "map_Kd ", 7) == 0) {
-
-            char fileRelPath[256];
-            sscanf(line, "map_Kd %s", fileRelPath);
-
-            char texturePath[512];
-            BE_ReplacePathSuffix(mtl_path, fileRelPath, texturePath, sizeof(texturePath));
-
-            textures[count++] = strdup(texturePath);
-            textures[count++] = strdup("diffuse");
-
-        } else if (strncmp(line, "map_Ks ", 7) == 0) {
-            
-            char fileRelPath[256];
-            sscanf(line, "map_Ks %s", fileRelPath);
-
-            char texturePath[512];
-            BE_ReplacePathSuffix(mtl_path, fileRelPath, texturePath, sizeof(texturePath));
-
-            textures[count++] = strdup(texturePath);
-            textures[count++] = strdup("specular");
-        
-        } else {
-            line[strcspn(line, "\n")] = '\0';
-            BE_IMPL_Message(1, "Mesh", mtl_path, lineNum, "Unsupported MTL directive '%s'", line);
-            continue;
-        }
-    }
-
-    fclose(file);
-
-    if (outCount) *outCount = count;
-    return textures;
-}
-
-#define INITIAL_MESH_CAPACITY 4
+#define MESH_PAGE_ELEMENTS 64
 
 void BE_MeshVectorInit(BE_MeshVector* vec) {
-    vec->data = (BE_Mesh*)malloc(sizeof(BE_Mesh) * INITIAL_MESH_CAPACITY);
-    vec->size = 0;
-    vec->capacity = INITIAL_MESH_CAPACITY;
+    BE_PoolInit(&vec->pool, sizeof(BE_Mesh), MESH_PAGE_ELEMENTS, BE_MEMORY_MESH);
+    BE_RegistryInit(&vec->registry);
 }
 
 void BE_MeshVectorPush(BE_MeshVector* vec, BE_Mesh value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Mesh*)realloc(vec->data, sizeof(BE_Mesh) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    BE_RegistryAdd(&vec->registry, value.name, vec->pool.size);
+    *(BE_Mesh*)BE_PoolAlloc(&vec->pool) = value;
 }
 
 void BE_MeshVectorFree(BE_MeshVector* vec) {
-    free(vec->data);
-    vec->data = NULL;
-    vec->size = 0;
-    vec->capacity = 0;
+    BE_RegistryFree(&vec->registry);
+    BE_PoolFree(&vec->pool);
 }
 
 void BE_MeshVectorCopy(BE_Mesh* meshes, size_t count, BE_MeshVector* outVec) {
@@ -1815,45 +2057,15 @@ void BE_MeshVectorCopy(BE_Mesh* meshes, size_t count, BE_MeshVector* outVec) {
 // Models
 // ==============================
 
-BE_Transform BE_TransformInit(vec3 position, vec3 eulerRotation, vec3 scale) {
-    BE_Transform transform;
-    glm_vec3_copy(position, transform.position);
-    // glm_vec3_copy(rotation, transform.rotation);
-    glm_vec3_copy(scale, transform.scale);
-
-    versor qPitch, qYaw, qRoll;
-    glm_quatv(qPitch, eulerRotation[0], (vec3){1,0,0});
-    glm_quatv(qYaw,   eulerRotation[1], (vec3){0,1,0});
-    glm_quatv(qRoll,  eulerRotation[2], (vec3){0,0,1});
-
-    glm_quat_mul(qYaw, qPitch, transform.orientation);
-    glm_quat_mul(transform.orientation, qRoll, transform.orientation);
-    glm_quat_normalize(transform.orientation);
-
-    return transform;
-}
-
-void BE_TransformUpdateMatrix(BE_Transform* transform, mat4 outMatrix) {
-    mat4 rot;
-    glm_quat_mat4(transform->orientation, rot); // quaternion -> rotation matrix
-
-    mat4 scale;
-    glm_scale_make(scale, transform->scale);
-
-    mat4 trans;
-    glm_translate_make(trans, transform->position);
-
-    // Combine: modelMatrix = Translation * Rotation * Scale
-    glm_mat4_mul(rot, scale, outMatrix);        // rotation * scale
-    glm_mat4_mul(trans, outMatrix, outMatrix);  // translation * (rotation*scale)
-}
-
 BE_Model BE_ModelInit(const char* name, BE_Mesh* mesh, BE_Transform transform) {
     BE_Model model = {0};
     if (mesh == NULL) return model;
-    model.name = strdup(name ? name : "new model");
+    model.name = BE_MemStrdup(name ? name : "new model", BE_MEMORY_SCENE);
     model.mesh = mesh;
     model.transform = transform;
+    model.parent = -1;
+    model.dirty = true;
+    glm_mat4_identity(model.worldMatrix);
     return model;
 }
 
@@ -1862,33 +2074,74 @@ void BE_ModelRotate(BE_Model* model, vec3 axis, float angle) {
     glm_quatv(q, angle, axis);
     glm_quat_mul(q, model->transform.orientation, model->transform.orientation);
     glm_quat_normalize(model->transform.orientation);
+    model->dirty = true;
+}
+
+void BE_ModelSetPosition(BE_Model* model, vec3 position) {
+    glm_vec3_copy(position, model->transform.position);
+    model->dirty = true;
+}
+
+void BE_ModelSetOrientation(BE_Model* model, versor orientation) {
+    glm_quat_copy(orientation, model->transform.orientation);
+    glm_quat_normalize(model->transform.orientation);
+    model->dirty = true;
 }
 
-#define INITIAL_MODEL_CAPACITY 16
+void BE_ModelSetScale(BE_Model* model, vec3 scale) {
+    glm_vec3_copy(scale, model->transform.scale);
+    model->dirty = true;
+}
+
+// For code that writes model->transform directly
+void BE_ModelMarkDirty(BE_Model* model) {
+    model->dirty = true;
+}
 
 void BE_ModelVectorInit(BE_ModelVector* vec) {
-    vec->data = (BE_Model*)malloc(sizeof(BE_Model) * INITIAL_MODEL_CAPACITY);
+    vec->data = NULL;
     vec->size = 0;
-    vec->capacity = INITIAL_MODEL_CAPACITY;
+    vec->capacity = 0;
+    BE_RegistryInit(&vec->registry);
+
+    vec->epoch = 1;
+    vec->structureEpoch = 1;
+    vec->syncedStructure = 0;
+
+    vec->order = NULL;
+    vec->orderCapacity = 0;
+    vec->hierarchyDirty = true;
+
+    BE_TransformStoreInit(&vec->changed);
+    vec->changedModels = NULL;
+    vec->changedCapacity = 0;
 }
 
 void BE_ModelVectorPush(BE_ModelVector* vec, BE_Model value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Model*)realloc(vec->data, sizeof(BE_Model) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    BE_RegistryAdd(&vec->registry, value.name, vec->size);
+    *BE_ModelVectorEmplace(vec, 1) = value;
+    vec->structureEpoch = ++vec->epoch;
+    vec->hierarchyDirty = true;
 }
 
 void BE_ModelVectorFree(BE_ModelVector* vec) {
-    free(vec->data);
+    BE_RegistryFree(&vec->registry);
+    BE_MemFree(vec->data);
+    BE_MemFree(vec->order);
+    BE_MemFree(vec->changedModels);
+    BE_TransformStoreFree(&vec->changed);
     vec->data = NULL;
+    vec->order = NULL;
+    vec->changedModels = NULL;
     vec->size = 0;
     vec->capacity = 0;
+    vec->orderCapacity = 0;
+    vec->changedCapacity = 0;
 }
 
 void BE_ModelVectorCopy(BE_Model* models, size_t count, BE_ModelVector* outVec) {
     BE_ModelVectorInit(outVec);
+    BE_ModelVectorReserve(outVec, count);
     for (size_t i = 0; i < count; i++) {
         BE_ModelVectorPush(outVec, models[i]);
     }
@@ -1903,107 +2156,582 @@ void BE_ModelVectorDraw(BE_ModelVector* vec, BE_Shader* shader) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     glEnable(GL_BLEND);
 
-    mat4 modelMatrix;
+    BE_ModelVectorUpdateTransforms(vec, NULL);
 
     for (size_t i = 0; i < vec->size; i++) {
         BE_Model* model = &vec->data[i];
 
-        BE_TransformUpdateMatrix(&model->transform, modelMatrix);
-        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)modelMatrix);
-        BE_MeshDraw(model->mesh, shader);
+        BE_RENDER_COUNT(uniformUploads, 1);
+        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model->worldMatrix);
+        BE_MeshDraw(model->mesh, shader);
+
+    }
+
+}
+
+void BE_ModelGetWorldBounds(BE_Model* model, mat4 modelMatrix, vec3 dest[2]) {
+    glm_aabb_transform(model->mesh->bounds, modelMatrix, dest);
+}
+
+bool BE_ModelVectorSetParent(BE_ModelVector* vec, BE_Model* child, BE_Model* parent) {
+    int childIndex = (int)(child - vec->data);
+    int parentIndex = parent ? (int)(parent - vec->data) : -1;
+
+    // Refuse cycles, the parent chain must never reach the child
+    for (int i = parentIndex; i >= 0; i = vec->data[i].parent) {
+        if (i == childIndex) return false;
+    }
+
+    child->parent = parentIndex;
+    child->dirty = true;
+    vec->hierarchyDirty = true;
+    return true;
+}
+
+// Counting sort by depth so every parent is updated before its children
+void BE_ModelVectorUpdateOrder(BE_ModelVector* vec) {
+    if (vec->orderCapacity < vec->size * 2) {
+        vec->orderCapacity = vec->capacity * 2;
+        vec->order = (size_t*)BE_MemRealloc(vec->order, sizeof(size_t) * vec->orderCapacity, BE_MEMORY_SCENE);
+    }
+
+    // Second half of order holds depths while sorting
+    size_t* depths = vec->order + vec->size;
+    size_t maxDepth = 0;
+    for (size_t i = 0; i < vec->size; i++) {
+        size_t depth = 0;
+        for (int p = vec->data[i].parent; p >= 0; p = vec->data[p].parent) depth++;
+        depths[i] = depth;
+        if (depth > maxDepth) maxDepth = depth;
+    }
+
+    size_t next = 0;
+    for (size_t depth = 0; depth <= maxDepth; depth++) {
+        for (size_t i = 0; i < vec->size; i++) {
+            if (depths[i] == depth) vec->order[next++] = i;
+        }
+    }
+
+    vec->hierarchyDirty = false;
+}
+
+// Rebuilds world matrices and bounds only for dirty models and their descendants.
+// Safe to call from every pass, after the first call in a frame it only scans flags.
+// jobs may be NULL, composing then stays on the calling thread.
+void BE_ModelVectorUpdateTransforms(BE_ModelVector* vec, BE_Jobs* jobs) {
+    BE_PROFILE_FUNCTION();
+
+    if (vec->hierarchyDirty) BE_ModelVectorUpdateOrder(vec);
+
+    // Gather changed transforms in update order, parents stay ahead of their children
+    BE_TransformStoreClear(&vec->changed);
+
+    for (size_t k = 0; k < vec->size; k++) {
+        BE_Model* model = &vec->data[vec->order[k]];
+        BE_Model* parent = model->parent >= 0 ? &vec->data[model->parent] : NULL;
+
+        model->moved = model->dirty || (parent && parent->moved);
+        model->dirty = false;
+        if (!model->moved && model->cachedMesh == model->mesh) continue;
+
+        BE_TransformStorePush(&vec->changed, model->transform.position, model->transform.orientation, model->transform.scale);
+        if (vec->changedCapacity < vec->changed.capacity) {
+            vec->changedCapacity = vec->changed.capacity;
+            vec->changedModels = (size_t*)BE_MemRealloc(vec->changedModels, sizeof(size_t) * vec->changedCapacity, BE_MEMORY_SCENE);
+        }
+        vec->changedModels[vec->changed.size - 1] = vec->order[k];
+    }
+
+    if (vec->changed.size == 0) return;
+
+    BE_JobsParallelFor(jobs, vec->changed.size, MODEL_TRANSFORM_GRAIN, BE_ModelVectorComposeJob, &vec->changed);
+
+    for (size_t j = 0; j < vec->changed.size; j++) {
+        BE_Model* model = &vec->data[vec->changedModels[j]];
+
+        if (model->parent >= 0) glm_mat4_mul(vec->data[model->parent].worldMatrix, vec->changed.world[j], model->worldMatrix);
+        else glm_mat4_copy(vec->changed.world[j], model->worldMatrix);
+
+        glm_vec3_copy(model->bounds[0], model->prevBounds[0]);
+        glm_vec3_copy(model->bounds[1], model->prevBounds[1]);
+        BE_ModelGetWorldBounds(model, model->worldMatrix, model->bounds);
+
+        if (!model->cachedMesh) {
+            glm_vec3_copy(model->bounds[0], model->prevBounds[0]);
+            glm_vec3_copy(model->bounds[1], model->prevBounds[1]);
+        }
+
+        model->cachedMesh = model->mesh;
+        model->epoch = ++vec->epoch;
+    }
+
+}
+
+// Pieces start at multiples of the grain, so the SIMD kernels never write into a neighbour's lanes
+void BE_ModelVectorComposeJob(void* arg, size_t begin, size_t end) {
+    BE_TransformStoreCompose((BE_TransformStore*)arg, begin, end - begin);
+}
+
+// ==============================
+// Lights
+// ==============================
+
+BE_ShadowMapFBO BE_ShadowMapFBOInit(int width, int height, int layers) {
+    BE_ShadowMapFBO smfbo = {0};
+    smfbo.width = width;
+    smfbo.height = height;
+    smfbo.layers = layers;
+
+    glGenFramebuffers(1, &smfbo.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, smfbo.fbo);
+
+    glGenTextures(1, &smfbo.depthTextureArray);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, smfbo.depthTextureArray);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32,
+                 width, height, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    BE_GpuMemoryAlloc(BE_MEMORY_RENDER, BE_GpuTextureBytes(width, height, layers, 4, 1));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, smfbo.depthTextureArray, 0, 0);
+
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
+
+    return smfbo;
+}
+
+BE_ShadowMapFBO BE_ShadowMapFBOInitCubeArray(int size, int cubes) {
+    BE_ShadowMapFBO smfbo = {0};
+    smfbo.width = size;
+    smfbo.height = size;
+    smfbo.layers = cubes * 6;
+
+    glGenFramebuffers(1, &smfbo.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, smfbo.fbo);
+
+    glGenTextures(1, &smfbo.depthTextureArray);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, smfbo.depthTextureArray);
+    glTexImage3D(GL_TEXTURE_CUBE_MAP_ARRAY, 0, GL_DEPTH_COMPONENT32,
+                 size, size, cubes * 6, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+    BE_GpuMemoryAlloc(BE_MEMORY_RENDER, BE_GpuTextureBytes(size, size, cubes * 6, 4, 1));
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+
+    float clearDepth = 1.0f;
+    glClearTexImage(smfbo.depthTextureArray, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+
+    // Attached as a whole, the geometry shader picks the face through gl_Layer
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, smfbo.depthTextureArray, 0);
+
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, defaultFramebuffer);
+
+    return smfbo;
+}
+
+void BE_ShadowMapFBOBindLayer(BE_ShadowMapFBO* smfbo, int layer) {
+    BE_RENDER_COUNT(stateChanges, 1);
+    glBindFramebuffer(GL_FRAMEBUFFER, smfbo->fbo);
+    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, smfbo->depthTextureArray, 0, layer);
+   
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+}
+
+void BE_ShadowMapFBOBindLayered(BE_ShadowMapFBO* smfbo) {
+    BE_RENDER_COUNT(stateChanges, 1);
+    glBindFramebuffer(GL_FRAMEBUFFER, smfbo->fbo);
+    glFramebufferTexture(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, smfbo->depthTextureArray, 0);
+
+    glDrawBuffer(GL_NONE);
+    glReadBuffer(GL_NONE);
+}
+
+void BE_ShadowMapFBODelete(BE_ShadowMapFBO* smfbo) {
+    glDeleteFramebuffers(1, &smfbo->fbo);
+    glDeleteTextures(1, &smfbo->depthTextureArray);
+    BE_GpuMemoryRelease(BE_MEMORY_RENDER, BE_GpuTextureBytes(smfbo->width, smfbo->height, smfbo->layers, 4, 1));
+}
+
+BE_ShadowAtlas BE_ShadowAtlasInit(int size, int minTile) {
+    BE_ShadowAtlas atlas = {0};
+    atlas.size = size;
+    atlas.minTile = minTile;
+
+    atlas.levels = 1;
+    size_t levelNodes = 1;
+    atlas.nodeCount = 1;
+    for (int s = size; s > minTile; s /= 2) {
+        atlas.levels++;
+        levelNodes *= 4;
+        atlas.nodeCount += levelNodes;
+    }
+
+    atlas.nodes = (unsigned char*)BE_MemCalloc(atlas.nodeCount, sizeof(unsigned char), BE_MEMORY_RENDER);
+
+    return atlas;
+}
+
+void BE_ShadowAtlasClear(BE_ShadowAtlas* atlas) {
+    memset(atlas->nodes, BE_ATLAS_NODE_FREE, atlas->nodeCount);
+}
+
+bool BE_ShadowAtlasAlloc(BE_ShadowAtlas* atlas, int tileSize, ivec4 dest) {
+
+    int level = 0;
+    for (int s = atlas->size; s > tileSize && level < atlas->levels - 1; s /= 2) {
+        level++;
+    }
+
+    // Depth first search for a free node on the requested level, children are pushed
+    // in reverse so tiles fill the atlas from the corner
+    struct { size_t node; int x, y, level; } stack[64];
+    int top = 0;
+    stack[top].node = 0;
+    stack[top].x = 0;
+    stack[top].y = 0;
+    stack[top].level = 0;
+    top++;
+
+    while (top > 0) {
+        top--;
+        size_t node = stack[top].node;
+        int x = stack[top].x;
+        int y = stack[top].y;
+        int nodeLevel = stack[top].level;
+
+        if (atlas->nodes[node] == BE_ATLAS_NODE_USED) continue;
+
+        if (nodeLevel == level) {
+            if (atlas->nodes[node] != BE_ATLAS_NODE_FREE) continue;
+
+            atlas->nodes[node] = BE_ATLAS_NODE_USED;
+            for (size_t parent = node; parent > 0;) {
+                parent = (parent - 1) / 4;
+                atlas->nodes[parent] = BE_ATLAS_NODE_SPLIT;
+            }
+
+            int side = atlas->size >> level;
+            dest[0] = x;
+            dest[1] = y;
+            dest[2] = side;
+            dest[3] = side;
+            return true;
+        }
+
+        int half = atlas->size >> (nodeLevel + 1);
+        for (int c = 3; c >= 0 && top < 64; c--) {
+            stack[top].node = node * 4 + 1 + c;
+            stack[top].x = x + (c & 1) * half;
+            stack[top].y = y + (c >> 1) * half;
+            stack[top].level = nodeLevel + 1;
+            top++;
+        }
+    }
+
+    glm_ivec4_zero(dest);
+    return false;
+}
+
+// Marks a tile handed out earlier as used again, false if it no longer fits the quadtree
+bool BE_ShadowAtlasReserve(BE_ShadowAtlas* atlas, ivec4 tile) {
+    int level = 0;
+    for (int s = atlas->size; s > tile[2] && level < atlas->levels - 1; s /= 2) {
+        level++;
+    }
+
+    int side = atlas->size >> level;
+    if (side != tile[2] || tile[0] % side != 0 || tile[1] % side != 0) return false;
+    if (tile[0] < 0 || tile[1] < 0 || tile[0] + side > atlas->size || tile[1] + side > atlas->size) return false;
+
+    size_t node = 0;
+    for (int l = 0; l < level; l++) {
+        if (atlas->nodes[node] == BE_ATLAS_NODE_USED) return false;
+        int half = atlas->size >> (l + 1);
+        int c = ((tile[0] / half) & 1) | (((tile[1] / half) & 1) << 1);
+        node = node * 4 + 1 + c;
+    }
+    if (atlas->nodes[node] != BE_ATLAS_NODE_FREE) return false;
+
+    atlas->nodes[node] = BE_ATLAS_NODE_USED;
+    for (size_t parent = node; parent > 0;) {
+        parent = (parent - 1) / 4;
+        atlas->nodes[parent] = BE_ATLAS_NODE_SPLIT;
+    }
+    return true;
+}
+
+void BE_ShadowAtlasFree(BE_ShadowAtlas* atlas) {
+    BE_MemFree(atlas->nodes);
+    atlas->nodes = NULL;
+    atlas->nodeCount = 0;
+}
+
+// With shared set the SSBO names are borrowed from it, the CPU side is always the caller's own
+void BE_LightClustersInit(BE_LightClusters* clusters, const BE_LightClusters* shared) {
+    memset(clusters, 0, sizeof(BE_LightClusters));
+
+    clusters->bounds = (float*)BE_MemAlloc(sizeof(float) * CLUSTER_COUNT * 10, BE_MEMORY_RENDER);
+    clusters->minX = clusters->bounds + CLUSTER_COUNT * 0;
+    clusters->minY = clusters->bounds + CLUSTER_COUNT * 1;
+    clusters->minZ = clusters->bounds + CLUSTER_COUNT * 2;
+    clusters->maxX = clusters->bounds + CLUSTER_COUNT * 3;
+    clusters->maxY = clusters->bounds + CLUSTER_COUNT * 4;
+    clusters->maxZ = clusters->bounds + CLUSTER_COUNT * 5;
+    clusters->centerX = clusters->bounds + CLUSTER_COUNT * 6;
+    clusters->centerY = clusters->bounds + CLUSTER_COUNT * 7;
+    clusters->centerZ = clusters->bounds + CLUSTER_COUNT * 8;
+    clusters->radius = clusters->bounds + CLUSTER_COUNT * 9;
+
+    clusters->grid = (unsigned int*)BE_MemCalloc(CLUSTER_COUNT * 2, sizeof(unsigned int), BE_MEMORY_RENDER);
+
+    if (shared) {
+        clusters->lightSSBO = shared->lightSSBO;
+        clusters->gridSSBO = shared->gridSSBO;
+        clusters->indexSSBO = shared->indexSSBO;
+        clusters->sharedBuffers = true;
+        return;
+    }
+
+    glGenBuffers(1, &clusters->lightSSBO);
+    glGenBuffers(1, &clusters->gridSSBO);
+    glGenBuffers(1, &clusters->indexSSBO);
+}
+
+void BE_LightClustersFree(BE_LightClusters* clusters) {
+    BE_MemFree(clusters->bounds);
+    BE_MemFree(clusters->lights);
+    BE_MemFree(clusters->hits);
+    BE_MemFree(clusters->grid);
+    BE_MemFree(clusters->indices);
+
+    if (!clusters->sharedBuffers) {
+        glDeleteBuffers(1, &clusters->lightSSBO);
+        glDeleteBuffers(1, &clusters->gridSSBO);
+        glDeleteBuffers(1, &clusters->indexSSBO);
+    }
+    BE_GpuMemoryRelease(BE_MEMORY_RENDER, clusters->ssboBytes);
+
+    memset(clusters, 0, sizeof(BE_LightClusters));
+}
+
+void BE_LightClustersUpdateBounds(BE_LightClusters* clusters, BE_Camera* camera) {
+
+    clusters->nearPlane = camera->nearPlane;
+    clusters->farPlane = camera->farPlane;
+    clusters->screen[0] = (float)camera->width;
+    clusters->screen[1] = (float)camera->height;
+    glm_mat4_copy(camera->viewMatrix, clusters->viewMatrix);
+
+    float aspect = camera->height > 0 ? (float)camera->width / (float)camera->height : 1.0f;
+    float tanY = tanf(glm_rad(camera->fov) * 0.5f);
+    float tanX = tanY * aspect;
+    float ratio = clusters->farPlane / clusters->nearPlane;
+
+    for (int z = 0; z < CLUSTER_Z; z++) {
+        float depthNear = clusters->nearPlane * powf(ratio, (float)z / CLUSTER_Z);
+        float depthFar = clusters->nearPlane * powf(ratio, (float)(z + 1) / CLUSTER_Z);
+
+        for (int y = 0; y < CLUSTER_Y; y++) {
+            float y0 = -1.0f + 2.0f * y / CLUSTER_Y;
+            float y1 = -1.0f + 2.0f * (y + 1) / CLUSTER_Y;
+
+            for (int x = 0; x < CLUSTER_X; x++) {
+                float x0 = -1.0f + 2.0f * x / CLUSTER_X;
+                float x1 = -1.0f + 2.0f * (x + 1) / CLUSTER_X;
+
+                size_t c = x + y * CLUSTER_X + z * CLUSTER_X * CLUSTER_Y;
 
-    }
+                // The tile widens with depth, so each extent comes from whichever end is further out
+                clusters->minX[c] = fminf(x0 * depthNear, x0 * depthFar) * tanX;
+                clusters->maxX[c] = fmaxf(x1 * depthNear, x1 * depthFar) * tanX;
+                clusters->minY[c] = fminf(y0 * depthNear, y0 * depthFar) * tanY;
+                clusters->maxY[c] = fmaxf(y1 * depthNear, y1 * depthFar) * tanY;
+                clusters->minZ[c] = -depthFar;
+                clusters->maxZ[c] = -depthNear;
 
+                float hx = (clusters->maxX[c] - clusters->minX[c]) * 0.5f;
+                float hy = (clusters->maxY[c] - clusters->minY[c]) * 0.5f;
+                float hz = (clusters->maxZ[c] - clusters->minZ[c]) * 0.5f;
+                clusters->centerX[c] = clusters->minX[c] + hx;
+                clusters->centerY[c] = clusters->minY[c] + hy;
+                clusters->centerZ[c] = clusters->minZ[c] + hz;
+                clusters->radius[c] = sqrtf(hx * hx + hy * hy + hz * hz);
+            }
+        }
+    }
 }
 
-// ==============================
-// Lights
-// ==============================
+void BE_LightClustersBinLight(BE_LightClusters* clusters, unsigned int light, vec3 center, float radius, vec3 direction, float cosAngle, bool spot) {
+
+    // Only the depth slices the light's sphere overlaps are tested
+    float depthMin = -center[2] - radius;
+    float depthMax = -center[2] + radius;
+    if (depthMax < clusters->nearPlane || depthMin > clusters->farPlane) return;
+
+    float logRatio = logf(clusters->farPlane / clusters->nearPlane);
+    int z0 = depthMin <= clusters->nearPlane ? 0 : (int)(logf(depthMin / clusters->nearPlane) / logRatio * CLUSTER_Z);
+    int z1 = (int)(logf(depthMax / clusters->nearPlane) / logRatio * CLUSTER_Z);
+    if (z0 > CLUSTER_Z - 1) z0 = CLUSTER_Z - 1;
+    if (z1 > CLUSTER_Z - 1) z1 = CLUSTER_Z - 1;
+
+    float sinAngle = sqrtf(fmaxf(0.0f, 1.0f - cosAngle * cosAngle));
+
+#ifdef BE_CLUSTER_SSE
+    __m128 zero = _mm_setzero_ps();
+    __m128 cx = _mm_set1_ps(center[0]);
+    __m128 cy = _mm_set1_ps(center[1]);
+    __m128 cz = _mm_set1_ps(center[2]);
+    __m128 r2 = _mm_set1_ps(radius * radius);
+    __m128 range = _mm_set1_ps(radius);
+    __m128 dx = _mm_set1_ps(direction[0]);
+    __m128 dy = _mm_set1_ps(direction[1]);
+    __m128 dz = _mm_set1_ps(direction[2]);
+    __m128 cosv = _mm_set1_ps(cosAngle);
+    __m128 sinv = _mm_set1_ps(sinAngle);
+#endif
 
-BE_ShadowMapFBO BE_ShadowMapFBOInit(int width, int height, int layers) {
-    BE_ShadowMapFBO smfbo = {0};
-    smfbo.width = width;
-    smfbo.height = height;
-    smfbo.layers = layers;
+    for (int z = z0; z <= z1; z++) {
+        size_t first = (size_t)z * CLUSTER_X * CLUSTER_Y;
+        size_t last = first + CLUSTER_X * CLUSTER_Y;
+
+        for (size_t c = first; c < last; c += 4) {
+            int mask = 0;
+
+#ifdef BE_CLUSTER_SSE
+            // Sphere vs AABB, four clusters at a time
+            __m128 ex = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&clusters->minX[c]), cx), _mm_sub_ps(cx, _mm_loadu_ps(&clusters->maxX[c]))));
+            __m128 ey = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&clusters->minY[c]), cy), _mm_sub_ps(cy, _mm_loadu_ps(&clusters->maxY[c]))));
+            __m128 ez = _mm_max_ps(zero, _mm_max_ps(_mm_sub_ps(_mm_loadu_ps(&clusters->minZ[c]), cz), _mm_sub_ps(cz, _mm_loadu_ps(&clusters->maxZ[c]))));
+            __m128 dist2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, ex), _mm_mul_ps(ey, ey)), _mm_mul_ps(ez, ez));
+            mask = _mm_movemask_ps(_mm_cmple_ps(dist2, r2));
+
+            if (mask && spot) {
+                // Cone vs cluster bounding sphere
+                __m128 vx = _mm_sub_ps(_mm_loadu_ps(&clusters->centerX[c]), cx);
+                __m128 vy = _mm_sub_ps(_mm_loadu_ps(&clusters->centerY[c]), cy);
+                __m128 vz = _mm_sub_ps(_mm_loadu_ps(&clusters->centerZ[c]), cz);
+                __m128 cr = _mm_loadu_ps(&clusters->radius[c]);
+                __m128 len2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx), _mm_mul_ps(vy, vy)), _mm_mul_ps(vz, vz));
+                __m128 proj = _mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, dx), _mm_mul_ps(vy, dy)), _mm_mul_ps(vz, dz));
+                __m128 perp = _mm_sqrt_ps(_mm_max_ps(zero, _mm_sub_ps(len2, _mm_mul_ps(proj, proj))));
+                __m128 closest = _mm_sub_ps(_mm_mul_ps(cosv, perp), _mm_mul_ps(proj, sinv));
+                __m128 inside = _mm_and_ps(_mm_cmple_ps(closest, cr), _mm_cmpge_ps(proj, _mm_sub_ps(zero, cr)));
+                inside = _mm_and_ps(inside, _mm_cmple_ps(proj, _mm_add_ps(cr, range)));
+                mask &= _mm_movemask_ps(inside);
+            }
+#else
+            for (int k = 0; k < 4; k++) {
+                size_t n = c + k;
+                float ex = fmaxf(0.0f, fmaxf(clusters->minX[n] - center[0], center[0] - clusters->maxX[n]));
+                float ey = fmaxf(0.0f, fmaxf(clusters->minY[n] - center[1], center[1] - clusters->maxY[n]));
+                float ez = fmaxf(0.0f, fmaxf(clusters->minZ[n] - center[2], center[2] - clusters->maxZ[n]));
+                if (ex * ex + ey * ey + ez * ez > radius * radius) continue;
+
+                if (spot) {
+                    float vx = clusters->centerX[n] - center[0];
+                    float vy = clusters->centerY[n] - center[1];
+                    float vz = clusters->centerZ[n] - center[2];
+                    float cr = clusters->radius[n];
+                    float proj = vx * direction[0] + vy * direction[1] + vz * direction[2];
+                    float perp = sqrtf(fmaxf(0.0f, vx * vx + vy * vy + vz * vz - proj * proj));
+                    if (cosAngle * perp - proj * sinAngle > cr) continue;
+                    if (proj < -cr || proj > cr + radius) continue;
+                }
 
-    glGenFramebuffers(1, &smfbo.fbo);
-    glBindFramebuffer(GL_FRAMEBUFFER, smfbo.fbo);
+                mask |= 1 << k;
+            }
+#endif
 
-    glGenTextures(1, &smfbo.depthTextureArray);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, smfbo.depthTextureArray);
-    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT32,
-                 width, height, layers, 0, GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_BORDER);
-    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_COMPARE_MODE, GL_NONE);
+            for (int k = 0; k < 4; k++) {
+                if (!(mask & (1 << k))) continue;
 
-    float borderColor[] = { 1.0f, 1.0f, 1.0f, 1.0f };
-    glTexParameterfv(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_BORDER_COLOR, borderColor);
-    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, smfbo.depthTextureArray, 0, 0);
+                if (clusters->hitCount >= clusters->hitCapacity) {
+                    clusters->hitCapacity = clusters->hitCapacity ? clusters->hitCapacity * 2 : 1024;
+                    clusters->hits = (unsigned int*)BE_MemRealloc(clusters->hits, sizeof(unsigned int) * clusters->hitCapacity, BE_MEMORY_RENDER);
+                }
+                clusters->hits[clusters->hitCount++] = (unsigned int)(c + k) << 16 | light;
+            }
+        }
+    }
+}
 
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
+void BE_LightClustersUpload(BE_LightClusters* clusters, BE_StreamRing* ring) {
+    BE_PROFILE_FUNCTION();
 
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    // Counting sort of the hits into contiguous per cluster index lists
+    memset(clusters->grid, 0, sizeof(unsigned int) * CLUSTER_COUNT * 2);
+    for (size_t i = 0; i < clusters->hitCount; i++) {
+        clusters->grid[(clusters->hits[i] >> 16) * 2 + 1]++;
+    }
 
-    return smfbo;
-}
+    unsigned int offset = 0;
+    for (size_t c = 0; c < CLUSTER_COUNT; c++) {
+        clusters->grid[c * 2] = offset;
+        offset += clusters->grid[c * 2 + 1];
+        clusters->grid[c * 2 + 1] = 0;
+    }
 
-void BE_ShadowMapFBOBindLayer(BE_ShadowMapFBO* smfbo, int layer) {
-    glBindFramebuffer(GL_FRAMEBUFFER, smfbo->fbo);
-    glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, smfbo->depthTextureArray, 0, layer);
-   
-    glDrawBuffer(GL_NONE);
-    glReadBuffer(GL_NONE);
-}
+    if (clusters->hitCount > clusters->indexCapacity) {
+        clusters->indexCapacity = clusters->hitCapacity;
+        clusters->indices = (unsigned int*)BE_MemRealloc(clusters->indices, sizeof(unsigned int) * clusters->indexCapacity, BE_MEMORY_RENDER);
+    }
 
-void BE_ShadowMapFBODelete(BE_ShadowMapFBO* smfbo) {
-    glDeleteFramebuffers(1, &smfbo->fbo);
-    glDeleteTextures(1, &smfbo->depthTextureArray);
-}
+    for (size_t i = 0; i < clusters->hitCount; i++) {
+        unsigned int c = clusters->hits[i] >> 16;
+        clusters->indices[clusters->grid[c * 2] + clusters->grid[c * 2 + 1]++] = clusters->hits[i] & 0xFFFF;
+    }
 
-BE_Light BE_LightInit(const char* name, int type, vec3 position, vec3 direction, vec4 color, float specular, float a, float b, float innerCone, float outerCone) {
+    // Empty lists still get a range, unsized SSBO arrays need something bound
+    size_t lightSize = sizeof(BE_GPULight) * (clusters->lightCount ? clusters->lightCount : 1);
+    size_t gridSize = sizeof(unsigned int) * CLUSTER_COUNT * 2;
+    size_t indexSize = sizeof(unsigned int) * (clusters->hitCount ? clusters->hitCount : 1);
+
+    size_t align = (size_t)ring->storageAlign;
+    if (BE_StreamRingAlloc(ring, lightSize, align, &clusters->lightRange) &&
+        BE_StreamRingAlloc(ring, gridSize, align, &clusters->gridRange) &&
+        BE_StreamRingAlloc(ring, indexSize, align, &clusters->indexRange)) {
+        memcpy(clusters->lightRange.ptr, clusters->lights, sizeof(BE_GPULight) * clusters->lightCount);
+        memcpy(clusters->gridRange.ptr, clusters->grid, gridSize);
+        memcpy(clusters->indexRange.ptr, clusters->indices, sizeof(unsigned int) * clusters->hitCount);
+        return;
+    }
 
-    BE_Light light = {0};
-    light.name = strdup(name ? name : "new light");
-    glm_vec4_copy(color, light.color);
-    light.specular = specular;
-    
-    glm_quat_identity(light.orientation);
-    vec3 forward = {0,0,-1};
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters->lightSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, lightSize, clusters->lightCount ? clusters->lights : NULL, GL_STREAM_DRAW);
 
-    switch (type) {
-        case BE_LIGHT_DIRECT:
-            glm_quat_from_vecs(forward, direction, light.orientation);
-            glm_vec3_copy(direction, light.direction);
-            break;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters->gridSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, gridSize, clusters->grid, GL_STREAM_DRAW);
 
-        case BE_LIGHT_POINT:
-            glm_vec3_copy(position, light.position);
-            break;
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, clusters->indexSSBO);
+    glBufferData(GL_SHADER_STORAGE_BUFFER, indexSize, clusters->hitCount ? clusters->indices : NULL, GL_STREAM_DRAW);
 
-        case BE_LIGHT_SPOT:
-            glm_quat_from_vecs(forward, direction, light.orientation);
-            glm_vec3_copy(position, light.position);
-            glm_vec3_copy(direction, light.direction);
-            break;
-        
-        default:
-            printf("invalid light type\n");
-            break;
-    }
+    glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
 
-    light.type = type;
-    light.a = a;
-    light.b = b;
-    light.innerCone = innerCone;
-    light.outerCone = outerCone;
+    BE_GpuMemoryRelease(BE_MEMORY_RENDER, clusters->ssboBytes);
+    clusters->ssboBytes = lightSize + gridSize + indexSize;
+    BE_GpuMemoryAlloc(BE_MEMORY_RENDER, clusters->ssboBytes);
 
-    return light;
+    clusters->lightRange = (BE_StreamAlloc){NULL, clusters->lightSSBO, 0, (GLsizeiptr)lightSize};
+    clusters->gridRange = (BE_StreamAlloc){NULL, clusters->gridSSBO, 0, (GLsizeiptr)gridSize};
+    clusters->indexRange = (BE_StreamAlloc){NULL, clusters->indexSSBO, 0, (GLsizeiptr)indexSize};
 }
 
+
 // void BE_LightSetPosition(BE_Light* light, const vec3 position) {
 //     light->position[0] = position[0];
 //     light->position[1] = position[1];
@@ -2034,6 +2762,128 @@ void BE_LightRotate(BE_Light* light, vec3 axis, float angle) {
     glm_quat_rotatev(light->orientation, forward, light->direction);
 }
 
+bool BE_LightCullBounds(BE_Light* light, vec4 planes[6], vec3 bounds[2]) {
+    vec3 center, toCenter, dir;
+    glm_aabb_center(bounds, center);
+    float radius = glm_aabb_radius(bounds);
+    float range = BE_LightGetRange(light);
+
+    switch (light->type) {
+        case BE_LIGHT_DIRECT:
+            return glm_aabb_frustum(bounds, planes);
+
+        case BE_LIGHT_POINT:
+            return glm_vec3_distance2(center, light->position) <= (range + radius) * (range + radius);
+
+        case BE_LIGHT_SPOT: {
+            // Sphere vs cone, cone axis along the light direction with half angle acos(outerCone)
+            glm_vec3_sub(center, light->position, toCenter);
+            glm_vec3_normalize_to(light->direction, dir);
+
+            float cosAngle = glm_clamp(light->outerCone, 0.0f, 1.0f);
+            float sinAngle = sqrtf(1.0f - cosAngle * cosAngle);
+            float distSq = glm_vec3_norm2(toCenter);
+            float along = glm_vec3_dot(toCenter, dir);
+            float closest = cosAngle * sqrtf(fmaxf(distSq - along * along, 0.0f)) - along * sinAngle;
+
+            if (closest > radius) return false;
+            if (along > range + radius) return false;
+            if (along < -radius) return false;
+            return true;
+        }
+
+        default:
+            return true;
+    }
+}
+
+void BE_LightGetShadowKey(BE_Light* light, BE_ShadowKey* dest) {
+    memset(dest, 0, sizeof(BE_ShadowKey));
+    glm_mat4_copy(light->lightSpaceMatrix, dest->lightSpaceMatrix);
+    glm_vec3_copy(light->position, dest->position);
+    glm_vec3_copy(light->direction, dest->direction);
+    dest->a = light->a;
+    dest->b = light->b;
+    dest->outerCone = light->outerCone;
+}
+
+bool BE_LightShadowIsDirty(BE_Light* light, BE_ModelVector* models) {
+
+    BE_ShadowKey key;
+    BE_LightGetShadowKey(light, &key);
+
+    if (light->shadowEpoch == 0) return true;
+    if (memcmp(&key, &light->shadowKey, sizeof(BE_ShadowKey)) != 0) return true;
+    if (models->structureEpoch > light->shadowEpoch) return true;
+    if (models->epoch == light->shadowEpoch) return false;
+
+    // Only casters that changed since the last render and touch the light, before or after the change, matter
+    vec4 planes[6];
+    glm_frustum_planes(light->lightSpaceMatrix, planes);
+
+    for (size_t i = 0; i < models->size; i++) {
+        BE_Model* model = &models->data[i];
+        if (model->epoch <= light->shadowEpoch) continue;
+        if (BE_LightCullBounds(light, planes, model->bounds)) return true;
+        if (BE_LightCullBounds(light, planes, model->prevBounds)) return true;
+    }
+
+    return false;
+}
+
+void BE_LightShadowMarkClean(BE_Light* light, BE_ModelVector* models) {
+    BE_ShadowKey key;
+    BE_LightGetShadowKey(light, &key);
+    memcpy(&light->shadowKey, &key, sizeof(BE_ShadowKey));
+    light->shadowEpoch = models->epoch;
+}
+
+float BE_LightGetScreenCoverage(BE_Light* light, BE_Camera* camera) {
+    if (camera == NULL || light->type == BE_LIGHT_DIRECT) return 1.0f;
+
+    float radius = BE_LightGetRange(light);
+
+    vec4 planes[6];
+    glm_frustum_planes(camera->projPersp, planes);
+    for (int i = 0; i < 6; i++) {
+        if (glm_vec3_dot(planes[i], light->position) + planes[i][3] < -radius) return 0.0f;
+    }
+
+    float dist = glm_vec3_distance(camera->position, light->position);
+    if (dist <= radius) return 1.0f;
+
+    // Projected radius relative to half the screen height
+    float projected = radius / (dist * tanf(glm_rad(camera->fov) * 0.5f));
+    return glm_clamp(projected * projected, 0.0f, 1.0f);
+}
+
+void BE_LightGetCubeMatrices(BE_Light* light, mat4 dest[6]) {
+    // GL cube map face order +X, -X, +Y, -Y, +Z, -Z
+    vec3 targets[6] = {{1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}};
+    vec3 ups[6] = {{0, -1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}, {0, -1, 0}, {0, -1, 0}};
+
+    mat4 projection, view;
+    vec3 target;
+    glm_perspective(glm_rad(90.0f), 1.0f, 0.05f, BE_LightGetRange(light), projection);
+
+    for (int face = 0; face < 6; face++) {
+        glm_vec3_add(light->position, targets[face], target);
+        glm_lookat(light->position, target, ups[face], view);
+        glm_mat4_mul(projection, view, dest[face]);
+    }
+}
+
+unsigned int BE_LightGetCubeFaceMask(BE_Light* light, vec4 facePlanes[6][6], vec3 bounds[2]) {
+    if (!BE_LightCullBounds(light, NULL, bounds)) return 0;
+
+    unsigned int mask = 0;
+    for (int face = 0; face < 6; face++) {
+        if (glm_aabb_frustum(bounds, facePlanes[face])) mask |= 1u << face;
+    }
+
+    return mask;
+}
+
 // void BE_LightGetDirection(BE_Light* light, vec3 dest) {
 //     glm_vec3_copy(light->direction, dest);
 // }
@@ -2118,29 +2968,53 @@ void BE_LightRotate(BE_Light* light, vec3 axis, float angle) {
 //     light->enabled = true;
 // }
 
-#define INITIAL_LIGHT_CAPACITY 4
-
 void BE_LightVectorInit(BE_LightVector* vec) {
-    vec->data = (BE_Light*)malloc(sizeof(BE_Light) * INITIAL_LIGHT_CAPACITY);
+    vec->data = NULL;
     vec->size = 0;
-    vec->capacity = INITIAL_LIGHT_CAPACITY;
+    vec->capacity = 0;
+    BE_RegistryInit(&vec->registry);
 
     vec->ambient = 0.15f;
     vec->directShadowFBO = BE_ShadowMapFBOInit(1024*4, 1024*4, 1);
-    vec->pointShadowFBO = BE_ShadowMapFBOInit(250, 250, 10);
-    vec->spotShadowFBO = BE_ShadowMapFBOInit(250, 250, 10);
+    vec->pointShadowFBO = BE_ShadowMapFBOInitCubeArray(POINT_SHADOW_SIZE, POINT_SHADOW_LIGHTS);
+    vec->spotShadowFBO = BE_ShadowMapFBOInit(SPOT_SHADOW_ATLAS_SIZE, SPOT_SHADOW_ATLAS_SIZE, 1);
+    vec->spotAtlas = BE_ShadowAtlasInit(SPOT_SHADOW_ATLAS_SIZE, SPOT_SHADOW_MIN_TILE);
+    BE_LightClustersInit(&vec->clusters, NULL);
+    vec->sharedMaps = false;
+}
+
+// For a render copy, only one of the two vectors draws at a time so both can use the owner's
+// shadow maps and cluster SSBOs. The owner has to outlive it.
+void BE_LightVectorInitShared(BE_LightVector* vec, const BE_LightVector* owner) {
+    vec->data = NULL;
+    vec->size = 0;
+    vec->capacity = 0;
+    BE_RegistryInit(&vec->registry);
+
+    vec->ambient = owner->ambient;
+    vec->directShadowFBO = owner->directShadowFBO;
+    vec->pointShadowFBO = owner->pointShadowFBO;
+    vec->spotShadowFBO = owner->spotShadowFBO;
+    vec->spotAtlas = BE_ShadowAtlasInit(owner->spotAtlas.size, owner->spotAtlas.minTile);
+    BE_LightClustersInit(&vec->clusters, &owner->clusters);
+    vec->sharedMaps = true;
 }
 
 void BE_LightVectorPush(BE_LightVector* vec, BE_Light value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Light*)realloc(vec->data, sizeof(BE_Light) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    BE_RegistryAdd(&vec->registry, value.name, vec->size);
+    *BE_LightVectorEmplace(vec, 1) = value;
 }
 
 void BE_LightVectorFree(BE_LightVector* vec) {
-    free(vec->data);
+    if (!vec->sharedMaps) {
+        BE_ShadowMapFBODelete(&vec->directShadowFBO);
+        BE_ShadowMapFBODelete(&vec->pointShadowFBO);
+        BE_ShadowMapFBODelete(&vec->spotShadowFBO);
+    }
+    BE_ShadowAtlasFree(&vec->spotAtlas);
+    BE_LightClustersFree(&vec->clusters);
+    BE_RegistryFree(&vec->registry);
+    BE_MemFree(vec->data);
     vec->data = NULL;
     vec->size = 0;
     vec->capacity = 0;
@@ -2148,12 +3022,14 @@ void BE_LightVectorFree(BE_LightVector* vec) {
 
 void BE_LightVectorCopy(BE_Light* lights, size_t count, BE_LightVector* outVec) {
     BE_LightVectorInit(outVec);
+    BE_LightVectorReserve(outVec, count);
     for (size_t i = 0; i < count; i++) {
         BE_LightVectorPush(outVec, lights[i]);
     }
 }
 
 void BE_LightVectorUpdateMatrix(BE_LightVector* vec) {
+    BE_PROFILE_FUNCTION();
     mat4 projection, view;
     vec3 position, direction;
     
@@ -2171,15 +3047,149 @@ void BE_LightVectorUpdateMatrix(BE_LightVector* vec) {
                 break;
             case BE_LIGHT_POINT:
                 break;
-            case BE_LIGHT_SPOT:
+            case BE_LIGHT_SPOT: {
+                glm_normalize_to(light->direction, direction);
+                if (glm_vec3_norm2(direction) == 0.0f) glm_vec3_copy((vec3){0.0f, -1.0f, 0.0f}, direction);
+
+                // outerCone is the cosine of the half angle, keep the frustum away from 0 and 180 degrees
+                float cosAngle = glm_clamp(light->outerCone, cosf(glm_rad(85.0f)), cosf(glm_rad(1.0f)));
+                float fov = 2.0f * acosf(cosAngle);
+
+                vec3 up = {0.0f, 1.0f, 0.0f};
+                if (fabsf(direction[1]) > 0.99f) glm_vec3_copy((vec3){1.0f, 0.0f, 0.0f}, up);
+
+                glm_vec3_add(light->position, direction, position);
+                glm_perspective(fov, 1.0f, 0.1f, BE_LightGetRange(light), projection);
+                glm_lookat(light->position, position, up, view);
+                glm_mat4_mul(projection, view, light->lightSpaceMatrix);
+
                 break;
+            }
             default:
                 break;
         }
     }
 }
 
-void BE_LightVectorUpdateMaps(BE_LightVector* vec, BE_Shader* shadowShader, ShadowRenderFunc renderFunc, bool enabled) {
+void BE_LightVectorAllocSpotTiles(BE_LightVector* vec, BE_Camera* camera) {
+    BE_PROFILE_FUNCTION();
+
+    BE_ShadowAtlas* atlas = &vec->spotAtlas;
+
+    size_t count = 0;
+    for (size_t i = 0; i < vec->size; i++) {
+        if (vec->data[i].type == BE_LIGHT_SPOT) count++;
+    }
+    if (count == 0) return;
+
+    BE_ArenaMark scratch = BE_ScratchBegin();
+    BE_ShadowTileRequest* requests = BE_ARENA_NEW(scratch.arena, BE_ShadowTileRequest, count);
+
+    long long budget = (long long)atlas->size * atlas->size;
+    long long used = 0;
+    size_t n = 0;
+
+    for (size_t i = 0; i < vec->size; i++) {
+        BE_Light* light = &vec->data[i];
+        if (light->type != BE_LIGHT_SPOT) continue;
+
+        float brightness = glm_clamp(glm_vec3_max(light->color) * light->color[3], 0.0f, 1.0f);
+        float importance = BE_LightGetScreenCoverage(light, camera) * brightness;
+
+        // Tile side follows the projected size, a light filling the screen gets the largest tile
+        int size = 0;
+        if (importance > 0.0f) {
+            float side = sqrtf(importance) * atlas->size;
+            size = atlas->minTile;
+            while (size < side && size < SPOT_SHADOW_MAX_TILE) size *= 2;
+
+            // A light sitting on a size boundary would move and re-render every frame
+            int current = light->shadowTile[2];
+            if (current > 0 && side <= current * (1.0f + SPOT_SHADOW_TILE_HYSTERESIS) &&
+                side >= current * (0.5f - SPOT_SHADOW_TILE_HYSTERESIS)) {
+                size = current;
+            }
+        }
+
+        requests[n].light = i;
+        requests[n].importance = importance;
+        requests[n].size = size;
+        used += (long long)size * size;
+        n++;
+    }
+
+    // Over budget, the least important lights give up resolution first and lose their shadow last
+    while (used > budget) {
+        size_t worst = count;
+        for (size_t k = 0; k < count; k++) {
+            if (requests[k].size <= atlas->minTile) continue;
+            if (worst == count || requests[k].importance < requests[worst].importance) worst = k;
+        }
+
+        if (worst != count) {
+            used -= (long long)requests[worst].size * requests[worst].size * 3 / 4;
+            requests[worst].size /= 2;
+            continue;
+        }
+
+        for (size_t k = 0; k < count; k++) {
+            if (requests[k].size == 0) continue;
+            if (worst == count || requests[k].importance < requests[worst].importance) worst = k;
+        }
+
+        used -= (long long)requests[worst].size * requests[worst].size;
+        requests[worst].size = 0;
+    }
+
+    // Placing power of two tiles largest first never fragments the quadtree
+    for (size_t k = 1; k < count; k++) {
+        BE_ShadowTileRequest request = requests[k];
+        size_t j = k;
+        while (j > 0 && requests[j - 1].size < request.size) {
+            requests[j] = requests[j - 1];
+            j--;
+        }
+        requests[j] = request;
+    }
+
+    // Lights that keep their size keep their tile and its cached map, only the rest are placed.
+    // Kept tiles can leave the free space fragmented, then everything is packed again.
+    BE_ShadowAtlasClear(atlas);
+    for (size_t k = 0; k < count; k++) {
+        BE_Light* light = &vec->data[requests[k].light];
+        glm_ivec4_zero(requests[k].tile);
+        if (requests[k].size > 0 && requests[k].size == light->shadowTile[2] && BE_ShadowAtlasReserve(atlas, light->shadowTile)) {
+            glm_ivec4_copy(light->shadowTile, requests[k].tile);
+        }
+    }
+
+    bool packed = true;
+    for (size_t k = 0; k < count && packed; k++) {
+        if (requests[k].size == 0 || requests[k].tile[2] != 0) continue;
+        packed = BE_ShadowAtlasAlloc(atlas, requests[k].size, requests[k].tile);
+    }
+
+    if (!packed) {
+        BE_ShadowAtlasClear(atlas);
+        for (size_t k = 0; k < count; k++) {
+            glm_ivec4_zero(requests[k].tile);
+            if (requests[k].size > 0) BE_ShadowAtlasAlloc(atlas, requests[k].size, requests[k].tile);
+        }
+    }
+
+    for (size_t k = 0; k < count; k++) {
+        BE_Light* light = &vec->data[requests[k].light];
+        if (memcmp(requests[k].tile, light->shadowTile, sizeof(ivec4)) != 0) {
+            glm_ivec4_copy(requests[k].tile, light->shadowTile);
+            light->shadowEpoch = 0;
+        }
+    }
+
+    BE_ScratchEnd(scratch);
+}
+
+void BE_LightVectorUpdateMultiMaps(BE_LightVector* vec, BE_ModelVector* models, BE_Camera* camera, BE_Shader* shadowShader, BE_Shader* pointShadowShader, bool enabled) {
+    BE_PROFILE_FUNCTION();
     
     BE_ShaderActivate(shadowShader);
     glEnable(GL_DEPTH_TEST);
@@ -2194,11 +3204,8 @@ void BE_LightVectorUpdateMaps(BE_LightVector* vec, BE_Shader* shadowShader, Shad
                 glClear(GL_DEPTH_BUFFER_BIT);
             }
 
-            // for (int layer = 0; layer < vec->pointShadowFBO.layers; layer++) {
-            //     BE_ShadowMapFBOBindLayer(&vec->pointShadowFBO, layer);
-            //     glViewport(0, 0, vec->pointShadowFBO.width, vec->pointShadowFBO.height);
-            //     glClear(GL_DEPTH_BUFFER_BIT);
-            // }
+            float clearDepth = 1.0f;
+            glClearTexImage(vec->pointShadowFBO.depthTextureArray, 0, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
 
             for (int layer = 0; layer < vec->spotShadowFBO.layers; layer++) {
                 BE_ShadowMapFBOBindLayer(&vec->spotShadowFBO, layer);
@@ -2208,6 +3215,11 @@ void BE_LightVectorUpdateMaps(BE_LightVector* vec, BE_Shader* shadowShader, Shad
 
             BE_FBOUnbind();
 
+            // cleared maps have to be rendered again once shadows come back on
+            for (size_t i = 0; i < vec->size; i++) {
+                vec->data[i].shadowEpoch = 0;
+            }
+
             vec->shadowsDirty = 0;
         }
 
@@ -2216,27 +3228,69 @@ void BE_LightVectorUpdateMaps(BE_LightVector* vec, BE_Shader* shadowShader, Shad
         vec->shadowsDirty = 1;
     }
 
+    BE_ModelVectorUpdateTransforms(models, NULL);
+    BE_LightVectorAllocSpotTiles(vec, camera);
+
+    int numDirects = 0;
+    int numPoints = 0;
+
     for (size_t i = 0; i < vec->size; i++) {
         BE_Light* light = &vec->data[i];
 
         switch (vec->data[i].type) {
-            case BE_LIGHT_DIRECT:
-                BE_ShadowMapFBOBindLayer(&vec->directShadowFBO, 0);
+            case BE_LIGHT_DIRECT: {
+                int layer = numDirects++;
+                if (layer >= vec->directShadowFBO.layers) break;
+                if (light->shadowLayer != layer) light->shadowEpoch = 0;
+                light->shadowLayer = layer;
+                if (!BE_LightShadowIsDirty(light, models)) break;
+
+                BE_ShadowMapFBOBindLayer(&vec->directShadowFBO, layer);
                 glViewport(0, 0, vec->directShadowFBO.width, vec->directShadowFBO.height);
                 glClear(GL_DEPTH_BUFFER_BIT);
-                glUniformMatrix4fv(glGetUniformLocation(shadowShader->ID, "lightSpaceMatrix"), 1, GL_FALSE, (float*)light->lightSpaceMatrix);
-                renderFunc(shadowShader);
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                BE_LightVectorDrawCasters(light, models, shadowShader);
+                BE_LightShadowMarkClean(light, models);
+
+                BE_FBOUnbind();
                 break;
-            case BE_LIGHT_POINT:
+            }
+            case BE_LIGHT_POINT: {
+                int cube = numPoints++;
+                if (cube >= vec->pointShadowFBO.layers / 6) {
+                    light->shadowLayer = -1;
+                    break;
+                }
+                if (light->shadowLayer != cube) light->shadowEpoch = 0;
+                light->shadowLayer = cube;
+                if (!BE_LightShadowIsDirty(light, models)) break;
+
+                // Only this light's six faces are cleared, other cubes keep their cached maps
+                float clearDepth = 1.0f;
+                glClearTexSubImage(vec->pointShadowFBO.depthTextureArray, 0, 0, 0, cube * 6,
+                    vec->pointShadowFBO.width, vec->pointShadowFBO.height, 6, GL_DEPTH_COMPONENT, GL_FLOAT, &clearDepth);
+
+                BE_ShadowMapFBOBindLayered(&vec->pointShadowFBO);
+                glViewport(0, 0, vec->pointShadowFBO.width, vec->pointShadowFBO.height);
+                BE_LightVectorDrawCubeCasters(light, models, pointShadowShader, cube);
+                BE_LightShadowMarkClean(light, models);
+
+                BE_FBOUnbind();
                 break;
+            }
             case BE_LIGHT_SPOT:
-                BE_ShadowMapFBOBindLayer(&vec->spotShadowFBO, i);
-                glViewport(0, 0, vec->spotShadowFBO.width, vec->spotShadowFBO.height);
+                if (light->shadowTile[2] == 0) break;
+                if (!BE_LightShadowIsDirty(light, models)) break;
+
+                BE_ShadowMapFBOBindLayer(&vec->spotShadowFBO, 0);
+                glViewport(light->shadowTile[0], light->shadowTile[1], light->shadowTile[2], light->shadowTile[3]);
+                glEnable(GL_SCISSOR_TEST);
+                glScissor(light->shadowTile[0], light->shadowTile[1], light->shadowTile[2], light->shadowTile[3]);
                 glClear(GL_DEPTH_BUFFER_BIT);
-                glUniformMatrix4fv(glGetUniformLocation(shadowShader->ID, "lightSpaceMatrix"), 1, GL_FALSE, (float*)light->lightSpaceMatrix);
-                renderFunc(shadowShader);
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
+                glDisable(GL_SCISSOR_TEST);
+                BE_LightVectorDrawCasters(light, models, shadowShader);
+                BE_LightShadowMarkClean(light, models);
+
+                BE_FBOUnbind();
                 break;
             default:
                 break;
@@ -2245,74 +3299,104 @@ void BE_LightVectorUpdateMaps(BE_LightVector* vec, BE_Shader* shadowShader, Shad
 
 }
 
-void BE_LightVectorUpdateMultiMaps(BE_LightVector* vec, BE_ModelVector* models, BE_Shader* shadowShader, bool enabled) {
-    
+void BE_LightVectorDrawCasters(BE_Light* light, BE_ModelVector* models, BE_Shader* shadowShader) {
+
     BE_ShaderActivate(shadowShader);
+
     glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
 
-    if (!enabled) {
+    GLint modelLoc = glGetUniformLocation(shadowShader->ID, "model");
+    BE_RENDER_COUNT(uniformUploads, 1);
+    BE_RENDER_COUNT(shadowPasses, 1);
+    glUniformMatrix4fv(glGetUniformLocation(shadowShader->ID, "lightSpaceMatrix"), 1, GL_FALSE, (float*)light->lightSpaceMatrix);
 
-        if (vec->shadowsDirty == 1) {
-            for (int layer = 0; layer < vec->directShadowFBO.layers; layer++) {
-                BE_ShadowMapFBOBindLayer(&vec->directShadowFBO, layer);
-                glViewport(0, 0, vec->directShadowFBO.width, vec->directShadowFBO.height);
-                glClear(GL_DEPTH_BUFFER_BIT);
-            }
+    vec4 planes[6];
+    glm_frustum_planes(light->lightSpaceMatrix, planes);
 
-            // for (int layer = 0; layer < vec->pointShadowFBO.layers; layer++) {
-            //     BE_ShadowMapFBOBindLayer(&vec->pointShadowFBO, layer);
-            //     glViewport(0, 0, vec->pointShadowFBO.width, vec->pointShadowFBO.height);
-            //     glClear(GL_DEPTH_BUFFER_BIT);
-            // }
+    for (size_t i = 0; i < models->size; i++) {
+        BE_Model* model = &models->data[i];
 
-            for (int layer = 0; layer < vec->spotShadowFBO.layers; layer++) {
-                BE_ShadowMapFBOBindLayer(&vec->spotShadowFBO, layer);
-                glViewport(0, 0, vec->spotShadowFBO.width, vec->spotShadowFBO.height);
-                glClear(GL_DEPTH_BUFFER_BIT);
-            }
+        if (!BE_LightCullBounds(light, planes, model->bounds)) continue;
 
-            BE_FBOUnbind();
+        BE_RENDER_COUNT(uniformUploads, 1);
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, (float*)model->worldMatrix);
+        BE_MeshDrawDepth(model->mesh);
+    }
 
-            vec->shadowsDirty = 0;
-        }
+}
 
-        return;
-    } else {
-        vec->shadowsDirty = 1;
+void BE_LightVectorDrawCubeCasters(BE_Light* light, BE_ModelVector* models, BE_Shader* pointShadowShader, int cube) {
+
+    BE_ShaderActivate(pointShadowShader);
+
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+
+    mat4 faceMatrices[6];
+    vec4 facePlanes[6][6];
+    BE_LightGetCubeMatrices(light, faceMatrices);
+    for (int face = 0; face < 6; face++) {
+        glm_frustum_planes(faceMatrices[face], facePlanes[face]);
     }
 
-    for (size_t i = 0; i < vec->size; i++) {
-        BE_Light* light = &vec->data[i];
+    BE_RENDER_COUNT(uniformUploads, 4);
+    BE_RENDER_COUNT(shadowPasses, 1);
+    glUniformMatrix4fv(glGetUniformLocation(pointShadowShader->ID, "faceMatrices"), 6, GL_FALSE, (float*)faceMatrices);
+    glUniform3fv(glGetUniformLocation(pointShadowShader->ID, "lightPos"), 1, (float*)light->position);
+    glUniform1f(glGetUniformLocation(pointShadowShader->ID, "farPlane"), BE_LightGetRange(light));
+    glUniform1i(glGetUniformLocation(pointShadowShader->ID, "cubeIndex"), cube);
 
-        switch (vec->data[i].type) {
-            case BE_LIGHT_DIRECT:
-                BE_ShadowMapFBOBindLayer(&vec->directShadowFBO, 0);
-                glViewport(0, 0, vec->directShadowFBO.width, vec->directShadowFBO.height);
-                glClear(GL_DEPTH_BUFFER_BIT);
-                glUniformMatrix4fv(glGetUniformLocation(shadowShader->ID, "lightSpaceMatrix"), 1, GL_FALSE, (float*)light->lightSpaceMatrix);
+    GLint modelLoc = glGetUniformLocation(pointShadowShader->ID, "model");
+    GLint maskLoc = glGetUniformLocation(pointShadowShader->ID, "faceMask");
 
-                BE_ModelVectorDraw(models, shadowShader);
+    for (size_t i = 0; i < models->size; i++) {
+        BE_Model* model = &models->data[i];
 
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-                break;
-            case BE_LIGHT_POINT:
-                break;
-            case BE_LIGHT_SPOT:
-                BE_ShadowMapFBOBindLayer(&vec->spotShadowFBO, i);
-                glViewport(0, 0, vec->spotShadowFBO.width, vec->spotShadowFBO.height);
-                glClear(GL_DEPTH_BUFFER_BIT);
-                glUniformMatrix4fv(glGetUniformLocation(shadowShader->ID, "lightSpaceMatrix"), 1, GL_FALSE, (float*)light->lightSpaceMatrix);
+        unsigned int mask = BE_LightGetCubeFaceMask(light, facePlanes, model->bounds);
+        if (mask == 0) continue;
 
-                BE_ModelVectorDraw(models, shadowShader);
+        BE_RENDER_COUNT(uniformUploads, 2);
+        glUniformMatrix4fv(modelLoc, 1, GL_FALSE, (float*)model->worldMatrix);
+        glUniform1i(maskLoc, (int)mask);
+        BE_MeshDrawDepth(model->mesh);
+    }
 
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-                break;
-            default:
-                break;
+}
+
+void BE_LightVectorUpdateClusters(BE_LightVector* vec, BE_Camera* camera, BE_StreamRing* ring) {
+    BE_PROFILE_FUNCTION();
+
+    BE_LightClusters* clusters = &vec->clusters;
+    BE_LightClustersUpdateBounds(clusters, camera);
+
+    clusters->lightCount = 0;
+    clusters->hitCount = 0;
+
+    vec3 center, direction;
+
+    for (size_t i = 0; i < vec->size && clusters->lightCount < CLUSTER_MAX_LIGHTS; i++) {
+        BE_Light* light = &vec->data[i];
+        if (light->type != BE_LIGHT_POINT && light->type != BE_LIGHT_SPOT) continue;
+
+        if (clusters->lightCount >= clusters->lightCapacity) {
+            clusters->lightCapacity = clusters->lightCapacity ? clusters->lightCapacity * 2 : 64;
+            clusters->lights = (BE_GPULight*)BE_MemRealloc(clusters->lights, sizeof(BE_GPULight) * clusters->lightCapacity, BE_MEMORY_RENDER);
         }
+
+        unsigned int index = (unsigned int)clusters->lightCount++;
+        BE_GPULight* gpu = &clusters->lights[index];
+        BE_LightPackGPU(vec, light, gpu);
+        float range = gpu->position[3];
+
+        glm_mat4_mulv3(camera->viewMatrix, light->position, 1.0f, center);
+        glm_mat4_mulv3(camera->viewMatrix, gpu->direction, 0.0f, direction);
+        BE_LightClustersBinLight(clusters, index, center, range, direction, glm_clamp(light->outerCone, 0.0f, 1.0f), light->type == BE_LIGHT_SPOT);
     }
 
+    BE_LightClustersUpload(clusters, ring);
 }
 
 void BE_LightVectorUpload(BE_LightVector* vec, BE_Shader* shader) {
@@ -2321,6 +3405,8 @@ void BE_LightVectorUpload(BE_LightVector* vec, BE_Shader* shader) {
 
     int numLights[3] = {0, 0, 0};
     
+    BE_RENDER_COUNT(uniformUploads, 4);
+    BE_RENDER_COUNT(textureBinds, 3);
     glUniform1f(glGetUniformLocation(shader->ID, "ambient"), vec->ambient);
     
     glActiveTexture(GL_TEXTURE0 + 3);
@@ -2328,7 +3414,7 @@ void BE_LightVectorUpload(BE_LightVector* vec, BE_Shader* shader) {
     glUniform1i(glGetUniformLocation(shader->ID, "directShadowMapArray"), 3);
     
     glActiveTexture(GL_TEXTURE0 + 4);
-    glBindTexture(GL_TEXTURE_2D_ARRAY, vec->pointShadowFBO.depthTextureArray);
+    glBindTexture(GL_TEXTURE_CUBE_MAP_ARRAY, vec->pointShadowFBO.depthTextureArray);
     glUniform1i(glGetUniformLocation(shader->ID, "pointShadowMapArray"), 4);
     
     glActiveTexture(GL_TEXTURE0 + 5);
@@ -2342,6 +3428,7 @@ void BE_LightVectorUpload(BE_LightVector* vec, BE_Shader* shader) {
 
         switch (vec->data[i].type) {
             case BE_LIGHT_DIRECT:
+                BE_RENDER_COUNT(uniformUploads, 4);
                 snprintf(buffer, sizeof(buffer), "directlights[%d].direction", numLights[light->type]);
                 glUniform3fv(glGetUniformLocation(shader->ID, buffer), 1, (float*)light->direction);
                 snprintf(buffer, sizeof(buffer), "directlights[%d].color", numLights[light->type]);
@@ -2350,39 +3437,11 @@ void BE_LightVectorUpload(BE_LightVector* vec, BE_Shader* shader) {
                 glUniform1f(glGetUniformLocation(shader->ID, buffer), light->specular);
                 snprintf(buffer, sizeof(buffer), "directlights[%d].lightSpaceMatrix", numLights[light->type]);
                 glUniformMatrix4fv(glGetUniformLocation(shader->ID, buffer), 1, GL_FALSE, (float*)light->lightSpaceMatrix);
-             
-                break;
-            case BE_LIGHT_POINT:
-                snprintf(buffer, sizeof(buffer), "pointlights[%d].position", numLights[light->type]);
-                glUniform3fv(glGetUniformLocation(shader->ID, buffer), 1, (float*)light->position);
-                snprintf(buffer, sizeof(buffer), "pointlights[%d].color", numLights[light->type]);
-                glUniform4fv(glGetUniformLocation(shader->ID, buffer), 1, (float*)light->color);
-                snprintf(buffer, sizeof(buffer), "pointlights[%d].specular", numLights[light->type]);
-                glUniform1f(glGetUniformLocation(shader->ID, buffer), light->specular);
-                snprintf(buffer, sizeof(buffer), "pointlights[%d].a", numLights[light->type]);
-                glUniform1f(glGetUniformLocation(shader->ID, buffer), light->a);
-                snprintf(buffer, sizeof(buffer), "pointlights[%d].b", numLights[light->type]);
-                glUniform1f(glGetUniformLocation(shader->ID, buffer), light->b);
-                snprintf(buffer, sizeof(buffer), "pointlights[%d].lightSpaceMatrix", numLights[light->type]);
-                glUniformMatrix4fv(glGetUniformLocation(shader->ID, buffer), 1, GL_FALSE, (float*)light->lightSpaceMatrix);
-
-                break;
-            case BE_LIGHT_SPOT:
-                snprintf(buffer, sizeof(buffer), "spotlights[%d].position", numLights[light->type]);
-                glUniform3fv(glGetUniformLocation(shader->ID, buffer), 1, (float*)light->position);
-                snprintf(buffer, sizeof(buffer), "spotlights[%d].direction", numLights[light->type]);
-                glUniform3fv(glGetUniformLocation(shader->ID, buffer), 1, (float*)light->direction);
-                snprintf(buffer, sizeof(buffer), "spotlights[%d].color", numLights[light->type]);
-                glUniform4fv(glGetUniformLocation(shader->ID, buffer), 1, (float*)light->color);
-                snprintf(buffer, sizeof(buffer), "spotlights[%d].specular", numLights[light->type]);
-                glUniform1f(glGetUniformLocation(shader->ID, buffer), light->specular);
-                snprintf(buffer, sizeof(buffer), "spotlights[%d].innerCone", numLights[light->type]);
-                glUniform1f(glGetUniformLocation(shader->ID, buffer), light->innerCone);
-                snprintf(buffer, sizeof(buffer), "spotlights[%d].outerCone", numLights[light->type]);
-                glUniform1f(glGetUniformLocation(shader->ID, buffer), light->outerCone);
-                snprintf(buffer, sizeof(buffer), "spotlights[%d].lightSpaceMatrix", numLights[light->type]);
-                glUniformMatrix4fv(glGetUniformLocation(shader->ID, buffer), 1, GL_FALSE, (float*)light->lightSpaceMatrix);
-
+             
+                break;
+            case BE_LIGHT_POINT:
+            case BE_LIGHT_SPOT:
+                // clustered, packed by BE_LightVectorUpdateClusters
                 break;
             default:
                 break;
@@ -2391,11 +3450,17 @@ void BE_LightVectorUpload(BE_LightVector* vec, BE_Shader* shader) {
         numLights[light->type]+=1;
     }
 
-    for (int i = 0; i < 3; i++) {
-        glUniform1i(glGetUniformLocation(shader->ID, "numDirects"), (int)numLights[0]);
-        glUniform1i(glGetUniformLocation(shader->ID, "numPoints"), (int)numLights[1]);
-        glUniform1i(glGetUniformLocation(shader->ID, "numSpots"), (int)numLights[2]);
+    BE_RENDER_COUNT(uniformUploads, 8);
+    glUniform1i(glGetUniformLocation(shader->ID, "numDirects"), (int)numLights[0]);
+
+    BE_StreamAlloc* ranges[3] = {&vec->clusters.lightRange, &vec->clusters.gridRange, &vec->clusters.indexRange};
+    for (GLuint i = 0; i < 3; i++) {
+        glBindBufferRange(GL_SHADER_STORAGE_BUFFER, i, ranges[i]->buffer, ranges[i]->offset, ranges[i]->size);
     }
+    glUniformMatrix4fv(glGetUniformLocation(shader->ID, "viewMatrix"), 1, GL_FALSE, (float*)vec->clusters.viewMatrix);
+    glUniform2fv(glGetUniformLocation(shader->ID, "clusterScreen"), 1, (float*)vec->clusters.screen);
+    glUniform1f(glGetUniformLocation(shader->ID, "clusterNear"), vec->clusters.nearPlane);
+    glUniform1f(glGetUniformLocation(shader->ID, "clusterFar"), vec->clusters.farPlane);
 
 }
 
@@ -2429,9 +3494,11 @@ void BE_LightVectorDraw(BE_LightVector* vec, BE_Mesh* mesh, BE_Shader* shader) {
                 continue;
         }
         
+        BE_RENDER_COUNT(uniformUploads, 2);
         glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
         glUniform3fv(glGetUniformLocation(shader->ID, "color"), 1, (float*)light->color);
         BE_VAOBind(&mesh->vao);
+        BE_RENDER_COUNT_DRAW(mesh->indices.size);
         glDrawElements(GL_TRIANGLES, mesh->indices.size, GL_UNSIGNED_INT, 0);
     }
 
@@ -2444,7 +3511,7 @@ void BE_LightVectorDraw(BE_LightVector* vec, BE_Mesh* mesh, BE_Shader* shader) {
 BE_Sprite BE_SpriteInit(const char* name, BE_Texture* texture, vec3 position, vec2 scale, vec3 color, float rotation) {
     BE_Sprite sprite = {0};
     
-    sprite.name = strdup(name ? name : "new sprite");
+    sprite.name = BE_MemStrdup(name ? name : "new sprite", BE_MEMORY_SCENE);
 
     glm_vec3_copy(position, sprite.position);
     glm_vec2_copy(scale, sprite.scale);
@@ -2456,26 +3523,52 @@ BE_Sprite BE_SpriteInit(const char* name, BE_Texture* texture, vec3 position, ve
     return sprite;
 }
 
-#define INITIAL_SPRITE_CAPACITY 4
+#define INITIAL_SPRITE_BATCH 1024
 
 void BE_SpriteVectorInit(BE_SpriteVector* vec) {
-    vec->data = (BE_Sprite*)malloc(sizeof(BE_Sprite) * INITIAL_SPRITE_CAPACITY);
+    memset(vec, 0, sizeof(BE_SpriteVector));
+    vec->data = NULL;
     vec->size = 0;
-    vec->capacity = INITIAL_SPRITE_CAPACITY;
+    vec->capacity = 0;
+    BE_RegistryInit(&vec->registry);
+
+    vec->vao = BE_VAOInit("sprite batch");
+    BE_VAOBind(&vec->vao);
+    vec->vbo = BE_VBOInitFromData(NULL, 0);
+
+    // Attributes read from binding 0, which is pointed at the stream ring each draw
+    glVertexAttribFormat(0, 3, GL_FLOAT, GL_FALSE, offsetof(BE_SpriteVertex, position));
+    glVertexAttribFormat(1, 2, GL_FLOAT, GL_FALSE, offsetof(BE_SpriteVertex, texCoord));
+    glVertexAttribFormat(2, 3, GL_FLOAT, GL_FALSE, offsetof(BE_SpriteVertex, color));
+    for (GLuint attrib = 0; attrib < 3; attrib++) {
+        glVertexAttribBinding(attrib, 0);
+        glEnableVertexAttribArray(attrib);
+    }
+    vec->ebo = BE_EBOInitFromData(NULL, 0);
+    BE_VAOUnbind();
+    BE_EBOUnbind();
 
-    vec->vao = BE_VAOInitSprite(NULL);
+    BE_SpriteVectorReserveBatch(vec, INITIAL_SPRITE_BATCH);
 }
 
 void BE_SpriteVectorPush(BE_SpriteVector* vec, BE_Sprite value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Sprite*)realloc(vec->data, sizeof(BE_Sprite) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    BE_RegistryAdd(&vec->registry, value.name, vec->size);
+    *BE_SpriteVectorEmplace(vec, 1) = value;
 }
 
 void BE_SpriteVectorFree(BE_SpriteVector* vec) {
-    free(vec->data);
+    BE_MemFree(vec->vertices);
+    BE_MemFree(vec->visible);
+    BE_MemFree(vec->runTextures);
+    BE_MemFree(vec->runEnds);
+    vec->vertices = NULL;
+    vec->visible = NULL;
+    vec->runTextures = NULL;
+    vec->runEnds = NULL;
+    vec->batchCapacity = vec->scratchCapacity = vec->runCapacity = 0;
+
+    BE_RegistryFree(&vec->registry);
+    BE_MemFree(vec->data);
     vec->data = NULL;
     vec->size = 0;
     vec->capacity = 0;
@@ -2483,12 +3576,58 @@ void BE_SpriteVectorFree(BE_SpriteVector* vec) {
 
 void BE_SpriteVectorCopy(BE_Sprite* sprites, size_t count, BE_SpriteVector* outVec) {
     BE_SpriteVectorInit(outVec);
+    BE_SpriteVectorReserve(outVec, count);
     for (size_t i = 0; i < count; i++) {
         BE_SpriteVectorPush(outVec, sprites[i]);
     }
 }
 
-void BE_SpriteVectorDraw(BE_SpriteVector* vec, BE_Shader* shader) {
+void BE_SpriteVectorRemove(BE_SpriteVector* vec, BE_Sprite* sprite) {
+    if (!vec || !sprite) return;
+
+    size_t index = BE_SpriteVectorIndexOf(vec, sprite);
+    if (index == SIZE_MAX) return;
+
+    BE_RegistryRemoveSwap(&vec->registry, index, vec->size);
+    BE_SpriteVectorRemoveSwap(vec, index);
+}
+
+void BE_SpriteVectorReserveBatch(BE_SpriteVector* vec, size_t quads) {
+    if (quads <= vec->batchCapacity) return;
+
+    size_t capacity = vec->batchCapacity ? vec->batchCapacity : INITIAL_SPRITE_BATCH;
+    while (capacity < quads) capacity *= 2;
+
+    vec->vertices = (BE_SpriteVertex*)BE_MemRealloc(vec->vertices, sizeof(BE_SpriteVertex) * 4 * capacity, BE_MEMORY_RENDER);
+
+    // Quad indices never change, only the vertex buffer is streamed
+    GLuint* indices = (GLuint*)BE_MemAlloc(sizeof(GLuint) * 6 * capacity, BE_MEMORY_RENDER);
+    for (size_t q = 0; q < capacity; q++) {
+        GLuint base = (GLuint)(q * 4);
+        indices[q * 6 + 0] = base + 0;
+        indices[q * 6 + 1] = base + 1;
+        indices[q * 6 + 2] = base + 2;
+        indices[q * 6 + 3] = base + 0;
+        indices[q * 6 + 4] = base + 2;
+        indices[q * 6 + 5] = base + 3;
+    }
+
+    BE_VAOBind(&vec->vao);
+    BE_EBOBind(&vec->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * 6 * capacity, indices, GL_STATIC_DRAW);
+    BE_VAOUnbind();
+    BE_EBOUnbind();
+
+    BE_GpuMemoryRelease(BE_MEMORY_RENDER, vec->ebo.bytes);
+    vec->ebo.bytes = sizeof(GLuint) * 6 * capacity;
+    BE_GpuMemoryAlloc(BE_MEMORY_RENDER, vec->ebo.bytes);
+
+    BE_MemFree(indices);
+    vec->batchCapacity = capacity;
+}
+
+void BE_SpriteVectorDraw(BE_SpriteVector* vec, BE_Shader* shader, mat4 camMatrix, BE_StreamRing* ring) {
+    BE_PROFILE_FUNCTION();
     
     BE_ShaderActivate(shader);
     
@@ -2497,26 +3636,126 @@ void BE_SpriteVectorDraw(BE_SpriteVector* vec, BE_Shader* shader) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     glEnable(GL_BLEND);
 
-    mat4 model;
+    if (vec->size == 0) return;
+
+    if (vec->scratchCapacity < vec->size) {
+        vec->scratchCapacity = vec->capacity;
+        vec->visible = (unsigned int*)BE_MemRealloc(vec->visible, sizeof(unsigned int) * vec->scratchCapacity, BE_MEMORY_RENDER);
+    }
+
+    // Visible rect in sprite space, from the NDC corners
+    mat4 inverse;
+    vec3 corner0, corner1;
+    glm_mat4_inv(camMatrix, inverse);
+    glm_mat4_mulv3(inverse, (vec3){-1.0f, -1.0f, 0.0f}, 1.0f, corner0);
+    glm_mat4_mulv3(inverse, (vec3){ 1.0f,  1.0f, 0.0f}, 1.0f, corner1);
+    float minX = fminf(corner0[0], corner1[0]);
+    float maxX = fmaxf(corner0[0], corner1[0]);
+    float minY = fminf(corner0[1], corner1[1]);
+    float maxY = fmaxf(corner0[1], corner1[1]);
+
+    // Cull with the bounding circle. Sprites keep the order they were submitted in, since with a
+    // shared depth that decides which one is on top and how blended ones mix. Consecutive sprites
+    // on the same texture become one run and one draw.
+    size_t visibleCount = 0;
+    size_t runCount = 0;
 
     for (size_t i = 0; i < vec->size; i++) {
         BE_Sprite* sprite = &vec->data[i];
 
-        glm_mat4_identity(model);
-        glm_translate(model, sprite->position);
-        glm_translate(model, (vec3){0.0f, 0.0f, 0.0f}); // optional pivot
-        glm_rotate(model, sprite->rotation, (vec3){0.0f, 0.0f, 1.0f});
-        glm_scale(model, (vec3){sprite->scale[0], sprite->scale[1], 1.0f});
+        float radius = 0.5f * sqrtf(sprite->scale[0] * sprite->scale[0] + sprite->scale[1] * sprite->scale[1]);
+        if (sprite->position[0] + radius < minX || sprite->position[0] - radius > maxX) continue;
+        if (sprite->position[1] + radius < minY || sprite->position[1] - radius > maxY) continue;
+
+        // Packed textures share their page's ID, so sprites from one page stay in the same run
+        GLuint textureID = sprite->texture ? sprite->texture->ID : 0;
+        if (runCount == 0 || vec->runTextures[runCount - 1] != textureID) {
+            if (runCount >= vec->runCapacity) {
+                vec->runCapacity = vec->runCapacity ? vec->runCapacity * 2 : 16;
+                vec->runTextures = (GLuint*)BE_MemRealloc(vec->runTextures, sizeof(GLuint) * vec->runCapacity, BE_MEMORY_RENDER);
+                vec->runEnds = (unsigned int*)BE_MemRealloc(vec->runEnds, sizeof(unsigned int) * vec->runCapacity, BE_MEMORY_RENDER);
+            }
+            vec->runTextures[runCount++] = textureID;
+        }
 
-        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
-        glUniform3fv(glGetUniformLocation(shader->ID, "spriteColor"), 1, (float*)sprite->color);
+        vec->visible[visibleCount++] = (unsigned int)i;
+        vec->runEnds[runCount - 1] = (unsigned int)visibleCount;
+    }
+
+    BE_RENDER_COUNT(visibleObjects, visibleCount);
+    BE_RENDER_COUNT(culledObjects, vec->size - visibleCount);
+    if (visibleCount == 0) return;
+
+    BE_SpriteVectorReserveBatch(vec, visibleCount);
+
+    // Write straight into the mapped ring, the scratch copy is only for a full ring
+    BE_StreamAlloc stream;
+    bool streamed = BE_StreamRingAlloc(ring, sizeof(BE_SpriteVertex) * 4 * visibleCount, sizeof(BE_SpriteVertex), &stream);
+    BE_SpriteVertex* vertices = streamed ? (BE_SpriteVertex*)stream.ptr : vec->vertices;
+
+    for (size_t k = 0; k < visibleCount; k++) {
+        BE_Sprite* sprite = &vec->data[vec->visible[k]];
+        BE_SpriteVertex* v = &vertices[k * 4];
+
+        float c = cosf(sprite->rotation);
+        float s = sinf(sprite->rotation);
+        float hx = sprite->scale[0] * 0.5f;
+        float hy = sprite->scale[1] * 0.5f;
+
+        const float corners[4][2] = {{-hx, -hy}, {hx, -hy}, {hx, hy}, {-hx, hy}};
+        float u0 = 0.0f, v0 = 0.0f, u1 = 1.0f, v1 = 1.0f;
+        if (sprite->texture) {
+            u0 = sprite->texture->atlasRect[0];
+            v0 = sprite->texture->atlasRect[1];
+            u1 = sprite->texture->atlasRect[2];
+            v1 = sprite->texture->atlasRect[3];
+        }
+        const float uvs[4][2] = {{u0, v0}, {u1, v0}, {u1, v1}, {u0, v1}};
+
+        for (int n = 0; n < 4; n++) {
+            v[n].position[0] = sprite->position[0] + corners[n][0] * c - corners[n][1] * s;
+            v[n].position[1] = sprite->position[1] + corners[n][0] * s + corners[n][1] * c;
+            v[n].position[2] = sprite->position[2];
+            v[n].texCoord[0] = uvs[n][0];
+            v[n].texCoord[1] = uvs[n][1];
+            v[n].color[0] = sprite->color[0];
+            v[n].color[1] = sprite->color[1];
+            v[n].color[2] = sprite->color[2];
+        }
+    }
 
-        BE_TextureBind(sprite->texture);
-        BE_TextureSetUniformUnit(shader, "spriteTexture", 0);
+    if (!streamed) {
+        // Orphan the previous frame's storage instead of waiting on it
+        BE_VBOBind(&vec->vbo);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(BE_SpriteVertex) * 4 * vec->batchCapacity, NULL, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(BE_SpriteVertex) * 4 * visibleCount, vec->vertices);
+        BE_VBOUnbind();
+        if (vec->vbo.bytes != sizeof(BE_SpriteVertex) * 4 * vec->batchCapacity) {
+            BE_GpuMemoryRelease(BE_MEMORY_RENDER, vec->vbo.bytes);
+            vec->vbo.bytes = sizeof(BE_SpriteVertex) * 4 * vec->batchCapacity;
+            BE_GpuMemoryAlloc(BE_MEMORY_RENDER, vec->vbo.bytes);
+        }
+        stream.buffer = vec->vbo.ID;
+        stream.offset = 0;
+    }
+
+    BE_TextureSetUniformUnit(shader, "spriteTexture", 0);
+    BE_VAOBind(&vec->vao);
+    glBindVertexBuffer(0, stream.buffer, stream.offset, sizeof(BE_SpriteVertex));
+
+    unsigned int first = 0;
+    for (size_t t = 0; t < runCount; t++) {
+        unsigned int last = vec->runEnds[t];
 
-        BE_VAOBind(&vec->vao);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+        BE_RENDER_COUNT(textureBinds, 1);
+        BE_RENDER_COUNT_DRAW((last - first) * 6);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, vec->runTextures[t]);
+        glDrawElements(GL_TRIANGLES, (GLsizei)(last - first) * 6, GL_UNSIGNED_INT, (void*)(sizeof(GLuint) * 6 * first));
+        first = last;
     }
+
+    BE_VAOUnbind();
 }
 
 // ==============================
@@ -2525,11 +3764,16 @@ void BE_SpriteVectorDraw(BE_SpriteVector* vec, BE_Shader* shader) {
 
 void BE_AudioEngineInit(BE_AudioEngine* engine) {
     FMOD_System_Create(&engine->system);
-    FMOD_System_Init(engine->system, 512, FMOD_INIT_3D_RIGHTHANDED, NULL);
+    // Without an audio device, like on a build machine, the system still runs and plays nothing
+    if (FMOD_System_Init(engine->system, 512, FMOD_INIT_3D_RIGHTHANDED, NULL) != FMOD_OK) {
+        FMOD_System_SetOutput(engine->system, FMOD_OUTPUTTYPE_NOSOUND);
+        FMOD_System_Init(engine->system, 512, FMOD_INIT_3D_RIGHTHANDED, NULL);
+    }
     FMOD_System_Set3DSettings(engine->system, 1.f, 1.f, 1.f);
 }
 
 void BE_AudioEngineUpdate(BE_AudioEngine* engine) {
+    BE_PROFILE_FUNCTION();
     FMOD_System_Update(engine->system);
 }
 
@@ -2550,8 +3794,8 @@ BE_Sound BE_SoundLoad(BE_AudioEngine* engine, const char* path, const char* name
         exit(1);
     }
 
-    sound.name = strdup(name ? name : "new sound");
-    sound.path = strdup(path ? path : "");
+    sound.name = BE_MemStrdup(name ? name : "new sound", BE_MEMORY_AUDIO);
+    sound.path = BE_MemStrdup(path ? path : "", BE_MEMORY_AUDIO);
 
     if (spatial) {
         FMOD_Sound_Set3DMinMaxDistance(sound.sound, min, max);
@@ -2561,32 +3805,57 @@ BE_Sound BE_SoundLoad(BE_AudioEngine* engine, const char* path, const char* name
     return sound;
 }
 
+// For async loads, the file was read on a loader thread. FMOD copies the data.
+bool BE_SoundLoadMemory(BE_AudioEngine* engine, const char* data, size_t size, const char* path, const char* name, bool spatial, float min, float max, BE_Sound* outSound) {
+    BE_Sound sound = {0};
+
+    FMOD_MODE mode = FMOD_DEFAULT | FMOD_OPENMEMORY;
+    if (spatial) mode |= FMOD_3D;
+    else mode |= FMOD_2D;
+
+    FMOD_CREATESOUNDEXINFO info;
+    memset(&info, 0, sizeof(info));
+    info.cbsize = sizeof(info);
+    info.length = (unsigned int)size;
+
+    if (FMOD_System_CreateSound(engine->system, data, mode, &info, &sound.sound) != FMOD_OK) {
+        BE_IMPL_Message(2, "Sound", path, 1, "Failed to load sound '%s'", name);
+        return false;
+    }
+
+    sound.name = BE_MemStrdup(name ? name : "new sound", BE_MEMORY_AUDIO);
+    sound.path = BE_MemStrdup(path ? path : "", BE_MEMORY_AUDIO);
+
+    if (spatial) {
+        FMOD_Sound_Set3DMinMaxDistance(sound.sound, min, max);
+    }
+
+    *outSound = sound;
+    return true;
+}
+
 void BE_SoundFree(BE_Sound* sound) {
     if (!sound) return;
     FMOD_Sound_Release(sound->sound);
-    free(sound->name);
-    free(sound->path);
-    free(sound);
+    BE_MemFree(sound->name);
+    BE_MemFree(sound->path);
 }
 
-#define INITIAL_SOUND_CAPACITY 8
-
 void BE_SoundVectorInit(BE_SoundVector* vec) {
-    vec->data = (BE_Sound*)malloc(sizeof(BE_Sound) * INITIAL_SOUND_CAPACITY);
+    vec->data = NULL;
     vec->size = 0;
-    vec->capacity = INITIAL_SOUND_CAPACITY;
+    vec->capacity = 0;
+    BE_RegistryInit(&vec->registry);
 }
 
 void BE_SoundVectorPush(BE_SoundVector* vec, BE_Sound value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Sound*)realloc(vec->data, sizeof(BE_Sound) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    BE_RegistryAdd(&vec->registry, value.name, vec->size);
+    *BE_SoundVectorEmplace(vec, 1) = value;
 }
 
 void BE_SoundVectorFree(BE_SoundVector* vec) {
-    free(vec->data);
+    BE_RegistryFree(&vec->registry);
+    BE_MemFree(vec->data);
     vec->data = NULL;
     vec->size = 0;
     vec->capacity = 0;
@@ -2594,6 +3863,7 @@ void BE_SoundVectorFree(BE_SoundVector* vec) {
 
 void BE_SoundVectorCopy(BE_Sound* sounds, size_t count, BE_SoundVector* outVec) {
     BE_SoundVectorInit(outVec);
+    BE_SoundVectorReserve(outVec, count);
     for (size_t i = 0; i < count; i++) {
         BE_SoundVectorPush(outVec, sounds[i]);
     }
@@ -2602,25 +3872,16 @@ void BE_SoundVectorCopy(BE_Sound* sounds, size_t count, BE_SoundVector* outVec)
 void BE_SoundVectorRemove(BE_SoundVector* vec, BE_Sound* sound) {
     if (!vec || !sound) return;
 
-    size_t index = SIZE_MAX;
-    for (size_t i = 0; i < vec->size; ++i) {
-        if (&vec->data[i] == sound) {
-            index = i;
-            break;
-        }
-    }
-
+    size_t index = BE_SoundVectorIndexOf(vec, sound);
     if (index == SIZE_MAX) return;
 
-    for (size_t i = index; i < vec->size - 1; ++i) {
-        vec->data[i] = vec->data[i + 1];
-    }
-    vec->size--;
+    BE_RegistryRemoveSwap(&vec->registry, index, vec->size);
+    BE_SoundVectorRemoveSwap(vec, index);
 }
 
 BE_Emitter BE_EmitterInit(const char* name, vec3 position, bool spatial) {
     BE_Emitter src = {0};
-    src.name = strdup(name ? name : "new source");
+    src.name = BE_MemStrdup(name ? name : "new source", BE_MEMORY_SCENE);
     glm_vec3_copy(position, src.position);
     src.gain = 1.f;
     src.pitch = 1.f;
@@ -2780,178 +4041,738 @@ void BE_EmitterSetListenerVersor(BE_AudioEngine* engine, const vec3 position, ve
     FMOD_VECTOR upv = { up[0], up[1], up[2] };
     FMOD_VECTOR velv = { velocity[0], velocity[1], velocity[2] };
 
-    FMOD_System_Set3DListenerAttributes(engine->system, 0, &posv, &velv, &forwardv, &upv);
-}
+    FMOD_System_Set3DListenerAttributes(engine->system, 0, &posv, &velv, &forwardv, &upv);
+}
+
+float BE_EmitterGetVolume(BE_Emitter* src) {
+    return src->gain;
+}
+
+float BE_EmitterGetPitch(BE_Emitter* src) {
+    return src->pitch;
+}
+
+void BE_EmitterGetPosition(BE_Emitter* src, vec3 dest) {
+    glm_vec3_copy(src->position, dest);
+}
+
+bool BE_EmitterGetIsPlaying(BE_Emitter* src) {
+    FMOD_BOOL isPlaying = false;
+    FMOD_Channel_IsPlaying(src->channel, &isPlaying);
+    return isPlaying != 0;
+}
+
+bool BE_EmitterGetIsPaused(BE_Emitter* src) {
+    FMOD_BOOL isPaused = false;
+    FMOD_Channel_GetPaused(src->channel, &isPaused);
+    return isPaused != 0;
+}
+
+void BE_EmitterVectorInit(BE_EmitterVector* vec) {
+    vec->data = NULL;
+    vec->size = 0;
+    vec->capacity = 0;
+    BE_RegistryInit(&vec->registry);
+}
+
+void BE_EmitterVectorPush(BE_EmitterVector* vec, BE_Emitter value) {
+    BE_RegistryAdd(&vec->registry, value.name, vec->size);
+    *BE_EmitterVectorEmplace(vec, 1) = value;
+}
+
+void BE_EmitterVectorFree(BE_EmitterVector* vec) {
+    BE_RegistryFree(&vec->registry);
+    BE_MemFree(vec->data);
+    vec->data = NULL;
+    vec->size = 0;
+    vec->capacity = 0;
+}
+
+void BE_EmitterVectorCopy(BE_Emitter* emitters, size_t count, BE_EmitterVector* outVec) {
+    BE_EmitterVectorInit(outVec);
+    BE_EmitterVectorReserve(outVec, count);
+    for (size_t i = 0; i < count; i++) {
+        BE_EmitterVectorPush(outVec, emitters[i]);
+    }
+}
+
+void BE_EmitterVectorDraw(BE_EmitterVector* vec, BE_Mesh* mesh, BE_Shader* shader) {
+
+    BE_ShaderActivate(shader);
+    
+    glEnable(GL_DEPTH_TEST);
+    glEnable(GL_CULL_FACE);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+    glEnable(GL_BLEND);
+
+    vec3 scale = { 0.2f, 0.2f, 0.2f };
+    mat4 model;
+
+    for (size_t i = 0; i < vec->size; i++) {
+        BE_Emitter* source = &vec->data[i];
+        
+        BE_MakeModelMatrix(source->position, (vec3){0.0f, 0.0f, 0.0f}, scale, model);
+        BE_RENDER_COUNT(uniformUploads, 2);
+        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
+        glUniform3fv(glGetUniformLocation(shader->ID, "color"), 1, (float*)(vec3){1,1,1});
+        BE_MeshDraw(mesh, shader);
+    }
+
+}
+
+void BE_EmitterVectorRemove(BE_EmitterVector* vec, BE_Emitter* emitter) {
+    if (!vec || !emitter) return;
+
+    size_t index = BE_EmitterVectorIndexOf(vec, emitter);
+    if (index == SIZE_MAX) return;
+
+    BE_RegistryRemoveSwap(&vec->registry, index, vec->size);
+    BE_EmitterVectorRemoveSwap(vec, index);
+}
+
+// ==============================
+// Scene
+// ==============================
+
+BE_Scene BE_SceneInit(const char* name) {
+    BE_Scene scene;
+    scene.name = BE_MemStrdup(name ? name : "new scene", BE_MEMORY_SCENE);
+    scene.activeCamera = NULL;
+    scene.renderScene = NULL;
+    BE_SceneInitWorld(&scene);
+    BE_CameraVectorInit(&scene.cameras);
+    BE_LightVectorInit(&scene.lights);
+    BE_ModelVectorInit(&scene.models);
+    BE_SpriteVectorInit(&scene.sprites);
+    BE_EmitterVectorInit(&scene.emitters);
+    return scene;
+}
+
+// The render thread's copy of owner: no ECS world, and the owner's shadow maps and cluster SSBOs
+BE_Scene BE_SceneInitRender(BE_Scene* owner) {
+    BE_Scene scene;
+    scene.name = BE_MemStrdup(owner->name, BE_MEMORY_SCENE);
+    scene.activeCamera = NULL;
+    scene.renderScene = NULL;
+    scene.world = NULL;
+    BE_CameraVectorInit(&scene.cameras);
+    BE_LightVectorInitShared(&scene.lights, &owner->lights);
+    BE_ModelVectorInit(&scene.models);
+    BE_SpriteVectorInit(&scene.sprites);
+    BE_EmitterVectorInit(&scene.emitters);
+    return scene;
+}
+
+// Needs the GL context, and the render thread idle when it has drawn the scene
+void BE_SceneFree(BE_Scene* scene) {
+    if (scene->renderScene) {
+        BE_SceneFree(scene->renderScene);
+        BE_MemFree(scene->renderScene);
+        scene->renderScene = NULL;
+    }
+
+    BE_ModelVectorFree(&scene->models);
+    BE_LightVectorFree(&scene->lights);
+    BE_CameraVectorFree(&scene->cameras);
+    BE_SpriteVectorFree(&scene->sprites);
+    BE_EmitterVectorFree(&scene->emitters);
+    if (scene->world) BE_WorldFree(scene->world);
+    BE_MemFree(scene->world);
+    BE_MemFree(scene->name);
+    scene->world = NULL;
+    scene->name = NULL;
+    scene->activeCamera = NULL;
+}
+
+void BE_SceneInitWorld(BE_Scene* scene) {
+    scene->world = (BE_World*)BE_MemAlloc(sizeof(BE_World), BE_MEMORY_SCENE);
+    BE_WorldInit(scene->world);
+
+    // Registered in BE_ComponentType order
+    BE_WorldRegisterComponent(scene->world, "Transform", sizeof(BE_Transform), _Alignof(BE_Transform));
+    BE_WorldRegisterComponent(scene->world, "MeshRenderer", sizeof(BE_MeshRenderer), _Alignof(BE_MeshRenderer));
+    BE_WorldRegisterComponent(scene->world, "Light", sizeof(BE_LightComponent), _Alignof(BE_LightComponent));
+    BE_WorldRegisterComponent(scene->world, "Camera", sizeof(BE_CameraComponent), _Alignof(BE_CameraComponent));
+    BE_WorldRegisterComponent(scene->world, "Sprite", sizeof(BE_SpriteComponent), _Alignof(BE_SpriteComponent));
+    BE_WorldRegisterComponent(scene->world, "AudioEmitter", sizeof(BE_AudioEmitterComponent), _Alignof(BE_AudioEmitterComponent));
+}
+
+// Entity for an object just pushed to one of the scene's vectors, the component holds its handle
+BE_Entity BE_SceneAddEntity(BE_Scene* scene, int component, BE_Handle handle) {
+    BE_Entity entity = BE_WorldCreate(scene->world, BE_COMPONENT_BIT(component));
+    BE_Handle* data = (BE_Handle*)BE_WorldWrite(scene->world, entity, component);
+    if (data) *data = handle;
+    return entity;
+}
+
+// Mirrors a model's local transform into its entity, the model stays the one the renderer reads
+void BE_SceneUpdateModelEntity(BE_Scene* scene, BE_Model* model) {
+    BE_Transform* transform = (BE_Transform*)BE_WorldWrite(scene->world, model->entity, BE_COMPONENT_TRANSFORM);
+    if (transform) *transform = model->transform;
+}
+
+// Copies what the simulation authored into the render thread's scene. Render side state
+// (GL objects, world matrices, shadow caches, clusters) stays where it is.
+void BE_SceneSync(BE_Scene* dst, BE_Scene* src) {
+    BE_PROFILE_FUNCTION();
+    BE_ModelVectorSync(&dst->models, &src->models);
+    BE_LightVectorSync(&dst->lights, &src->lights);
+    BE_CameraVectorSync(&dst->cameras, &src->cameras);
+    BE_SpriteVectorSync(&dst->sprites, &src->sprites);
+    BE_EmitterVectorSync(&dst->emitters, &src->emitters);
+
+    size_t activeCamera = BE_PoolIndex(&src->cameras.pool, src->activeCamera);
+    dst->activeCamera = activeCamera != SIZE_MAX ? BE_CameraVectorAt(&dst->cameras, activeCamera) : NULL;
+}
+
+void BE_ModelVectorSync(BE_ModelVector* dst, BE_ModelVector* src) {
+    BE_ModelVectorReserve(dst, src->capacity);
+
+    // Added or removed models shift indices, so start over like a fresh vector
+    bool rebuild = dst->size != src->size || dst->syncedStructure != src->structureEpoch;
+
+    for (size_t i = 0; i < src->size; i++) {
+        BE_Model* d = &dst->data[i];
+        BE_Model* s = &src->data[i];
+
+        if (rebuild) {
+            *d = *s;
+            d->dirty = true;
+            d->cachedMesh = NULL;
+        } else {
+            if (s->dirty) {
+                d->transform = s->transform;
+                d->dirty = true;
+            }
+            if (d->parent != s->parent) {
+                d->parent = s->parent;
+                d->dirty = true;
+                dst->hierarchyDirty = true;
+            }
+            d->mesh = s->mesh;
+        }
+        s->dirty = false;
+    }
+
+    if (rebuild) {
+        dst->size = src->size;
+        dst->hierarchyDirty = true;
+        dst->structureEpoch = ++dst->epoch;
+        dst->syncedStructure = src->structureEpoch;
+    }
+}
+
+void BE_LightVectorSync(BE_LightVector* dst, BE_LightVector* src) {
+    BE_LightVectorReserve(dst, src->capacity);
+
+    for (size_t i = 0; i < src->size; i++) {
+        BE_Light light = src->data[i];
+
+        // Matrices and the shadow cache are computed on the render side
+        if (i < dst->size) {
+            BE_Light* d = &dst->data[i];
+            glm_mat4_copy(d->lightSpaceMatrix, light.lightSpaceMatrix);
+            light.shadowKey = d->shadowKey;
+            light.shadowEpoch = d->shadowEpoch;
+            light.shadowLayer = d->shadowLayer;
+            memcpy(light.shadowTile, d->shadowTile, sizeof(ivec4));
+        }
+
+        dst->data[i] = light;
+    }
+
+    dst->size = src->size;
+    dst->ambient = src->ambient;
+}
+
+void BE_CameraVectorSync(BE_CameraVector* dst, BE_CameraVector* src) {
+    while (dst->pool.size < src->pool.size) BE_PoolAlloc(&dst->pool);
+    while (dst->pool.size > src->pool.size) BE_PoolRelease(&dst->pool, BE_PoolAt(&dst->pool, dst->pool.size - 1));
+
+    for (size_t i = 0; i < src->pool.size; i++) {
+        *BE_CameraVectorAt(dst, i) = *BE_CameraVectorAt(src, i);
+    }
+}
+
+void BE_SpriteVectorSync(BE_SpriteVector* dst, BE_SpriteVector* src) {
+    BE_SpriteVectorAssign(dst, src->data, src->size);
+}
+
+void BE_EmitterVectorSync(BE_EmitterVector* dst, BE_EmitterVector* src) {
+    BE_EmitterVectorAssign(dst, src->data, src->size);
+}
+
+#define SCENE_PAGE_ELEMENTS 4
+
+void BE_SceneVectorInit(BE_SceneVector* vec) {
+    BE_PoolInit(&vec->pool, sizeof(BE_Scene), SCENE_PAGE_ELEMENTS, BE_MEMORY_SCENE);
+}
+
+void BE_SceneVectorPush(BE_SceneVector* vec, BE_Scene value) {
+    *(BE_Scene*)BE_PoolAlloc(&vec->pool) = value;
+}
+
+void BE_SceneVectorFree(BE_SceneVector* vec) {
+    BE_PoolFree(&vec->pool);
+}
+
+void BE_SceneVectorCopy(BE_Scene* scenes, size_t count, BE_SceneVector* outVec) {
+    BE_SceneVectorInit(outVec);
+    for (size_t i = 0; i < count; i++) {
+        BE_SceneVectorPush(outVec, scenes[i]);
+    }
+}
+
+void BE_SceneVectorRemove(BE_SceneVector* vec, BE_Scene* scene) {
+    if (!vec || !scene) return;
+    BE_PoolRelease(&vec->pool, scene);
+}
+
+
+
+
+
+
+
+
+
+
+
+// ==============================
+// Render Thread
+// ==============================
+
+// Draws take the shader by name but record and replay it as a handle, BE_HANDLE_NONE picks the draw's default
+static BE_Handle BE_DrawShaderHandle(const char* shaderName, const char* module, const char* fallback, const char* file, int line) {
+    if (!shaderName) return BE_HANDLE_NONE;
+    BE_Handle handle = BE_RegistryFind(&g_engine->resources.shaders.registry, shaderName);
+    if (!handle) BE_IMPL_Message(1, module, file, line, "Failed to find shader '%s'. Using default %s shader", shaderName, fallback);
+    return handle;
+}
+
+static BE_Shader* BE_DrawShader(BE_Engine* engine, BE_Handle handle, BE_Shader* fallback) {
+    BE_Shader* shader = handle ? BE_GetShaderPtr(&engine->resources.shaders, handle) : NULL;
+    return shader ? shader : fallback;
+}
+
+static void BE_RenderShadows(BE_Engine* engine, bool active);
+static void BE_RenderClear(BE_Engine* engine);
+static void BE_RenderModels(BE_Engine* engine, BE_Handle shaderHandle);
+static void BE_RenderLights(BE_Engine* engine, BE_Handle shaderHandle);
+static void BE_RenderCameras(BE_Engine* engine, BE_Handle shaderHandle);
+static void BE_RenderSprites(BE_Engine* engine, BE_Handle shaderHandle);
+static void BE_RenderEmitters(BE_Engine* engine, BE_Handle shaderHandle);
+
+void BE_RenderThreadMain(void* arg) {
+    BE_RenderThread* rt = (BE_RenderThread*)arg;
+
+    glfwMakeContextCurrent(rt->view.window);
+    BE_PROFILE_THREAD("render");
+
+    BE_MutexLock(&rt->mutex);
+    while (true) {
+        while (!rt->pending && !rt->borrowRequest && !rt->quit) BE_CondWait(&rt->cond, &rt->mutex);
+
+        if (rt->borrowRequest) {
+            // Hand the context over for a resource load and wait to get it back
+            glfwMakeContextCurrent(NULL);
+            rt->borrowed = true;
+            BE_CondBroadcast(&rt->cond);
+            while (rt->borrowRequest) BE_CondWait(&rt->cond, &rt->mutex);
+            rt->borrowed = false;
+            glfwMakeContextCurrent(rt->view.window);
+            continue;
+        }
+
+        if (!rt->pending) break;
+
+        // The simulation is blocked in BE_EndFrame until the copy is done
+        int index = rt->recording;
+        BE_RenderThreadSyncFrame(rt);
+        rt->synced = true;
+        BE_CondBroadcast(&rt->cond);
+        BE_MutexUnlock(&rt->mutex);
+
+        BE_RenderThreadReplay(&rt->view, &rt->frames[index]);
+
+        BE_MutexLock(&rt->mutex);
+        rt->pending = false;
+        BE_CondBroadcast(&rt->cond);
+    }
+    BE_MutexUnlock(&rt->mutex);
+
+    glfwMakeContextCurrent(NULL);
+    BE_ScratchFree();
+}
+
+void BE_RenderThreadRecord(BE_RenderThread* rt, BE_RenderCommandType type, bool active, BE_Handle shader, const char* file, int line) {
+    BE_RenderFrame* frame = &rt->frames[rt->recording];
+    if (frame->count >= RENDER_MAX_COMMANDS) {
+        BE_IMPL_Message(1, "Render", file, line, "More than %d draws recorded this frame, dropping the rest", RENDER_MAX_COMMANDS);
+        return;
+    }
+    frame->commands[frame->count++] = (BE_RenderCommand){type, active, shader, file, line};
+}
+
+void BE_RenderThreadSubmit(BE_RenderThread* rt) {
+    BE_PROFILE_FUNCTION();
+    BE_MutexLock(&rt->mutex);
+
+    while (rt->pending) BE_CondWait(&rt->cond, &rt->mutex);
+    rt->pending = true;
+    rt->synced = false;
+    BE_CondBroadcast(&rt->cond);
+
+    while (!rt->synced) BE_CondWait(&rt->cond, &rt->mutex);
+    rt->recording ^= 1;
+    rt->frames[rt->recording].count = 0;
+
+    BE_MutexUnlock(&rt->mutex);
+}
+
+// Runs on the render thread while the simulation waits
+void BE_RenderThreadSyncFrame(BE_RenderThread* rt) {
+    BE_Engine* engine = rt->engine;
+
+    // Counts of the frame replayed last, the view copy below hands them to the overlay too
+    BE_RenderStatsTake(&engine->timer.render);
+
+    BE_StreamRing stream = rt->view.stream;
+    rt->view = *engine;
+    rt->view.stream = stream;
+    rt->view.renderThread = NULL;
+    rt->view.activeScene = NULL;
+
+    BE_Scene* scene = engine->activeScene;
+    if (!scene) return;
 
-float BE_EmitterGetVolume(BE_Emitter* src) {
-    return src->gain;
-}
+    if (!scene->renderScene) {
+        scene->renderScene = (BE_Scene*)BE_MemAlloc(sizeof(BE_Scene), BE_MEMORY_RENDER);
+        *scene->renderScene = BE_SceneInitRender(scene);
+    }
+    BE_SceneSync(scene->renderScene, scene);
+    rt->view.activeScene = scene->renderScene;
+}
+
+// A headless engine has nothing to show, waiting for the GPU keeps its frame times covering the GPU work like a swap would
+static void BE_PresentFrame(BE_Engine* engine) {
+    if (engine->headless) glFinish();
+    else glfwSwapBuffers(engine->window);
+}
+
+// Runs on the render thread against its view, g_engine belongs to the simulation
+void BE_RenderThreadReplay(BE_Engine* view, BE_RenderFrame* frame) {
+    BE_PROFILE_FUNCTION();
+    BE_StreamRingBeginFrame(&view->stream);
+    BE_GpuTimerBeginFrame(view->gpuTimer);
+
+    for (size_t i = 0; i < frame->count; i++) {
+        BE_RenderCommand* cmd = &frame->commands[i];
+        switch (cmd->type) {
+            case BE_RENDER_MAKE_SHADOWS:  BE_RenderShadows(view, cmd->active); break;
+            case BE_RENDER_BEGIN_RENDER:  BE_RenderClear(view); break;
+            case BE_RENDER_DRAW_MODELS:   BE_RenderModels(view, cmd->shader); break;
+            case BE_RENDER_DRAW_LIGHTS:   BE_RenderLights(view, cmd->shader); break;
+            case BE_RENDER_DRAW_CAMERAS:  BE_RenderCameras(view, cmd->shader); break;
+            case BE_RENDER_DRAW_SPRITES:  BE_RenderSprites(view, cmd->shader); break;
+            case BE_RENDER_DRAW_EMITTERS: BE_RenderEmitters(view, cmd->shader); break;
+            default: break;
+        }
+    }
 
-float BE_EmitterGetPitch(BE_Emitter* src) {
-    return src->pitch;
+    if (view->overlay) BE_OverlayDraw(view);
+    BE_GpuTimerEndFrame(view->gpuTimer);
+    BE_StreamRingEndFrame(&view->stream);
+    BE_PresentFrame(view);
 }
 
-void BE_EmitterGetPosition(BE_Emitter* src, vec3 dest) {
-    glm_vec3_copy(src->position, dest);
-}
+// Waits for the render thread to go idle and takes the context, nests
+void BE_RenderThreadBorrowContext(BE_RenderThread* rt) {
+    if (!rt) return;
+    if (rt->borrowDepth++ > 0) return;
 
-bool BE_EmitterGetIsPlaying(BE_Emitter* src) {
-    FMOD_BOOL isPlaying = false;
-    FMOD_Channel_IsPlaying(src->channel, &isPlaying);
-    return isPlaying != 0;
-}
+    BE_MutexLock(&rt->mutex);
+    while (rt->pending) BE_CondWait(&rt->cond, &rt->mutex);
+    rt->borrowRequest = true;
+    BE_CondBroadcast(&rt->cond);
+    while (!rt->borrowed) BE_CondWait(&rt->cond, &rt->mutex);
+    BE_MutexUnlock(&rt->mutex);
 
-bool BE_EmitterGetIsPaused(BE_Emitter* src) {
-    FMOD_BOOL isPaused = false;
-    FMOD_Channel_GetPaused(src->channel, &isPaused);
-    return isPaused != 0;
+    glfwMakeContextCurrent(rt->engine->window);
 }
 
-#define INITIAL_SOURCE_CAPACITY 8
+void BE_RenderThreadReturnContext(BE_RenderThread* rt) {
+    if (!rt) return;
+    if (--rt->borrowDepth > 0) return;
 
-void BE_EmitterVectorInit(BE_EmitterVector* vec) {
-    vec->data = (BE_Emitter*)malloc(sizeof(BE_Emitter) * INITIAL_SOURCE_CAPACITY);
-    vec->size = 0;
-    vec->capacity = INITIAL_SOURCE_CAPACITY;
-}
+    glFlush();
+    glfwMakeContextCurrent(NULL);
 
-void BE_EmitterVectorPush(BE_EmitterVector* vec, BE_Emitter value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Emitter*)realloc(vec->data, sizeof(BE_Emitter) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
+    BE_MutexLock(&rt->mutex);
+    rt->borrowRequest = false;
+    BE_CondBroadcast(&rt->cond);
+    BE_MutexUnlock(&rt->mutex);
 }
 
-void BE_EmitterVectorFree(BE_EmitterVector* vec) {
-    free(vec->data);
-    vec->data = NULL;
-    vec->size = 0;
-    vec->capacity = 0;
+// ==============================
+// Async Loading
+// ==============================
+
+void BE_LoadQueuePush(BE_LoadQueue* queue, size_t value) {
+    *BE_LoadQueueEmplace(queue, 1) = value;
 }
 
-void BE_EmitterVectorCopy(BE_Emitter* emitters, size_t count, BE_EmitterVector* outVec) {
-    BE_EmitterVectorInit(outVec);
-    for (size_t i = 0; i < count; i++) {
-        BE_EmitterVectorPush(outVec, emitters[i]);
-    }
+bool BE_LoadQueuePop(BE_LoadQueue* queue, size_t* outValue) {
+    if (queue->head >= queue->size) return false;
+    *outValue = queue->data[queue->head++];
+    if (queue->head == queue->size) queue->head = queue->size = 0;
+    return true;
 }
 
-void BE_EmitterVectorDraw(BE_EmitterVector* vec, BE_Mesh* mesh, BE_Shader* shader) {
+void BE_LoaderInit(BE_Loader* loader) {
+    memset(loader, 0, sizeof(BE_Loader));
+    BE_MutexInit(&loader->mutex);
+    BE_CondInit(&loader->cond);
+    loader->budgetMs = LOADER_DEFAULT_BUDGET_MS;
 
-    BE_ShaderActivate(shader);
-    
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-    glEnable(GL_BLEND);
+    for (int i = 0; i < LOADER_THREADS; i++) {
+        if (!BE_ThreadCreate(&loader->threads[loader->threadCount], BE_LoaderThreadMain, loader)) break;
+        loader->threadCount++;
+    }
+    if (loader->threadCount == 0) BE_IMPL_Message(1, "Loader", "LOADER", 1, "Failed to start loader threads, async loads parse on submit");
+}
 
-    vec3 scale = { 0.2f, 0.2f, 0.2f };
-    mat4 model;
+void BE_LoaderFree(BE_Loader* loader) {
+    BE_MutexLock(&loader->mutex);
+    loader->quit = true;
+    BE_CondBroadcast(&loader->cond);
+    BE_MutexUnlock(&loader->mutex);
 
-    for (size_t i = 0; i < vec->size; i++) {
-        BE_Emitter* source = &vec->data[i];
-        
-        BE_MakeModelMatrix(source->position, (vec3){0.0f, 0.0f, 0.0f}, scale, model);
-        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
-        glUniform3fv(glGetUniformLocation(shader->ID, "color"), 1, (float*)(vec3){1,1,1});
-        BE_MeshDraw(mesh, shader);
+    for (int i = 0; i < loader->threadCount; i++) {
+        BE_ThreadJoin(&loader->threads[i]);
     }
 
+    for (size_t i = 0; i < loader->size; i++) {
+        BE_LoadRequestFree(loader->requests[i]);
+        BE_MemFree(loader->requests[i]);
+    }
+    BE_MemFree(loader->requests);
+    BE_MemFree(loader->waiting.data);
+    BE_MemFree(loader->parsed.data);
+
+    BE_CondFree(&loader->cond);
+    BE_MutexFree(&loader->mutex);
+}
+
+// Frees what the request carried, the request itself stays so its state can be queried
+void BE_LoadRequestFree(BE_LoadRequest* request) {
+    BE_MemFree(request->name);
+    request->name = NULL;
+    for (int i = 0; i < 4; i++) {
+        BE_MemFree(request->files[i]);
+        BE_MemFree(request->sources[i]);
+        request->files[i] = NULL;
+        request->sources[i] = NULL;
+    }
+    BE_OBJDataFree(&request->obj);
+    BE_ImageFree(&request->image);
+    BE_MemFree(request->bytes);
+    request->bytes = NULL;
 }
 
-void BE_EmitterVectorRemove(BE_EmitterVector* vec, BE_Emitter* emitter) {
-    if (!vec || !emitter) return;
+BE_LoadHandle BE_LoaderSubmit(BE_Loader* loader, BE_LoadType type, const char* name, const char* files[4], BE_LoadCallback callback, void* userData) {
+    BE_LoadRequest* request = (BE_LoadRequest*)BE_MemCalloc(1, sizeof(BE_LoadRequest), BE_MEMORY_LOADER);
+    if (!request) return -1;
 
-    size_t index = SIZE_MAX;
-    for (size_t i = 0; i < vec->size; ++i) {
-        if (&vec->data[i] == emitter) {
-            index = i;
-            break;
-        }
+    request->type = type;
+    atomic_init(&request->state, BE_LOAD_QUEUED);
+    request->name = BE_MemStrdup(name, BE_MEMORY_LOADER);
+    for (int i = 0; i < 4; i++) {
+        request->files[i] = files[i] ? BE_MemStrdup(files[i], BE_MEMORY_LOADER) : NULL;
     }
+    request->callback = callback;
+    request->userData = userData;
 
-    if (index == SIZE_MAX) return;
+    BE_MutexLock(&loader->mutex);
+    if (loader->size >= loader->capacity) {
+        loader->capacity = loader->capacity ? loader->capacity * 2 : INITIAL_LOAD_CAPACITY;
+        loader->requests = (BE_LoadRequest**)BE_MemRealloc(loader->requests, sizeof(BE_LoadRequest*) * loader->capacity, BE_MEMORY_LOADER);
+    }
+    size_t handle = loader->size++;
+    loader->requests[handle] = request;
+    loader->unfinished++;
 
-    for (size_t i = index; i < vec->size - 1; ++i) {
-        vec->data[i] = vec->data[i + 1];
+    if (loader->threadCount > 0) {
+        BE_LoadQueuePush(&loader->waiting, handle);
+        BE_CondBroadcast(&loader->cond);
     }
-    vec->size--;
-}
+    BE_MutexUnlock(&loader->mutex);
 
-// ==============================
-// Scene
-// ==============================
+    if (loader->threadCount == 0) {
+        BE_LoaderParse(request);
+        BE_MutexLock(&loader->mutex);
+        BE_LoadQueuePush(&loader->parsed, handle);
+        BE_MutexUnlock(&loader->mutex);
+    }
 
-BE_Scene BE_SceneInit(const char* name) {
-    BE_Scene scene;
-    scene.name = strdup(name ? name : "new scene");
-    BE_CameraVectorInit(&scene.cameras);
-    BE_LightVectorInit(&scene.lights);
-    BE_ModelVectorInit(&scene.models);
-    BE_SpriteVectorInit(&scene.sprites);
-    BE_EmitterVectorInit(&scene.emitters);
-    return scene;
+    return (BE_LoadHandle)handle;
 }
 
-#define INITIAL_SCENE_CAPACITY 2
+void BE_LoaderThreadMain(void* arg) {
+    BE_Loader* loader = (BE_Loader*)arg;
+    BE_PROFILE_THREAD("loader");
 
-void BE_SceneVectorInit(BE_SceneVector* vec) {
-    vec->data = (BE_Scene*)malloc(sizeof(BE_Scene) * INITIAL_SCENE_CAPACITY);
-    vec->size = 0;
-    vec->capacity = INITIAL_SCENE_CAPACITY;
-}
+    BE_MutexLock(&loader->mutex);
+    while (true) {
+        size_t index;
+        while (!loader->quit && !BE_LoadQueuePop(&loader->waiting, &index)) BE_CondWait(&loader->cond, &loader->mutex);
+        if (loader->quit) break;
 
-void BE_SceneVectorPush(BE_SceneVector* vec, BE_Scene value) {
-    if (vec->size >= vec->capacity) {
-        vec->capacity *= 2;
-        vec->data = (BE_Scene*)realloc(vec->data, sizeof(BE_Scene) * vec->capacity);
-    }
-    vec->data[vec->size++] = value;
-}
+        BE_LoadRequest* request = loader->requests[index];
+        BE_MutexUnlock(&loader->mutex);
 
-void BE_SceneVectorFree(BE_SceneVector* vec) {
-    free(vec->data);
-    vec->data = NULL;
-    vec->size = 0;
-    vec->capacity = 0;
-}
+        atomic_store(&request->state, BE_LOAD_LOADING);
+        BE_LoaderParse(request);
 
-void BE_SceneVectorCopy(BE_Scene* scenes, size_t count, BE_SceneVector* outVec) {
-    BE_SceneVectorInit(outVec);
-    for (size_t i = 0; i < count; i++) {
-        BE_SceneVectorPush(outVec, scenes[i]);
+        BE_MutexLock(&loader->mutex);
+        BE_LoadQueuePush(&loader->parsed, index);
     }
+    BE_MutexUnlock(&loader->mutex);
+    BE_ScratchFree();
 }
 
-void BE_SceneVectorRemove(BE_SceneVector* vec, BE_Scene* scene) {
-    if (!vec || !scene) return;
-
-    size_t index = SIZE_MAX;
-    for (size_t i = 0; i < vec->size; ++i) {
-        if (&vec->data[i] == scene) {
-            index = i;
+// File I/O and decoding only, runs on a loader thread
+void BE_LoaderParse(BE_LoadRequest* request) {
+    BE_PROFILE_FUNCTION();
+    switch (request->type) {
+        case BE_LOAD_MESH:
+            request->failed = !BE_ParseOBJ(request->files[0], &request->obj) || !BE_OBJDataLoadImage(&request->obj);
+            break;
+        case BE_LOAD_TEXTURE:
+            request->failed = !BE_ImageLoadForAtlas(request->files[0], &request->image);
+            break;
+        case BE_LOAD_SOUND:
+            request->bytes = BE_GetFileBytes(request->files[0], &request->byteCount);
+            if (!request->bytes) {
+                BE_IMPL_Message(2, "Sound", request->files[0], 1, "Failed to read sound '%s'", request->name);
+                request->failed = true;
+            }
+            break;
+        case BE_LOAD_SHADER:
+            for (int i = 0; i < 4; i++) {
+                if (!request->files[i]) continue;
+                request->sources[i] = BE_GetFileContents(request->files[i]);
+                if (!request->sources[i]) {
+                    BE_IMPL_Message(2, "Shader", request->files[i], 1, "Failed to read shader source for '%s'", request->name);
+                    request->failed = true;
+                }
+            }
+            break;
+        default:
+            request->failed = true;
             break;
-        }
     }
+}
 
-    if (index == SIZE_MAX) return;
+// Creates the GL and FMOD objects on the owning thread. Placeholders are replaced in place,
+// so models and sprites that already point at them pick up the real resource.
+bool BE_LoaderFinalize(BE_LoadRequest* request) {
+    BE_PROFILE_FUNCTION();
+    if (request->failed) return false;
+
+    BE_Resources* resources = &g_engine->resources;
 
-    for (size_t i = index; i < vec->size - 1; ++i) {
-        vec->data[i] = vec->data[i + 1];
+    switch (request->type) {
+        case BE_LOAD_MESH: {
+            BE_Mesh loaded = BE_MeshInitFromOBJData(request->name, &request->obj);
+            BE_Mesh* mesh = BE_FindMeshPtr(&resources->meshes, request->name);
+            if (!mesh) {
+                BE_MeshVectorPush(&resources->meshes, loaded);
+            } else {
+                // Placeholders share the cube's buffers, a mesh loaded twice owns its own
+                if (mesh->vao.ID != resources->defaultCubeMesh.vao.ID) BE_MeshDelete(mesh);
+                else BE_MemFree(mesh->name);
+                *mesh = loaded;
+
+                // Bounds come from the mesh, rebuild them for every model using it
+                for (size_t i = 0; i < g_engine->scenes.pool.size; i++) {
+                    BE_ModelVector* models = &BE_SceneVectorAt(&g_engine->scenes, i)->models;
+                    for (size_t m = 0; m < models->size; m++) {
+                        if (models->data[m].mesh == mesh) BE_ModelMarkDirty(&models->data[m]);
+                    }
+                }
+            }
+            BE_IMPL_Message(0, "Mesh", request->files[0], 1, "Mesh '%s' loaded successfully", request->name);
+            return true;
+        }
+        case BE_LOAD_TEXTURE: {
+            BE_Texture loaded = BE_TextureInitAtlasFromImage(request->name, &request->image, &resources->atlas);
+            BE_Texture* texture = BE_FindTexturePtr(&resources->textures, request->name);
+            if (!texture) {
+                BE_TextureVectorPush(&resources->textures, loaded);
+            } else {
+                BE_MemFree(texture->name);
+                BE_MemFree(texture->type);
+                *texture = loaded;
+            }
+            return true;
+        }
+        case BE_LOAD_SOUND: {
+            BE_Sound sound;
+            if (!BE_SoundLoadMemory(&g_engine->audio, request->bytes, request->byteCount, request->files[0], request->name, true, 1.0f, 5.0f, &sound)) return false;
+            BE_SoundVectorPush(&resources->sounds, sound);
+            return true;
+        }
+        case BE_LOAD_SHADER: {
+            BE_Shader shader = BE_ShaderInitString(request->name, request->sources[0], request->sources[1], request->sources[2], request->sources[3]);
+            GLint linked;
+            glGetProgramiv(shader.ID, GL_LINK_STATUS, &linked);
+            if (linked == GL_FALSE) {
+                glDeleteProgram(shader.ID);
+                BE_MemFree(shader.name);
+                return false;
+            }
+            BE_ShaderVectorPush(&resources->shaders, shader);
+            return true;
+        }
+        default:
+            return false;
     }
-    vec->size--;
 }
 
+// Called from BE_BeginFrame. Finalizes parsed loads until the budget runs out, at least one per call.
+void BE_LoaderUpdate(BE_Loader* loader) {
+    BE_PROFILE_FUNCTION();
+    BE_MutexLock(&loader->mutex);
+    bool parsed = loader->parsed.head < loader->parsed.size;
+    BE_MutexUnlock(&loader->mutex);
+    if (!parsed) return;
 
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
 
+    uint64_t start = BE_ThreadClockNs();
+    uint64_t budget = (uint64_t)(loader->budgetMs * 1e6);
 
+    do {
+        size_t index;
+        BE_MutexLock(&loader->mutex);
+        bool popped = BE_LoadQueuePop(&loader->parsed, &index);
+        BE_MutexUnlock(&loader->mutex);
+        if (!popped) break;
 
+        BE_LoadRequest* request = loader->requests[index];
+        BE_LoadState state = BE_LoaderFinalize(request) ? BE_LOAD_READY : BE_LOAD_FAILED;
+        if (state == BE_LOAD_FAILED) BE_IMPL_Message(2, "Loader", request->files[0] ? request->files[0] : "LOADER", 1, "Failed to load '%s'", request->name);
 
+        BE_LoadRequestFree(request);
+        atomic_store(&request->state, state);
+        loader->unfinished--;
 
+        if (request->callback) request->callback((BE_LoadHandle)index, state, request->userData);
+    } while (BE_ThreadClockNs() - start < budget);
 
-
-
+    BE_RenderThreadReturnContext(g_engine->renderThread);
+}
 
 // ==============================
 // Engine
@@ -2964,13 +4785,56 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     engine->width = width;
     engine->height = height;
 
+    // The render thread picks the size up with the next frame
+    if (engine->renderThread) return;
+
     glViewport(0, 0, width, height);
 
     BE_FBOResize(&engine->FBOs[0], width, height);
     BE_FBOResize(&engine->FBOs[1], width, height);
 }
 
-BE_Engine BE_IMPL_EngineStart(const char* title, int width, int height, const char* file, int line) {
+// EGL first, surfaceless on a GPU driver or Mesa's software rasterizer, then OSMesa
+static GLFWwindow* BE_CreateHeadlessWindow(int width, int height, const char* title) {
+    static const int apis[] = { GLFW_EGL_CONTEXT_API, GLFW_OSMESA_CONTEXT_API };
+    for (int i = 0; i < 2; i++) {
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, apis[i]);
+        GLFWwindow* window = glfwCreateWindow(width, height, title, NULL, NULL);
+        if (window) return window;
+    }
+    return NULL;
+}
+
+// Stands in for the window's back buffer, nothing reads it back
+static void BE_OffscreenInit(BE_Engine* engine, const char* file, int line) {
+    glGenFramebuffers(1, &engine->offscreenFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, engine->offscreenFBO);
+    glGenRenderbuffers(2, engine->offscreenTargets);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, engine->offscreenTargets[0]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, engine->width, engine->height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, engine->offscreenTargets[0]);
+    glBindRenderbuffer(GL_RENDERBUFFER, engine->offscreenTargets[1]);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, engine->width, engine->height);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, engine->offscreenTargets[1]);
+    BE_GpuMemoryAlloc(BE_MEMORY_RENDER, BE_FBOBytes(engine->width, engine->height));
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        BE_IMPL_Message(2, "Engine", file, line, "Offscreen framebuffer is not complete");
+    }
+    defaultFramebuffer = engine->offscreenFBO;
+}
+
+static void BE_OffscreenFree(BE_Engine* engine) {
+    if (!engine->offscreenFBO) return;
+    glDeleteFramebuffers(1, &engine->offscreenFBO);
+    glDeleteRenderbuffers(2, engine->offscreenTargets);
+    BE_GpuMemoryRelease(BE_MEMORY_RENDER, BE_FBOBytes(engine->width, engine->height));
+    engine->offscreenFBO = 0;
+    defaultFramebuffer = 0;
+}
+
+static BE_Engine BE_EngineStart(const char* title, int width, int height, bool headless, const char* file, int line) {
     
     BE_Engine engine;
     // BE_Engine* p_engine;
@@ -2979,8 +4843,13 @@ BE_Engine BE_IMPL_EngineStart(const char* title, int width, int height, const ch
     engine.width = width;
     engine.height = height;
     engine.running = true;
-    engine.title = title ? strdup(title) : strdup("Ballistic Engine");
+    engine.headless = headless;
+    engine.offscreenFBO = 0;
+    engine.renderThread = NULL;
+    engine.title = title ? BE_MemStrdup(title, BE_MEMORY_GENERAL) : BE_MemStrdup("Ballistic Engine", BE_MEMORY_GENERAL);
     
+    // The null platform needs no display, its windows only carry the context
+    if (headless) glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
     glfwInit();
 
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
@@ -2991,9 +4860,10 @@ BE_Engine BE_IMPL_EngineStart(const char* title, int width, int height, const ch
 #endif
     glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
 
-    engine.window = glfwCreateWindow(engine.width, engine.height, engine.title, NULL, NULL);
+    engine.window = headless ? BE_CreateHeadlessWindow(engine.width, engine.height, engine.title)
+                             : glfwCreateWindow(engine.width, engine.height, engine.title, NULL, NULL);
     if (!engine.window) {
-        BE_IMPL_Message(2, "Engine", file, line, "Failed to create GLFW window");
+        BE_IMPL_Message(2, "Engine", file, line, headless ? "Failed to create an offscreen OpenGL 4.6 context (EGL or OSMesa)" : "Failed to create GLFW window");
         glfwTerminate();
         exit(1);
     }
@@ -3003,12 +4873,35 @@ BE_Engine BE_IMPL_EngineStart(const char* title, int width, int height, const ch
         BE_IMPL_Message(2, "Engine", file, line, "Failed to initialize GLAD");
         exit(1);
     }
+    if (headless) BE_OffscreenInit(&engine, file, line);
     
+    BE_StreamRingInit(&engine.stream, STREAM_REGION_SIZE);
+    BE_ArenaInit(&engine.frame, FRAME_ARENA_SIZE);
+    BE_FrameStatsInit(&engine.timer);
+    BE_ProfileInit();
+    BE_PROFILE_THREAD("main");
+    engine.gpuTimer = (BE_GpuTimer*)BE_MemAlloc(sizeof(BE_GpuTimer), BE_MEMORY_RENDER);
+    BE_GpuTimerInit(engine.gpuTimer);
+    engine.profileSpikeMs = 0.0f;
+    engine.profileSpikePath = NULL;
+    engine.overlay = false;
+
+    engine.loader = (BE_Loader*)BE_MemAlloc(sizeof(BE_Loader), BE_MEMORY_GENERAL);
+    BE_LoaderInit(engine.loader);
+
+    engine.jobs = (BE_Jobs*)BE_MemAlloc(sizeof(BE_Jobs), BE_MEMORY_GENERAL);
+    if (!BE_JobsInit(engine.jobs, 0)) {
+        BE_IMPL_Message(1, "Engine", file, line, "Failed to start job workers, running single threaded");
+        BE_MemFree(engine.jobs);
+        engine.jobs = NULL;
+    }
+
     BE_SceneVectorInit(&engine.scenes);
     BE_AudioEngineInit(&engine.audio);
     BE_IMPL_AddScene("scene1", file, line);
     
     BE_TextureVectorInit(&engine.resources.textures);
+    BE_TextureAtlasInit(&engine.resources.atlas, ATLAS_PAGE_SIZE);
     BE_MeshVectorInit(&engine.resources.meshes);
     BE_SoundVectorInit(&engine.resources.sounds);
     BE_ShaderVectorInit(&engine.resources.shaders);
@@ -3021,11 +4914,15 @@ BE_Engine BE_IMPL_EngineStart(const char* title, int width, int height, const ch
 
     engine.resources.default3DShader = BE_ShaderInitString("3D", BE_Default3DVert, BE_Default3DFrag, NULL, NULL);
     engine.resources.defaultDepthShader = BE_ShaderInitString("depth", BE_DefaultDepthVert, NULL, NULL, NULL);
+    engine.resources.defaultPointDepthShader = BE_ShaderInitString("point depth", BE_DefaultPointDepthVert, BE_DefaultPointDepthFrag, BE_DefaultPointDepthGeom, NULL);
     engine.resources.defaultColorShader = BE_ShaderInitString("color", BE_Default3DVert, BE_DefaultColorFrag, NULL, NULL);
     engine.resources.defaultSpriteShader= BE_ShaderInitString("sprite", BE_DefaultSpriteVert, BE_DefaultSpriteFrag, NULL, NULL);
     engine.resources.defaultCubeMesh = BE_LoadOBJFromString("cube", BE_DefaultCubeOBJ);
     engine.resources.defaultCameraMesh = BE_LoadOBJFromString("camera", BE_DefaultCameraOBJ);
 
+    unsigned char white[4] = {255, 255, 255, 255};
+    engine.resources.defaultTexture = BE_TextureInitFromImage("default", &(BE_Image){white, 1, 1, 4}, "diffuse", 0);
+
     // int fbWidth, fbHeight;
     // glfwGetFramebufferSize(engine.window, &fbWidth, &fbHeight);
     // engine.width = fbWidth;
@@ -3044,18 +4941,69 @@ BE_Engine BE_IMPL_EngineStart(const char* title, int width, int height, const ch
     glDepthFunc(GL_LESS);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
-    glfwShowWindow(engine.window);
+    if (!headless) glfwShowWindow(engine.window);
 
     // BE_IMPL_UnbindEngine();
 
     return engine;
 }
 
+BE_Engine BE_IMPL_EngineStart(const char* title, int width, int height, const char* file, int line) {
+    return BE_EngineStart(title, width, height, false, file, line);
+}
+
+BE_Engine BE_IMPL_EngineStartHeadless(const char* title, int width, int height, const char* file, int line) {
+    return BE_EngineStart(title, width, height, true, file, line);
+}
+
 void BE_IMPL_EngineShutdown(BE_Engine* engine, const char* file, int line) {
     // BE_IMPL_BindEngine(engine, __FILE__, __LINE__);
     
     if (!engine) { BE_IMPL_Message(2, "Engine", file, line, "Expected engine value cannot be NULL"); return; }
 
+    if (engine->renderThread) {
+        BE_Engine* bound = g_engine;
+        g_engine = engine;
+        BE_IMPL_StopRenderThread(file, line);
+        g_engine = bound;
+    }
+
+    // Loader threads finish the file they are on, queued loads are dropped
+    BE_LoaderFree(engine->loader);
+    BE_MemFree(engine->loader);
+    engine->loader = NULL;
+
+    if (engine->jobs) {
+        BE_JobsFree(engine->jobs);
+        BE_MemFree(engine->jobs);
+        engine->jobs = NULL;
+    }
+
+    // Scenes hold GL objects, free them while the context is still current
+    for (size_t i = 0; i < engine->scenes.pool.size; i++) BE_SceneFree(BE_SceneVectorAt(&engine->scenes, i));
+    BE_SceneVectorFree(&engine->scenes);
+    engine->activeScene = NULL;
+
+    // Meshes still waiting on their load are the cube's placeholder and own only their name
+    for (size_t i = 0; i < engine->resources.meshes.pool.size; i++) {
+        BE_Mesh* mesh = BE_MeshVectorAt(&engine->resources.meshes, i);
+        if (mesh->vao.ID != engine->resources.defaultCubeMesh.vao.ID) BE_MeshDelete(mesh);
+        else BE_MemFree(mesh->name);
+    }
+    BE_MeshVectorFree(&engine->resources.meshes);
+    BE_MeshDelete(&engine->resources.defaultCubeMesh);
+
+    BE_OverlayShutdown();
+    BE_StreamRingFree(&engine->stream);
+    BE_GpuTimerFree(engine->gpuTimer);
+    BE_MemFree(engine->gpuTimer);
+    engine->gpuTimer = NULL;
+    BE_ArenaFree(&engine->frame);
+    BE_ScratchFree();
+    BE_MemFree(engine->profileSpikePath);
+    engine->profileSpikePath = NULL;
+    BE_ProfileShutdown();
+    BE_OffscreenFree(engine);
     glfwDestroyWindow(engine->window);
     if (g_engine == engine) g_engine = NULL;
 
@@ -3072,6 +5020,65 @@ void BE_IMPL_UnbindEngine(const char* file, int line) {
     g_engine = NULL;
 }
 
+void BE_IMPL_StartRenderThread(const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    if (g_engine->renderThread) { BE_IMPL_Message(1, "Engine", file, line, "Render thread is already running"); return; }
+
+    BE_RenderThread* rt = (BE_RenderThread*)BE_MemCalloc(1, sizeof(BE_RenderThread), BE_MEMORY_RENDER);
+    BE_MutexInit(&rt->mutex);
+    BE_CondInit(&rt->cond);
+    rt->engine = g_engine;
+    rt->view = *g_engine;
+
+    // The context can only be current on one thread
+    glFinish();
+    glfwMakeContextCurrent(NULL);
+
+    if (!BE_ThreadCreate(&rt->thread, BE_RenderThreadMain, rt)) {
+        BE_IMPL_Message(2, "Engine", file, line, "Failed to start render thread, rendering stays on this thread");
+        glfwMakeContextCurrent(g_engine->window);
+        BE_CondFree(&rt->cond);
+        BE_MutexFree(&rt->mutex);
+        BE_MemFree(rt);
+        return;
+    }
+
+    g_engine->renderThread = rt;
+}
+
+void BE_IMPL_StopRenderThread(const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    BE_RenderThread* rt = g_engine->renderThread;
+    if (!rt) return;
+
+    BE_MutexLock(&rt->mutex);
+    rt->quit = true;
+    BE_CondBroadcast(&rt->cond);
+    BE_MutexUnlock(&rt->mutex);
+    BE_ThreadJoin(&rt->thread);
+
+    glfwMakeContextCurrent(g_engine->window);
+    g_engine->stream = rt->view.stream;
+    g_engine->renderThread = NULL;
+
+    // Syncing consumed the dirty flags, so rebuild every transform on this side. The render
+    // copies drew into the shadow maps both sides share, neither side's cached maps are its own.
+    for (size_t i = 0; i < g_engine->scenes.pool.size; i++) {
+        BE_Scene* scene = BE_SceneVectorAt(&g_engine->scenes, i);
+        BE_ModelVector* models = &scene->models;
+        for (size_t m = 0; m < models->size; m++) models->data[m].dirty = true;
+        for (size_t l = 0; l < scene->lights.size; l++) scene->lights.data[l].shadowEpoch = 0;
+        if (scene->renderScene) {
+            BE_LightVector* lights = &scene->renderScene->lights;
+            for (size_t l = 0; l < lights->size; l++) lights->data[l].shadowEpoch = 0;
+        }
+    }
+
+    BE_CondFree(&rt->cond);
+    BE_MutexFree(&rt->mutex);
+    BE_MemFree(rt);
+}
+
 // ==============================
 // Frames
 // ==============================
@@ -3086,35 +5093,82 @@ void BE_IMPL_CloseWindow(const char* file, int line) {
     g_engine->running = false;
 }
 
+// Writes the frame that just ended and the one before it, then disarms so the capture is not overwritten
+static void BE_ProfileWriteSpike(const char* file, int line) {
+    uint64_t frameNs = (uint64_t)((double)g_engine->timer.dt * 1e9);
+    uint64_t since = g_engine->timer.currentTime > 2 * frameNs ? g_engine->timer.currentTime - 2 * frameNs : 0;
+
+    if (BE_ProfileWriteTrace(g_engine->profileSpikePath, since)) {
+        BE_IMPL_Message(1, "Profile", file, line, "Frame %d took %.2f ms, wrote '%s'", g_engine->timer.frameCount - 1, g_engine->timer.dt * 1000.0f, g_engine->profileSpikePath);
+    } else {
+        BE_IMPL_Message(2, "Profile", file, line, "Failed to write '%s'", g_engine->profileSpikePath);
+    }
+    g_engine->profileSpikeMs = 0.0f;
+}
+
 void BE_IMPL_BeginFrame(const char* file, int line) {
     BE_CheckEngineActive(file, line,);
     BE_UpdateFrameTimeInfo(&g_engine->timer);
+    BE_PROFILE_FRAME();
+    if (g_engine->profileSpikeMs > 0.0f && g_engine->timer.dt * 1000.0f > g_engine->profileSpikeMs) BE_ProfileWriteSpike(file, line);
+    BE_PROFILE_SCOPE("BE_BeginFrame");
+    BE_ArenaReset(&g_engine->frame);
+    BE_UpdateFrameMemoryInfo(&g_engine->timer, file, line);
+    if (!g_engine->renderThread) {
+        BE_RenderStatsTake(&g_engine->timer.render);
+        BE_StreamRingBeginFrame(&g_engine->stream);
+        BE_GpuTimerBeginFrame(g_engine->gpuTimer);
+    }
+    BE_LoaderUpdate(g_engine->loader);
     
     glfwSetWindowUserPointer(g_engine->window, g_engine);
     glfwSetFramebufferSizeCallback(g_engine->window, framebuffer_size_callback);
 
     glfwPollEvents();
+    if (g_engine->overlay) BE_OverlayReadInput(g_engine->window, &g_engine->overlayInput);
     BE_AudioEngineUpdate(&g_engine->audio);
     BE_IMPL_SetListenerPositionToActiveCamera(file, line);
 }
 
 void BE_IMPL_MakeShadows(bool active, const char* file, int line) {
+    BE_PROFILE_SCOPE("BE_MakeShadows");
     BE_CheckSceneActive(file, line,);
-    BE_CameraVectorUpdateMatrix(&g_engine->activeScene->cameras, g_engine->width, g_engine->height);
-    BE_LightVectorUpdateMatrix(&g_engine->activeScene->lights);
-    BE_LightVectorUpdateMultiMaps(&g_engine->activeScene->lights, &g_engine->activeScene->models, &g_engine->resources.defaultDepthShader, active);        
+    if (g_engine->renderThread) { BE_RenderThreadRecord(g_engine->renderThread, BE_RENDER_MAKE_SHADOWS, active, BE_HANDLE_NONE, file, line); return; }
+    BE_RenderShadows(g_engine, active);
+}
+
+static void BE_RenderShadows(BE_Engine* engine, bool active) {
+    BE_PROFILE_FUNCTION();
+    BE_GPU_SCOPE(engine->gpuTimer, "Shadows");
+    BE_CameraVectorUpdateMatrix(&engine->activeScene->cameras, engine->width, engine->height);
+    BE_LightVectorUpdateMatrix(&engine->activeScene->lights);
+    BE_ModelVectorUpdateTransforms(&engine->activeScene->models, engine->jobs);
+    BE_LightVectorUpdateMultiMaps(&engine->activeScene->lights, &engine->activeScene->models, engine->activeScene->activeCamera, &engine->resources.defaultDepthShader, &engine->resources.defaultPointDepthShader, active);
 }
 
 void BE_IMPL_BeginRender(const char* file, int line) {
+    BE_PROFILE_SCOPE("BE_BeginRender");
     BE_CheckEngineActive(file, line,);
-    glViewport(0, 0, g_engine->width, g_engine->height);
+    if (g_engine->renderThread) { BE_RenderThreadRecord(g_engine->renderThread, BE_RENDER_BEGIN_RENDER, false, BE_HANDLE_NONE, file, line); return; }
+    BE_RenderClear(g_engine);
+}
+
+static void BE_RenderClear(BE_Engine* engine) {
+    BE_PROFILE_FUNCTION();
+    BE_GPU_SCOPE(engine->gpuTimer, "Clear");
+    glViewport(0, 0, engine->width, engine->height);
     glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
 void BE_IMPL_EndFrame(const char* file, int line) {
+    BE_PROFILE_SCOPE("BE_EndFrame");
     BE_CheckEngineActive(file, line,);
-    glfwSwapBuffers(g_engine->window);
+    if (g_engine->renderThread) { BE_RenderThreadSubmit(g_engine->renderThread); return; }
+    if (g_engine->overlay) BE_OverlayDraw(g_engine);
+    BE_GpuTimerEndFrame(g_engine->gpuTimer);
+    BE_StreamRingEndFrame(&g_engine->stream);
+    BE_PresentFrame(g_engine);
 }
 
 // ==============================
@@ -3138,16 +5192,19 @@ void BE_IMPL_AddScene(const char* sceneName, const char* file, int line) {
 
     char buffer[128];
     if (!sceneName) {
-        snprintf(buffer, sizeof(buffer), "scene%d", g_engine->scenes.size+1);
+        snprintf(buffer, sizeof(buffer), "scene%d", g_engine->scenes.pool.size+1);
         sceneName = buffer;
         BE_IMPL_Message(1, "Scene", file, line, "No name provided; defaulted to '%s'", sceneName);
     }
     
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
     BE_SceneVectorPush(&g_engine->scenes, BE_SceneInit(sceneName));
+    BE_RenderThreadReturnContext(g_engine->renderThread);
     BE_Scene* scene = BE_FindScenePtr(&g_engine->scenes, sceneName);
     
     BE_CameraVectorPush(&scene->cameras, BE_CameraInit("camera1", 1, 1, 45, 0.1f, 100, BE_vec3(-1.93f, 0.73f, -1.75f), BE_vec3(0.67f, -0.12f, 0.73f)));
     scene->activeCamera = BE_FindCameraPtr(&scene->cameras, "camera1");
+    scene->activeCamera->entity = BE_SceneAddEntity(scene, BE_COMPONENT_CAMERA, BE_RegistryHandle(&scene->cameras.registry, 0));
     
     BE_IMPL_BindScene(sceneName, file, line);
 }
@@ -3160,21 +5217,28 @@ void BE_IMPL_DeleteScene(const char* sceneName, const char* file, int line) {
 
     if (g_engine->activeScene == scene) { BE_UnbindScene(); }
 
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
+    BE_SceneFree(scene);
+    BE_RenderThreadReturnContext(g_engine->renderThread);
     BE_SceneVectorRemove(&g_engine->scenes, scene);
 
-    if(g_engine->scenes.size == 0) {
+    if(g_engine->scenes.pool.size == 0) {
         BE_IMPL_AddScene(NULL, file, line);
-    } else if (!g_engine->activeScene && g_engine->scenes.size > 0) {
-        g_engine->activeScene = &g_engine->scenes.data[0];
+    } else if (!g_engine->activeScene && g_engine->scenes.pool.size > 0) {
+        g_engine->activeScene = BE_SceneVectorAt(&g_engine->scenes, 0);
     }
 }
 
 void BE_IMPL_DeleteAllScenes(const char* file, int line) {
     BE_CheckEngineActive(file, line,);
-    for (int i = 0; i < g_engine->resources.sounds.size; i++) {
-        BE_Scene* scene = &g_engine->scenes.data[i];
+    g_engine->activeScene = NULL;
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
+    while (g_engine->scenes.pool.size > 0) {
+        BE_Scene* scene = BE_SceneVectorAt(&g_engine->scenes, 0);
+        BE_SceneFree(scene);
         BE_SceneVectorRemove(&g_engine->scenes, scene);
     }
+    BE_RenderThreadReturnContext(g_engine->renderThread);
     BE_IMPL_AddScene(NULL, file, line);
 }
 
@@ -3200,12 +5264,14 @@ void BE_IMPL_LoadShader(const char* shaderName, const char* vertexFile, const ch
 
     char buffer[128];
     if (!shaderName) {
-        snprintf(buffer, sizeof(buffer), "shader%d", g_engine->resources.meshes.size+1);
+        snprintf(buffer, sizeof(buffer), "shader%d", g_engine->resources.meshes.pool.size+1);
         shaderName = buffer;
         BE_IMPL_Message(1, "Shader", file, line, "No name provided; defaulted to '%s'", shaderName);
     }
 
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
     BE_ShaderVectorPush(&g_engine->resources.shaders, BE_ShaderInit(shaderName, vertexFile, fragmentFile, geometryFile, computeFile));
+    BE_RenderThreadReturnContext(g_engine->renderThread);
 }
 
 // delete
@@ -3218,60 +5284,188 @@ BE_Shader* BE_IMPL_FindShader(const char* shaderName, const char* file, int line
     return shader;
 }
 
+BE_Handle BE_IMPL_GetShaderHandle(const char* shaderName, const char* file, int line) {
+    BE_CheckEngineActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->resources.shaders.registry, shaderName);
+    if (!handle) { BE_IMPL_Message(2, "Shader", file, line, "Failed to find shader '%s'", shaderName); }
+    return handle;
+}
+
+BE_Shader* BE_IMPL_GetShader(BE_Handle handle, const char* file, int line) {
+    BE_CheckEngineActive(file, line, NULL);
+    BE_Shader* shader = BE_GetShaderPtr(&g_engine->resources.shaders, handle);
+    if (!shader) { BE_IMPL_Message(2, "Shader", file, line, "Shader handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return shader;
+}
+
+// chack
+
+// ==============================
+// Meshes
+// ==============================
+
+void BE_IMPL_LoadMesh(const char* meshName, const char* objFile, const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    if (!objFile) { BE_IMPL_Message(2, "Mesh", file, line, "Failed to find file '%s'", objFile); return; }
+
+    char buffer[128];
+    if (!meshName) {
+        snprintf(buffer, sizeof(buffer), "mesh%d", g_engine->resources.meshes.pool.size+1);
+        meshName = buffer;
+        BE_IMPL_Message(1, "Mesh", file, line, "No name provided; defaulted to '%s'", meshName);
+    }
+
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
+    BE_MeshVectorPush(&g_engine->resources.meshes, BE_LoadOBJToMesh(meshName, objFile));
+    BE_RenderThreadReturnContext(g_engine->renderThread);
+}
+
+// delete
+// delete all
+
+BE_Mesh* BE_IMPL_FindMesh(const char* meshName, const char* file, int line) {
+    BE_CheckEngineActive(file, line, NULL);
+    BE_Mesh* mesh = BE_FindMeshPtr(&g_engine->resources.meshes, meshName);
+    if (!mesh) { BE_IMPL_Message(2, "Mesh", file, line, "Failed to find mesh '%s'", meshName); return NULL; }
+    return mesh;
+}
+
+BE_Handle BE_IMPL_GetMeshHandle(const char* meshName, const char* file, int line) {
+    BE_CheckEngineActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->resources.meshes.registry, meshName);
+    if (!handle) { BE_IMPL_Message(2, "Mesh", file, line, "Failed to find mesh '%s'", meshName); }
+    return handle;
+}
+
+BE_Mesh* BE_IMPL_GetMesh(BE_Handle handle, const char* file, int line) {
+    BE_CheckEngineActive(file, line, NULL);
+    BE_Mesh* mesh = BE_GetMeshPtr(&g_engine->resources.meshes, handle);
+    if (!mesh) { BE_IMPL_Message(2, "Mesh", file, line, "Mesh handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return mesh;
+}
+
 // chack
 
-// ==============================
-// Meshes
-// ==============================
+// ==============================
+// Models
+// ==============================
+
+void BE_IMPL_AddModel(const char* modelName, const char* meshName, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
+
+    BE_Mesh* mesh = BE_FindMeshPtr(&g_engine->resources.meshes, meshName);
+    if (!mesh) { BE_IMPL_Message(2, "Model", file, line, "Failed to find mesh '%s'", meshName); return; }
+
+    char buffer[128];
+    if (!modelName) {
+        snprintf(buffer, sizeof(buffer), "model%d", g_engine->activeScene->cameras.pool.size+1);
+        modelName = buffer;
+        BE_IMPL_Message(1, "Model", file, line, "No name provided; defaulted to '%s'", modelName);
+    }
+    
+    BE_Scene* scene = g_engine->activeScene;
+    BE_ModelVectorPush(&scene->models, BE_ModelInit(modelName, mesh, BE_TransformInit(BE_vec3(0,0,0), BE_vec3(0,0,0), BE_vec3(1,1,1))));
+
+    BE_Model* model = &scene->models.data[scene->models.size - 1];
+    model->entity = BE_WorldCreate(scene->world, BE_COMPONENT_BIT(BE_COMPONENT_TRANSFORM) | BE_COMPONENT_BIT(BE_COMPONENT_MESH_RENDERER));
+    BE_MeshRenderer renderer = {BE_RegistryHandle(&scene->models.registry, scene->models.size - 1), mesh};
+    BE_WorldSet(scene->world, model->entity, BE_COMPONENT_MESH_RENDERER, &renderer);
+    BE_SceneUpdateModelEntity(scene, model);
+}
+
+// delete
+// delete all
+
+void BE_IMPL_SetModelPosition(const char* modelName, const vec3 position, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
+
+    BE_Model* model = BE_FindModelPtr(&g_engine->activeScene->models, modelName);
+    if (!model) { BE_IMPL_Message(2, "Model", file, line, "Failed to find model '%s'", modelName); return; }
+
+    if (!position) { BE_IMPL_Message(2, "Model", file, line, "Expected position value cannot be NULL"); return; }
+
+    BE_ModelSetPosition(model, (float*)position);
+    BE_SceneUpdateModelEntity(g_engine->activeScene, model);
+}
+
+void BE_IMPL_SetModelRotation(const char* modelName, const vec3 eulerRotation, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
+
+    BE_Model* model = BE_FindModelPtr(&g_engine->activeScene->models, modelName);
+    if (!model) { BE_IMPL_Message(2, "Model", file, line, "Failed to find model '%s'", modelName); return; }
+
+    if (!eulerRotation) { BE_IMPL_Message(2, "Model", file, line, "Expected rotation value cannot be NULL"); return; }
+
+    BE_Transform rotation = BE_TransformInit(model->transform.position, (float*)eulerRotation, model->transform.scale);
+    BE_ModelSetOrientation(model, rotation.orientation);
+    BE_SceneUpdateModelEntity(g_engine->activeScene, model);
+}
+
+void BE_IMPL_SetModelScale(const char* modelName, const vec3 scale, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
+
+    BE_Model* model = BE_FindModelPtr(&g_engine->activeScene->models, modelName);
+    if (!model) { BE_IMPL_Message(2, "Model", file, line, "Failed to find model '%s'", modelName); return; }
+
+    if (!scale) { BE_IMPL_Message(2, "Model", file, line, "Expected scale value cannot be NULL"); return; }
+
+    BE_ModelSetScale(model, (float*)scale);
+    BE_SceneUpdateModelEntity(g_engine->activeScene, model);
+}
+
+void BE_IMPL_SetModelPositionByHandle(BE_Handle handle, const vec3 position, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
 
-void BE_IMPL_LoadMesh(const char* meshName, const char* objFile, const char* file, int line) {
-    BE_CheckEngineActive(file, line,);
-    if (!objFile) { BE_IMPL_Message(2, "Mesh", file, line, "Failed to find file '%s'", objFile); return; }
+    BE_Model* model = BE_GetModelPtr(&g_engine->activeScene->models, handle);
+    if (!model) { BE_IMPL_Message(2, "Model", file, line, "Model handle 0x%08x is stale or invalid", (unsigned)handle); return; }
 
-    char buffer[128];
-    if (!meshName) {
-        snprintf(buffer, sizeof(buffer), "mesh%d", g_engine->resources.meshes.size+1);
-        meshName = buffer;
-        BE_IMPL_Message(1, "Mesh", file, line, "No name provided; defaulted to '%s'", meshName);
-    }
+    if (!position) { BE_IMPL_Message(2, "Model", file, line, "Expected position value cannot be NULL"); return; }
 
-    BE_MeshVectorPush(&g_engine->resources.meshes, BE_LoadOBJToMesh(meshName, objFile));
+    BE_ModelSetPosition(model, (float*)position);
+    BE_SceneUpdateModelEntity(g_engine->activeScene, model);
 }
 
-// delete
-// delete all
+void BE_IMPL_SetModelRotationByHandle(BE_Handle handle, const vec3 eulerRotation, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
 
-BE_Mesh* BE_IMPL_FindMesh(const char* meshName, const char* file, int line) {
-    BE_CheckEngineActive(file, line, NULL);
-    BE_Mesh* mesh = BE_FindMeshPtr(&g_engine->resources.meshes, meshName);
-    if (!mesh) { BE_IMPL_Message(2, "Mesh", file, line, "Failed to find mesh '%s'", meshName); return NULL; }
-    return mesh;
+    BE_Model* model = BE_GetModelPtr(&g_engine->activeScene->models, handle);
+    if (!model) { BE_IMPL_Message(2, "Model", file, line, "Model handle 0x%08x is stale or invalid", (unsigned)handle); return; }
+
+    if (!eulerRotation) { BE_IMPL_Message(2, "Model", file, line, "Expected rotation value cannot be NULL"); return; }
+
+    BE_Transform rotation = BE_TransformInit(model->transform.position, (float*)eulerRotation, model->transform.scale);
+    BE_ModelSetOrientation(model, rotation.orientation);
+    BE_SceneUpdateModelEntity(g_engine->activeScene, model);
 }
 
-// chack
+void BE_IMPL_SetModelScaleByHandle(BE_Handle handle, const vec3 scale, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
 
-// ==============================
-// Models
-// ==============================
+    BE_Model* model = BE_GetModelPtr(&g_engine->activeScene->models, handle);
+    if (!model) { BE_IMPL_Message(2, "Model", file, line, "Model handle 0x%08x is stale or invalid", (unsigned)handle); return; }
 
-void BE_IMPL_AddModel(const char* modelName, const char* meshName, const char* file, int line) {
+    if (!scale) { BE_IMPL_Message(2, "Model", file, line, "Expected scale value cannot be NULL"); return; }
+
+    BE_ModelSetScale(model, (float*)scale);
+    BE_SceneUpdateModelEntity(g_engine->activeScene, model);
+}
+
+void BE_IMPL_SetModelParent(const char* modelName, const char* parentName, const char* file, int line) {
     BE_CheckSceneActive(file, line,);
 
-    BE_Mesh* mesh = BE_FindMeshPtr(&g_engine->resources.meshes, meshName);
-    if (!mesh) { BE_IMPL_Message(2, "Model", file, line, "Failed to find mesh '%s'", meshName); return; }
+    BE_Model* model = BE_FindModelPtr(&g_engine->activeScene->models, modelName);
+    if (!model) { BE_IMPL_Message(2, "Model", file, line, "Failed to find model '%s'", modelName); return; }
 
-    char buffer[128];
-    if (!modelName) {
-        snprintf(buffer, sizeof(buffer), "model%d", g_engine->activeScene->cameras.size+1);
-        modelName = buffer;
-        BE_IMPL_Message(1, "Model", file, line, "No name provided; defaulted to '%s'", modelName);
+    BE_Model* parent = NULL;
+    if (parentName) {
+        parent = BE_FindModelPtr(&g_engine->activeScene->models, parentName);
+        if (!parent) { BE_IMPL_Message(2, "Model", file, line, "Failed to find model '%s'", parentName); return; }
     }
-    
-    BE_ModelVectorPush(&g_engine->activeScene->models, BE_ModelInit(modelName, mesh, BE_TransformInit(BE_vec3(0,0,0), BE_vec3(0,0,0), BE_vec3(1,1,1))));
-}
 
-// delete
-// delete all
+    if (!BE_ModelVectorSetParent(&g_engine->activeScene->models, model, parent)) {
+        BE_IMPL_Message(2, "Model", file, line, "Model '%s' cannot be parented to its own child '%s'", modelName, parentName);
+    }
+}
 
 BE_Model* BE_IMPL_FindModel(const char* modelName, const char* file, int line) {
     BE_CheckSceneActive(file, line, NULL);
@@ -3280,24 +5474,38 @@ BE_Model* BE_IMPL_FindModel(const char* modelName, const char* file, int line) {
     return model;
 }
 
+BE_Handle BE_IMPL_GetModelHandle(const char* modelName, const char* file, int line) {
+    BE_CheckSceneActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->activeScene->models.registry, modelName);
+    if (!handle) { BE_IMPL_Message(2, "Model", file, line, "Failed to find model '%s'", modelName); }
+    return handle;
+}
+
+BE_Model* BE_IMPL_GetModel(BE_Handle handle, const char* file, int line) {
+    BE_CheckSceneActive(file, line, NULL);
+    BE_Model* model = BE_GetModelPtr(&g_engine->activeScene->models, handle);
+    if (!model) { BE_IMPL_Message(2, "Model", file, line, "Model handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return model;
+}
+
 // check
 
 void BE_IMPL_DrawModels(const char* shaderName, const char* file, int line) {
+    BE_PROFILE_SCOPE("BE_DrawModels");
     BE_CheckCameraActive(file, line,);
+    BE_Handle shader = BE_DrawShaderHandle(shaderName, "Model", "model", file, line);
+    if (g_engine->renderThread) { BE_RenderThreadRecord(g_engine->renderThread, BE_RENDER_DRAW_MODELS, false, shader, file, line); return; }
+    BE_RenderModels(g_engine, shader);
+}
 
-    BE_Shader* shader = {0};
-    if (!shaderName) {
-        shader = &g_engine->resources.default3DShader;
-    } else {
-        BE_FindShaderPtr(&g_engine->resources.shaders, shaderName);
-        if (!shader) {
-            BE_IMPL_Message(1, "Model", file, line, "Failed to find shader '%s'. Using default model shader", shaderName);
-            shader = &g_engine->resources.default3DShader;
-        }
-    }
+static void BE_RenderModels(BE_Engine* engine, BE_Handle shaderHandle) {
+    BE_PROFILE_FUNCTION();
+    BE_GPU_SCOPE(engine->gpuTimer, "Models");
+    BE_Shader* shader = BE_DrawShader(engine, shaderHandle, &engine->resources.default3DShader);
 
-    BE_LightVectorUpload(&g_engine->activeScene->lights, shader);
-    BE_CameraMatrixUploadPersp(g_engine->activeScene->activeCamera, shader, "camMatrix");
+    BE_LightVectorUpdateClusters(&engine->activeScene->lights, engine->activeScene->activeCamera, &engine->stream);
+    BE_LightVectorUpload(&engine->activeScene->lights, shader);
+    BE_CameraMatrixUploadPersp(engine->activeScene->activeCamera, shader, "camMatrix");
 
     BE_ShaderActivate(shader);
 
@@ -3306,11 +5514,21 @@ void BE_IMPL_DrawModels(const char* shaderName, const char* file, int line) {
     glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     glEnable(GL_BLEND);
 
-    mat4 modelMatrix;
-    for (size_t i = 0; i < g_engine->activeScene->models.size; i++) {
-        BE_Model* model = &g_engine->activeScene->models.data[i];
-        BE_TransformUpdateMatrix(&model->transform, modelMatrix);
-        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)modelMatrix);
+    BE_ModelVectorUpdateTransforms(&engine->activeScene->models, engine->jobs);
+
+    vec4 planes[6];
+    glm_frustum_planes(engine->activeScene->activeCamera->projPersp, planes);
+
+    for (size_t i = 0; i < engine->activeScene->models.size; i++) {
+        BE_Model* model = &engine->activeScene->models.data[i];
+        if (!glm_aabb_frustum(model->bounds, planes)) {
+            BE_RENDER_COUNT(culledObjects, 1);
+            continue;
+        }
+
+        BE_RENDER_COUNT(visibleObjects, 1);
+        BE_RENDER_COUNT(uniformUploads, 1);
+        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model->worldMatrix);
         BE_MeshDraw(model->mesh, shader);
     }
 }
@@ -3324,12 +5542,14 @@ void BE_IMPL_AddLight(const char* lightName, BE_LightType type, const char* file
 
     char buffer[128];
     if (!lightName) {
-        snprintf(buffer, sizeof(buffer), "light%d", g_engine->activeScene->cameras.size+1);
+        snprintf(buffer, sizeof(buffer), "light%d", g_engine->activeScene->cameras.pool.size+1);
         lightName = buffer;
         BE_IMPL_Message(1, "Light", file, line, "No name provided; defaulted to '%s'", lightName);
     }
     
-    BE_LightVectorPush(&g_engine->activeScene->lights, BE_LightInit(lightName, type, BE_vec3(0,0,0), BE_vec3(0,0,0), BE_vec4(1,1,1,1), 0.0f, 1, 0.04f, 0, 0));
+    BE_LightVector* lights = &g_engine->activeScene->lights;
+    BE_LightVectorPush(lights, BE_LightInit(lightName, type, BE_vec3(0,0,0), BE_vec3(0,0,0), BE_vec4(1,1,1,1), 0.0f, 1, 0.04f, 0, 0));
+    lights->data[lights->size - 1].entity = BE_SceneAddEntity(g_engine->activeScene, BE_COMPONENT_LIGHT, BE_RegistryHandle(&lights->registry, lights->size - 1));
 }
 
 // delete
@@ -3342,23 +5562,36 @@ BE_Light* BE_IMPL_FindLight(const char* lightName, const char* file, int line) {
     return light;
 }
 
+BE_Handle BE_IMPL_GetLightHandle(const char* lightName, const char* file, int line) {
+    BE_CheckSceneActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->activeScene->lights.registry, lightName);
+    if (!handle) { BE_IMPL_Message(2, "Light", file, line, "Failed to find light '%s'", lightName); }
+    return handle;
+}
+
+BE_Light* BE_IMPL_GetLight(BE_Handle handle, const char* file, int line) {
+    BE_CheckSceneActive(file, line, NULL);
+    BE_Light* light = BE_GetLightPtr(&g_engine->activeScene->lights, handle);
+    if (!light) { BE_IMPL_Message(2, "Light", file, line, "Light handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return light;
+}
+
 // check
 
 void BE_IMPL_DrawLights(const char* shaderName, const char* file, int line) {
+    BE_PROFILE_SCOPE("BE_DrawLights");
     BE_CheckCameraActive(file, line,);
+    BE_Handle shader = BE_DrawShaderHandle(shaderName, "Light", "light", file, line);
+    if (g_engine->renderThread) { BE_RenderThreadRecord(g_engine->renderThread, BE_RENDER_DRAW_LIGHTS, false, shader, file, line); return; }
+    BE_RenderLights(g_engine, shader);
+}
 
-    BE_Shader* shader = {0};
-    if (shaderName == NULL) {
-        shader = &g_engine->resources.defaultColorShader;
-    } else {
-        BE_FindShaderPtr(&g_engine->resources.shaders, shaderName);
-        if (!shader) {
-            BE_IMPL_Message(1, "Light", file, line, "Failed to find shader '%s'. Using default light shader", shaderName);
-            shader = &g_engine->resources.defaultColorShader;
-        }
-    }
+static void BE_RenderLights(BE_Engine* engine, BE_Handle shaderHandle) {
+    BE_PROFILE_FUNCTION();
+    BE_GPU_SCOPE(engine->gpuTimer, "Lights");
+    BE_Shader* shader = BE_DrawShader(engine, shaderHandle, &engine->resources.defaultColorShader);
 
-    BE_CameraMatrixUploadPersp(g_engine->activeScene->activeCamera, shader, "camMatrix");
+    BE_CameraMatrixUploadPersp(engine->activeScene->activeCamera, shader, "camMatrix");
 
     BE_ShaderActivate(shader);
 
@@ -3370,8 +5603,8 @@ void BE_IMPL_DrawLights(const char* shaderName, const char* file, int line) {
     vec3 scale = { 0.1f, 0.1f, 0.1f };
     mat4 model;
 
-    for (size_t i = 0; i < g_engine->activeScene->lights.size; i++) {
-        BE_Light* light = &g_engine->activeScene->lights.data[i];
+    for (size_t i = 0; i < engine->activeScene->lights.size; i++) {
+        BE_Light* light = &engine->activeScene->lights.data[i];
         
         switch (light->type) {
             case BE_LIGHT_DIRECT:
@@ -3388,10 +5621,12 @@ void BE_IMPL_DrawLights(const char* shaderName, const char* file, int line) {
                 continue;
         }
         
+        BE_RENDER_COUNT(uniformUploads, 2);
         glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
         glUniform3fv(glGetUniformLocation(shader->ID, "color"), 1, (float*)light->color);
-        BE_VAOBind(&g_engine->resources.defaultCubeMesh.vao);
-        glDrawElements(GL_TRIANGLES, g_engine->resources.defaultCubeMesh.indices.size, GL_UNSIGNED_INT, 0);
+        BE_VAOBind(&engine->resources.defaultCubeMesh.vao);
+        BE_RENDER_COUNT_DRAW(engine->resources.defaultCubeMesh.indices.size);
+        glDrawElements(GL_TRIANGLES, engine->resources.defaultCubeMesh.indices.size, GL_UNSIGNED_INT, 0);
     }
 }
 
@@ -3404,12 +5639,14 @@ void BE_IMPL_AddCamera(const char* cameraName, const char* file, int line) {
 
     char buffer[128];
     if (!cameraName) {
-        snprintf(buffer, sizeof(buffer), "camera%d", g_engine->activeScene->cameras.size+1);
+        snprintf(buffer, sizeof(buffer), "camera%d", g_engine->activeScene->cameras.pool.size+1);
         cameraName = buffer;
         BE_IMPL_Message(1, "Camera", file, line, "No name provided; defaulted to '%s'", cameraName);
     }
     
-    BE_CameraVectorPush(&g_engine->activeScene->cameras, BE_CameraInit(cameraName, g_engine->width, g_engine->height, 45.0f, 0.1f, 100.0f, BE_vec3(0,0,0), BE_vec3(0,0,0)));
+    BE_CameraVector* cameras = &g_engine->activeScene->cameras;
+    BE_CameraVectorPush(cameras, BE_CameraInit(cameraName, g_engine->width, g_engine->height, 45.0f, 0.1f, 100.0f, BE_vec3(0,0,0), BE_vec3(0,0,0)));
+    BE_CameraVectorAt(cameras, cameras->pool.size - 1)->entity = BE_SceneAddEntity(g_engine->activeScene, BE_COMPONENT_CAMERA, BE_RegistryHandle(&cameras->registry, cameras->pool.size - 1));
 }
 
 // delete
@@ -3422,26 +5659,40 @@ BE_Camera* BE_IMPL_FindCamera(const char* cameraName, const char* file, int line
     return camera;
 }
 
+BE_Handle BE_IMPL_GetCameraHandle(const char* cameraName, const char* file, int line) {
+    BE_CheckSceneActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->activeScene->cameras.registry, cameraName);
+    if (!handle) { BE_IMPL_Message(2, "Camera", file, line, "Failed to find camera '%s'", cameraName); }
+    return handle;
+}
+
+BE_Camera* BE_IMPL_GetCamera(BE_Handle handle, const char* file, int line) {
+    BE_CheckSceneActive(file, line, NULL);
+    BE_Camera* camera = BE_GetCameraPtr(&g_engine->activeScene->cameras, handle);
+    if (!camera) { BE_IMPL_Message(2, "Camera", file, line, "Camera handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return camera;
+}
+
 // check
 
 void BE_IMPL_DrawCameras(const char* shaderName, const char* file, int line) {
+    BE_PROFILE_SCOPE("BE_DrawCameras");
     BE_CheckCameraActive(file, line,);
+    BE_Handle shader = BE_DrawShaderHandle(shaderName, "Camera", "camera", file, line);
+    if (g_engine->renderThread) { BE_RenderThreadRecord(g_engine->renderThread, BE_RENDER_DRAW_CAMERAS, false, shader, file, line); return; }
+    BE_RenderCameras(g_engine, shader);
+}
 
-    BE_Shader* shader = {0};
-    if (shaderName == NULL) {
-        shader = &g_engine->resources.defaultColorShader;
-    } else {
-        BE_FindShaderPtr(&g_engine->resources.shaders, shaderName);
-        if (!shader) {
-            BE_IMPL_Message(1, "Camera", file, line, "Failed to find shader '%s'. Using default sprite shader", shaderName);
-            shader = &g_engine->resources.defaultColorShader;
-        }
-    }
+static void BE_RenderCameras(BE_Engine* engine, BE_Handle shaderHandle) {
+    BE_PROFILE_FUNCTION();
+    BE_GPU_SCOPE(engine->gpuTimer, "Cameras");
+    BE_Shader* shader = BE_DrawShader(engine, shaderHandle, &engine->resources.defaultColorShader);
     
-    BE_CameraMatrixUploadPersp(g_engine->activeScene->activeCamera, shader, "camMatrix");
+    BE_CameraMatrixUploadPersp(engine->activeScene->activeCamera, shader, "camMatrix");
 
     BE_ShaderActivate(shader);
 
+    BE_RENDER_COUNT(uniformUploads, 1);
     glUniform3fv(glGetUniformLocation(shader->ID, "color"), 1, (float[]){1.0f, 1.0f, 1.0f});
     
     glEnable(GL_DEPTH_TEST);
@@ -3452,16 +5703,17 @@ void BE_IMPL_DrawCameras(const char* shaderName, const char* file, int line) {
     mat4 model;
     vec3 ori;
 
-    for (size_t i = 0; i < g_engine->activeScene->cameras.size; i++) {
-        BE_Camera* camera = &g_engine->activeScene->cameras.data[i];
+    for (size_t i = 0; i < engine->activeScene->cameras.pool.size; i++) {
+        BE_Camera* camera = BE_CameraVectorAt(&engine->activeScene->cameras, i);
 
-        if (camera == g_engine->activeScene->activeCamera) continue;
+        if (camera == engine->activeScene->activeCamera) continue;
         
         BE_VersorToEuler(camera->orientation, ori);
 
         BE_MakeModelMatrix(camera->position, ori, (vec3){0.25f * camera->width/1000 * camera->fov/45, 0.25f * camera->height/1000, 0.2f * camera->zoom}, model);
+        BE_RENDER_COUNT(uniformUploads, 1);
         glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
-        BE_MeshDraw(&g_engine->resources.defaultCameraMesh, shader);
+        BE_MeshDraw(&engine->resources.defaultCameraMesh, shader);
     }
 }
 
@@ -3475,12 +5727,14 @@ void BE_IMPL_LoadTexture(const char* textureName, const char* imageFile, const c
 
     char buffer[128];
     if (!textureName) {
-        snprintf(buffer, sizeof(buffer), "texture%d", g_engine->resources.meshes.size+1);
+        snprintf(buffer, sizeof(buffer), "texture%d", g_engine->resources.meshes.pool.size+1);
         textureName = buffer;
         BE_IMPL_Message(1, "Texture", file, line, "No name provided; defaulted to '%s'", textureName);
     }
 
-    BE_TextureVectorPush(&g_engine->resources.textures, BE_TextureInit(textureName, imageFile, "texture", 0));
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
+    BE_TextureVectorPush(&g_engine->resources.textures, BE_TextureInitAtlas(textureName, imageFile, &g_engine->resources.atlas));
+    BE_RenderThreadReturnContext(g_engine->renderThread);
 }
 
 // delete
@@ -3493,6 +5747,20 @@ BE_Texture* BE_IMPL_FindTexture(const char* textureName, const char* file, int l
     return texture;
 }
 
+BE_Handle BE_IMPL_GetTextureHandle(const char* textureName, const char* file, int line) {
+    BE_CheckEngineActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->resources.textures.registry, textureName);
+    if (!handle) { BE_IMPL_Message(2, "Texture", file, line, "Failed to find texture '%s'", textureName); }
+    return handle;
+}
+
+BE_Texture* BE_IMPL_GetTexture(BE_Handle handle, const char* file, int line) {
+    BE_CheckEngineActive(file, line, NULL);
+    BE_Texture* texture = BE_GetTexturePtr(&g_engine->resources.textures, handle);
+    if (!texture) { BE_IMPL_Message(2, "Texture", file, line, "Texture handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return texture;
+}
+
 // chack
 
 // ==============================
@@ -3512,11 +5780,28 @@ void BE_IMPL_AddSprite(const char* spriteName, const char* textureName, const ch
         BE_IMPL_Message(1, "Sprite", file, line, "No name provided; defaulted to '%s'", spriteName);
     }
 
-    BE_SpriteVectorPush(&g_engine->activeScene->sprites, BE_SpriteInit(spriteName, texture, BE_vec3(0,0,0), BE_vec2(1,1), BE_vec3(1,1,1), 0));
+    BE_SpriteVector* sprites = &g_engine->activeScene->sprites;
+    BE_SpriteVectorPush(sprites, BE_SpriteInit(spriteName, texture, BE_vec3(0,0,0), BE_vec2(1,1), BE_vec3(1,1,1), 0));
+    sprites->data[sprites->size - 1].entity = BE_SceneAddEntity(g_engine->activeScene, BE_COMPONENT_SPRITE, BE_RegistryHandle(&sprites->registry, sprites->size - 1));
 }
 
-// delete
-// delete all
+void BE_IMPL_RemoveSprite(const char* spriteName, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
+    BE_Sprite* sprite = BE_FindSpritePtr(&g_engine->activeScene->sprites, spriteName);
+    if (!sprite) { BE_IMPL_Message(2, "Sprite", file, line, "Failed to find sprite '%s'", spriteName); return; }
+    BE_WorldDestroy(g_engine->activeScene->world, sprite->entity);
+    BE_SpriteVectorRemove(&g_engine->activeScene->sprites, sprite);
+}
+
+void BE_IMPL_RemoveAllSprites(const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
+    BE_SpriteVector* sprites = &g_engine->activeScene->sprites;
+    while (sprites->size > 0) {
+        BE_Sprite* sprite = &sprites->data[sprites->size - 1];
+        BE_WorldDestroy(g_engine->activeScene->world, sprite->entity);
+        BE_SpriteVectorRemove(sprites, sprite);
+    }
+}
 
 BE_Sprite* BE_IMPL_FindSprite(const char* spriteName, const char* file, int line) {
     BE_CheckSceneActive(file, line, NULL);
@@ -3525,51 +5810,38 @@ BE_Sprite* BE_IMPL_FindSprite(const char* spriteName, const char* file, int line
     return sprite;
 }
 
+BE_Handle BE_IMPL_GetSpriteHandle(const char* spriteName, const char* file, int line) {
+    BE_CheckSceneActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->activeScene->sprites.registry, spriteName);
+    if (!handle) { BE_IMPL_Message(2, "Sprite", file, line, "Failed to find sprite '%s'", spriteName); }
+    return handle;
+}
+
+BE_Sprite* BE_IMPL_GetSprite(BE_Handle handle, const char* file, int line) {
+    BE_CheckSceneActive(file, line, NULL);
+    BE_Sprite* sprite = BE_GetSpritePtr(&g_engine->activeScene->sprites, handle);
+    if (!sprite) { BE_IMPL_Message(2, "Sprite", file, line, "Sprite handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return sprite;
+}
+
 // check
 
 void BE_IMPL_DrawSprites(const char* shaderName, const char* file, int line) {
+    BE_PROFILE_SCOPE("BE_DrawSprites");
     BE_CheckCameraActive(file, line,);
-    
-    BE_Shader* shader = {0};
-    if (shaderName == NULL) {
-        shader = &g_engine->resources.defaultSpriteShader;
-    } else {
-        BE_FindShaderPtr(&g_engine->resources.shaders, shaderName);
-        if (!shader) {
-            BE_IMPL_Message(1, "Sprite", file, line, "Failed to find shader '%s'. Using default sprite shader", shaderName);
-            shader = &g_engine->resources.defaultSpriteShader;
-        }
-    }
-    
-    BE_CameraMatrixUploadOrtho(g_engine->activeScene->activeCamera, shader, "camMatrix");
+    BE_Handle shader = BE_DrawShaderHandle(shaderName, "Sprite", "sprite", file, line);
+    if (g_engine->renderThread) { BE_RenderThreadRecord(g_engine->renderThread, BE_RENDER_DRAW_SPRITES, false, shader, file, line); return; }
+    BE_RenderSprites(g_engine, shader);
+}
 
-    BE_ShaderActivate(shader);
+static void BE_RenderSprites(BE_Engine* engine, BE_Handle shaderHandle) {
+    BE_PROFILE_FUNCTION();
+    BE_GPU_SCOPE(engine->gpuTimer, "Sprites");
+    BE_Shader* shader = BE_DrawShader(engine, shaderHandle, &engine->resources.defaultSpriteShader);
     
-    glEnable(GL_DEPTH_TEST);
-    glEnable(GL_CULL_FACE);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glEnable(GL_BLEND);
-
-    mat4 model;
-
-    for (size_t i = 0; i < g_engine->activeScene->sprites.size; i++) {
-        BE_Sprite* sprite = &g_engine->activeScene->sprites.data[i];
-
-        glm_mat4_identity(model);
-        glm_translate(model, sprite->position);
-        glm_translate(model, (vec3){0.0f, 0.0f, 0.0f}); // optional pivot
-        glm_rotate(model, sprite->rotation, (vec3){0.0f, 0.0f, 1.0f});
-        glm_scale(model, (vec3){sprite->scale[0], sprite->scale[1], 1.0f});
-
-        glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
-        glUniform3fv(glGetUniformLocation(shader->ID, "spriteColor"), 1, (float*)sprite->color);
-
-        BE_TextureBind(sprite->texture);
-        BE_TextureSetUniformUnit(shader, "spriteTexture", 0);
-
-        BE_VAOBind(&g_engine->activeScene->sprites.vao);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-    }
+    BE_TextureAtlasUpdateMips(&engine->resources.atlas);
+    BE_CameraMatrixUploadOrtho(engine->activeScene->activeCamera, shader, "camMatrix");
+    BE_SpriteVectorDraw(&engine->activeScene->sprites, shader, engine->activeScene->activeCamera->projOrtho, &engine->stream);
 }
 
 // ==============================
@@ -3599,9 +5871,9 @@ void BE_IMPL_DeleteSound(const char* soundName, const char* file, int line) {
 
 void BE_IMPL_DeleteAllSounds(const char* file, int line) {
     BE_CheckEngineActive(file, line,);
-    for (int i = 0; i < g_engine->resources.sounds.size; i++) {
-        BE_Sound* sound = &g_engine->resources.sounds.data[i];
-        BE_SoundVectorRemove(&g_engine->resources.sounds, sound);
+    BE_SoundVector* sounds = &g_engine->resources.sounds;
+    while (sounds->size > 0) {
+        BE_SoundVectorRemove(sounds, &sounds->data[sounds->size - 1]);
     }
 }
 
@@ -3612,12 +5884,251 @@ BE_Sound* BE_IMPL_FindSound(const char* soundName, const char* file, int line) {
     return sound;
 }
 
+BE_Handle BE_IMPL_GetSoundHandle(const char* soundName, const char* file, int line) {
+    BE_CheckEngineActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->resources.sounds.registry, soundName);
+    if (!handle) { BE_IMPL_Message(2, "Sound", file, line, "Failed to find sound '%s'", soundName); }
+    return handle;
+}
+
+BE_Sound* BE_IMPL_GetSound(BE_Handle handle, const char* file, int line) {
+    BE_CheckEngineActive(file, line, NULL);
+    BE_Sound* sound = BE_GetSoundPtr(&g_engine->resources.sounds, handle);
+    if (!sound) { BE_IMPL_Message(2, "Sound", file, line, "Sound handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return sound;
+}
+
 bool BE_IMPL_CheckSound(const char* soundName, const char* file, int line) {
     BE_CheckEngineActive(file, line, false);
     BE_Sound* sound = BE_FindSoundPtr(&g_engine->resources.sounds, soundName);
     return sound != NULL;
 }
 
+// ==============================
+// Entities
+// ==============================
+
+BE_World* BE_IMPL_GetWorld(const char* file, int line) {
+    BE_CheckSceneActive(file, line, NULL);
+    return g_engine->activeScene->world;
+}
+
+int BE_IMPL_RegisterComponent(const char* componentName, size_t size, size_t align, const char* file, int line) {
+    BE_CheckSceneActive(file, line, -1);
+    int component = BE_WorldRegisterComponent(g_engine->activeScene->world, componentName, size, align);
+    if (component < 0) { BE_IMPL_Message(2, "Entity", file, line, "Failed to register component '%s'", componentName); }
+    return component;
+}
+
+void BE_IMPL_RunSystem(BE_EcsQuery* query, BE_EcsSystem system, void* arg, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
+    if (!query || !system) { BE_IMPL_Message(2, "Entity", file, line, "Expected query and system cannot be NULL"); return; }
+    BE_WorldEachParallel(g_engine->activeScene->world, query, g_engine->jobs, system, arg);
+}
+
+// ==============================
+// Timing
+// ==============================
+
+BE_FrameTimeSummary BE_IMPL_GetFrameTimes(const char* file, int line) {
+    BE_FrameTimeSummary summary = {0};
+    BE_CheckEngineActive(file, line, summary);
+    BE_FrameStatsSummarize(&g_engine->timer, &summary);
+    return summary;
+}
+
+void BE_IMPL_PrintFrameTimes(const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    BE_FrameTimeSummary summary;
+    BE_FrameStatsSummarize(&g_engine->timer, &summary);
+
+    printf("Frame times over %d frames (ms): min %.2f avg %.2f p50 %.2f p95 %.2f p99 %.2f max %.2f\n", summary.count,
+           summary.minMs, summary.avgMs, summary.p50Ms, summary.p95Ms, summary.p99Ms, summary.maxMs);
+    for (int i = 0; i < FRAME_HISTOGRAM_BINS; i++) {
+        float low = i > 0 ? BE_FrameHistogramBinMs(i - 1) : 0.0f;
+        if (i < FRAME_HISTOGRAM_BINS - 1) printf("  %6.2f - %6.2f  %u\n", low, BE_FrameHistogramBinMs(i), summary.histogram[i]);
+        else printf("  %6.2f +         %u\n", low, summary.histogram[i]);
+    }
+}
+
+void BE_IMPL_ResetFrameTimes(const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    g_engine->timer.frameTimeIndex = 0;
+    g_engine->timer.frameTimeCount = 0;
+    memset(&g_engine->timer.frameTime, 0, sizeof(BE_FrameTimeSummary));
+}
+
+int BE_IMPL_GetGpuTimes(BE_GpuPassTime* outPasses, int maxPasses, const char* file, int line) {
+    BE_CheckEngineActive(file, line, 0);
+    if (!outPasses) { BE_IMPL_Message(2, "Timing", file, line, "Expected passes cannot be NULL"); return 0; }
+    return BE_GpuTimerGetPasses(g_engine->gpuTimer, outPasses, maxPasses);
+}
+
+void BE_IMPL_PrintGpuTimes(const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    BE_GpuPassTime passes[GPU_TIMER_MAX_PASSES];
+    int count = BE_GpuTimerGetPasses(g_engine->gpuTimer, passes, GPU_TIMER_MAX_PASSES);
+    if (count == 0) { printf("No GPU pass times\n"); return; }
+
+    printf("GPU pass times (ms), %llu frames dropped:\n", (unsigned long long)g_engine->gpuTimer->dropped);
+    for (int i = 0; i < count; i++) {
+        printf("  %-12s avg %6.3f  last %6.3f  frames %llu\n", passes[i].name, passes[i].avgMs, passes[i].lastMs,
+               (unsigned long long)passes[i].frames);
+    }
+}
+
+void BE_IMPL_ShowOverlay(bool show, const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    g_engine->overlay = show;
+    if (show) BE_OverlayReadInput(g_engine->window, &g_engine->overlayInput);
+}
+
+// ==============================
+// Profiling
+// ==============================
+
+bool BE_IMPL_WriteProfile(const char* path, const char* file, int line) {
+#ifndef BE_PROFILE_ENABLED
+    BE_IMPL_Message(1, "Profile", file, line, "Profiling is compiled out, build without NDEBUG or with BE_PROFILE");
+    return false;
+#else
+    if (!path) { BE_IMPL_Message(2, "Profile", file, line, "Expected path cannot be NULL"); return false; }
+    if (!BE_ProfileWriteTrace(path, 0)) { BE_IMPL_Message(2, "Profile", file, line, "Failed to write '%s'", path); return false; }
+    return true;
+#endif
+}
+
+void BE_IMPL_SetProfileSpikeCapture(float thresholdMs, const char* path, const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+#ifndef BE_PROFILE_ENABLED
+    BE_IMPL_Message(1, "Profile", file, line, "Profiling is compiled out, build without NDEBUG or with BE_PROFILE");
+#else
+    if (thresholdMs > 0.0f && !path) { BE_IMPL_Message(2, "Profile", file, line, "Expected path cannot be NULL"); return; }
+    BE_MemFree(g_engine->profileSpikePath);
+    g_engine->profileSpikePath = thresholdMs > 0.0f ? BE_MemStrdup(path, BE_MEMORY_GENERAL) : NULL;
+    g_engine->profileSpikeMs = thresholdMs > 0.0f ? thresholdMs : 0.0f;
+#endif
+}
+
+// ==============================
+// Memory
+// ==============================
+
+void* BE_IMPL_FrameAlloc(size_t size, size_t align, const char* file, int line) {
+    BE_CheckEngineActive(file, line, NULL);
+    void* data = BE_ArenaAlloc(&g_engine->frame, size, align);
+    if (!data) { BE_IMPL_Message(2, "Memory", file, line, "Failed to allocate %zu bytes of frame memory", size); }
+    return data;
+}
+
+void BE_IMPL_SetAllocationCheck(bool enabled, const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    // Start counting from here, not from the beginning of the frame
+    g_engine->timer.allocationMark = BE_MemoryAllocationCount();
+    g_engine->timer.allocatedBytesMark = BE_MemoryAllocatedBytes();
+    g_engine->timer.allocationCheck = enabled;
+}
+
+BE_Arena* BE_IMPL_GetFrameArena(const char* file, int line) {
+    BE_CheckEngineActive(file, line, NULL);
+    return &g_engine->frame;
+}
+
+// ==============================
+// Async Loading
+// ==============================
+
+BE_LoadHandle BE_IMPL_LoadMeshAsync(const char* meshName, const char* objFile, BE_LoadCallback callback, void* userData, const char* file, int line) {
+    BE_CheckEngineActive(file, line, -1);
+    if (!objFile) { BE_IMPL_Message(2, "Mesh", file, line, "Failed to find file '%s'", objFile); return -1; }
+
+    char buffer[128];
+    if (!meshName) {
+        snprintf(buffer, sizeof(buffer), "mesh%zu", g_engine->resources.meshes.pool.size+1);
+        meshName = buffer;
+        BE_IMPL_Message(1, "Mesh", file, line, "No name provided; defaulted to '%s'", meshName);
+    }
+
+    // Shares the cube's buffers until the load is finalized
+    BE_Mesh placeholder = g_engine->resources.defaultCubeMesh;
+    placeholder.name = BE_MemStrdup(meshName, BE_MEMORY_MESH);
+
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
+    BE_MeshVectorPush(&g_engine->resources.meshes, placeholder);
+    BE_RenderThreadReturnContext(g_engine->renderThread);
+
+    const char* files[4] = {objFile, NULL, NULL, NULL};
+    return BE_LoaderSubmit(g_engine->loader, BE_LOAD_MESH, meshName, files, callback, userData);
+}
+
+BE_LoadHandle BE_IMPL_LoadTextureAsync(const char* textureName, const char* imageFile, BE_LoadCallback callback, void* userData, const char* file, int line) {
+    BE_CheckEngineActive(file, line, -1);
+    if (!imageFile) { BE_IMPL_Message(2, "Texture", file, line, "Failed to find file '%s'", imageFile); return -1; }
+
+    char buffer[128];
+    if (!textureName) {
+        snprintf(buffer, sizeof(buffer), "texture%zu", g_engine->resources.textures.pool.size+1);
+        textureName = buffer;
+        BE_IMPL_Message(1, "Texture", file, line, "No name provided; defaulted to '%s'", textureName);
+    }
+
+    BE_Texture placeholder = g_engine->resources.defaultTexture;
+    placeholder.name = BE_MemStrdup(textureName, BE_MEMORY_TEXTURE);
+    placeholder.type = BE_MemStrdup("texture", BE_MEMORY_TEXTURE);
+
+    BE_RenderThreadBorrowContext(g_engine->renderThread);
+    BE_TextureVectorPush(&g_engine->resources.textures, placeholder);
+    BE_RenderThreadReturnContext(g_engine->renderThread);
+
+    const char* files[4] = {imageFile, NULL, NULL, NULL};
+    return BE_LoaderSubmit(g_engine->loader, BE_LOAD_TEXTURE, textureName, files, callback, userData);
+}
+
+BE_LoadHandle BE_IMPL_LoadSoundAsync(const char* soundName, const char* soundFile, BE_LoadCallback callback, void* userData, const char* file, int line) {
+    BE_CheckEngineActive(file, line, -1);
+    if (!soundFile) { BE_IMPL_Message(2, "Sound", file, line, "Failed to find file '%s'", soundFile); return -1; }
+
+    char buffer[128];
+    if (!soundName) {
+        snprintf(buffer, sizeof(buffer), "sound%zu", g_engine->resources.sounds.size+1);
+        soundName = buffer;
+        BE_IMPL_Message(1, "Sound", file, line, "No name provided; defaulted to '%s'", soundName);
+    }
+
+    const char* files[4] = {soundFile, NULL, NULL, NULL};
+    return BE_LoaderSubmit(g_engine->loader, BE_LOAD_SOUND, soundName, files, callback, userData);
+}
+
+BE_LoadHandle BE_IMPL_LoadShaderAsync(const char* shaderName, const char* vertexFile, const char* fragmentFile, const char* geometryFile, const char* computeFile, BE_LoadCallback callback, void* userData, const char* file, int line) {
+    BE_CheckEngineActive(file, line, -1);
+
+    char buffer[128];
+    if (!shaderName) {
+        snprintf(buffer, sizeof(buffer), "shader%zu", g_engine->resources.shaders.size+1);
+        shaderName = buffer;
+        BE_IMPL_Message(1, "Shader", file, line, "No name provided; defaulted to '%s'", shaderName);
+    }
+
+    const char* files[4] = {vertexFile, fragmentFile, geometryFile, computeFile};
+    return BE_LoaderSubmit(g_engine->loader, BE_LOAD_SHADER, shaderName, files, callback, userData);
+}
+
+BE_LoadState BE_IMPL_GetLoadState(BE_LoadHandle handle, const char* file, int line) {
+    BE_CheckEngineActive(file, line, BE_LOAD_FAILED);
+    if (handle < 0 || (size_t)handle >= g_engine->loader->size) { BE_IMPL_Message(2, "Loader", file, line, "Invalid load handle '%d'", handle); return BE_LOAD_FAILED; }
+    return (BE_LoadState)atomic_load(&g_engine->loader->requests[handle]->state);
+}
+
+int BE_IMPL_GetPendingLoads(const char* file, int line) {
+    BE_CheckEngineActive(file, line, 0);
+    return (int)g_engine->loader->unfinished;
+}
+
+void BE_IMPL_SetLoadBudget(double milliseconds, const char* file, int line) {
+    BE_CheckEngineActive(file, line,);
+    g_engine->loader->budgetMs = milliseconds > 0.0 ? milliseconds : 0.0;
+}
+
 // ==============================
 // Audio Emitters
 // ==============================
@@ -3632,21 +6143,26 @@ void BE_IMPL_AddEmitter(const char* emitterName, bool spatial, const char* file,
         BE_IMPL_Message(1, "Emitter", file, line, "No name provided; defaulted to '%s'", emitterName);
     }
 
-    BE_EmitterVectorPush(&g_engine->activeScene->emitters, BE_EmitterInit(emitterName, (vec3){0,0,0}, spatial));
+    BE_EmitterVector* emitters = &g_engine->activeScene->emitters;
+    BE_EmitterVectorPush(emitters, BE_EmitterInit(emitterName, (vec3){0,0,0}, spatial));
+    emitters->data[emitters->size - 1].entity = BE_SceneAddEntity(g_engine->activeScene, BE_COMPONENT_AUDIO_EMITTER, BE_RegistryHandle(&emitters->registry, emitters->size - 1));
 }
 
 void BE_IMPL_RemoveEmitter(const char* emitterName, const char* file, int line) {
     BE_CheckSceneActive(file, line,);
     BE_Emitter* emitter = BE_FindEmitterPtr(&g_engine->activeScene->emitters, emitterName);
     if (!emitter) { BE_IMPL_Message(2, "Emitter", file, line, "Failed to find emitter '%s'", emitterName); return; }
+    BE_WorldDestroy(g_engine->activeScene->world, emitter->entity);
     BE_EmitterVectorRemove(&g_engine->activeScene->emitters, emitter);
 }
 
 void BE_IMPL_RemoveAllEmitters(const char* file, int line) {
     BE_CheckSceneActive(file, line,);
-    for (int i = 0; i < g_engine->activeScene->emitters.size; i++) {
-        BE_Emitter* emitter = &g_engine->activeScene->emitters.data[i];
-        BE_EmitterVectorRemove(&g_engine->activeScene->emitters, emitter);
+    BE_EmitterVector* emitters = &g_engine->activeScene->emitters;
+    while (emitters->size > 0) {
+        BE_Emitter* emitter = &emitters->data[emitters->size - 1];
+        BE_WorldDestroy(g_engine->activeScene->world, emitter->entity);
+        BE_EmitterVectorRemove(emitters, emitter);
     }
 }
 
@@ -3657,6 +6173,20 @@ BE_Emitter* BE_IMPL_FindEmitter(const char* emitterName, const char* file, int l
     return emitter;
 }
 
+BE_Handle BE_IMPL_GetEmitterHandle(const char* emitterName, const char* file, int line) {
+    BE_CheckSceneActive(file, line, BE_HANDLE_NONE);
+    BE_Handle handle = BE_RegistryFind(&g_engine->activeScene->emitters.registry, emitterName);
+    if (!handle) { BE_IMPL_Message(2, "Emitter", file, line, "Failed to find emitter '%s'", emitterName); }
+    return handle;
+}
+
+BE_Emitter* BE_IMPL_GetEmitter(BE_Handle handle, const char* file, int line) {
+    BE_CheckSceneActive(file, line, NULL);
+    BE_Emitter* emitter = BE_GetEmitterPtr(&g_engine->activeScene->emitters, handle);
+    if (!emitter) { BE_IMPL_Message(2, "Emitter", file, line, "Emitter handle 0x%08x is stale or invalid", (unsigned)handle); return NULL; }
+    return emitter;
+}
+
 bool BE_IMPL_CheckEmitter(const char* emitterName, const char* file, int line) {
     BE_CheckSceneActive(file, line, false);
     BE_Emitter* emitter = BE_FindEmitterPtr(&g_engine->activeScene->emitters, emitterName);
@@ -3664,23 +6194,23 @@ bool BE_IMPL_CheckEmitter(const char* emitterName, const char* file, int line) {
 }
 
 void BE_IMPL_DrawEmitters(const char* shaderName, const char* file, int line) {
+    BE_PROFILE_SCOPE("BE_DrawEmitters");
     BE_CheckCameraActive(file, line,);
+    BE_Handle shader = BE_DrawShaderHandle(shaderName, "Emitter", "emitter", file, line);
+    if (g_engine->renderThread) { BE_RenderThreadRecord(g_engine->renderThread, BE_RENDER_DRAW_EMITTERS, false, shader, file, line); return; }
+    BE_RenderEmitters(g_engine, shader);
+}
+
+static void BE_RenderEmitters(BE_Engine* engine, BE_Handle shaderHandle) {
+    BE_PROFILE_FUNCTION();
+    BE_GPU_SCOPE(engine->gpuTimer, "Emitters");
+    BE_Shader* shader = BE_DrawShader(engine, shaderHandle, &engine->resources.defaultColorShader);
     
-    BE_Shader* shader = {0};
-    if (!shaderName) {
-        shader = &g_engine->resources.defaultColorShader;
-    } else {
-        shader = BE_FindShaderPtr(&g_engine->resources.shaders, shaderName);
-        if (!shader) {
-            BE_IMPL_Message(1, "Emitter", file, line, "Failed to find shader '%s'. Using default emitter shader", shaderName);
-            shader = &g_engine->resources.defaultColorShader;
-        }
-    }
-    
-    BE_CameraMatrixUploadPersp(g_engine->activeScene->activeCamera, shader, "camMatrix");
+    BE_CameraMatrixUploadPersp(engine->activeScene->activeCamera, shader, "camMatrix");
 
     BE_ShaderActivate(shader);
 
+    BE_RENDER_COUNT(uniformUploads, 1);
     glUniform3fv(glGetUniformLocation(shader->ID, "color"), 1, (float[]){1.0f, 1.0f, 1.0f});
     
     glEnable(GL_DEPTH_TEST);
@@ -3689,12 +6219,13 @@ void BE_IMPL_DrawEmitters(const char* shaderName, const char* file, int line) {
     glEnable(GL_BLEND);
 
     mat4 model;
-    for (size_t i = 0; i < g_engine->activeScene->emitters.size; i++) {
-        BE_Emitter* source = &g_engine->activeScene->emitters.data[i];
+    for (size_t i = 0; i < engine->activeScene->emitters.size; i++) {
+        BE_Emitter* source = &engine->activeScene->emitters.data[i];
 
         BE_MakeModelMatrix(source->position, (vec3){0,0,0}, (vec3){0.1f,0.1f,0.1f}, model);
+        BE_RENDER_COUNT(uniformUploads, 1);
         glUniformMatrix4fv(glGetUniformLocation(shader->ID, "model"), 1, GL_FALSE, (float*)model);
-        BE_MeshDraw(&g_engine->resources.defaultCubeMesh, shader);
+        BE_MeshDraw(&engine->resources.defaultCubeMesh, shader);
     }
 }
 
@@ -3756,6 +6287,17 @@ void BE_IMPL_SetEmitterPosition(const char* emitterName, const vec3 position, co
     BE_EmitterSetPosition(emitter, position);
 }
 
+void BE_IMPL_SetEmitterPositionByHandle(BE_Handle handle, const vec3 position, const char* file, int line) {
+    BE_CheckSceneActive(file, line,);
+
+    BE_Emitter* emitter = BE_GetEmitterPtr(&g_engine->activeScene->emitters, handle);
+    if (!emitter) { BE_IMPL_Message(2, "Emitter", file, line, "Emitter handle 0x%08x is stale or invalid", (unsigned)handle); return; }
+
+    if (!position) { BE_IMPL_Message(2, "Emitter", file, line, "Expected position value cannot be NULL"); return; }
+
+    BE_EmitterSetPosition(emitter, position);
+}
+
 void BE_IMPL_SetEmitterPositionToCamera(const char* emitterName, const char* cameraName, const char* file, int line) {
     BE_CheckCameraActive(file, line,);
     BE_Camera* camera = BE_FindCameraPtr(&g_engine->activeScene->cameras, cameraName);
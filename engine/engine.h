@@ -3,6 +3,11 @@
 #include <engine/glad/glad.h>
 #include <engine/GLFW/glfw3.h>
 #include <engine/cglm/cglm.h>
+#include <engine/engine_transform.h>
+#include <engine/engine_jobs.h>
+#include <engine/engine_ecs.h>
+#include <engine/engine_memory.h>
+#include <engine/engine_profile.h>
 #include <engine/stb_image/stb_image.h>
 #include <engine/stb_image/stb_image_resize.h>
 #include <engine/stb_image/stb_truetype.h>
@@ -18,6 +23,9 @@
 //     #define BE_LINE() __LINE__
 // #endif
 
+// Severity 0 info, 1 warning, 2 error, 3 fatal and exits
+void BE_IMPL_Message(int severity, const char* module, const char* file, int line, const char* fmt, ...);
+
 #define BE_vec2(x,y) ((vec2){x,y})
 #define BE_vec3(x,y,z) ((vec3){x,y,z})
 #define BE_vec4(x,y,z,w) ((vec4){x,y,z,w})
@@ -41,10 +49,38 @@ void BE_VersorToEuler(versor q, vec3 outEuler);
 void BE_Vec3RotateAxis(vec3 in, vec3 axis, float angle_rad, vec3 out);
 
 #define FPS_HISTORY_COUNT 20
+#define FRAME_TIME_HISTORY 1024    // frames kept for the percentiles, about 17 s at 60 Hz
+#define FRAME_HISTOGRAM_BINS 10
+
+// Spread of the recorded frame times, the averaged FPS hides single slow frames
+typedef struct {
+    int count;
+    float minMs, avgMs, p50Ms, p95Ms, p99Ms, maxMs;
+    unsigned int histogram[FRAME_HISTOGRAM_BINS]; // frames per bin, see BE_FrameHistogramBinMs()
+} BE_FrameTimeSummary;
 
+// Work the draw paths handed to GL, counted by whichever thread owns the context
 typedef struct {
-    clock_t previousTime;
-    clock_t currentTime;
+    uint32_t drawCalls;
+    uint64_t triangles;
+    uint32_t stateChanges;         // program, vertex array and framebuffer binds
+    uint32_t uniformUploads;       // glUniform calls and buffer ranges bound for shaders
+    uint32_t textureBinds;
+    uint32_t shadowPasses;         // shadow maps rendered, a point light's cube counts once
+    uint32_t visibleObjects;       // models and sprites left after camera culling
+    uint32_t culledObjects;
+} BE_RenderStats;
+
+extern BE_RenderStats g_renderStats;
+
+#define BE_RENDER_COUNT(field, n) (g_renderStats.field += (n))
+#define BE_RENDER_COUNT_DRAW(vertices) (g_renderStats.drawCalls++, g_renderStats.triangles += (uint64_t)(vertices) / 3)
+
+void BE_RenderStatsTake(BE_RenderStats* outStats); // the counts so far, then starts over
+
+typedef struct {
+    uint64_t previousTime;         // BE_ThreadClockNs(), wall time even when blocked on swap
+    uint64_t currentTime;
     float dt;
 
     int frameCount;
@@ -58,9 +94,30 @@ typedef struct {
     int fpsHistoryIndex;
     int fpsHistoryCount;
 
+    float frameTimes[FRAME_TIME_HISTORY]; // ms, ring
+    int frameTimeIndex;
+    int frameTimeCount;
+    BE_FrameTimeSummary frameTime;        // refreshed with fps
+
+    // Memory over the previous frame, taken by BE_BeginFrame
+    size_t cpuBytes;               // live tracked heap
+    size_t cpuPeakBytes;
+    size_t gpuBytes;               // estimated
+    uint64_t frameAllocations;
+    uint64_t frameAllocatedBytes;
+    uint64_t allocationMark;       // counters when the frame began
+    uint64_t allocatedBytesMark;
+    bool allocationCheck;          // a frame that allocates is fatal, see BE_SetAllocationCheck()
+
+    BE_RenderStats render;         // the previous frame's draw work
+
 } BE_FrameStats;
 
+void BE_FrameStatsInit(BE_FrameStats* info);
 float BE_UpdateFrameTimeInfo(BE_FrameStats* info);
+void BE_FrameStatsSummarize(const BE_FrameStats* info, BE_FrameTimeSummary* outSummary); // sorts a copy of the ring
+float BE_FrameHistogramBinMs(int bin); // upper edge, INFINITY for the last bin
+void BE_UpdateFrameMemoryInfo(BE_FrameStats* info, const char* file, int line);
 
 #define MAX_JOYSTICKS GLFW_JOYSTICK_16+1
 
@@ -131,12 +188,14 @@ typedef struct {
     vec2 texUV;
 } BE_Vertex;
 
+#define INITIAL_VERTEX_CAPACITY 256
+
 typedef struct {
-    BE_Vertex* data;
-    size_t size;
-    size_t capacity;
+    BE_VECTOR_FIELDS(BE_Vertex);
 } BE_VertexVector;
 
+BE_VECTOR_DEFINE(BE_VertexVector, BE_Vertex, INITIAL_VERTEX_CAPACITY, VECTOR_GROWTH, BE_MEMORY_MESH)
+
 void BE_VertexVectorInit(BE_VertexVector* vec);
 void BE_VertexVectorPush(BE_VertexVector* vec, BE_Vertex value);
 void BE_VertexVectorFree(BE_VertexVector* vec);
@@ -147,12 +206,14 @@ typedef struct {
     GLuint ID;
 } BE_VAO;
 
+#define INITIAL_VAO_CAPACITY 16
+
 typedef struct {
-    BE_VAO* data;
-    size_t size;
-    size_t capacity;
+    BE_VECTOR_FIELDS(BE_VAO);
 } BE_VAOVector;
 
+BE_VECTOR_DEFINE(BE_VAOVector, BE_VAO, INITIAL_VAO_CAPACITY, VECTOR_GROWTH, BE_MEMORY_RENDER)
+
 BE_VAO BE_VAOInit(const char* name);
 BE_VAO BE_VAOInitQuad(const char* name);
 BE_VAO BE_VAOInitSprite(const char* name);
@@ -169,6 +230,7 @@ void BE_VAOVectorCopy(BE_VAO* vaos, size_t count, BE_VAOVector* outVec);
 
 typedef struct {
     GLuint ID;
+    size_t bytes;
 } BE_VBO;
 
 BE_VBO BE_VBOInitFromData(GLfloat* vertices, GLsizeiptr size);
@@ -178,12 +240,14 @@ void BE_VBOUnbind();
 void BE_VBODelete(BE_VBO* vbo);
 void BE_LinkVertexAttribToVBO(BE_VBO* vbo, GLuint layout, GLuint numComponents, GLenum type, GLsizeiptr stride, void* offset);
 
+#define INITIAL_GLUINT_CAPACITY 256
+
 typedef struct {
-    GLuint* data;
-    size_t size;
-    size_t capacity;
+    BE_VECTOR_FIELDS(GLuint);
 } BE_GLuintVector;
 
+BE_VECTOR_DEFINE(BE_GLuintVector, GLuint, INITIAL_GLUINT_CAPACITY, VECTOR_GROWTH, BE_MEMORY_MESH)
+
 void BE_GLuintVectorInit(BE_GLuintVector* vec);
 void BE_GLuintVectorPush(BE_GLuintVector* vec, GLuint value);
 void BE_GLuintVectorFree(BE_GLuintVector* vec);
@@ -191,6 +255,7 @@ void BE_GLuintVectorCopy(GLuint* data, size_t count, BE_GLuintVector* outVec);
 
 typedef struct {
     GLuint ID;
+    size_t bytes;
 } BE_EBO;
 
 BE_EBO BE_EBOInitFromData(GLuint* indices, GLsizeiptr size);
@@ -199,18 +264,161 @@ void BE_EBOBind(BE_EBO* ebo);
 void BE_EBOUnbind();
 void BE_EBODelete(BE_EBO* ebo);
 
+// One persistently mapped buffer split into a region per frame in flight. Per frame data is
+// written straight into the mapping, a fence per region tells when it can be written again.
+#define STREAM_FRAMES 3
+#define STREAM_REGION_SIZE (4 * 1024 * 1024)
+
+typedef struct {
+    GLuint ID;
+    unsigned char* mapped;
+    size_t regionSize;
+    GLsync fences[STREAM_FRAMES];
+    int region;                  // region written this frame
+    size_t offset;               // next free byte inside the region
+    size_t highWater;            // most bytes used by a single frame
+
+    GLint uniformAlign;          // GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    GLint storageAlign;          // GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT
+} BE_StreamRing;
+
+typedef struct {
+    void* ptr;                   // write target, valid until the end of the frame
+    GLuint buffer;
+    GLintptr offset;
+    GLsizeiptr size;
+} BE_StreamAlloc;
+
+void BE_StreamRingInit(BE_StreamRing* ring, size_t regionSize);
+void BE_StreamRingBeginFrame(BE_StreamRing* ring);
+void BE_StreamRingEndFrame(BE_StreamRing* ring);
+bool BE_StreamRingAlloc(BE_StreamRing* ring, size_t size, size_t alignment, BE_StreamAlloc* out);
+void BE_StreamRingFree(BE_StreamRing* ring);
+
+// Per pass GPU times from timestamp queries. A frame's queries are read back a few frames
+// later and only once the driver says they are available, so timing never waits on the GPU.
+// Passes are named ranges, they nest and a name used more than once a frame is summed.
+#define GPU_TIMER_FRAMES 4           // frames in flight before a frame's results are dropped
+#define GPU_TIMER_MAX_RANGES 32      // per frame, later ranges are not timed
+#define GPU_TIMER_MAX_PASSES 32      // distinct names
+#define GPU_TIMER_SMOOTHING 0.05f    // weight of the newest frame in the average
+
+typedef struct {
+    const char* name;            // not copied
+    float lastMs;                // newest frame read back
+    float avgMs;                 // exponential moving average
+    uint64_t frames;             // frames the pass ran in
+} BE_GpuPassTime;
+
+typedef struct {
+    GLuint queries[GPU_TIMER_MAX_RANGES * 2]; // begin and end timestamp per range
+    const char* names[GPU_TIMER_MAX_RANGES];
+    bool closed[GPU_TIMER_MAX_RANGES];
+    int count;                   // ranges begun
+    bool pending;                // issued and not read back yet
+} BE_GpuTimerFrame;
+
+typedef struct {
+    bool supported;              // false without timestamp bits or with profiling compiled out
+    BE_GpuTimerFrame frames[GPU_TIMER_FRAMES];
+    int frame;                   // recorded into this frame
+    int frameRange;              // the range spanning the whole frame, -1 outside one
+    int64_t clockOffset;         // BE_ThreadClockNs() minus GL_TIMESTAMP, taken at each read back
+    uint64_t dropped;            // frames whose results were not available in time
+
+    BE_GpuPassTime passes[GPU_TIMER_MAX_PASSES];
+    int passCount;
+    BE_Mutex mutex;              // guards passes, readers may be on another thread than the context
+    BE_ProfileThread* track;     // "GPU" row in profiler captures
+} BE_GpuTimer;
+
+void BE_GpuTimerInit(BE_GpuTimer* timer);
+void BE_GpuTimerFree(BE_GpuTimer* timer);
+void BE_GpuTimerBeginFrame(BE_GpuTimer* timer);   // reads back finished frames and opens the "Frame" range
+void BE_GpuTimerEndFrame(BE_GpuTimer* timer);
+int BE_GpuTimerBegin(BE_GpuTimer* timer, const char* name); // range index, -1 when not timed
+void BE_GpuTimerEnd(BE_GpuTimer* timer, int range);
+int BE_GpuTimerGetPasses(BE_GpuTimer* timer, BE_GpuPassTime* outPasses, int maxPasses);
+
+typedef struct {
+    BE_GpuTimer* timer;
+    int range;
+} BE_GpuZone;
+
+static inline void BE_GpuZoneEnd(BE_GpuZone* zone) {
+    BE_GpuTimerEnd(zone->timer, zone->range);
+}
+
+// Times the rest of the enclosing scope on the GPU, only on the thread that owns the context
+#ifdef BE_PROFILE_ENABLED
+#define BE_GPU_SCOPE(timer, name) \
+    BE_GpuZone BE_PROFILE_CONCAT(beGpuZone, __LINE__) __attribute__((cleanup(BE_GpuZoneEnd))) = { timer, BE_GpuTimerBegin(timer, name) }
+#else
+#define BE_GPU_SCOPE(timer, name) ((void)0)
+#endif
+
+// Handles are 32 bit ids for objects kept in vectors: the low bits pick a slot, the high bits
+// are that slot's generation. Removing an object bumps the generation, so old handles stop
+// resolving instead of pointing at whatever moved into its place. Slots map to the object's
+// current index, vectors keep that mapping up to date when removal shifts elements.
+typedef uint32_t BE_Handle;
+
+#define BE_HANDLE_NONE 0
+#define HANDLE_INDEX_BITS 20
+#define HANDLE_INDEX_MASK ((1u << HANDLE_INDEX_BITS) - 1)
+#define HANDLE_GENERATION_MASK ((1u << (32 - HANDLE_INDEX_BITS)) - 1)
+
+typedef struct {
+    uint32_t hash;
+    uint32_t slot;               // slot + 1, 0 for an empty bucket
+} BE_NameBucket;
+
+typedef struct {
+    uint32_t* indices;           // slot -> index in the owning vector
+    uint16_t* generations;       // slot -> current generation, never 0
+    char** names;                // slot -> owned copy of the name
+    uint32_t* slots;             // index -> slot
+    uint32_t* freeSlots;
+    size_t slotCount, slotCapacity;
+    size_t freeCount, indexCapacity;
+
+    BE_NameBucket* buckets;      // open addressing, power of two, at most 3/4 full
+    size_t bucketCount;
+    size_t nameCount;
+    size_t duplicateNames;       // slots whose name an earlier slot already holds
+
+    uint16_t salt;               // first generation of new slots, differs between registries
+} BE_Registry;
+
+uint32_t BE_HashString(const char* string);
+void BE_RegistryInit(BE_Registry* registry);
+void BE_RegistryFree(BE_Registry* registry);
+BE_Handle BE_RegistryAdd(BE_Registry* registry, const char* name, size_t index);
+void BE_RegistryRemoveSwap(BE_Registry* registry, size_t index, size_t size);
+BE_Handle BE_RegistryHandle(BE_Registry* registry, size_t index);
+size_t BE_RegistryIndex(BE_Registry* registry, BE_Handle handle);  // SIZE_MAX for stale handles
+BE_Handle BE_RegistryFind(BE_Registry* registry, const char* name);
+size_t BE_RegistryFindIndex(BE_Registry* registry, const char* name); // SIZE_MAX if not found
+size_t BE_RegistryFindBucket(BE_Registry* registry, const char* name, uint32_t hash);
+bool BE_RegistryInsertName(BE_Registry* registry, uint32_t slot); // false if the name is taken
+bool BE_RegistryRemoveName(BE_Registry* registry, uint32_t slot);
+
 typedef struct {
     char* name;
     GLuint ID;
 } BE_Shader;
 
+#define INITIAL_SHADER_CAPACITY 8
+
 typedef struct {
-    BE_Shader* data;
-    size_t size;
-    size_t capacity;
+    BE_VECTOR_FIELDS(BE_Shader);
+    BE_Registry registry;       // names and handles
 } BE_ShaderVector;
 
+BE_VECTOR_DEFINE(BE_ShaderVector, BE_Shader, INITIAL_SHADER_CAPACITY, VECTOR_GROWTH, BE_MEMORY_SHADER)
+
 char* BE_GetFileContents(const char* filename);
+char* BE_GetFileBytes(const char* filename, size_t* outSize);
 void BE_ShaderGetCompileErrors(unsigned int shader, const char* type);
 BE_Shader BE_ShaderInit(const char* name, const char* vertexFile, const char* fragmentFile, const char* geometryFile, const char* computeFile);
 BE_Shader BE_ShaderInitString(const char* name, const char* vertexSource, const char* fragmentSource, const char* geometrySource, const char* computeSource);
@@ -223,12 +431,13 @@ void BE_ShaderVectorFree(BE_ShaderVector* vec);
 void BE_ShaderVectorCopy(BE_Shader* shaders, size_t count, BE_ShaderVector* outVec);
 
 static inline BE_Shader* BE_FindShaderPtr(BE_ShaderVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
+}
+
+static inline BE_Shader* BE_GetShaderPtr(BE_ShaderVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
 }
 
 typedef struct {
@@ -253,15 +462,63 @@ typedef struct {
     GLuint ID;
     char* type;
     GLuint unit;
+
+    int atlasPage;  // -1 if the texture owns its GL object, otherwise ID is the page's
+    vec4 atlasRect; // u0, v0, u1, v1 inside the page
+    size_t gpuBytes; // estimated, 0 when the atlas owns the storage
 } BE_Texture;
 
 typedef struct {
-    BE_Texture* data;
+    BE_Pool pool;               // stable addresses, sprites point at their texture
+    BE_Registry registry;       // names and handles
+} BE_TextureVector;
+
+// Small sprite images are packed into shared pages, larger ones keep their own texture
+#define ATLAS_PAGE_SIZE 2048
+#define ATLAS_PADDING 4
+#define ATLAS_MAX_ENTRY 512
+#define ATLAS_MIP_LEVELS 3
+
+typedef struct {
+    int x, y, width;
+} BE_SkylineNode;
+
+typedef struct {
+    GLuint ID;
+    BE_SkylineNode* skyline;
+    size_t skylineSize;
+    size_t skylineCapacity;
+    bool mipsDirty;
+} BE_AtlasPage;
+
+typedef struct {
+    BE_AtlasPage* pages;
     size_t size;
     size_t capacity;
-} BE_TextureVector;
+    int pageSize;
+} BE_TextureAtlas;
+
+void BE_TextureAtlasInit(BE_TextureAtlas* atlas, int pageSize);
+bool BE_TextureAtlasInsert(BE_TextureAtlas* atlas, unsigned char* pixels, int width, int height, int* outPage, vec4 outRect);
+void BE_TextureAtlasUpdateMips(BE_TextureAtlas* atlas);
+void BE_TextureAtlasFree(BE_TextureAtlas* atlas);
+bool BE_AtlasPageFind(BE_AtlasPage* page, int pageSize, int width, int height, int* outX, int* outY, size_t* outIndex);
+void BE_AtlasPageAdd(BE_AtlasPage* page, size_t index, int x, int y, int width, int height);
+
+// Decoded pixels, loading them needs no GL so it can run on a loader thread
+typedef struct {
+    unsigned char* pixels;
+    int width, height, channels;
+} BE_Image;
+
+bool BE_ImageLoad(const char* imageFile, int channels, BE_Image* outImage);
+bool BE_ImageLoadForAtlas(const char* imageFile, BE_Image* outImage);
+void BE_ImageFree(BE_Image* image);
 
 BE_Texture BE_TextureInit(const char* name, const char* imageFile, const char* texType, GLenum slot);
+BE_Texture BE_TextureInitFromImage(const char* name, BE_Image* image, const char* texType, GLuint slot);
+BE_Texture BE_TextureInitAtlas(const char* name, const char* imageFile, BE_TextureAtlas* atlas);
+BE_Texture BE_TextureInitAtlasFromImage(const char* name, BE_Image* image, BE_TextureAtlas* atlas);
 void BE_TextureSetUniformUnit(BE_Shader* shader, const char* uniform, GLuint unit);
 void BE_TextureBind(BE_Texture* texture);
 void BE_TextureUnbind();
@@ -272,17 +529,23 @@ void BE_TextureVectorPush(BE_TextureVector* vec, BE_Texture value);
 void BE_TextureVectorFree(BE_TextureVector* vec);
 void BE_TextureVectorCopy(BE_Texture* textures, size_t count, BE_TextureVector* outVec);
 
+static inline BE_Texture* BE_TextureVectorAt(BE_TextureVector* vec, size_t index) {
+    return (BE_Texture*)BE_PoolAt(&vec->pool, index);
+}
+
 static inline BE_Texture* BE_FindTexturePtr(BE_TextureVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? BE_TextureVectorAt(vec, index) : NULL;
+}
+
+static inline BE_Texture* BE_GetTexturePtr(BE_TextureVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? BE_TextureVectorAt(vec, index) : NULL;
 }
 
 typedef struct {
     char* name;
+    BE_Entity entity;
     int width, height;
     float zoom, fov;
     float nearPlane, farPlane;
@@ -294,9 +557,8 @@ typedef struct {
 } BE_Camera;
 
 typedef struct {
-    BE_Camera* data;
-    size_t size;
-    size_t capacity;
+    BE_Pool pool;               // stable addresses for activeCamera
+    BE_Registry registry;       // names and handles
 } BE_CameraVector;
 
 BE_Camera BE_CameraInit(const char* name, int width, int height, float fov, float nearPlane, float farPlane, vec3 position, vec3 direction);
@@ -313,13 +575,18 @@ void BE_CameraVectorFree(BE_CameraVector* vec);
 void BE_CameraVectorCopy(BE_Camera* lights, size_t count, BE_CameraVector* outVec);
 void BE_CameraVectorUpdateMatrix(BE_CameraVector* vec, int width, int height);
 
+static inline BE_Camera* BE_CameraVectorAt(BE_CameraVector* vec, size_t index) {
+    return (BE_Camera*)BE_PoolAt(&vec->pool, index);
+}
+
 static inline BE_Camera* BE_FindCameraPtr(BE_CameraVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? BE_CameraVectorAt(vec, index) : NULL;
+}
+
+static inline BE_Camera* BE_GetCameraPtr(BE_CameraVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? BE_CameraVectorAt(vec, index) : NULL;
 }
 
 typedef struct {
@@ -328,39 +595,67 @@ typedef struct {
     BE_GLuintVector indices;
     BE_TextureVector textures;
     BE_VAO vao;
+    BE_VBO vbo;
+    BE_EBO ebo;
+    BE_VAO depthVao; // position-only stream for depth passes, shares the EBO
+    BE_VBO depthVbo;
+    vec3 bounds[2];  // local space AABB
 } BE_Mesh;
 
 typedef struct {
-    BE_Mesh* data;
-    size_t size;
-    size_t capacity;
+    BE_Pool pool;               // stable addresses, models point at their mesh
+    BE_Registry registry;       // names and handles
 } BE_MeshVector;
 
 BE_Mesh BE_MeshInitFromVertex(const char* name, BE_VertexVector vertices, BE_GLuintVector indices, BE_TextureVector textures);
 BE_Mesh BE_MeshInitFromData(const char* name, const char** texbuffer, int texcount, BE_Vertex* vertices, int vertcount, GLuint* indices, int indcount);
 void BE_MeshDraw(BE_Mesh* mesh, BE_Shader* shader);
+void BE_MeshDrawDepth(BE_Mesh* mesh);
 void BE_MeshDrawBillboard(BE_Mesh* mesh, BE_Shader* shader, BE_Texture* texture);
+void BE_MeshDelete(BE_Mesh* mesh);
 
 int BE_FindOrAddVertex(BE_Vertex* vertices, int* verticesCount, BE_Vertex v);
 void BE_ReplacePathSuffix(const char* path, const char* newsuffix, char* dest, int destsize);
 int BE_CountFaceVertices(const char* line);
+char* BE_NextToken(char** cursor, const char* delims);
 BE_Mesh BE_LoadOBJToMesh(const char* name, const char* obj_path);
 BE_Mesh BE_LoadOBJFromString(const char* name, const char* obj_contents);
 const char** BE_LoadMTLTextures(const char* mtl_path, int* outCount);
 
+// CPU side of an OBJ import, everything BE_MeshInitFromOBJData needs to create GL objects
+typedef struct {
+    BE_Vertex* vertices;
+    int verticesCount;
+    GLuint* indices;
+    int indicesCount;
+    char* texturePath;  // only the first MTL texture is bound, like BE_LoadOBJToMesh
+    char* textureType;
+    BE_Image image;     // filled by BE_OBJDataLoadImage
+} BE_OBJData;
+
+bool BE_ParseOBJ(const char* obj_path, BE_OBJData* outData);
+bool BE_OBJDataLoadImage(BE_OBJData* data);
+void BE_OBJDataFree(BE_OBJData* data);
+BE_Mesh BE_MeshInitFromOBJData(const char* name, BE_OBJData* data);
+
 void BE_MeshVectorInit(BE_MeshVector* vec);
 void BE_MeshVectorPush(BE_MeshVector* vec, BE_Mesh value);
 void BE_MeshVectorFree(BE_MeshVector* vec);
 void BE_MeshVectorCopy(BE_Mesh* meshes, size_t count, BE_MeshVector* outVec);
 void BE_CameraVectorDraw(BE_CameraVector* vec, BE_Mesh* mesh, BE_Shader* shader, BE_Camera* selected);
 
+static inline BE_Mesh* BE_MeshVectorAt(BE_MeshVector* vec, size_t index) {
+    return (BE_Mesh*)BE_PoolAt(&vec->pool, index);
+}
+
 static inline BE_Mesh* BE_FindMeshPtr(BE_MeshVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? BE_MeshVectorAt(vec, index) : NULL;
+}
+
+static inline BE_Mesh* BE_GetMeshPtr(BE_MeshVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? BE_MeshVectorAt(vec, index) : NULL;
 }
 
 typedef struct {
@@ -371,35 +666,74 @@ typedef struct {
 
 typedef struct {
     char* name;
+    BE_Entity entity;          // in the scene's world, see BE_ComponentType
     BE_Mesh* mesh;
-    BE_Transform transform;
+    BE_Transform transform;    // local to the parent, edit through the setters so it gets marked dirty
+
+    int parent;                // index in the model vector, -1 for roots
+    bool dirty;                // transform changed since the last update
+    bool moved;                // world matrix changed in the last update
+    mat4 worldMatrix;
+
+    // shadow cache bookkeeping
+    unsigned int epoch;        // model clock value of the last change
+    BE_Mesh* cachedMesh;
+    vec3 bounds[2];            // world space AABB
+    vec3 prevBounds[2];        // world space AABB before the last change
 } BE_Model;
 
+#define INITIAL_MODEL_CAPACITY 16
+
 typedef struct {
-    BE_Model* data;
-    size_t size;
-    size_t capacity;
+    BE_VECTOR_FIELDS(BE_Model);
+    BE_Registry registry;       // names and handles
+
+    unsigned int epoch;          // bumped for every caster change
+    unsigned int structureEpoch; // bumped when models are added or removed
+
+    size_t* order;               // parents before children
+    size_t orderCapacity;
+    bool hierarchyDirty;
+
+    unsigned int syncedStructure; // source structureEpoch at the last render thread sync
+
+    BE_TransformStore changed;   // SoA copy of this update's changed transforms
+    size_t* changedModels;       // model index of each changed entry
+    size_t changedCapacity;
 } BE_ModelVector;
 
+BE_VECTOR_DEFINE(BE_ModelVector, BE_Model, INITIAL_MODEL_CAPACITY, VECTOR_GROWTH, BE_MEMORY_SCENE)
+
 BE_Transform BE_TransformInit(vec3 position, vec3 eulerRotation, vec3 scale);
 void BE_TransformUpdateMatrix(BE_Transform* transform, mat4 outMatrix);
 
 BE_Model BE_ModelInit(const char* name, BE_Mesh* mesh, BE_Transform transform);
 void BE_ModelRotate(BE_Model* model, vec3 axis, float angle);
+void BE_ModelSetPosition(BE_Model* model, vec3 position);
+void BE_ModelSetOrientation(BE_Model* model, versor orientation);
+void BE_ModelSetScale(BE_Model* model, vec3 scale);
+void BE_ModelMarkDirty(BE_Model* model);
 
 void BE_ModelVectorInit(BE_ModelVector* vec);
 void BE_ModelVectorPush(BE_ModelVector* vec, BE_Model value);
 void BE_ModelVectorFree(BE_ModelVector* vec);
 void BE_ModelVectorCopy(BE_Model* models, size_t count, BE_ModelVector* outVec);
 void BE_ModelVectorDraw(BE_ModelVector* vec, BE_Shader* shader);
+void BE_ModelGetWorldBounds(BE_Model* model, mat4 modelMatrix, vec3 dest[2]);
+bool BE_ModelVectorSetParent(BE_ModelVector* vec, BE_Model* child, BE_Model* parent);
+void BE_ModelVectorUpdateOrder(BE_ModelVector* vec);
+#define MODEL_TRANSFORM_GRAIN 512 // changed transforms per job, a multiple of BE_TRANSFORM_LANES
+void BE_ModelVectorUpdateTransforms(BE_ModelVector* vec, BE_Jobs* jobs);
+void BE_ModelVectorComposeJob(void* arg, size_t begin, size_t end);
 
 static inline BE_Model* BE_FindModelPtr(BE_ModelVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
+}
+
+static inline BE_Model* BE_GetModelPtr(BE_ModelVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
 }
 
 #define DIRECT_LIGHT_DIST 50
@@ -411,15 +745,55 @@ typedef struct {
     int layers;
 } BE_ShadowMapFBO;
 
+// Point shadows are cube map array slices, one per shadowed point light
+#define POINT_SHADOW_SIZE 512
+#define POINT_SHADOW_LIGHTS 10
+
+// Spot shadows share one atlas, split by a quadtree into power of two tiles
+#define SPOT_SHADOW_ATLAS_SIZE 4096
+#define SPOT_SHADOW_MIN_TILE 64
+#define SPOT_SHADOW_MAX_TILE 1024
+#define SPOT_SHADOW_TILE_HYSTERESIS 0.25f // a tile keeps its size until the wanted side leaves this margin
+
+typedef enum {
+    BE_ATLAS_NODE_FREE,
+    BE_ATLAS_NODE_SPLIT,
+    BE_ATLAS_NODE_USED
+} BE_AtlasNodeState;
+
+typedef struct {
+    int size;
+    int minTile;
+    int levels;
+    unsigned char* nodes; // full quadtree, children of node n are 4n+1 .. 4n+4
+    size_t nodeCount;
+} BE_ShadowAtlas;
+
+typedef struct {
+    size_t light;     // index into the light vector
+    float importance; // screen coverage weighted by brightness
+    int size;         // tile side in texels, 0 for no shadow
+    ivec4 tile;
+} BE_ShadowTileRequest;
+
 typedef enum {
     BE_LIGHT_DIRECT,
     BE_LIGHT_POINT,
     BE_LIGHT_SPOT
 } BE_LightType;
 
+typedef struct {
+    mat4 lightSpaceMatrix;
+    vec3 position;
+    vec3 direction;
+    float a, b;
+    float outerCone;
+} BE_ShadowKey;
+
 typedef struct {
     int type;
     char* name;
+    BE_Entity entity;
 
     vec3 position;
     vec3 direction;
@@ -435,26 +809,97 @@ typedef struct {
     // spotlight
     float innerCone;
     float outerCone;
+
+    // shadow cache
+    BE_ShadowKey shadowKey;   // light state the cached map was rendered with
+    unsigned int shadowEpoch; // model clock value at last render, 0 if invalid
+    int shadowLayer;          // layer the cached map lives in
+    ivec4 shadowTile;         // atlas x, y, width, height of a spot map, width 0 if it has none
 } BE_Light;
 
+// Froxel grid for clustered point and spot lights, depth slices are exponential
+#define CLUSTER_X 16
+#define CLUSTER_Y 9
+#define CLUSTER_Z 24
+#define CLUSTER_COUNT (CLUSTER_X * CLUSTER_Y * CLUSTER_Z)
+#define CLUSTER_MAX_LIGHTS 65535
+
+// Mirrors the std430 Light struct in the scene shader
 typedef struct {
-    BE_Light* data;
-    size_t size;
-    size_t capacity;
+    vec4 position;         // xyz position, w range
+    vec4 direction;        // xyz direction, w outer cone cosine
+    vec4 color;
+    vec4 params;           // a, b, inner cone cosine, specular
+    vec4 shadowRect;       // spot atlas tile, zero size if no shadow
+    mat4 lightSpaceMatrix;
+    int type;
+    int shadowIndex;       // point shadow cube, -1 if none
+    float farPlane;
+    float pad;
+} BE_GPULight;
+
+typedef struct {
+    // view space cluster bounds, SoA for the SIMD tests
+    float* bounds;
+    float* minX; float* minY; float* minZ;
+    float* maxX; float* maxY; float* maxZ;
+    float* centerX; float* centerY; float* centerZ;
+    float* radius;
+
+    float nearPlane, farPlane;
+    vec2 screen;
+    mat4 viewMatrix;
+
+    BE_GPULight* lights;
+    size_t lightCount, lightCapacity;
+    unsigned int* hits;    // cluster << 16 | light
+    size_t hitCount, hitCapacity;
+    unsigned int* grid;    // offset and count per cluster
+    unsigned int* indices;
+    size_t indexCapacity;
+
+    GLuint lightSSBO, gridSSBO, indexSSBO; // used when the stream ring is full
+    bool sharedBuffers;                    // the SSBOs belong to another light vector
+    size_t ssboBytes;
+    BE_StreamAlloc lightRange, gridRange, indexRange;
+} BE_LightClusters;
+
+#define INITIAL_LIGHT_CAPACITY 4
+
+typedef struct {
+    BE_VECTOR_FIELDS(BE_Light);
+    BE_Registry registry;       // names and handles
     
     float ambient;
     BE_ShadowMapFBO directShadowFBO;
     BE_ShadowMapFBO pointShadowFBO;
     BE_ShadowMapFBO spotShadowFBO;
+    BE_ShadowAtlas spotAtlas;
+    BE_LightClusters clusters;
+    bool sharedMaps; // shadow maps and cluster SSBOs are borrowed, see BE_LightVectorInitShared
 
     int shadowsDirty;
 } BE_LightVector;
 
+BE_VECTOR_DEFINE(BE_LightVector, BE_Light, INITIAL_LIGHT_CAPACITY, VECTOR_GROWTH, BE_MEMORY_SCENE)
+
 BE_ShadowMapFBO BE_ShadowMapFBOInit(int width, int height, int layers);
+BE_ShadowMapFBO BE_ShadowMapFBOInitCubeArray(int size, int cubes);
 void BE_ShadowMapFBOBindLayer(BE_ShadowMapFBO* smfbo, int layer);
+void BE_ShadowMapFBOBindLayered(BE_ShadowMapFBO* smfbo);
 void BE_ShadowMapFBODelete(BE_ShadowMapFBO* smfbo);
 
-typedef void (*ShadowRenderFunc)(BE_Shader* shader);
+void BE_LightClustersInit(BE_LightClusters* clusters, const BE_LightClusters* shared);
+void BE_LightClustersFree(BE_LightClusters* clusters);
+void BE_LightClustersUpdateBounds(BE_LightClusters* clusters, BE_Camera* camera);
+void BE_LightClustersBinLight(BE_LightClusters* clusters, unsigned int light, vec3 center, float radius, vec3 direction, float cosAngle, bool spot);
+void BE_LightClustersUpload(BE_LightClusters* clusters, BE_StreamRing* ring);
+
+BE_ShadowAtlas BE_ShadowAtlasInit(int size, int minTile);
+void BE_ShadowAtlasClear(BE_ShadowAtlas* atlas);
+bool BE_ShadowAtlasAlloc(BE_ShadowAtlas* atlas, int tileSize, ivec4 dest);
+bool BE_ShadowAtlasReserve(BE_ShadowAtlas* atlas, ivec4 tile);
+void BE_ShadowAtlasFree(BE_ShadowAtlas* atlas);
 
 BE_Light BE_LightInit(const char* name, int type, vec3 position, vec3 direction, vec4 color, float specular, float a, float b, float innerCone, float outerCone);
 
@@ -463,6 +908,15 @@ BE_Light BE_LightInit(const char* name, int type, vec3 position, vec3 direction,
 // void BE_LightSetDirection(BE_Light* light, const vec3 direction);
 // void BE_LightSetOrientation(BE_Light* light, versor orientation);
 void BE_LightRotate(BE_Light* light, vec3 axis, float angle);
+float BE_LightGetRange(BE_Light* light); // attenuation cutoff, spot lights reach the full cap
+void BE_LightPackGPU(BE_LightVector* vec, BE_Light* light, BE_GPULight* outLight); // point and spot lights
+bool BE_LightCullBounds(BE_Light* light, vec4 planes[6], vec3 bounds[2]);
+void BE_LightGetShadowKey(BE_Light* light, BE_ShadowKey* dest);
+bool BE_LightShadowIsDirty(BE_Light* light, BE_ModelVector* models);
+void BE_LightShadowMarkClean(BE_Light* light, BE_ModelVector* models);
+float BE_LightGetScreenCoverage(BE_Light* light, BE_Camera* camera);
+void BE_LightGetCubeMatrices(BE_Light* light, mat4 dest[6]);
+unsigned int BE_LightGetCubeFaceMask(BE_Light* light, vec4 facePlanes[6][6], vec3 bounds[2]);
 // void BE_LightGetDirection(BE_Light* light, vec3 dest);
 // void BE_LightGetOrientation(BE_Light* light, versor dest);
 // void BE_LightSetColor(BE_Light* light, const vec4 color);
@@ -482,57 +936,89 @@ void BE_LightRotate(BE_Light* light, vec3 axis, float angle);
 // void BE_LightReset(BE_Light* light);
 
 void BE_LightVectorInit(BE_LightVector* vec);
+void BE_LightVectorInitShared(BE_LightVector* vec, const BE_LightVector* owner);
 void BE_LightVectorPush(BE_LightVector* vec, BE_Light value);
 void BE_LightVectorFree(BE_LightVector* vec);
 void BE_LightVectorCopy(BE_Light* lights, size_t count, BE_LightVector* outVec);
 
 void BE_LightVectorUpdateMatrix(BE_LightVector* vec);
-void BE_LightVectorUpdateMaps(BE_LightVector* vec, BE_Shader* shadowShader, ShadowRenderFunc renderFunc, bool enabled);
-void BE_LightVectorUpdateMultiMaps(BE_LightVector* vec, BE_ModelVector* models, BE_Shader* shadowShader, bool enabled);
+void BE_LightVectorAllocSpotTiles(BE_LightVector* vec, BE_Camera* camera);
+void BE_LightVectorUpdateMultiMaps(BE_LightVector* vec, BE_ModelVector* models, BE_Camera* camera, BE_Shader* shadowShader, BE_Shader* pointShadowShader, bool enabled);
+void BE_LightVectorUpdateClusters(BE_LightVector* vec, BE_Camera* camera, BE_StreamRing* ring);
 void BE_LightVectorUpload(BE_LightVector* vec, BE_Shader* shader);
+void BE_LightVectorDrawCasters(BE_Light* light, BE_ModelVector* models, BE_Shader* shadowShader);
+void BE_LightVectorDrawCubeCasters(BE_Light* light, BE_ModelVector* models, BE_Shader* pointShadowShader, int cube);
 void BE_LightVectorDraw(BE_LightVector* vec, BE_Mesh* mesh, BE_Shader* shader);
 
 static inline BE_Light* BE_FindLightPtr(BE_LightVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
+}
+
+static inline BE_Light* BE_GetLightPtr(BE_LightVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
 }
 
 typedef struct {
     char* name;
+    BE_Entity entity;
     vec3 position;
     vec2 scale;
     float rotation;
     vec3 color;
-    BE_Texture* texture;
+    BE_Texture* texture; // packed textures sample their page through atlasRect
 } BE_Sprite;
 
+// Sprites are transformed on the CPU into one streamed vertex buffer
 typedef struct {
-    BE_Sprite* data;
-    size_t size;
-    size_t capacity;
+    float position[3];
+    float texCoord[2];
+    float color[3];
+} BE_SpriteVertex;
 
+#define INITIAL_SPRITE_CAPACITY 4
+
+typedef struct {
+    BE_VECTOR_FIELDS(BE_Sprite);
+    BE_Registry registry;       // names and handles
+
+    // batching
     BE_VAO vao;
+    BE_VBO vbo;
+    BE_EBO ebo;
+    size_t batchCapacity;      // quads the vertex and index buffers hold
+    BE_SpriteVertex* vertices; // used when the stream ring is full
+
+    // per draw scratch, sized to the sprite count
+    unsigned int* visible;     // visible sprite indices, in submission order
+    size_t scratchCapacity;
+
+    GLuint* runTextures;       // texture of each run of consecutive visible sprites
+    unsigned int* runEnds;     // one past the run's last visible sprite
+    size_t runCapacity;
 } BE_SpriteVector;
 
+BE_VECTOR_DEFINE(BE_SpriteVector, BE_Sprite, INITIAL_SPRITE_CAPACITY, VECTOR_GROWTH, BE_MEMORY_SCENE)
+
 BE_Sprite BE_SpriteInit(const char* name, BE_Texture* texture, vec3 position, vec2 scale, vec3 color, float rotation);
 
 void BE_SpriteVectorInit(BE_SpriteVector* vec);
 void BE_SpriteVectorPush(BE_SpriteVector* vec, BE_Sprite value);
 void BE_SpriteVectorFree(BE_SpriteVector* vec);
 void BE_SpriteVectorCopy(BE_Sprite* sprites, size_t count, BE_SpriteVector* outVec);
-void BE_SpriteVectorDraw(BE_SpriteVector* vec, BE_Shader* shader);
+void BE_SpriteVectorRemove(BE_SpriteVector* vec, BE_Sprite* sprite); // the last sprite takes its place
+void BE_SpriteVectorReserveBatch(BE_SpriteVector* vec, size_t quads);
+void BE_SpriteVectorDraw(BE_SpriteVector* vec, BE_Shader* shader, mat4 camMatrix, BE_StreamRing* ring);
 
 static inline BE_Sprite* BE_FindSpritePtr(BE_SpriteVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
+}
+
+static inline BE_Sprite* BE_GetSpritePtr(BE_SpriteVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
 }
 
 typedef struct {
@@ -549,32 +1035,38 @@ typedef struct {
     char* path;
 } BE_Sound;
 
+#define INITIAL_SOUND_CAPACITY 8
+
 typedef struct {
-    BE_Sound* data;
-    size_t size;
-    size_t capacity;
+    BE_VECTOR_FIELDS(BE_Sound);
+    BE_Registry registry;       // names and handles
 } BE_SoundVector;
 
+BE_VECTOR_DEFINE(BE_SoundVector, BE_Sound, INITIAL_SOUND_CAPACITY, VECTOR_GROWTH, BE_MEMORY_AUDIO)
+
 BE_Sound BE_SoundLoad(BE_AudioEngine* engine, const char* path, const char* name, bool spatial, float min, float max);
+bool BE_SoundLoadMemory(BE_AudioEngine* engine, const char* data, size_t size, const char* path, const char* name, bool spatial, float min, float max, BE_Sound* outSound);
 void BE_SoundFree(BE_Sound* sound);
 
 void BE_SoundVectorInit(BE_SoundVector* vec);
 void BE_SoundVectorPush(BE_SoundVector* vec, BE_Sound value);
 void BE_SoundVectorFree(BE_SoundVector* vec);
 void BE_SoundVectorCopy(BE_Sound* sounds, size_t count, BE_SoundVector* outVec);
-void BE_SoundVectorRemove(BE_SoundVector* vec, BE_Sound* sound);
+void BE_SoundVectorRemove(BE_SoundVector* vec, BE_Sound* sound); // the last sound takes its place
 
 static inline BE_Sound* BE_FindSoundPtr(BE_SoundVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
+}
+
+static inline BE_Sound* BE_GetSoundPtr(BE_SoundVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
 }
 
 typedef struct {
     char* name;
+    BE_Entity entity;
     vec3 position;
     float gain;
     float pitch;
@@ -584,12 +1076,15 @@ typedef struct {
     FMOD_DSP* reverbDSP;
 } BE_Emitter;
 
+#define INITIAL_EMITTER_CAPACITY 8
+
 typedef struct {
-    BE_Emitter* data;
-    size_t size;
-    size_t capacity;
+    BE_VECTOR_FIELDS(BE_Emitter);
+    BE_Registry registry;       // names and handles
 } BE_EmitterVector;
 
+BE_VECTOR_DEFINE(BE_EmitterVector, BE_Emitter, INITIAL_EMITTER_CAPACITY, VECTOR_GROWTH, BE_MEMORY_SCENE)
+
 BE_Emitter BE_EmitterInit(const char* name, vec3 position, bool spatial);
 
 void BE_EmitterPlaySound(BE_AudioEngine* engine, BE_Emitter* src, BE_Sound* sound);
@@ -618,19 +1113,21 @@ void BE_EmitterVectorPush(BE_EmitterVector* vec, BE_Emitter value);
 void BE_EmitterVectorFree(BE_EmitterVector* vec);
 void BE_EmitterVectorCopy(BE_Emitter* emitters, size_t count, BE_EmitterVector* outVec);
 void BE_EmitterVectorDraw(BE_EmitterVector* vec, BE_Mesh* mesh, BE_Shader* shader);
-void BE_EmitterVectorRemove(BE_EmitterVector* vec, BE_Emitter* emitter);
+void BE_EmitterVectorRemove(BE_EmitterVector* vec, BE_Emitter* emitter); // the last emitter takes its place
 
 static inline BE_Emitter* BE_FindEmitterPtr(BE_EmitterVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
-        }
-    }
-    return NULL;
+    size_t index = BE_RegistryFindIndex(&vec->registry, name);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
+}
+
+static inline BE_Emitter* BE_GetEmitterPtr(BE_EmitterVector* vec, BE_Handle handle) {
+    size_t index = BE_RegistryIndex(&vec->registry, handle);
+    return index != SIZE_MAX ? &vec->data[index] : NULL;
 }
 
 typedef struct {
     BE_TextureVector textures;
+    BE_TextureAtlas atlas;
     BE_MeshVector meshes;
     BE_SoundVector sounds;
     BE_ShaderVector shaders;
@@ -638,32 +1135,66 @@ typedef struct {
 
     BE_Shader default3DShader;
     BE_Shader defaultDepthShader;
+    BE_Shader defaultPointDepthShader;
     BE_Shader defaultColorShader;
     BE_Shader defaultSpriteShader;
 
     BE_Mesh defaultCubeMesh;
     BE_Mesh defaultCameraMesh;
+    BE_Texture defaultTexture; // 1x1 white, stands in for textures that are still loading
 } BE_Resources;
 
-typedef struct {
+// Every object added through the BE_Add* API also gets an entity in its scene's world, so game
+// systems can query scene objects next to their own components. The ids of these components are
+// fixed, components registered on the world afterwards start at BE_COMPONENT_BUILTIN_COUNT.
+typedef enum {
+    BE_COMPONENT_TRANSFORM,      // BE_Transform, a model's local transform
+    BE_COMPONENT_MESH_RENDERER,  // BE_MeshRenderer
+    BE_COMPONENT_LIGHT,          // BE_LightComponent
+    BE_COMPONENT_CAMERA,         // BE_CameraComponent
+    BE_COMPONENT_SPRITE,         // BE_SpriteComponent
+    BE_COMPONENT_AUDIO_EMITTER,  // BE_AudioEmitterComponent
+    BE_COMPONENT_BUILTIN_COUNT
+} BE_ComponentType;
+
+typedef struct { BE_Handle handle; BE_Mesh* mesh; } BE_MeshRenderer;
+typedef struct { BE_Handle handle; } BE_LightComponent;
+typedef struct { BE_Handle handle; } BE_CameraComponent;
+typedef struct { BE_Handle handle; } BE_SpriteComponent;
+typedef struct { BE_Handle handle; } BE_AudioEmitterComponent;
+
+typedef struct BE_Scene {
     char* name;
     
     BE_Camera* activeCamera;
+    BE_World* world;
+
 
     BE_ModelVector models;
     BE_LightVector lights;
     BE_CameraVector cameras;
     BE_SpriteVector sprites;
     BE_EmitterVector emitters;
+
+    struct BE_Scene* renderScene; // render thread's copy, NULL until it first draws this scene
 } BE_Scene;
 
 typedef struct {
-    BE_Scene* data;
-    size_t size;
-    size_t capacity;
+    BE_Pool pool;               // stable addresses for activeScene
 } BE_SceneVector;
 
 BE_Scene BE_SceneInit(const char* name);
+BE_Scene BE_SceneInitRender(BE_Scene* owner);
+void BE_SceneFree(BE_Scene* scene); // also its render copy
+void BE_SceneInitWorld(BE_Scene* scene);
+BE_Entity BE_SceneAddEntity(BE_Scene* scene, int component, BE_Handle handle);
+void BE_SceneUpdateModelEntity(BE_Scene* scene, BE_Model* model);
+void BE_SceneSync(BE_Scene* dst, BE_Scene* src);
+void BE_ModelVectorSync(BE_ModelVector* dst, BE_ModelVector* src);
+void BE_LightVectorSync(BE_LightVector* dst, BE_LightVector* src);
+void BE_CameraVectorSync(BE_CameraVector* dst, BE_CameraVector* src);
+void BE_SpriteVectorSync(BE_SpriteVector* dst, BE_SpriteVector* src);
+void BE_EmitterVectorSync(BE_EmitterVector* dst, BE_EmitterVector* src);
 
 void BE_SceneVectorInit(BE_SceneVector* vec);
 void BE_SceneVectorPush(BE_SceneVector* vec, BE_Scene value);
@@ -671,16 +1202,143 @@ void BE_SceneVectorFree(BE_SceneVector* vec);
 void BE_SceneVectorCopy(BE_Scene* scenes, size_t count, BE_SceneVector* outVec);
 void BE_SceneVectorRemove(BE_SceneVector* vec, BE_Scene* value);
 
+static inline BE_Scene* BE_SceneVectorAt(BE_SceneVector* vec, size_t index) {
+    return (BE_Scene*)BE_PoolAt(&vec->pool, index);
+}
+
 static inline BE_Scene* BE_FindScenePtr(BE_SceneVector* vec, const char* name) {
-    for (size_t i = 0; i < vec->size; i++) {
-        if (strcmp(vec->data[i].name, name) == 0) {
-            return &vec->data[i];
+    for (size_t i = 0; i < vec->pool.size; i++) {
+        BE_Scene* scene = BE_SceneVectorAt(vec, i);
+        if (strcmp(scene->name, name) == 0) {
+            return scene;
         }
     }
     return NULL;
 }
 
+// ==============================
+// Render Thread
+// ==============================
+
+#define RENDER_MAX_COMMANDS 256
+
+typedef enum {
+    BE_RENDER_MAKE_SHADOWS,
+    BE_RENDER_BEGIN_RENDER,
+    BE_RENDER_DRAW_MODELS,
+    BE_RENDER_DRAW_LIGHTS,
+    BE_RENDER_DRAW_CAMERAS,
+    BE_RENDER_DRAW_SPRITES,
+    BE_RENDER_DRAW_EMITTERS
+} BE_RenderCommandType;
+
 typedef struct {
+    BE_RenderCommandType type;
+    bool active;
+    BE_Handle shader;           // BE_HANDLE_NONE for the draw's default
+    const char* file;
+    int line;
+} BE_RenderCommand;
+
+typedef struct {
+    BE_RenderCommand commands[RENDER_MAX_COMMANDS];
+    size_t count;
+} BE_RenderFrame;
+
+typedef struct BE_RenderThread BE_RenderThread;
+
+// ==============================
+// Async Loading
+// ==============================
+
+#define LOADER_THREADS 2
+#define LOADER_DEFAULT_BUDGET_MS 2.0 // finalize time per frame, at least one load always finishes
+
+typedef int BE_LoadHandle; // -1 if the load could not be queued
+
+typedef enum {
+    BE_LOAD_QUEUED,
+    BE_LOAD_LOADING,
+    BE_LOAD_READY,
+    BE_LOAD_FAILED
+} BE_LoadState;
+
+typedef enum {
+    BE_LOAD_MESH,
+    BE_LOAD_TEXTURE,
+    BE_LOAD_SOUND,
+    BE_LOAD_SHADER
+} BE_LoadType;
+
+// Called on the thread that owns the engine once the load is ready or failed
+typedef void (*BE_LoadCallback)(BE_LoadHandle handle, BE_LoadState state, void* userData);
+
+typedef struct {
+    BE_LoadType type;
+    atomic_int state;
+    char* name;
+    char* files[4];         // shaders use all four stages, the rest only the first
+    BE_LoadCallback callback;
+    void* userData;
+    bool failed;            // set by the loader thread
+
+    // Filled on a loader thread, turned into GL and FMOD objects when finalized
+    BE_OBJData obj;
+    BE_Image image;
+    char* sources[4];
+    char* bytes;
+    size_t byteCount;
+} BE_LoadRequest;
+
+#define INITIAL_LOAD_CAPACITY 16
+
+typedef struct {
+    BE_VECTOR_FIELDS(size_t);
+    size_t head;
+} BE_LoadQueue;
+
+BE_VECTOR_DEFINE(BE_LoadQueue, size_t, INITIAL_LOAD_CAPACITY, VECTOR_GROWTH, BE_MEMORY_LOADER)
+
+typedef struct {
+    BE_Thread threads[LOADER_THREADS];
+    int threadCount;
+    BE_Mutex mutex;
+    BE_Cond cond;
+    bool quit;
+
+    BE_LoadRequest** requests;  // indexed by handle, pointers stay valid for the loader threads
+    size_t size;
+    size_t capacity;
+
+    BE_LoadQueue waiting;       // not picked up by a loader thread yet
+    BE_LoadQueue parsed;        // waiting to be finalized
+    size_t unfinished;
+
+    double budgetMs;
+} BE_Loader;
+
+void BE_LoaderInit(BE_Loader* loader);
+void BE_LoaderFree(BE_Loader* loader);
+BE_LoadHandle BE_LoaderSubmit(BE_Loader* loader, BE_LoadType type, const char* name, const char* files[4], BE_LoadCallback callback, void* userData);
+void BE_LoaderThreadMain(void* arg);
+void BE_LoaderParse(BE_LoadRequest* request);
+bool BE_LoaderFinalize(BE_LoadRequest* request);
+void BE_LoaderUpdate(BE_Loader* loader);
+void BE_LoadRequestFree(BE_LoadRequest* request);
+void BE_LoadQueuePush(BE_LoadQueue* queue, size_t value);
+bool BE_LoadQueuePop(BE_LoadQueue* queue, size_t* outValue);
+
+#define FRAME_ARENA_SIZE (1024 * 1024) // grows to the busiest frame
+
+// What the overlay reads from the window, taken on the main thread since GLFW only answers there
+typedef struct {
+    int width, height;               // window, in screen coordinates
+    int displayWidth, displayHeight; // framebuffer, in pixels
+    int cursor[2];
+    int buttons[3];                  // left, middle, right
+} BE_OverlayInput;
+
+typedef struct BE_Engine {
     char* title;
     GLFWwindow* window;
     int width, height;
@@ -694,15 +1352,60 @@ typedef struct {
     BE_FBO FBOs[2];
     int ping;
 
+    BE_StreamRing stream;
+    BE_Jobs* jobs;              // allocated, workers keep pointers into it
+    BE_Loader* loader;          // same
+    BE_Arena frame;             // reset by BE_BeginFrame, simulation thread only
+    BE_GpuTimer* gpuTimer;      // allocated, shared with the render view
+
+    bool overlay;               // performance overlay drawn by BE_EndFrame
+    BE_OverlayInput overlayInput; // read by BE_BeginFrame while the overlay is on
+    float profileSpikeMs;       // 0 when spike capture is off
+    char* profileSpikePath;
+
     BE_FrameStats timer;
     BE_Joystick joystick;
 
     bool running;
+    bool headless;              // no display, frames go to the offscreen target
+    GLuint offscreenFBO;        // 0 unless headless
+    GLuint offscreenTargets[2]; // color and depth renderbuffers
+
+    BE_RenderThread* renderThread; // NULL when rendering on the calling thread
 
 } BE_Engine;
 
+// Bound engine for the BE_* API, shared by every thread. The render thread never uses it, it
+// replays frames against its own view of the engine.
 extern BE_Engine* g_engine;
 
+// Simulation records frame N + 1 while the render thread owns the context and replays frame N
+struct BE_RenderThread {
+    BE_Thread thread;
+    BE_Mutex mutex;
+    BE_Cond cond;
+
+    BE_Engine* engine;          // simulation side
+    BE_Engine view;             // render side copy, its active scene is the render scene
+
+    BE_RenderFrame frames[2];
+    int recording;              // frame the simulation writes into
+    bool pending;               // the other frame is waiting for or being replayed
+    bool synced;                // scene data of the pending frame has been copied
+    bool borrowRequest;
+    bool borrowed;              // simulation holds the context for a resource load
+    int borrowDepth;
+    bool quit;
+};
+
+void BE_RenderThreadMain(void* arg);
+void BE_RenderThreadRecord(BE_RenderThread* rt, BE_RenderCommandType type, bool active, BE_Handle shader, const char* file, int line);
+void BE_RenderThreadSubmit(BE_RenderThread* rt);
+void BE_RenderThreadSyncFrame(BE_RenderThread* rt);
+void BE_RenderThreadReplay(BE_Engine* view, BE_RenderFrame* frame);
+void BE_RenderThreadBorrowContext(BE_RenderThread* rt);
+void BE_RenderThreadReturnContext(BE_RenderThread* rt);
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 
 // =======================
@@ -720,6 +1423,20 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 #define BE_StartEngine(title, width, height) BE_IMPL_EngineStart(title, width, height, __FILE__, __LINE__)
 BE_Engine BE_IMPL_EngineStart(const char* title, int width, int height, const char* file, int line);
 
+/**
+ * @brief Starts an engine without a display, for benchmarks and automated runs
+ * @param width The width of the offscreen target in pixels. Must be greater than 0.
+ * @param height The height of the offscreen target in pixels. Must be greater than 0.
+ * @param title The window title GLFW keeps, nothing shows it. If NULL, "Ballistic Engine" is used.
+ * @return A fully initialized BE_Engine struct.
+ * @note Uses the GLFW null platform with an EGL context, falling back to OSMesa, so it runs on a machine
+ * without a display or GPU as long as Mesa provides a 4.6 context. Frames render into an offscreen
+ * framebuffer and BE_EndFrame() waits for the GPU instead of swapping. Input functions see no events.
+ * @see BE_StartEngine()
+ */
+#define BE_StartEngineHeadless(title, width, height) BE_IMPL_EngineStartHeadless(title, width, height, __FILE__, __LINE__)
+BE_Engine BE_IMPL_EngineStartHeadless(const char* title, int width, int height, const char* file, int line);
+
 #define BE_ShutdownEngine(engine) do { BE_IMPL_EngineShutdown(engine, __FILE__, __LINE__); } while(0)
 void BE_IMPL_EngineShutdown(BE_Engine* engine, const char* file, int line);
 
@@ -731,6 +1448,22 @@ void BE_IMPL_EngineShutdown(BE_Engine* engine, const char* file, int line);
 #define BE_BindEngine(engine) do { BE_IMPL_BindEngine(engine, __FILE__, __LINE__); } while(0)
 void BE_IMPL_BindEngine(BE_Engine* engine, const char* file, int line);
 
+/**
+ * @brief Moves all GL work of the bound engine to a dedicated render thread
+ * @note Draw calls are recorded and replayed one frame later against a copy of the scene. Resource loads
+ * briefly take the GL context back, so keep them out of the frame loop where possible.
+ * @see BE_StopRenderThread()
+ */
+#define BE_StartRenderThread() do { BE_IMPL_StartRenderThread(__FILE__, __LINE__); } while(0)
+void BE_IMPL_StartRenderThread(const char* file, int line);
+
+/**
+ * @brief Finishes the last recorded frame and brings rendering back to the calling thread
+ * @see BE_StartRenderThread()
+ */
+#define BE_StopRenderThread() do { BE_IMPL_StopRenderThread(__FILE__, __LINE__); } while(0)
+void BE_IMPL_StopRenderThread(const char* file, int line);
+
 /**
  * @brief Unbinds an engine
  * @see BE_BindEngine()
@@ -833,6 +1566,24 @@ void BE_IMPL_LoadShader(const char* shaderName, const char* vertexFile, const ch
 #define BE_FindShader(shaderName) BE_IMPL_FindMesh(shaderName, __FILE__, __LINE__)
 BE_Shader* BE_IMPL_FindShader(const char* shaderName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific shader, for repeated access without a name lookup
+ * @param shaderName The name of the specific shader (const char*). Must not be NULL.
+ * @return The handle of the shader (BE_Handle). BE_HANDLE_NONE if the shader does not exist.
+ * @see BE_GetShader()
+ */
+#define BE_GetShaderHandle(shaderName) BE_IMPL_GetShaderHandle(shaderName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetShaderHandle(const char* shaderName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific shader from its handle
+ * @param handle The handle of the specific shader (BE_Handle).
+ * @return The pointer to the specific shader. NULL if the shader was removed since the handle was taken.
+ * @see BE_GetShaderHandle()
+ */
+#define BE_GetShader(handle) BE_IMPL_GetShader(handle, __FILE__, __LINE__)
+BE_Shader* BE_IMPL_GetShader(BE_Handle handle, const char* file, int line);
+
 // =======================
 // MESHES
 // =======================
@@ -848,6 +1599,24 @@ void BE_IMPL_LoadMesh(const char* meshName, const char* objFile, const char* fil
 #define BE_FindMesh(meshName) BE_IMPL_FindMesh(meshName, __FILE__, __LINE__)
 BE_Mesh* BE_IMPL_FindMesh(const char* meshName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific mesh, for repeated access without a name lookup
+ * @param meshName The name of the specific mesh (const char*). Must not be NULL.
+ * @return The handle of the mesh (BE_Handle). BE_HANDLE_NONE if the mesh does not exist.
+ * @see BE_GetMesh()
+ */
+#define BE_GetMeshHandle(meshName) BE_IMPL_GetMeshHandle(meshName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetMeshHandle(const char* meshName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific mesh from its handle
+ * @param handle The handle of the specific mesh (BE_Handle).
+ * @return The pointer to the specific mesh. NULL if the mesh was removed since the handle was taken.
+ * @see BE_GetMeshHandle()
+ */
+#define BE_GetMesh(handle) BE_IMPL_GetMesh(handle, __FILE__, __LINE__)
+BE_Mesh* BE_IMPL_GetMesh(BE_Handle handle, const char* file, int line);
+
 // =======================
 // MODELS
 // =======================
@@ -863,6 +1632,86 @@ void BE_IMPL_AddModel(const char* modelName, const char* meshName, const char* f
 #define BE_FindModel(modelName) BE_IMPL_FindModel(modelName, __FILE__, __LINE__)
 BE_Model* BE_IMPL_FindModel(const char* modelName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific model, for repeated access without a name lookup
+ * @param modelName The name of the specific model (const char*). Must not be NULL.
+ * @return The handle of the model (BE_Handle). BE_HANDLE_NONE if the model does not exist.
+ * @note Handles belong to the scene that was bound when they were taken.
+ * @see BE_GetModel()
+ */
+#define BE_GetModelHandle(modelName) BE_IMPL_GetModelHandle(modelName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetModelHandle(const char* modelName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific model from its handle
+ * @param handle The handle of the specific model (BE_Handle).
+ * @return The pointer to the specific model. NULL if the model was removed since the handle was taken.
+ * @see BE_GetModelHandle()
+ */
+#define BE_GetModel(handle) BE_IMPL_GetModel(handle, __FILE__, __LINE__)
+BE_Model* BE_IMPL_GetModel(BE_Handle handle, const char* file, int line);
+
+/**
+ * @brief Sets the position of a specific model, relative to its parent
+ * @param modelName The name of the specific model (const char*). Must not be NULL.
+ * @param position The new position of the model (vec3, use BE_vec3);. Must not be NULL.
+ * @note HINT: For vec3s try using BE_vec3().
+ */
+#define BE_SetModelPosition(modelName, position) do { BE_IMPL_SetModelPosition(modelName, position, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetModelPosition(const char* modelName, const vec3 position, const char* file, int line);
+
+/**
+ * @brief Sets the rotation of a specific model, relative to its parent
+ * @param modelName The name of the specific model (const char*). Must not be NULL.
+ * @param eulerRotation The new pitch, yaw and roll in radians (vec3, use BE_vec3);. Must not be NULL.
+ */
+#define BE_SetModelRotation(modelName, eulerRotation) do { BE_IMPL_SetModelRotation(modelName, eulerRotation, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetModelRotation(const char* modelName, const vec3 eulerRotation, const char* file, int line);
+
+/**
+ * @brief Sets the scale of a specific model, relative to its parent
+ * @param modelName The name of the specific model (const char*). Must not be NULL.
+ * @param scale The new scale of the model (vec3, use BE_vec3);. Must not be NULL.
+ */
+#define BE_SetModelScale(modelName, scale) do { BE_IMPL_SetModelScale(modelName, scale, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetModelScale(const char* modelName, const vec3 scale, const char* file, int line);
+
+/**
+ * @brief Sets the position of a specific model from its handle, relative to its parent
+ * @param handle The handle of the specific model (BE_Handle).
+ * @param position The new position of the model (vec3, use BE_vec3);. Must not be NULL.
+ * @see BE_SetModelPosition(), BE_GetModelHandle()
+ */
+#define BE_SetModelPositionByHandle(handle, position) do { BE_IMPL_SetModelPositionByHandle(handle, position, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetModelPositionByHandle(BE_Handle handle, const vec3 position, const char* file, int line);
+
+/**
+ * @brief Sets the rotation of a specific model from its handle, relative to its parent
+ * @param handle The handle of the specific model (BE_Handle).
+ * @param eulerRotation The new pitch, yaw and roll in radians (vec3, use BE_vec3);. Must not be NULL.
+ * @see BE_SetModelRotation(), BE_GetModelHandle()
+ */
+#define BE_SetModelRotationByHandle(handle, eulerRotation) do { BE_IMPL_SetModelRotationByHandle(handle, eulerRotation, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetModelRotationByHandle(BE_Handle handle, const vec3 eulerRotation, const char* file, int line);
+
+/**
+ * @brief Sets the scale of a specific model from its handle, relative to its parent
+ * @param handle The handle of the specific model (BE_Handle).
+ * @param scale The new scale of the model (vec3, use BE_vec3);. Must not be NULL.
+ * @see BE_SetModelScale(), BE_GetModelHandle()
+ */
+#define BE_SetModelScaleByHandle(handle, scale) do { BE_IMPL_SetModelScaleByHandle(handle, scale, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetModelScaleByHandle(BE_Handle handle, const vec3 scale, const char* file, int line);
+
+/**
+ * @brief Attaches a model to a parent so it follows the parent's transform
+ * @param modelName The name of the specific model (const char*). Must not be NULL.
+ * @param parentName The name of the parent model (const char*). If NULL, the model is detached.
+ * @note A parent cannot be one of the model's own children.
+ */
+#define BE_SetModelParent(modelName, parentName) do { BE_IMPL_SetModelParent(modelName, parentName, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetModelParent(const char* modelName, const char* parentName, const char* file, int line);
+
 #define BE_DrawModels(shaderName) do { BE_IMPL_DrawModels(shaderName, __FILE__, __LINE__); } while(0)
 void BE_IMPL_DrawModels(const char* shaderName, const char* file, int line);
 
@@ -881,6 +1730,25 @@ void BE_IMPL_AddLight(const char* lightName, BE_LightType type, const char* file
 #define BE_FindLight(lightName) BE_IMPL_FindLight(lightName, __FILE__, __LINE__)
 BE_Light* BE_IMPL_FindLight(const char* lightName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific light, for repeated access without a name lookup
+ * @param lightName The name of the specific light (const char*). Must not be NULL.
+ * @return The handle of the light (BE_Handle). BE_HANDLE_NONE if the light does not exist.
+ * @note Handles belong to the scene that was bound when they were taken.
+ * @see BE_GetLight()
+ */
+#define BE_GetLightHandle(lightName) BE_IMPL_GetLightHandle(lightName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetLightHandle(const char* lightName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific light from its handle
+ * @param handle The handle of the specific light (BE_Handle).
+ * @return The pointer to the specific light. NULL if the light was removed since the handle was taken.
+ * @see BE_GetLightHandle()
+ */
+#define BE_GetLight(handle) BE_IMPL_GetLight(handle, __FILE__, __LINE__)
+BE_Light* BE_IMPL_GetLight(BE_Handle handle, const char* file, int line);
+
 #define BE_DrawLights(shaderName) do { BE_IMPL_DrawLights(shaderName, __FILE__, __LINE__); } while(0)
 void BE_IMPL_DrawLights(const char* shaderName, const char* file, int line);
 
@@ -899,6 +1767,25 @@ void BE_IMPL_AddCamera(const char* cameraName, const char* file, int line);
 #define BE_FindCamera(cameraName) BE_IMPL_FindCamera(cameraName, __FILE__, __LINE__)
 BE_Camera* BE_IMPL_FindCamera(const char* cameraName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific camera, for repeated access without a name lookup
+ * @param cameraName The name of the specific camera (const char*). Must not be NULL.
+ * @return The handle of the camera (BE_Handle). BE_HANDLE_NONE if the camera does not exist.
+ * @note Handles belong to the scene that was bound when they were taken.
+ * @see BE_GetCamera()
+ */
+#define BE_GetCameraHandle(cameraName) BE_IMPL_GetCameraHandle(cameraName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetCameraHandle(const char* cameraName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific camera from its handle
+ * @param handle The handle of the specific camera (BE_Handle).
+ * @return The pointer to the specific camera. NULL if the camera was removed since the handle was taken.
+ * @see BE_GetCameraHandle()
+ */
+#define BE_GetCamera(handle) BE_IMPL_GetCamera(handle, __FILE__, __LINE__)
+BE_Camera* BE_IMPL_GetCamera(BE_Handle handle, const char* file, int line);
+
 #define BE_DrawCameras(shaderName) do { BE_IMPL_DrawCameras(shaderName, __FILE__, __LINE__); } while(0)
 void BE_IMPL_DrawCameras(const char* shaderName, const char* file, int line);
 
@@ -917,6 +1804,24 @@ void BE_IMPL_LoadTexture(const char* textureName, const char* imageFile, const c
 #define BE_FindTexture(textureName) BE_IMPL_FindTexture(textureName, __FILE__, __LINE__)
 BE_Texture* BE_IMPL_FindTexture(const char* textureName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific texture, for repeated access without a name lookup
+ * @param textureName The name of the specific texture (const char*). Must not be NULL.
+ * @return The handle of the texture (BE_Handle). BE_HANDLE_NONE if the texture does not exist.
+ * @see BE_GetTexture()
+ */
+#define BE_GetTextureHandle(textureName) BE_IMPL_GetTextureHandle(textureName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetTextureHandle(const char* textureName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific texture from its handle
+ * @param handle The handle of the specific texture (BE_Handle).
+ * @return The pointer to the specific texture. NULL if the texture was removed since the handle was taken.
+ * @see BE_GetTextureHandle()
+ */
+#define BE_GetTexture(handle) BE_IMPL_GetTexture(handle, __FILE__, __LINE__)
+BE_Texture* BE_IMPL_GetTexture(BE_Handle handle, const char* file, int line);
+
 // =======================
 // SPRITES
 // =======================
@@ -929,6 +1834,22 @@ BE_Texture* BE_IMPL_FindTexture(const char* textureName, const char* file, int l
 #define BE_AddSprite(emitterName, textureName) do { BE_IMPL_AddSprite(spriteName, textureName, __FILE__, __LINE__); } while(0)
 void BE_IMPL_AddSprite(const char* spriteName, const char* textureName, const char* file, int line);
 
+/**
+ * @brief Removes a specific sprite from the bound scene
+ * @param spriteName The name of the specific sprite (const char*). Must not be NULL.
+ * @note The last sprite moves into the removed one's place, handles stay valid.
+ * @see BE_AddSprite(), BE_RemoveAllSprites()
+ */
+#define BE_RemoveSprite(spriteName) do { BE_IMPL_RemoveSprite(spriteName, __FILE__, __LINE__); } while(0)
+void BE_IMPL_RemoveSprite(const char* spriteName, const char* file, int line);
+
+/**
+ * @brief Removes all sprites from the bound scene
+ * @see BE_RemoveSprite()
+ */
+#define BE_RemoveAllSprites() do { BE_IMPL_RemoveAllSprites(__FILE__, __LINE__); } while(0)
+void BE_IMPL_RemoveAllSprites(const char* file, int line);
+
 /**
  * @brief Gets the pointer to a specific sprite
  * @param spriteName The name of the specific sprite (const char*). Must not be NULL.
@@ -937,6 +1858,25 @@ void BE_IMPL_AddSprite(const char* spriteName, const char* textureName, const ch
 #define BE_FindSprite(spriteName) BE_IMPL_FindSprite(spriteName, __FILE__, __LINE__)
 BE_Sprite* BE_IMPL_FindSprite(const char* spriteName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific sprite, for repeated access without a name lookup
+ * @param spriteName The name of the specific sprite (const char*). Must not be NULL.
+ * @return The handle of the sprite (BE_Handle). BE_HANDLE_NONE if the sprite does not exist.
+ * @note Handles belong to the scene that was bound when they were taken.
+ * @see BE_GetSprite()
+ */
+#define BE_GetSpriteHandle(spriteName) BE_IMPL_GetSpriteHandle(spriteName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetSpriteHandle(const char* spriteName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific sprite from its handle
+ * @param handle The handle of the specific sprite (BE_Handle).
+ * @return The pointer to the specific sprite. NULL if the sprite was removed since the handle was taken.
+ * @see BE_GetSpriteHandle()
+ */
+#define BE_GetSprite(handle) BE_IMPL_GetSprite(handle, __FILE__, __LINE__)
+BE_Sprite* BE_IMPL_GetSprite(BE_Handle handle, const char* file, int line);
+
 /**
  * @brief Draws all sprites with a specific shader
  * @param shaderName The name of the specific shader (const char*). If NULL, a default shader will be used.
@@ -980,6 +1920,24 @@ void BE_IMPL_DeleteAllSounds(const char* file, int line);
 #define BE_FindSound(soundName) BE_IMPL_FindSound(soundName, __FILE__, __LINE__)
 BE_Sound* BE_IMPL_FindSound(const char* soundName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific sound, for repeated access without a name lookup
+ * @param soundName The name of the specific sound (const char*). Must not be NULL.
+ * @return The handle of the sound (BE_Handle). BE_HANDLE_NONE if the sound does not exist.
+ * @see BE_GetSound()
+ */
+#define BE_GetSoundHandle(soundName) BE_IMPL_GetSoundHandle(soundName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetSoundHandle(const char* soundName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific sound from its handle
+ * @param handle The handle of the specific sound (BE_Handle).
+ * @return The pointer to the specific sound. NULL if the sound was removed since the handle was taken.
+ * @see BE_GetSoundHandle()
+ */
+#define BE_GetSound(handle) BE_IMPL_GetSound(handle, __FILE__, __LINE__)
+BE_Sound* BE_IMPL_GetSound(BE_Handle handle, const char* file, int line);
+
 /**
  * @brief Checks whether a specific sound exists
  * @param soundName The name of the sound to check (const char*). Must not be NULL.
@@ -988,6 +1946,205 @@ BE_Sound* BE_IMPL_FindSound(const char* soundName, const char* file, int line);
 #define BE_CheckSound(soundName) BE_IMPL_CheckSound(soundName, __FILE__, __LINE__)
 bool BE_IMPL_CheckSound(const char* soundName, const char* file, int line);
 
+// =======================
+// ENTITIES
+// =======================
+
+/**
+ * @brief Gets the entity world of the bound scene
+ * @return The pointer to the world (BE_World*). Objects added with BE_Add* already have entities in it.
+ * @see BE_ComponentType, BE_RegisterComponent(), BE_RunSystem()
+ */
+#define BE_GetWorld() BE_IMPL_GetWorld(__FILE__, __LINE__)
+BE_World* BE_IMPL_GetWorld(const char* file, int line);
+
+/**
+ * @brief Adds a component type to the bound scene's world
+ * @param componentName The name of the component (const char*). Must outlive the scene.
+ * @param type The component's C type.
+ * @return The component id (int), for BE_COMPONENT_BIT() and the BE_World* functions. -1 if it can't be registered.
+ */
+#define BE_RegisterComponent(componentName, type) BE_IMPL_RegisterComponent(componentName, sizeof(type), _Alignof(type), __FILE__, __LINE__)
+int BE_IMPL_RegisterComponent(const char* componentName, size_t size, size_t align, const char* file, int line);
+
+/**
+ * @brief Runs a system over every chunk of entities matching a query in the bound scene, spread over the engine's workers
+ * @param query The cached query (BE_EcsQuery*, set up with BE_EcsQueryInit()). Must not be NULL.
+ * @param system Called once per chunk (BE_EcsSystem). Must not be NULL.
+ * @param arg Passed to the system (void*).
+ * @note Returns once every chunk is done. Systems must not add or remove entities or components.
+ */
+#define BE_RunSystem(query, system, arg) do { BE_IMPL_RunSystem(query, system, arg, __FILE__, __LINE__); } while(0)
+void BE_IMPL_RunSystem(BE_EcsQuery* query, BE_EcsSystem system, void* arg, const char* file, int line);
+
+// =======================
+// TIMING
+// =======================
+
+/**
+ * @brief Gets min, average, percentiles and a histogram of the recent frame times
+ * @return The summary over the last FRAME_TIME_HISTORY frames (BE_FrameTimeSummary).
+ * @note Sorts the recorded frames, call it when the numbers are needed rather than every frame.
+ * @see BE_PrintFrameTimes()
+ */
+#define BE_GetFrameTimes() BE_IMPL_GetFrameTimes(__FILE__, __LINE__)
+BE_FrameTimeSummary BE_IMPL_GetFrameTimes(const char* file, int line);
+
+/**
+ * @brief Prints the frame time summary and histogram to stdout
+ * @see BE_GetFrameTimes()
+ */
+#define BE_PrintFrameTimes() do { BE_IMPL_PrintFrameTimes(__FILE__, __LINE__); } while(0)
+void BE_IMPL_PrintFrameTimes(const char* file, int line);
+
+/**
+ * @brief Forgets the recorded frame times, so percentiles only cover the frames after it
+ * @note Useful after loading or a warmup. The fps counter and GPU pass averages are left alone.
+ */
+#define BE_ResetFrameTimes() do { BE_IMPL_ResetFrameTimes(__FILE__, __LINE__); } while(0)
+void BE_IMPL_ResetFrameTimes(const char* file, int line);
+
+/**
+ * @brief Gets the GPU time of each timed render pass
+ * @param outPasses Receives the passes (BE_GpuPassTime*). Must not be NULL.
+ * @param maxPasses The size of outPasses (int).
+ * @return The number of passes written (int). 0 without timer query support or with profiling compiled out.
+ * @note Results trail the CPU by a few frames. "Frame" spans everything from BE_BeginFrame() to BE_EndFrame().
+ * @see BE_PrintGpuTimes()
+ */
+#define BE_GetGpuTimes(outPasses, maxPasses) BE_IMPL_GetGpuTimes(outPasses, maxPasses, __FILE__, __LINE__)
+int BE_IMPL_GetGpuTimes(BE_GpuPassTime* outPasses, int maxPasses, const char* file, int line);
+
+/**
+ * @brief Prints the average and latest GPU time of each timed render pass to stdout
+ * @see BE_GetGpuTimes()
+ */
+#define BE_PrintGpuTimes() do { BE_IMPL_PrintGpuTimes(__FILE__, __LINE__); } while(0)
+void BE_IMPL_PrintGpuTimes(const char* file, int line);
+
+/**
+ * @brief Shows or hides the performance overlay
+ * @param show Whether to draw it at the end of each frame (bool).
+ * @note The overlay lists frame times, draw counts, GPU pass times and memory, along with its own cost.
+ * It needs GL_ARB_bindless_texture and stays off without it.
+ */
+#define BE_ShowOverlay(show) do { BE_IMPL_ShowOverlay(show, __FILE__, __LINE__); } while(0)
+void BE_IMPL_ShowOverlay(bool show, const char* file, int line);
+
+// =======================
+// PROFILING
+// =======================
+
+/**
+ * @brief Writes the recorded profiler zones of every thread as a Chrome trace
+ * @param path The output file (const char*), opens in Perfetto or chrome://tracing. Must not be NULL.
+ * @return Whether the file was written (bool).
+ * @note Zones are BE_PROFILE_SCOPE() in engine and user code, compiled out in release builds.
+ */
+#define BE_WriteProfile(path) BE_IMPL_WriteProfile(path, __FILE__, __LINE__)
+bool BE_IMPL_WriteProfile(const char* path, const char* file, int line);
+
+/**
+ * @brief Writes a trace of the first frame slower than a threshold
+ * @param thresholdMs The frame time that triggers the capture (float). 0 turns it off.
+ * @param path The output file (const char*). Must not be NULL unless thresholdMs is 0.
+ * @note The trace covers the slow frame and the one before it. Only one is written, set it again for the next.
+ */
+#define BE_SetProfileSpikeCapture(thresholdMs, path) do { BE_IMPL_SetProfileSpikeCapture(thresholdMs, path, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetProfileSpikeCapture(float thresholdMs, const char* path, const char* file, int line);
+
+// =======================
+// MEMORY
+// =======================
+
+/**
+ * @brief Allocates transient memory that lives until the next BE_BeginFrame()
+ * @param type The C type to allocate.
+ * @param count The number of elements (size_t).
+ * @return The uninitialized memory (type*). NULL if the allocation failed.
+ * @note Only for the thread calling BE_BeginFrame(). Other threads use BE_ScratchBegin().
+ */
+#define BE_FrameAlloc(type, count) ((type*)BE_IMPL_FrameAlloc(sizeof(type) * (count), _Alignof(type), __FILE__, __LINE__))
+void* BE_IMPL_FrameAlloc(size_t size, size_t align, const char* file, int line);
+
+/**
+ * @brief Fails the next frame that touches the heap, from any thread
+ * @param enabled Whether to check (bool).
+ * @note Turn it on once loading is done. Frame and scratch arenas only count when they grow.
+ * @see BE_MemoryGetStats() for the per subsystem totals
+ */
+#define BE_SetAllocationCheck(enabled) do { BE_IMPL_SetAllocationCheck(enabled, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetAllocationCheck(bool enabled, const char* file, int line);
+
+/**
+ * @brief Gets the bound engine's frame arena
+ * @return The pointer to the arena (BE_Arena*). peak is the high-water mark across frames.
+ */
+#define BE_GetFrameArena() BE_IMPL_GetFrameArena(__FILE__, __LINE__)
+BE_Arena* BE_IMPL_GetFrameArena(const char* file, int line);
+
+// =======================
+// ASYNC LOADING
+// =======================
+
+/**
+ * @brief Starts loading a mesh in the background and returns immediately
+ * @param meshName The name of the new mesh (const char*). If NULL, the default name will be used.
+ * @param objFile The path to the OBJ file (const char*). Must not be NULL.
+ * @param callback Called with the final state once the mesh is ready or failed (BE_LoadCallback). Can be NULL.
+ * @param userData Passed to the callback (void*).
+ * @return A handle to query with BE_GetLoadState().
+ * @note The mesh exists right away as a cube placeholder, so models can be added before it finishes.
+ */
+#define BE_LoadMeshAsync(meshName, objFile, callback, userData) BE_IMPL_LoadMeshAsync(meshName, objFile, callback, userData, __FILE__, __LINE__)
+BE_LoadHandle BE_IMPL_LoadMeshAsync(const char* meshName, const char* objFile, BE_LoadCallback callback, void* userData, const char* file, int line);
+
+/**
+ * @brief Starts loading a texture in the background and returns immediately
+ * @note The texture exists right away as a white placeholder, so sprites can be added before it finishes.
+ * @see BE_LoadMeshAsync()
+ */
+#define BE_LoadTextureAsync(textureName, imageFile, callback, userData) BE_IMPL_LoadTextureAsync(textureName, imageFile, callback, userData, __FILE__, __LINE__)
+BE_LoadHandle BE_IMPL_LoadTextureAsync(const char* textureName, const char* imageFile, BE_LoadCallback callback, void* userData, const char* file, int line);
+
+/**
+ * @brief Starts loading a sound in the background and returns immediately
+ * @note The sound can only be found once it is ready.
+ * @see BE_LoadMeshAsync()
+ */
+#define BE_LoadSoundAsync(soundName, soundFile, callback, userData) BE_IMPL_LoadSoundAsync(soundName, soundFile, callback, userData, __FILE__, __LINE__)
+BE_LoadHandle BE_IMPL_LoadSoundAsync(const char* soundName, const char* soundFile, BE_LoadCallback callback, void* userData, const char* file, int line);
+
+/**
+ * @brief Starts reading shader sources in the background, they are compiled when finalized
+ * @note The shader can only be found once it is ready. Draws fall back to the default shader until then.
+ * @see BE_LoadMeshAsync()
+ */
+#define BE_LoadShaderAsync(shaderName, vertexFile, fragmentFile, geometryFile, computeFile, callback, userData) BE_IMPL_LoadShaderAsync(shaderName, vertexFile, fragmentFile, geometryFile, computeFile, callback, userData, __FILE__, __LINE__)
+BE_LoadHandle BE_IMPL_LoadShaderAsync(const char* shaderName, const char* vertexFile, const char* fragmentFile, const char* geometryFile, const char* computeFile, BE_LoadCallback callback, void* userData, const char* file, int line);
+
+/**
+ * @brief Gets the state of an async load
+ * @param handle The handle returned when the load was started (BE_LoadHandle).
+ * @return BE_LOAD_QUEUED, BE_LOAD_LOADING, BE_LOAD_READY or BE_LOAD_FAILED.
+ */
+#define BE_GetLoadState(handle) BE_IMPL_GetLoadState(handle, __FILE__, __LINE__)
+BE_LoadState BE_IMPL_GetLoadState(BE_LoadHandle handle, const char* file, int line);
+
+/**
+ * @brief Gets how many async loads have not finished yet
+ * @return The number of loads that are not ready or failed.
+ */
+#define BE_GetPendingLoads() BE_IMPL_GetPendingLoads(__FILE__, __LINE__)
+int BE_IMPL_GetPendingLoads(const char* file, int line);
+
+/**
+ * @brief Sets how long BE_BeginFrame may spend creating GL and FMOD objects for finished loads
+ * @param milliseconds The time budget per frame (double). At least one load is finalized per frame.
+ */
+#define BE_SetLoadBudget(milliseconds) do { BE_IMPL_SetLoadBudget(milliseconds, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetLoadBudget(double milliseconds, const char* file, int line);
+
 // =======================
 // AUDIO EMITTERS
 // =======================
@@ -1023,6 +2180,25 @@ void BE_IMPL_RemoveAllEmitters(const char* file, int line);
 #define BE_FindEmitter(emitterName) BE_IMPL_FindEmitter(emitterName, __FILE__, __LINE__)
 BE_Emitter* BE_IMPL_FindEmitter(const char* emitterName, const char* file, int line);
 
+/**
+ * @brief Gets the handle of a specific emitter, for repeated access without a name lookup
+ * @param emitterName The name of the specific emitter (const char*). Must not be NULL.
+ * @return The handle of the emitter (BE_Handle). BE_HANDLE_NONE if the emitter does not exist.
+ * @note Handles belong to the scene that was bound when they were taken.
+ * @see BE_GetEmitter()
+ */
+#define BE_GetEmitterHandle(emitterName) BE_IMPL_GetEmitterHandle(emitterName, __FILE__, __LINE__)
+BE_Handle BE_IMPL_GetEmitterHandle(const char* emitterName, const char* file, int line);
+
+/**
+ * @brief Gets the pointer to a specific emitter from its handle
+ * @param handle The handle of the specific emitter (BE_Handle).
+ * @return The pointer to the specific emitter. NULL if the emitter was removed since the handle was taken.
+ * @see BE_GetEmitterHandle()
+ */
+#define BE_GetEmitter(handle) BE_IMPL_GetEmitter(handle, __FILE__, __LINE__)
+BE_Emitter* BE_IMPL_GetEmitter(BE_Handle handle, const char* file, int line);
+
 /**
  * @brief Checks whether a specific audio emitter exists
  * @param emitterName The name of the emitter to check (const char*). Must not be NULL.
@@ -1101,6 +2277,15 @@ void BE_IMPL_SetEmitterSeek(const char* emitterName, float seek, const char* fil
 #define BE_SetEmitterPosition(emitterName, position) do { BE_IMPL_SetEmitterPosition(emitterName, position, __FILE__, __LINE__); } while(0)
 void BE_IMPL_SetEmitterPosition(const char* emitterName, const vec3 position, const char* file, int line);
 
+/**
+ * @brief Sets the position of a specific audio emitter from its handle
+ * @param handle The handle of the specific emitter (BE_Handle).
+ * @param position The new position of the emitter (vec3, use BE_vec3);. Must not be NULL.
+ * @see BE_SetEmitterPosition(), BE_GetEmitterHandle()
+ */
+#define BE_SetEmitterPositionByHandle(handle, position) do { BE_IMPL_SetEmitterPositionByHandle(handle, position, __FILE__, __LINE__); } while(0)
+void BE_IMPL_SetEmitterPositionByHandle(BE_Handle handle, const vec3 position, const char* file, int line);
+
 /**
  * @brief Sets the position of a specific audio emitter to a specific camera
  * @param emitterName The name of the specific emitter (const char*). Must not be NULL.
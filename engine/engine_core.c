@@ -0,0 +1,814 @@
+#include "engine/engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <math.h>
+
+// The parts of engine.h that need no GL context, window or audio device: messages, handles,
+// transform and camera matrices, light packing and OBJ/MTL parsing. Tools and benchmarks link
+// this with engine_memory.c and engine_jobs.c and leave the rest of the engine out.
+
+// ==============================
+// Messages
+// ==============================
+
+void BE_IMPL_Message(int severity, const char* module, const char* file, int line, const char* fmt, ...) {
+    static char last_msg[1024] = "";
+    static int repeat_count = 0;
+    static atomic_flag lock = ATOMIC_FLAG_INIT; // loader threads report too
+
+    char formatted[512];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(formatted, sizeof(formatted), fmt, args);
+    va_end(args);
+
+    const char* color_code;
+    const char* label;
+    switch (severity) {
+        case 0:     color_code = "\033[37m"; label = "[INFO]"; break;
+        case 1:     color_code = "\033[35m"; label = "[WARNING]"; break;
+        case 2:     color_code = "\033[31m"; label = "[ERROR]"; break;
+        case 3:     color_code = "\033[91m"; label = "[FATAL]"; break;
+        default:    color_code = "\033[37m"; label = "[INFO]"; break;
+    }
+
+    char full_msg[1024];
+    snprintf(full_msg, sizeof(full_msg), "%s%s\033[0m %s:%d -> %s: %s", color_code, label, file, line, module, formatted);
+
+    while (atomic_flag_test_and_set_explicit(&lock, memory_order_acquire)) BE_ThreadYield();
+    if (strcmp(last_msg, full_msg) == 0) {
+        repeat_count++;
+        printf("\r%s (x%d)\033[0m", full_msg, repeat_count + 1);
+        fflush(stdout);
+    } else {
+        if (repeat_count > 0) printf("\n");
+        strcpy(last_msg, full_msg);
+        repeat_count = 0;
+        fprintf(stderr, "%s\033[0m\n", full_msg);
+    }
+    atomic_flag_clear_explicit(&lock, memory_order_release);
+
+    if (severity >= 3) exit(1);
+}
+
+// ==============================
+// Handles
+// ==============================
+
+#define INITIAL_REGISTRY_SLOTS 16
+#define INITIAL_REGISTRY_BUCKETS 32
+#define REGISTRY_NO_SLOT UINT32_MAX
+
+// FNV-1a
+uint32_t BE_HashString(const char* string) {
+    uint32_t hash = 2166136261u;
+    for (const unsigned char* c = (const unsigned char*)string; *c; c++) {
+        hash ^= *c;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void BE_RegistryInit(BE_Registry* registry) {
+    static atomic_uint registries = 0;
+    memset(registry, 0, sizeof(BE_Registry));
+
+    // An odd step visits every generation before repeating, so a handle used with the
+    // wrong scene's vector almost never carries a matching generation
+    uint32_t salt = (atomic_fetch_add(&registries, 1) * 0x9E5u) & HANDLE_GENERATION_MASK;
+    registry->salt = (uint16_t)(salt ? salt : 1);
+}
+
+void BE_RegistryFree(BE_Registry* registry) {
+    for (size_t i = 0; i < registry->slotCount; i++) {
+        BE_MemFree(registry->names[i]);
+    }
+    BE_MemFree(registry->indices);
+    BE_MemFree(registry->generations);
+    BE_MemFree(registry->names);
+    BE_MemFree(registry->slots);
+    BE_MemFree(registry->freeSlots);
+    BE_MemFree(registry->buckets);
+    uint16_t salt = registry->salt;
+    memset(registry, 0, sizeof(BE_Registry));
+    registry->salt = salt;
+}
+
+// Registers the object just appended at index, which must be the vector's old size
+BE_Handle BE_RegistryAdd(BE_Registry* registry, const char* name, size_t index) {
+    if (index >= registry->indexCapacity) {
+        size_t capacity = registry->indexCapacity ? registry->indexCapacity : INITIAL_REGISTRY_SLOTS;
+        while (capacity <= index) capacity *= 2;
+        registry->slots = (uint32_t*)BE_MemRealloc(registry->slots, sizeof(uint32_t) * capacity, BE_MEMORY_SCENE);
+        registry->indexCapacity = capacity;
+    }
+
+    uint32_t slot;
+    if (registry->freeCount > 0) {
+        slot = registry->freeSlots[--registry->freeCount];
+    } else {
+        if (registry->slotCount > HANDLE_INDEX_MASK) {
+            registry->slots[index] = REGISTRY_NO_SLOT;
+            return BE_HANDLE_NONE;
+        }
+        if (registry->slotCount >= registry->slotCapacity) {
+            size_t capacity = registry->slotCapacity ? registry->slotCapacity * 2 : INITIAL_REGISTRY_SLOTS;
+            registry->indices = (uint32_t*)BE_MemRealloc(registry->indices, sizeof(uint32_t) * capacity, BE_MEMORY_SCENE);
+            registry->generations = (uint16_t*)BE_MemRealloc(registry->generations, sizeof(uint16_t) * capacity, BE_MEMORY_SCENE);
+            registry->names = (char**)BE_MemRealloc(registry->names, sizeof(char*) * capacity, BE_MEMORY_SCENE);
+            registry->freeSlots = (uint32_t*)BE_MemRealloc(registry->freeSlots, sizeof(uint32_t) * capacity, BE_MEMORY_SCENE);
+            registry->slotCapacity = capacity;
+        }
+        slot = (uint32_t)registry->slotCount++;
+        registry->generations[slot] = registry->salt;
+    }
+
+    registry->indices[slot] = (uint32_t)index;
+    registry->names[slot] = BE_MemStrdup(name ? name : "", BE_MEMORY_SCENE);
+    registry->slots[index] = slot;
+
+    // Like the old linear scan, the first object with a name is the one found
+    if (!BE_RegistryInsertName(registry, slot)) registry->duplicateNames++;
+
+    return ((BE_Handle)registry->generations[slot] << HANDLE_INDEX_BITS) | slot;
+}
+
+// Frees slot once its index is gone, size is the vector's size before removal
+static void BE_RegistryReleaseSlot(BE_Registry* registry, uint32_t slot, size_t size) {
+    bool named = BE_RegistryRemoveName(registry, slot);
+    if (!named) registry->duplicateNames--;
+    char* name = registry->names[slot];
+    registry->names[slot] = NULL;
+
+    uint16_t generation = (uint16_t)((registry->generations[slot] + 1) & HANDLE_GENERATION_MASK);
+    registry->generations[slot] = generation ? generation : 1;
+    registry->freeSlots[registry->freeCount++] = slot;
+
+    // A later object with the same name takes over the name, only searched for when the
+    // registry holds a name twice
+    if (named && registry->duplicateNames > 0) {
+        for (size_t i = 0; i + 1 < size; i++) {
+            uint32_t other = registry->slots[i];
+            if (other != REGISTRY_NO_SLOT && strcmp(registry->names[other], name) == 0) {
+                BE_RegistryInsertName(registry, other);
+                registry->duplicateNames--;
+                break;
+            }
+        }
+    }
+    BE_MemFree(name);
+}
+
+// Call before the vector moves its last element into index
+void BE_RegistryRemoveSwap(BE_Registry* registry, size_t index, size_t size) {
+    if (index >= size || size > registry->indexCapacity) return;
+
+    uint32_t slot = registry->slots[index];
+    uint32_t last = registry->slots[size - 1];
+    registry->slots[index] = last;
+    if (last != REGISTRY_NO_SLOT) registry->indices[last] = (uint32_t)index;
+    if (slot != REGISTRY_NO_SLOT) BE_RegistryReleaseSlot(registry, slot, size);
+}
+
+BE_Handle BE_RegistryHandle(BE_Registry* registry, size_t index) {
+    if (index >= registry->indexCapacity) return BE_HANDLE_NONE;
+    uint32_t slot = registry->slots[index];
+    if (slot == REGISTRY_NO_SLOT) return BE_HANDLE_NONE;
+    return ((BE_Handle)registry->generations[slot] << HANDLE_INDEX_BITS) | slot;
+}
+
+size_t BE_RegistryIndex(BE_Registry* registry, BE_Handle handle) {
+    uint32_t slot = handle & HANDLE_INDEX_MASK;
+    uint32_t generation = handle >> HANDLE_INDEX_BITS;
+    if (slot >= registry->slotCount || registry->generations[slot] != generation) return SIZE_MAX;
+    return registry->indices[slot];
+}
+
+size_t BE_RegistryFindBucket(BE_Registry* registry, const char* name, uint32_t hash) {
+    if (!registry->bucketCount || !name) return SIZE_MAX;
+
+    size_t mask = registry->bucketCount - 1;
+    for (size_t i = hash & mask; registry->buckets[i].slot; i = (i + 1) & mask) {
+        BE_NameBucket* bucket = &registry->buckets[i];
+        if (bucket->hash == hash && strcmp(registry->names[bucket->slot - 1], name) == 0) return i;
+    }
+    return SIZE_MAX;
+}
+
+BE_Handle BE_RegistryFind(BE_Registry* registry, const char* name) {
+    if (!name) return BE_HANDLE_NONE;
+    size_t bucket = BE_RegistryFindBucket(registry, name, BE_HashString(name));
+    if (bucket == SIZE_MAX) return BE_HANDLE_NONE;
+    uint32_t slot = registry->buckets[bucket].slot - 1;
+    return ((BE_Handle)registry->generations[slot] << HANDLE_INDEX_BITS) | slot;
+}
+
+size_t BE_RegistryFindIndex(BE_Registry* registry, const char* name) {
+    if (!name) return SIZE_MAX;
+    size_t bucket = BE_RegistryFindBucket(registry, name, BE_HashString(name));
+    if (bucket == SIZE_MAX) return SIZE_MAX;
+    return registry->indices[registry->buckets[bucket].slot - 1];
+}
+
+bool BE_RegistryInsertName(BE_Registry* registry, uint32_t slot) {
+    const char* name = registry->names[slot];
+    uint32_t hash = BE_HashString(name);
+    if (BE_RegistryFindBucket(registry, name, hash) != SIZE_MAX) return false;
+
+    if ((registry->nameCount + 1) * 4 > registry->bucketCount * 3) {
+        size_t count = registry->bucketCount ? registry->bucketCount * 2 : INITIAL_REGISTRY_BUCKETS;
+        BE_NameBucket* buckets = (BE_NameBucket*)BE_MemCalloc(count, sizeof(BE_NameBucket), BE_MEMORY_SCENE);
+
+        for (size_t i = 0; i < registry->bucketCount; i++) {
+            BE_NameBucket bucket = registry->buckets[i];
+            if (!bucket.slot) continue;
+            size_t j = bucket.hash & (count - 1);
+            while (buckets[j].slot) j = (j + 1) & (count - 1);
+            buckets[j] = bucket;
+        }
+
+        BE_MemFree(registry->buckets);
+        registry->buckets = buckets;
+        registry->bucketCount = count;
+    }
+
+    size_t mask = registry->bucketCount - 1;
+    size_t i = hash & mask;
+    while (registry->buckets[i].slot) i = (i + 1) & mask;
+    registry->buckets[i].hash = hash;
+    registry->buckets[i].slot = slot + 1;
+    registry->nameCount++;
+    return true;
+}
+
+// Returns false if the slot's name belonged to another object
+bool BE_RegistryRemoveName(BE_Registry* registry, uint32_t slot) {
+    size_t i = BE_RegistryFindBucket(registry, registry->names[slot], BE_HashString(registry->names[slot]));
+    if (i == SIZE_MAX || registry->buckets[i].slot != slot + 1) return false;
+
+    // Backward shift instead of tombstones: pull later entries of the probe run into the hole
+    // unless that would move them in front of their home bucket
+    size_t mask = registry->bucketCount - 1;
+    for (size_t j = (i + 1) & mask; registry->buckets[j].slot; j = (j + 1) & mask) {
+        size_t home = registry->buckets[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            registry->buckets[i] = registry->buckets[j];
+            i = j;
+        }
+    }
+    registry->buckets[i].slot = 0;
+    registry->nameCount--;
+    return true;
+}
+
+// ==============================
+// Transforms
+// ==============================
+
+BE_Transform BE_TransformInit(vec3 position, vec3 eulerRotation, vec3 scale) {
+    BE_Transform transform;
+    glm_vec3_copy(position, transform.position);
+    // glm_vec3_copy(rotation, transform.rotation);
+    glm_vec3_copy(scale, transform.scale);
+
+    versor qPitch, qYaw, qRoll;
+    glm_quatv(qPitch, eulerRotation[0], (vec3){1,0,0});
+    glm_quatv(qYaw,   eulerRotation[1], (vec3){0,1,0});
+    glm_quatv(qRoll,  eulerRotation[2], (vec3){0,0,1});
+
+    glm_quat_mul(qYaw, qPitch, transform.orientation);
+    glm_quat_mul(transform.orientation, qRoll, transform.orientation);
+    glm_quat_normalize(transform.orientation);
+
+    return transform;
+}
+
+void BE_TransformUpdateMatrix(BE_Transform* transform, mat4 outMatrix) {
+    mat4 rot;
+    glm_quat_mat4(transform->orientation, rot); // quaternion -> rotation matrix
+
+    mat4 scale;
+    glm_scale_make(scale, transform->scale);
+
+    mat4 trans;
+    glm_translate_make(trans, transform->position);
+
+    // Combine: modelMatrix = Translation * Rotation * Scale
+    glm_mat4_mul(rot, scale, outMatrix);        // rotation * scale
+    glm_mat4_mul(trans, outMatrix, outMatrix);  // translation * (rotation*scale)
+}
+
+// ==============================
+// Cameras
+// ==============================
+
+BE_Camera BE_CameraInit(const char* name, int width, int height, float fov, float nearPlane, float farPlane, vec3 position, vec3 direction) {
+    BE_Camera camera;
+    camera.name = BE_MemStrdup(name ? name : "new camera", BE_MEMORY_SCENE);
+    camera.width = width;
+    camera.height = height;
+    camera.entity = BE_ENTITY_NONE;
+    glm_vec3_copy(position, camera.position);
+
+    camera.pitch = 0;
+    camera.yaw = 0;
+    camera.roll = 0;
+
+    glm_quat_identity(camera.orientation);
+    vec3 forward = {0,0,-1};
+    vec3 dirNorm;
+    glm_vec3_normalize_to(direction, dirNorm);
+    glm_quat_from_vecs(forward, dirNorm, camera.orientation);
+
+    camera.zoom = 1.0f;
+    camera.fov = fov;
+
+    camera.nearPlane = nearPlane;
+    camera.farPlane = farPlane;
+
+    mat4 mat;
+    glm_mat4_identity(mat);
+    glm_mat4_copy(mat, camera.projPersp);
+    glm_mat4_copy(mat, camera.projOrtho);
+
+    return camera;
+}
+
+#define CAMERA_PAGE_ELEMENTS 16
+
+void BE_CameraVectorInit(BE_CameraVector* vec) {
+    BE_PoolInit(&vec->pool, sizeof(BE_Camera), CAMERA_PAGE_ELEMENTS, BE_MEMORY_SCENE);
+    BE_RegistryInit(&vec->registry);
+}
+
+void BE_CameraVectorPush(BE_CameraVector* vec, BE_Camera value) {
+    BE_RegistryAdd(&vec->registry, value.name, vec->pool.size);
+    *(BE_Camera*)BE_PoolAlloc(&vec->pool) = value;
+}
+
+void BE_CameraVectorFree(BE_CameraVector* vec) {
+    BE_RegistryFree(&vec->registry);
+    BE_PoolFree(&vec->pool);
+}
+
+void BE_CameraVectorCopy(BE_Camera* lights, size_t count, BE_CameraVector* outVec) {
+    BE_CameraVectorInit(outVec);
+    for (size_t i = 0; i < count; i++) {
+        BE_CameraVectorPush(outVec, lights[i]);
+    }
+}
+
+void BE_CameraVectorUpdateMatrix(BE_CameraVector* vec, int width, int height) {
+    
+    mat4 view;
+    mat4 projection;
+    mat4 projView;
+    
+    for (size_t i = 0; i < vec->pool.size; i++) {
+        BE_Camera* camera = BE_CameraVectorAt(vec, i);
+        
+        float fov = camera->fov;
+
+        camera->width = width;
+        camera->height = height;
+
+        vec3 target, forward;
+        glm_quat_rotatev(camera->orientation, (vec3){0.0f, 0.0f, -1.0f}, forward);
+        // glm_quat_rotatev(camera->orientation, (vec3){0.0f, 1.0f,  0.0f}, up);
+        glm_vec3_add(camera->position, forward, target);
+        glm_lookat(camera->position, target, (vec3){0,1,0}, view);
+        
+        glm_perspective(glm_rad(fov), (float)camera->width / (float)camera->height, camera->nearPlane, camera->farPlane, projection);
+        glm_mat4_mul(projection, view, projView);
+        glm_mat4_copy(projView, camera->projPersp);
+        glm_mat4_copy(view, camera->viewMatrix);
+
+        glm_ortho(0.0f, (float)camera->width, (float)camera->height, 0.0f, -1.0f, 1.0f, camera->projOrtho);
+
+    }
+}
+
+// ==============================
+// Lights
+// ==============================
+
+BE_Light BE_LightInit(const char* name, int type, vec3 position, vec3 direction, vec4 color, float specular, float a, float b, float innerCone, float outerCone) {
+
+    BE_Light light = {0};
+    light.name = BE_MemStrdup(name ? name : "new light", BE_MEMORY_SCENE);
+    glm_vec4_copy(color, light.color);
+    light.specular = specular;
+    
+    glm_quat_identity(light.orientation);
+    vec3 forward = {0,0,-1};
+
+    switch (type) {
+        case BE_LIGHT_DIRECT:
+            glm_quat_from_vecs(forward, direction, light.orientation);
+            glm_vec3_copy(direction, light.direction);
+            break;
+
+        case BE_LIGHT_POINT:
+            glm_vec3_copy(position, light.position);
+            break;
+
+        case BE_LIGHT_SPOT:
+            glm_quat_from_vecs(forward, direction, light.orientation);
+            glm_vec3_copy(position, light.position);
+            glm_vec3_copy(direction, light.direction);
+            break;
+        
+        default:
+            printf("invalid light type\n");
+            break;
+    }
+
+    light.type = type;
+    light.a = a;
+    light.b = b;
+    light.innerCone = innerCone;
+    light.outerCone = outerCone;
+
+    return light;
+}
+
+float BE_LightGetRange(BE_Light* light) {
+    // Spot lights are only shaped by their cone in the scene shader, a and b don't dim them
+    if (light->type == BE_LIGHT_SPOT) return DIRECT_LIGHT_DIST * 2;
+
+    // Distance at which 1 / (a*d^2 + b*d + 1) drops below 1/256
+    const float cutoff = 255.0f;
+    float range;
+
+    if (light->a > 1e-6f) {
+        range = (-light->b + sqrtf(light->b * light->b + 4.0f * light->a * cutoff)) / (2.0f * light->a);
+    } else if (light->b > 1e-6f) {
+        range = cutoff / light->b;
+    } else {
+        range = DIRECT_LIGHT_DIST * 2;
+    }
+
+    return fminf(range, DIRECT_LIGHT_DIST * 2);
+}
+
+// The std430 entry the scene shader reads for a point or spot light
+void BE_LightPackGPU(BE_LightVector* vec, BE_Light* light, BE_GPULight* outLight) {
+    memset(outLight, 0, sizeof(BE_GPULight));
+
+    float range = BE_LightGetRange(light);
+    glm_vec3_copy(light->position, outLight->position);
+    outLight->position[3] = range;
+    glm_normalize_to(light->direction, outLight->direction);
+    if (glm_vec3_norm2(outLight->direction) == 0.0f) glm_vec3_copy((vec3){0.0f, -1.0f, 0.0f}, outLight->direction);
+    outLight->direction[3] = light->outerCone;
+    glm_vec4_copy(light->color, outLight->color);
+    outLight->params[0] = light->a;
+    outLight->params[1] = light->b;
+    outLight->params[2] = light->innerCone;
+    outLight->params[3] = light->specular;
+    glm_mat4_copy(light->lightSpaceMatrix, outLight->lightSpaceMatrix);
+    outLight->type = light->type;
+    outLight->shadowIndex = -1;
+
+    if (light->type == BE_LIGHT_POINT && light->shadowLayer >= 0 && light->shadowLayer < vec->pointShadowFBO.layers / 6) {
+        outLight->shadowIndex = light->shadowLayer;
+        outLight->farPlane = range;
+    }
+
+    if (light->type == BE_LIGHT_SPOT) {
+        for (int k = 0; k < 4; k++) {
+            outLight->shadowRect[k] = (float)light->shadowTile[k] / vec->spotAtlas.size;
+        }
+    }
+}
+
+// ==============================
+// Mesh Import
+// ==============================
+
+int BE_FindOrAddVertex(BE_Vertex* vertices, int* verticesCount, BE_Vertex v) {
+    for (int i = 0; i < *verticesCount; i++) {
+        if (memcmp(&vertices[i], &v, sizeof(BE_Vertex)) == 0) {
+            return i;
+        }
+    }
+
+    int index = (*verticesCount)++;
+    vertices[index] = v;
+    return index;
+}
+
+int BE_CountFaceVertices(const char* line) {
+    const char* ptr = line + 2;
+    int count = 0;
+
+    while (*ptr) {
+        while (*ptr == ' ' || *ptr == '\t' || *ptr == '\r' || *ptr == '\n') ptr++;
+        if (*ptr == '\0') break;
+
+        const char* token_start = ptr;
+
+        while (*ptr && *ptr != ' ' && *ptr != '\t' && *ptr != '\r' && *ptr != '\n') ptr++;
+
+        char token[64];
+        size_t len = ptr - token_start;
+        if (len >= sizeof(token)) len = sizeof(token) - 1;
+        memcpy(token, token_start, len);
+        token[len] = '\0';
+
+        int vi, vti, vni;
+        if (sscanf(token, "%d/%d/%d", &vi, &vti, &vni) == 3 ||
+            sscanf(token, "%d//%d", &vi, &vni) == 2 ||
+            sscanf(token, "%d/%d", &vi, &vti) == 2 ||
+            sscanf(token, "%d", &vi) == 1) {
+            count++;
+        }
+    }
+
+    return count;
+}
+
+void BE_ReplacePathSuffix(const char* path, const char* newsuffix, char* dest, int destsize) {
+    const char* lastSlash = strrchr(path, '/');
+
+    if (!lastSlash) {
+        snprintf(dest, destsize, "%s", newsuffix);
+        return;
+    }
+
+    int dirLen = lastSlash - path + 1;
+
+    if (dirLen >= destsize) dirLen = destsize - 1;
+
+    strncpy(dest, path, dirLen);
+    dest[dirLen] = '\0';
+
+    strncat(dest, newsuffix, destsize - strlen(dest) - 1);
+}
+
+// strtok keeps hidden state, and loader threads parse files side by side
+char* BE_NextToken(char** cursor, const char* delims) {
+    char* start = *cursor + strspn(*cursor, delims);
+    if (*start == '\0') {
+        *cursor = start;
+        return NULL;
+    }
+
+    char* end = start + strcspn(start, delims);
+    if (*end) *end++ = '\0';
+    *cursor = end;
+    return start;
+}
+
+// Everything up to GL object creation, safe to run on a loader thread
+bool BE_ParseOBJ(const char* obj_path, BE_OBJData* outData) {
+    memset(outData, 0, sizeof(BE_OBJData));
+
+    FILE* file = fopen(obj_path, "r");
+    if (!file) {
+        BE_IMPL_Message(2, "Mesh", obj_path, 1, "Failed to find OBJ file '%s'", obj_path);
+        return false;
+    }
+
+    // Only the vertices and indices outlive the parse, the rest is scratch
+    BE_ArenaMark scratch = BE_ScratchBegin();
+    vec3* positions = BE_ARENA_NEW(scratch.arena, vec3, 100000);
+    int positionsCount = 0;
+    vec3* normals = BE_ARENA_NEW(scratch.arena, vec3, 100000);
+    int normalsCount = 0;
+    vec2* uvs = BE_ARENA_NEW(scratch.arena, vec2, 100000);
+    int uvsCount = 0;
+    BE_Vertex* vertices = (BE_Vertex*)BE_MemAlloc(sizeof(BE_Vertex) * 100000, BE_MEMORY_MESH);
+    int verticesCount = 0;
+    GLuint* indices =  (GLuint*)BE_MemAlloc(sizeof(GLuint) * 100000, BE_MEMORY_MESH);
+    int indicesCount = 0;
+
+    if (!positions || !normals || !uvs || !vertices || !indices) {
+        BE_IMPL_Message(2, "Mesh", obj_path, 1, "Could not allocate memory for mesh data");
+        BE_ScratchEnd(scratch);
+        BE_MemFree(vertices);
+        BE_MemFree(indices);
+        fclose(file);
+        return false;
+    }
+
+    const char** textures = NULL;
+    int texturesCount = 0;
+
+    char line[546];
+    int lineNum = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        lineNum++;
+        
+        if ( 
+            line[0] == '#' || 
+            line[0] == '\n' || 
+            strncmp(line, "o ", 2) == 0 || 
+            strncmp(line, "s ", 2) == 0
+        ) continue;
+
+        if (strncmp(line, "mtllib ", 7) == 0) {
+            char mtl_file[256] = {0};
+            char mtl_filepath[256] = {0};
+
+            sscanf(line, "mtllib %s", mtl_file);
+            BE_ReplacePathSuffix(obj_path, mtl_file, mtl_filepath, sizeof(mtl_filepath));
+
+            textures = BE_LoadMTLTextures(mtl_filepath, &texturesCount);
+
+        } else if (strncmp(line, "v ", 2) == 0) {
+
+            vec3 v;
+            if (sscanf(line, "v %f %f %f", &v[0], &v[1], &v[2]) == 3) {
+                glm_vec3_copy(v, positions[positionsCount++]);
+            } else {
+                BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Broken position vertex '%s'", line);
+                continue;
+            }
+
+        } else if (strncmp(line, "vt ", 3) == 0) {
+
+            vec2 vt;
+            if (sscanf(line, "vt %f %f", &vt[0], &vt[1]) == 2) {
+                glm_vec2_copy(vt, uvs[uvsCount++]);
+            } else {
+                BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Broken uv vertex '%s'", line);
+                continue;
+            }
+
+        } else if (strncmp(line, "vn ", 3) == 0) {
+
+            vec3 vn;
+            if (sscanf(line, "vn %f %f %f", &vn[0], &vn[1], &vn[2]) == 3) {
+                glm_vec3_copy(vn, normals[normalsCount++]);
+            } else {
+                BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Broken normal vertex '%s'", line);
+                continue;
+            }
+
+        } else if (strncmp(line, "f ", 2) == 0) {
+            
+            int faceVertCount = BE_CountFaceVertices(line);
+
+            char* cursor = line + 2;
+            char* token = BE_NextToken(&cursor, " \t\r\n");
+            
+            BE_ArenaMark face = BE_ScratchBegin();
+            BE_Vertex* verts = BE_ARENA_NEW(face.arena, BE_Vertex, faceVertCount);
+            int numVerts = 0;
+
+            while (token != NULL) {
+
+                int vi, vti, vni;
+
+                if (sscanf(token, "%d/%d/%d", &vi, &vti, &vni) == 3) {
+
+                    vi--; vti--; vni--;
+                    glm_vec3_copy(positions[vi], verts[numVerts].position);
+                    glm_vec3_copy(normals[vni], verts[numVerts].normal);
+                    glm_vec3_copy((vec3){1.0f,1.0f,1.0f}, verts[numVerts].color);
+                    glm_vec2_copy(uvs[vti], verts[numVerts].texUV);
+
+                } else if (sscanf(token, "%d//%d", &vi, &vni) == 2) {
+
+                    vi--; vni--;
+                    glm_vec3_copy(positions[vi], verts[numVerts].position);
+                    glm_vec3_copy(normals[vni], verts[numVerts].normal);
+                    glm_vec3_copy((vec3){1.0f,1.0f,1.0f}, verts[numVerts].color);
+                    glm_vec2_copy((vec2){0.0f,0.0f}, verts[numVerts].texUV);
+
+                } else if (sscanf(token, "%d/%d", &vi, &vti) == 2) {
+
+                    vi--; vni--;
+                    glm_vec3_copy(positions[vi], verts[numVerts].position);
+                    glm_vec3_copy((vec3){0.0f,0.0f,1.0f}, verts[numVerts].normal);
+                    glm_vec3_copy((vec3){1.0f,1.0f,1.0f}, verts[numVerts].color);
+                    glm_vec2_copy(uvs[vti], verts[numVerts].texUV);
+
+                } else if (sscanf(token, "%d", &vi) == 1) {
+
+                    vi--;
+                    glm_vec3_copy(positions[vi], verts[numVerts].position);
+                    glm_vec3_copy((vec3){0.0f,0.0f,1.0f}, verts[numVerts].normal);
+                    glm_vec3_copy((vec3){1.0f,1.0f,1.0f}, verts[numVerts].color);
+                    glm_vec2_copy((vec2){0.0f,0.0f}, verts[numVerts].texUV);
+
+                } else {
+                    BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Broken face vertex '%s'", token);
+                }
+
+                token = BE_NextToken(&cursor, " \t\r\n");
+                numVerts++;
+            }
+
+            for (int i = 1; i < numVerts - 1; i++) {
+                int i0 = BE_FindOrAddVertex(vertices, &verticesCount, verts[0]);
+                int i1 = BE_FindOrAddVertex(vertices, &verticesCount, verts[i]);
+                int i2 = BE_FindOrAddVertex(vertices, &verticesCount, verts[i + 1]);
+
+                indices[indicesCount++] = i1;
+                indices[indicesCount++] = i0;
+                indices[indicesCount++] = i2;
+            }
+
+            BE_ScratchEnd(face);
+            
+        } else {
+            line[strcspn(line, "\n")] = '\0';
+            BE_IMPL_Message(2, "Mesh", obj_path, lineNum, "Unsupported OBJ directive '%s'", line);
+            continue;
+        }
+
+    }
+
+    fclose(file);
+
+    // Only the first texture is bound, the rest of the MTL list is dropped
+    if (texturesCount >= 2) {
+        outData->texturePath = (char*)textures[0];
+        outData->textureType = (char*)textures[1];
+        for (int i = 2; i < texturesCount; i++) BE_MemFree((void*)textures[i]);
+    } else {
+        outData->texturePath = BE_MemStrdup("res/textures/null.jpg", BE_MEMORY_MESH);
+        outData->textureType = BE_MemStrdup("diffuse", BE_MEMORY_MESH);
+    }
+    BE_MemFree(textures);
+
+    BE_ScratchEnd(scratch);
+
+    outData->vertices = vertices;
+    outData->verticesCount = verticesCount;
+    outData->indices = indices;
+    outData->indicesCount = indicesCount;
+
+    return true;
+}
+
+const char** BE_LoadMTLTextures(const char* mtl_path, int* outCount) {
+
+    if (outCount) *outCount = 0;
+
+    // The mesh falls back to the null texture
+    FILE* file = fopen(mtl_path, "r");
+    if (!file) {
+        BE_IMPL_Message(2, "Mesh", mtl_path, 1, "Could not open file '%s'", mtl_path);
+        return NULL;
+    }
+    
+    const char** textures = (const char**)BE_MemAlloc(sizeof(char*) * 50, BE_MEMORY_MESH);
+    int count = 0;
+    if (!textures) {
+        BE_IMPL_Message(1, "Mesh", mtl_path, 1, "Could not allocate memory for mesh textures");
+        fclose(file);
+        return NULL;
+    }
+
+    char line[256];
+    int lineNum = 0;
+
+    while (fgets(line, sizeof(line), file)) {
+        lineNum++;
+        
+        if ( 
+            line[0] == '#' || 
+            line[0] == '\n'
+        ) continue;
+
+        if (strncmp(line, "map_Kd ", 7) == 0) {
+
+            char fileRelPath[256];
+            sscanf(line, "map_Kd %s", fileRelPath);
+
+            char texturePath[512];
+            BE_ReplacePathSuffix(mtl_path, fileRelPath, texturePath, sizeof(texturePath));
+
+            textures[count++] = BE_MemStrdup(texturePath, BE_MEMORY_MESH);
+            textures[count++] = BE_MemStrdup("diffuse", BE_MEMORY_MESH);
+
+        } else if (strncmp(line, "map_Ks ", 7) == 0) {
+            
+            char fileRelPath[256];
+            sscanf(line, "map_Ks %s", fileRelPath);
+
+            char texturePath[512];
+            BE_ReplacePathSuffix(mtl_path, fileRelPath, texturePath, sizeof(texturePath));
+
+            textures[count++] = BE_MemStrdup(texturePath, BE_MEMORY_MESH);
+            textures[count++] = BE_MemStrdup("specular", BE_MEMORY_MESH);
+        
+        } else {
+            line[strcspn(line, "\n")] = '\0';
+            BE_IMPL_Message(1, "Mesh", mtl_path, lineNum, "Unsupported MTL directive '%s'", line);
+            continue;
+        }
+    }
+
+    fclose(file);
+
+    if (outCount) *outCount = count;
+    return textures;
+}
@@ -7,22 +7,24 @@
 // ==============================
 
 static const char* BE_DefaultSpriteVert = "#version 460 core\n"
-"layout (location = 0) in vec2 aPos;\n"
+"layout (location = 0) in vec3 aPos;\n"
 "layout (location = 1) in vec2 aTex;\n"
+"layout (location = 2) in vec3 aColor;\n"
 "out vec2 texCoord;\n"
+"out vec3 spriteColor;\n"
 "uniform mat4 camMatrix;\n"
-"uniform mat4 model;\n"
 "void main()\n"
 "{\n"
-"    gl_Position = camMatrix * model * vec4(aPos, 0.0, 1.0);\n"
+"    gl_Position = camMatrix * vec4(aPos, 1.0);\n"
 "    texCoord = aTex;\n"
+"    spriteColor = aColor;\n"
 "}\n";
 
 static const char* BE_DefaultSpriteFrag = "#version 460 core\n"
 "in vec2 texCoord;\n"
+"in vec3 spriteColor;\n"
 "out vec4 FragColor;\n"
 "uniform sampler2D spriteTexture;\n"
-"uniform vec3 spriteColor;\n"
 "void main()\n"
 "{\n"
 "    vec4 texColor = texture(spriteTexture, texCoord);\n"
@@ -47,6 +49,40 @@ static const char* BE_DefaultDepthVert = "#version 460 core\n"
 "    gl_Position = lightSpaceMatrix * model * vec4(aPos, 1.0);\n"
 "}\n";
 
+static const char* BE_DefaultPointDepthVert = "#version 460 core\n"
+"layout (location = 0) in vec3 aPos;\n"
+"uniform mat4 model;\n"
+"void main() {\n"
+"    gl_Position = model * vec4(aPos, 1.0);\n"
+"}\n";
+
+// One invocation per cube face, faces the caster does not touch are skipped
+static const char* BE_DefaultPointDepthGeom = "#version 460 core\n"
+"layout (triangles, invocations = 6) in;\n"
+"layout (triangle_strip, max_vertices = 3) out;\n"
+"uniform mat4 faceMatrices[6];\n"
+"uniform int faceMask;\n"
+"uniform int cubeIndex;\n"
+"out vec3 fragPos;\n"
+"void main() {\n"
+"    if ((faceMask & (1 << gl_InvocationID)) == 0) return;\n"
+"    for (int i = 0; i < 3; i++) {\n"
+"        gl_Layer = cubeIndex * 6 + gl_InvocationID;\n"
+"        fragPos = gl_in[i].gl_Position.xyz;\n"
+"        gl_Position = faceMatrices[gl_InvocationID] * gl_in[i].gl_Position;\n"
+"        EmitVertex();\n"
+"    }\n"
+"    EndPrimitive();\n"
+"}\n";
+
+static const char* BE_DefaultPointDepthFrag = "#version 460 core\n"
+"in vec3 fragPos;\n"
+"uniform vec3 lightPos;\n"
+"uniform float farPlane;\n"
+"void main() {\n"
+"    gl_FragDepth = length(fragPos - lightPos) / farPlane;\n"
+"}\n";
+
 static const char* BE_Default3DVert = "#version 460 core\n"
 "\n"
 "layout (location = 0) in vec3 aPos;\n"
@@ -93,37 +129,36 @@ static const char* BE_Default3DFrag = "#version 460 core\n"
 "    mat4 lightSpaceMatrix;\n"
 "};\n"
 "\n"
-"struct PointLight {\n"
-"    vec3 position;\n"
-"    vec4 color;\n"
-"    float a;\n"
-"    float b;\n"
-"    float specular;\n"
-"    mat4 lightSpaceMatrix;\n"
-"};\n"
-"\n"
-"struct SpotLight {\n"
-"    vec3 position;\n"
-"    vec3 direction;\n"
+"struct Light {\n"
+"    vec4 position;\n"
+"    vec4 direction;\n"
 "    vec4 color;\n"
-"    float innerCone;\n"
-"    float outerCone;\n"
-"    float specular;\n"
+"    vec4 params;\n"
+"    vec4 shadowRect;\n"
 "    mat4 lightSpaceMatrix;\n"
+"    int type;\n"
+"    int shadowIndex;\n"
+"    float farPlane;\n"
+"    float pad;\n"
 "};\n"
 "\n"
 "uniform int numDirects;\n"
 "uniform DirectLight directlights[10];\n"
 "uniform sampler2DArray directShadowMapArray;\n"
 "\n"
-"uniform int numPoints;\n"
-"uniform PointLight pointlights[10];\n"
-"uniform sampler2DArray pointShadowMapArray;\n"
+"uniform samplerCubeArray pointShadowMapArray;\n"
 "\n"
-"uniform int numSpots;\n"
-"uniform SpotLight spotlights[10];\n"
 "uniform sampler2DArray spotShadowMapArray;\n"
 "\n"
+"layout (std430, binding = 0) readonly buffer LightBuffer { Light lights[]; };\n"
+"layout (std430, binding = 1) readonly buffer ClusterGrid { uvec2 clusterGrid[]; };\n"
+"layout (std430, binding = 2) readonly buffer ClusterIndices { uint clusterIndices[]; };\n"
+"uniform mat4 viewMatrix;\n"
+"uniform vec2 clusterScreen;\n"
+"uniform float clusterNear;\n"
+"uniform float clusterFar;\n"
+"const uvec3 clusterDims = uvec3(16, 9, 24);\n"
+"\n"
 "vec3 calcDirectLight(DirectLight light, vec3 normal, vec3 viewDirection, int index) {\n"
 "    vec3 lightDirection = normalize(-light.direction);\n"
 "    float diffuse = max(dot(normal, lightDirection), 0.0f);\n"
@@ -154,51 +189,71 @@ static const char* BE_Default3DFrag = "#version 460 core\n"
 "    return (texture(diffuse0, texCoord) * diffuse * (1.0f - shadow) + texture(specular0, texCoord).r * specular * (1.0f - shadow)) * light.color;\n"
 "}\n"
 "\n"
-"vec3 calcPointLight(PointLight light, vec3 normal, vec3 viewDirection, int index) {\n"
-"    float dist = length(light.position - crntPos);\n"
-"    float inten = 1.0f / (light.a * dist * dist + light.b * dist + 1.0f);\n"
-"    vec3 lightDirection = normalize(light.position - crntPos);\n"
+"vec3 calcPointLight(Light light, vec3 normal, vec3 viewDirection) {\n"
+"    float dist = length(light.position.xyz - crntPos);\n"
+"    float inten = 1.0f / (light.params.x * dist * dist + light.params.y * dist + 1.0f);\n"
+"    vec3 lightDirection = normalize(light.position.xyz - crntPos);\n"
 "    float diffuse = max(dot(normal, lightDirection), 0.0f);\n"
 "    float specular = 0.0f;\n"
 "    if (diffuse != 0.0f) {\n"
-"        float specularLight = light.specular;\n"
+"        float specularLight = light.params.w;\n"
 "        vec3 halfwayVec = normalize(viewDirection + lightDirection);\n"
 "        float specAmount = pow(max(dot(normal, halfwayVec), 0.0f), 16);\n"
 "        specular = specAmount * specularLight;\n"
 "    };\n"
-"    return (texture(diffuse0, texCoord) * (diffuse * inten) + texture(specular0, texCoord).r * specular * inten) * light.color;\n"
+"    float shadow = 0.0f;\n"
+"    vec3 fragToLight = crntPos - light.position.xyz;\n"
+"    float currentDepth = length(fragToLight);\n"
+"    if (light.shadowIndex >= 0 && currentDepth < light.farPlane) {\n"
+"        float bias = max(0.05f * (1.0f - dot(normal, lightDirection)), 0.005f);\n"
+"        float texelSize = 2.0 * currentDepth / float(textureSize(pointShadowMapArray, 0).x);\n"
+"        for (int z = -sampleRadius; z <= sampleRadius; z++) {\n"
+"            for (int y = -sampleRadius; y <= sampleRadius; y++) {\n"
+"                for (int x = -sampleRadius; x <= sampleRadius; x++) {\n"
+"                    vec3 sampleDir = fragToLight + vec3(x, y, z) * texelSize;\n"
+"                    float closestDepth = texture(pointShadowMapArray, vec4(sampleDir, light.shadowIndex)).r * light.farPlane;\n"
+"                    if (currentDepth > closestDepth + bias) shadow += 1.0f;\n"
+"                }\n"
+"            }\n"
+"        }\n"
+"        shadow /= pow((sampleRadius * 2. + 1.), 3);\n"
+"    }\n"
+"    return (texture(diffuse0, texCoord) * (diffuse * (1.0f - shadow) * inten) + texture(specular0, texCoord).r * specular * (1.0f - shadow) * inten) * light.color;\n"
 "}\n"
 "\n"
-"vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 viewDirection, int index) {\n"
-"    vec3 lightDirection = normalize(light.position - crntPos);\n"
+"vec3 calcSpotLight(Light light, vec3 normal, vec3 viewDirection) {\n"
+"    vec3 lightDirection = normalize(light.position.xyz - crntPos);\n"
 "    float diffuse = max(dot(normal, lightDirection), 0.0f);\n"
 "    float specular = 0.0f;\n"
 "    if (diffuse != 0.0f) {\n"
-"        float specularLight = light.specular;\n"
+"        float specularLight = light.params.w;\n"
 "        vec3 halfwayVec = normalize(viewDirection + lightDirection);\n"
 "        float specAmount = pow(max(dot(normal, halfwayVec), 0.0f), 8);\n"
 "        specular = specAmount * specularLight;\n"
 "    };\n"
-"    float angle = dot(normalize(-light.direction), lightDirection);\n"
-"    float inten = clamp((angle - light.outerCone) / (light.outerCone - light.innerCone), 0.0f, 1.0f);\n"
+"    float angle = dot(normalize(-light.direction.xyz), lightDirection);\n"
+"    float inten = clamp((angle - light.direction.w) / (light.direction.w - light.params.z), 0.0f, 1.0f);\n"
 "    vec4 fragPosLight = light.lightSpaceMatrix * vec4(crntPos, 1.0);\n"
 "    float shadow = 0.0f;\n"
 "    vec3 lightCoords = fragPosLight.xyz / fragPosLight.w;\n"
-"    if(lightCoords.z <= 1.0f) {\n"
+"    if(lightCoords.z <= 1.0f && light.shadowRect.z > 0.0f) {\n"
 "        lightCoords = (lightCoords + 1.0f) / 2.0f;\n"
-"        float closestDepth = texture(spotShadowMapArray, vec3(lightCoords.xy, index)).r;\n"
 "        float currentDepth = lightCoords.z;\n"
 "        float bias = max(0.005f * (1.0f - dot(normal, lightDirection)), 0.002f);\n"
-"        vec2 pixelSize = 1.0 / vec2(textureSize(spotShadowMapArray, index).xy);\n"
+"        vec2 pixelSize = 1.0 / vec2(textureSize(spotShadowMapArray, 0).xy);\n"
+"        vec2 tileMin = light.shadowRect.xy + pixelSize * 0.5;\n"
+"        vec2 tileMax = light.shadowRect.xy + light.shadowRect.zw - pixelSize * 0.5;\n"
+"        vec2 atlasCoords = light.shadowRect.xy + clamp(lightCoords.xy, 0.0, 1.0) * light.shadowRect.zw;\n"
 "        for (int y = -sampleRadius; y <= sampleRadius; y++) {\n"
 "            for (int x = -sampleRadius; x <= sampleRadius; x++) {\n"
-"                closestDepth = texture(spotShadowMapArray, vec3(lightCoords.xy + vec2(x, y) * pixelSize, index)).r;\n"
+"                vec2 sampleCoords = clamp(atlasCoords + vec2(x, y) * pixelSize, tileMin, tileMax);\n"
+"                float closestDepth = texture(spotShadowMapArray, vec3(sampleCoords, 0)).r;\n"
 "                if (currentDepth > closestDepth + bias) shadow += 1.0f;\n"
 "            }\n"
 "        }\n"
 "        shadow /= pow((sampleRadius * 2. + 1.), 2);\n"
 "    }\n"
-"    return (texture(diffuse0, texCoord) * (diffuse * inten) + texture(specular0, texCoord).r * specular * inten) * light.color;\n"
+"    return (texture(diffuse0, texCoord) * (diffuse * (1.0f - shadow) * inten) + texture(specular0, texCoord).r * specular * (1.0f - shadow) * inten) * light.color;\n"
 "}\n"
 "\n"
 "float near = 0.1f;\n"
@@ -220,8 +275,19 @@ static const char* BE_Default3DFrag = "#version 460 core\n"
 "    vec3 viewDir = normalize(camPos - crntPos);\n"
 "    vec3 result = texture(diffuse0, texCoord).rgb * ambient;\n"
 "    for (int i = 0; i < numDirects; i++) result += calcDirectLight(directlights[i], normal, viewDir, i);\n"
-"    for (int i = 0; i < numPoints; i++) result += calcPointLight(pointlights[i], normal, viewDir, i);\n"
-"    for (int i = 0; i < numSpots; i++) result += calcSpotLight(spotlights[i], normal, viewDir, i);\n"
+"    // Only the point and spot lights binned into this fragment's cluster are evaluated\n"
+"    float viewDepth = -(viewMatrix * vec4(crntPos, 1.0)).z;\n"
+"    uvec2 tile = uvec2(clamp(gl_FragCoord.xy / clusterScreen, 0.0, 0.999) * vec2(clusterDims.xy));\n"
+"    uint slice = uint(clamp(log(max(viewDepth, clusterNear) / clusterNear) / log(clusterFar / clusterNear), 0.0, 0.999) * float(clusterDims.z));\n"
+"    uvec2 cluster = clusterGrid[tile.x + tile.y * clusterDims.x + slice * clusterDims.x * clusterDims.y];\n"
+"    for (uint i = 0; i < cluster.y; i++) {\n"
+"        Light light = lights[clusterIndices[cluster.x + i]];\n"
+"        if (light.type == 1) {\n"
+"            result += calcPointLight(light, normal, viewDir);\n"
+"        } else {\n"
+"            result += calcSpotLight(light, normal, viewDir);\n"
+"        }\n"
+"    }\n"
 "    FragColor = vec4(result, 1.0);\n"
 "}\n";
 
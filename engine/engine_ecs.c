@@ -0,0 +1,399 @@
+#include "engine/engine_ecs.h"
+#include "engine/engine_profile.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define INITIAL_ARCHETYPE_CAPACITY 16
+#define INITIAL_ENTITY_CAPACITY 256
+#define INITIAL_QUERY_CAPACITY 8
+
+// ==============================
+// Archetypes
+// ==============================
+
+void BE_ArchetypeInit(BE_World* world, BE_Archetype* archetype, BE_ComponentMask mask) {
+    memset(archetype, 0, sizeof(BE_Archetype));
+    archetype->mask = mask;
+    memset(archetype->columns, -1, sizeof(archetype->columns));
+    memset(archetype->addEdges, 0xFF, sizeof(archetype->addEdges));
+    memset(archetype->removeEdges, 0xFF, sizeof(archetype->removeEdges));
+
+    size_t rowSize = sizeof(BE_Entity);
+    for (int component = 0; component < world->componentCount; component++) {
+        if (!(mask & BE_COMPONENT_BIT(component))) continue;
+        int column = archetype->columnCount++;
+        archetype->components[column] = component;
+        archetype->columns[component] = (int8_t)column;
+        archetype->sizes[column] = world->components[component].size;
+        rowSize += archetype->sizes[column];
+    }
+
+    // Leave room to align every column, a row that doesn't fit gets a chunk of its own
+    size_t padding = (size_t)(archetype->columnCount + 1) * ECS_COLUMN_ALIGN;
+    size_t capacity = ECS_CHUNK_SIZE > padding ? (ECS_CHUNK_SIZE - padding) / rowSize : 0;
+    archetype->chunkCapacity = capacity ? capacity : 1;
+
+    size_t offset = sizeof(BE_Entity) * archetype->chunkCapacity;
+    for (int column = 0; column < archetype->columnCount; column++) {
+        offset = (offset + ECS_COLUMN_ALIGN - 1) & ~(size_t)(ECS_COLUMN_ALIGN - 1);
+        archetype->offsets[column] = offset;
+        offset += archetype->sizes[column] * archetype->chunkCapacity;
+    }
+    archetype->chunkBytes = offset;
+}
+
+void BE_ArchetypeFree(BE_Archetype* archetype) {
+    for (size_t i = 0; i < archetype->chunkCount; i++) {
+        BE_AlignedFree(archetype->chunks[i].data);
+        BE_MemFree(archetype->chunks[i].versions);
+    }
+    BE_MemFree(archetype->chunks);
+    archetype->chunks = NULL;
+    archetype->chunkCount = 0;
+    archetype->chunksCapacity = 0;
+    archetype->entityCount = 0;
+}
+
+// Appends a zeroed row, the caller fills in the entity's record
+size_t BE_ArchetypeAddRow(BE_World* world, BE_Archetype* archetype, BE_Entity entity) {
+    size_t row = archetype->entityCount;
+    size_t chunkIndex = row / archetype->chunkCapacity;
+
+    if (chunkIndex >= archetype->chunkCount) {
+        if (archetype->chunkCount >= archetype->chunksCapacity) {
+            archetype->chunksCapacity = archetype->chunksCapacity ? archetype->chunksCapacity * 2 : 1;
+            archetype->chunks = (BE_EcsChunk*)BE_MemRealloc(archetype->chunks, sizeof(BE_EcsChunk) * archetype->chunksCapacity, BE_MEMORY_SCENE);
+        }
+        BE_EcsChunk* chunk = &archetype->chunks[archetype->chunkCount++];
+        chunk->data = (unsigned char*)BE_AlignedAlloc(archetype->chunkBytes, ECS_COLUMN_ALIGN, BE_MEMORY_SCENE);
+        chunk->count = 0;
+        chunk->versions = (uint32_t*)BE_MemCalloc(archetype->columnCount ? archetype->columnCount : 1, sizeof(uint32_t), BE_MEMORY_SCENE);
+    }
+
+    BE_EcsChunk* chunk = &archetype->chunks[chunkIndex];
+    chunk->count++;
+    archetype->entityCount++;
+
+    *BE_ArchetypeEntity(archetype, row) = entity;
+    uint32_t version = ++world->version;
+    for (int column = 0; column < archetype->columnCount; column++) {
+        memset(BE_ArchetypeCell(archetype, row, column), 0, archetype->sizes[column]);
+        chunk->versions[column] = version;
+    }
+    return row;
+}
+
+// Fills the hole with the archetype's last row so chunks stay packed
+void BE_ArchetypeRemoveRow(BE_World* world, BE_Archetype* archetype, size_t row) {
+    size_t last = archetype->entityCount - 1;
+    uint32_t version = ++world->version;
+
+    if (row != last) {
+        BE_Entity moved = *BE_ArchetypeEntity(archetype, last);
+        *BE_ArchetypeEntity(archetype, row) = moved;
+
+        BE_EcsChunk* chunk = &archetype->chunks[row / archetype->chunkCapacity];
+        for (int column = 0; column < archetype->columnCount; column++) {
+            memcpy(BE_ArchetypeCell(archetype, row, column), BE_ArchetypeCell(archetype, last, column), archetype->sizes[column]);
+            chunk->versions[column] = version;
+        }
+        world->records[moved & ECS_INDEX_MASK].row = (uint32_t)row;
+    }
+
+    archetype->chunks[last / archetype->chunkCapacity].count--;
+    archetype->entityCount--;
+}
+
+uint32_t BE_WorldFindArchetype(BE_World* world, BE_ComponentMask mask) {
+    for (size_t i = 0; i < world->archetypeCount; i++) {
+        if (world->archetypes[i].mask == mask) return (uint32_t)i;
+    }
+
+    if (world->archetypeCount >= world->archetypeCapacity) {
+        world->archetypeCapacity = world->archetypeCapacity ? world->archetypeCapacity * 2 : INITIAL_ARCHETYPE_CAPACITY;
+        world->archetypes = (BE_Archetype*)BE_MemRealloc(world->archetypes, sizeof(BE_Archetype) * world->archetypeCapacity, BE_MEMORY_SCENE);
+    }
+    BE_ArchetypeInit(world, &world->archetypes[world->archetypeCount], mask);
+    return (uint32_t)world->archetypeCount++;
+}
+
+// ==============================
+// World
+// ==============================
+
+void BE_WorldInit(BE_World* world) {
+    memset(world, 0, sizeof(BE_World));
+    world->version = 1;
+    BE_WorldFindArchetype(world, 0);
+}
+
+void BE_WorldFree(BE_World* world) {
+    for (size_t i = 0; i < world->archetypeCount; i++) {
+        BE_ArchetypeFree(&world->archetypes[i]);
+    }
+    BE_MemFree(world->archetypes);
+    BE_MemFree(world->records);
+    BE_MemFree(world->freeEntities);
+    memset(world, 0, sizeof(BE_World));
+}
+
+int BE_WorldRegisterComponent(BE_World* world, const char* name, size_t size, size_t align) {
+    if (world->componentCount >= ECS_MAX_COMPONENTS || align > ECS_COLUMN_ALIGN) return -1;
+
+    int component = world->componentCount++;
+    world->components[component].name = name;
+    world->components[component].size = size;
+    world->components[component].align = align ? align : 1;
+    return component;
+}
+
+BE_Entity BE_WorldCreate(BE_World* world, BE_ComponentMask mask) {
+    if (world->componentCount < ECS_MAX_COMPONENTS && (mask >> world->componentCount)) return BE_ENTITY_NONE;
+
+    uint32_t index;
+    if (world->freeCount > 0) {
+        index = world->freeEntities[--world->freeCount];
+    } else {
+        if (world->recordCount > ECS_INDEX_MASK) return BE_ENTITY_NONE;
+        if (world->recordCount >= world->recordCapacity) {
+            world->recordCapacity = world->recordCapacity ? world->recordCapacity * 2 : INITIAL_ENTITY_CAPACITY;
+            world->records = (BE_EntityRecord*)BE_MemRealloc(world->records, sizeof(BE_EntityRecord) * world->recordCapacity, BE_MEMORY_SCENE);
+            world->freeEntities = (uint32_t*)BE_MemRealloc(world->freeEntities, sizeof(uint32_t) * world->recordCapacity, BE_MEMORY_SCENE);
+        }
+        index = (uint32_t)world->recordCount++;
+        world->records[index].generation = 1;
+    }
+
+    BE_EntityRecord* record = &world->records[index];
+    BE_Entity entity = ((BE_Entity)record->generation << ECS_INDEX_BITS) | index;
+
+    record->archetype = BE_WorldFindArchetype(world, mask);
+    record->row = (uint32_t)BE_ArchetypeAddRow(world, &world->archetypes[record->archetype], entity);
+    world->entityCount++;
+    return entity;
+}
+
+bool BE_WorldAlive(BE_World* world, BE_Entity entity) {
+    uint32_t index = entity & ECS_INDEX_MASK;
+    if (index >= world->recordCount) return false;
+    BE_EntityRecord* record = &world->records[index];
+    return record->archetype != ECS_NO_ARCHETYPE && record->generation == entity >> ECS_INDEX_BITS;
+}
+
+void BE_WorldDestroy(BE_World* world, BE_Entity entity) {
+    if (!BE_WorldAlive(world, entity)) return;
+
+    uint32_t index = entity & ECS_INDEX_MASK;
+    BE_EntityRecord* record = &world->records[index];
+    BE_ArchetypeRemoveRow(world, &world->archetypes[record->archetype], record->row);
+
+    record->archetype = ECS_NO_ARCHETYPE;
+    uint16_t generation = (uint16_t)((record->generation + 1) & ECS_GENERATION_MASK);
+    record->generation = generation ? generation : 1;
+    world->freeEntities[world->freeCount++] = index;
+    world->entityCount--;
+}
+
+bool BE_WorldHas(BE_World* world, BE_Entity entity, int component) {
+    if (!BE_WorldAlive(world, entity) || component < 0 || component >= world->componentCount) return false;
+    return (world->archetypes[world->records[entity & ECS_INDEX_MASK].archetype].mask & BE_COMPONENT_BIT(component)) != 0;
+}
+
+size_t BE_WorldCount(BE_World* world) {
+    return world->entityCount;
+}
+
+const void* BE_WorldGet(BE_World* world, BE_Entity entity, int component) {
+    if (!BE_WorldHas(world, entity, component)) return NULL;
+    BE_EntityRecord* record = &world->records[entity & ECS_INDEX_MASK];
+    BE_Archetype* archetype = &world->archetypes[record->archetype];
+    return BE_ArchetypeCell(archetype, record->row, archetype->columns[component]);
+}
+
+void* BE_WorldWrite(BE_World* world, BE_Entity entity, int component) {
+    if (!BE_WorldHas(world, entity, component)) return NULL;
+    BE_EntityRecord* record = &world->records[entity & ECS_INDEX_MASK];
+    BE_Archetype* archetype = &world->archetypes[record->archetype];
+    int column = archetype->columns[component];
+    archetype->chunks[record->row / archetype->chunkCapacity].versions[column] = ++world->version;
+    return BE_ArchetypeCell(archetype, record->row, column);
+}
+
+// Copies the shared components into the target archetype, new ones start zeroed
+void BE_WorldMoveEntity(BE_World* world, BE_Entity entity, uint32_t target) {
+    BE_EntityRecord* record = &world->records[entity & ECS_INDEX_MASK];
+    if (record->archetype == target) return;
+
+    BE_Archetype* from = &world->archetypes[record->archetype];
+    BE_Archetype* to = &world->archetypes[target];
+    size_t row = BE_ArchetypeAddRow(world, to, entity);
+
+    for (int column = 0; column < to->columnCount; column++) {
+        int source = from->columns[to->components[column]];
+        if (source < 0) continue;
+        memcpy(BE_ArchetypeCell(to, row, column), BE_ArchetypeCell(from, record->row, source), to->sizes[column]);
+    }
+
+    BE_ArchetypeRemoveRow(world, from, record->row);
+    record->archetype = target;
+    record->row = (uint32_t)row;
+}
+
+void* BE_WorldAdd(BE_World* world, BE_Entity entity, int component) {
+    if (!BE_WorldAlive(world, entity) || component < 0 || component >= world->componentCount) return NULL;
+
+    uint32_t current = world->records[entity & ECS_INDEX_MASK].archetype;
+    if (!(world->archetypes[current].mask & BE_COMPONENT_BIT(component))) {
+        uint32_t target = world->archetypes[current].addEdges[component];
+        if (target == ECS_NO_ARCHETYPE) {
+            target = BE_WorldFindArchetype(world, world->archetypes[current].mask | BE_COMPONENT_BIT(component));
+            world->archetypes[current].addEdges[component] = target;
+            world->archetypes[target].removeEdges[component] = current;
+        }
+        BE_WorldMoveEntity(world, entity, target);
+    }
+    return BE_WorldWrite(world, entity, component);
+}
+
+void BE_WorldSet(BE_World* world, BE_Entity entity, int component, const void* value) {
+    void* data = BE_WorldAdd(world, entity, component);
+    if (data && value) memcpy(data, value, world->components[component].size);
+}
+
+void BE_WorldRemove(BE_World* world, BE_Entity entity, int component) {
+    if (!BE_WorldHas(world, entity, component)) return;
+
+    uint32_t current = world->records[entity & ECS_INDEX_MASK].archetype;
+    uint32_t target = world->archetypes[current].removeEdges[component];
+    if (target == ECS_NO_ARCHETYPE) {
+        target = BE_WorldFindArchetype(world, world->archetypes[current].mask & ~BE_COMPONENT_BIT(component));
+        world->archetypes[current].removeEdges[component] = target;
+        world->archetypes[target].addEdges[component] = current;
+    }
+    BE_WorldMoveEntity(world, entity, target);
+}
+
+// ==============================
+// Queries
+// ==============================
+
+void BE_EcsQueryInit(BE_EcsQuery* query, BE_ComponentMask all, BE_ComponentMask none) {
+    memset(query, 0, sizeof(BE_EcsQuery));
+    query->all = all;
+    query->none = none;
+}
+
+void BE_EcsQueryFree(BE_EcsQuery* query) {
+    BE_MemFree(query->archetypes);
+    BE_MemFree(query->views);
+    query->archetypes = NULL;
+    query->views = NULL;
+    query->count = query->capacity = query->viewCapacity = 0;
+    query->seen = 0;
+}
+
+void BE_EcsQueryRefresh(BE_World* world, BE_EcsQuery* query) {
+    for (; query->seen < world->archetypeCount; query->seen++) {
+        BE_ComponentMask mask = world->archetypes[query->seen].mask;
+        if ((mask & query->all) != query->all || (mask & query->none)) continue;
+
+        if (query->count >= query->capacity) {
+            query->capacity = query->capacity ? query->capacity * 2 : INITIAL_QUERY_CAPACITY;
+            query->archetypes = (uint32_t*)BE_MemRealloc(query->archetypes, sizeof(uint32_t) * query->capacity, BE_MEMORY_SCENE);
+        }
+        query->archetypes[query->count++] = (uint32_t)query->seen;
+    }
+}
+
+size_t BE_EcsQueryCount(BE_World* world, BE_EcsQuery* query) {
+    BE_EcsQueryRefresh(world, query);
+    size_t count = 0;
+    for (size_t i = 0; i < query->count; i++) {
+        count += world->archetypes[query->archetypes[i]].entityCount;
+    }
+    return count;
+}
+
+bool BE_EcsQueryAccept(BE_EcsQuery* query, BE_Archetype* archetype, BE_EcsChunk* chunk) {
+    if (chunk->count == 0) return false;
+    if (!query->changed) return true;
+
+    BE_ComponentMask changed = query->changed & archetype->mask;
+    for (int column = 0; column < archetype->columnCount; column++) {
+        if ((changed & BE_COMPONENT_BIT(archetype->components[column])) && chunk->versions[column] > query->lastRun) return true;
+    }
+    return false;
+}
+
+void BE_WorldEach(BE_World* world, BE_EcsQuery* query, BE_EcsSystem system, void* arg) {
+    BE_PROFILE_FUNCTION();
+    BE_EcsQueryRefresh(world, query);
+    uint32_t version = ++world->version;
+
+    for (size_t i = 0; i < query->count; i++) {
+        BE_Archetype* archetype = &world->archetypes[query->archetypes[i]];
+
+        for (size_t c = 0; c < archetype->chunkCount; c++) {
+            BE_EcsChunk* chunk = &archetype->chunks[c];
+            if (!BE_EcsQueryAccept(query, archetype, chunk)) continue;
+
+            for (int column = 0; column < archetype->columnCount; column++) {
+                if (query->write & BE_COMPONENT_BIT(archetype->components[column])) chunk->versions[column] = version;
+            }
+
+            BE_EcsView view = {world, archetype, chunk, chunk->count, (BE_Entity*)chunk->data};
+            system(&view, arg);
+        }
+    }
+    query->lastRun = version;
+}
+
+// Gathers the accepted chunks and marks their written columns, before any worker starts
+size_t BE_EcsQueryCollect(BE_World* world, BE_EcsQuery* query, uint32_t version) {
+    size_t count = 0;
+    for (size_t i = 0; i < query->count; i++) {
+        BE_Archetype* archetype = &world->archetypes[query->archetypes[i]];
+
+        for (size_t c = 0; c < archetype->chunkCount; c++) {
+            BE_EcsChunk* chunk = &archetype->chunks[c];
+            if (!BE_EcsQueryAccept(query, archetype, chunk)) continue;
+
+            for (int column = 0; column < archetype->columnCount; column++) {
+                if (query->write & BE_COMPONENT_BIT(archetype->components[column])) chunk->versions[column] = version;
+            }
+
+            if (count >= query->viewCapacity) {
+                query->viewCapacity = query->viewCapacity ? query->viewCapacity * 2 : INITIAL_QUERY_CAPACITY;
+                query->views = (BE_EcsView*)BE_MemRealloc(query->views, sizeof(BE_EcsView) * query->viewCapacity, BE_MEMORY_SCENE);
+            }
+            query->views[count++] = (BE_EcsView){world, archetype, chunk, chunk->count, (BE_Entity*)chunk->data};
+        }
+    }
+    return count;
+}
+
+typedef struct {
+    BE_EcsView* views;
+    BE_EcsSystem system;
+    void* arg;
+} BE_EcsEach;
+
+void BE_EcsEachJob(void* arg, size_t begin, size_t end) {
+    BE_EcsEach* each = (BE_EcsEach*)arg;
+    for (size_t i = begin; i < end; i++) {
+        each->system(&each->views[i], each->arg);
+    }
+}
+
+void BE_WorldEachParallel(BE_World* world, BE_EcsQuery* query, BE_Jobs* jobs, BE_EcsSystem system, void* arg) {
+    BE_PROFILE_FUNCTION();
+    BE_EcsQueryRefresh(world, query);
+    uint32_t version = ++world->version;
+
+    size_t count = BE_EcsQueryCollect(world, query, version);
+    BE_EcsEach each = {query->views, system, arg};
+    BE_JobsParallelFor(jobs, count, 1, BE_EcsEachJob, &each); // a chunk is already ECS_CHUNK_SIZE of work
+
+    query->lastRun = version;
+}
@@ -0,0 +1,183 @@
+#pragma once
+#ifndef ENGINE_ECS_H
+#define ENGINE_ECS_H
+
+#include <engine/engine_jobs.h>
+#include <engine/engine_memory.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==============================
+// Entities
+// ==============================
+
+// Archetype ECS. Entities with the same set of components share an archetype, which packs
+// them into fixed size chunks holding one array per component, so a system only streams the
+// columns it asks for. No GL here, the engine's own component types live in engine.h.
+
+#define ECS_MAX_COMPONENTS 64         // component sets are a 64 bit mask
+#define ECS_CHUNK_SIZE (64 * 1024)    // bytes per chunk, entity ids included
+#define ECS_COLUMN_ALIGN 64
+#define ECS_INDEX_BITS 22
+#define ECS_INDEX_MASK ((1u << ECS_INDEX_BITS) - 1)
+#define ECS_GENERATION_MASK ((1u << (32 - ECS_INDEX_BITS)) - 1)
+#define ECS_NO_ARCHETYPE UINT32_MAX
+
+// Index and generation like BE_Handle, destroyed entities stop resolving
+typedef uint32_t BE_Entity;
+typedef uint64_t BE_ComponentMask;
+
+#define BE_ENTITY_NONE 0
+#define BE_COMPONENT_BIT(component) ((BE_ComponentMask)1 << (component))
+
+typedef struct {
+    const char* name;
+    size_t size;               // 0 for tags
+    size_t align;
+} BE_ComponentInfo;
+
+typedef struct {
+    unsigned char* data;       // entity column, then one column per component
+    size_t count;
+    uint32_t* versions;        // per column, world version of the last write
+} BE_EcsChunk;
+
+typedef struct {
+    BE_ComponentMask mask;
+    int columnCount;
+    int components[ECS_MAX_COMPONENTS];     // column -> component id, ascending
+    int8_t columns[ECS_MAX_COMPONENTS];     // component id -> column, -1 if absent
+    size_t sizes[ECS_MAX_COMPONENTS];       // per column
+    size_t offsets[ECS_MAX_COMPONENTS];     // column start inside a chunk
+    size_t chunkCapacity;                   // entities per chunk
+    size_t chunkBytes;
+
+    BE_EcsChunk* chunks;       // full chunks first, empty ones are kept for reuse
+    size_t chunkCount;
+    size_t chunksCapacity;
+    size_t entityCount;
+
+    uint32_t addEdges[ECS_MAX_COMPONENTS];    // archetype with one more component, filled on first use
+    uint32_t removeEdges[ECS_MAX_COMPONENTS];
+} BE_Archetype;
+
+typedef struct {
+    uint32_t archetype;        // ECS_NO_ARCHETYPE while the index is free
+    uint32_t row;              // chunk is row / chunkCapacity
+    uint16_t generation;
+} BE_EntityRecord;
+
+typedef struct {
+    BE_ComponentInfo components[ECS_MAX_COMPONENTS];
+    int componentCount;
+
+    BE_Archetype* archetypes;  // 0 is the empty archetype, never removed so indices stay valid
+    size_t archetypeCount;
+    size_t archetypeCapacity;
+
+    BE_EntityRecord* records;
+    size_t recordCount;
+    size_t recordCapacity;
+    uint32_t* freeEntities;
+    size_t freeCount;
+    size_t entityCount;
+
+    uint32_t version;          // bumped by every write
+} BE_World;
+
+// Matching archetypes are cached, only archetypes created since the last run are tested
+typedef struct {
+    BE_ComponentMask all;      // required
+    BE_ComponentMask none;     // excluded
+    BE_ComponentMask write;    // columns the system writes, visited chunks are marked changed
+    BE_ComponentMask changed;  // if not 0, skip chunks where none of these changed since the last run
+
+    uint32_t* archetypes;
+    size_t count;
+    size_t capacity;
+    size_t seen;               // world archetypes already tested
+    uint32_t lastRun;          // world version of the previous run
+
+    struct BE_EcsView* views;  // parallel runs hand chunks to workers from here
+    size_t viewCapacity;
+} BE_EcsQuery;
+
+// One chunk of a query's result
+typedef struct BE_EcsView {
+    BE_World* world;
+    BE_Archetype* archetype;
+    BE_EcsChunk* chunk;
+    size_t count;
+    BE_Entity* entities;
+} BE_EcsView;
+
+typedef void (*BE_EcsSystem)(BE_EcsView* view, void* arg);
+
+static inline void* BE_EcsViewColumn(BE_EcsView* view, int component) {
+    int column = view->archetype->columns[component];
+    return column >= 0 ? view->chunk->data + view->archetype->offsets[column] : NULL;
+}
+
+#define BE_ECS_COLUMN(view, type, component) ((type*)BE_EcsViewColumn(view, component))
+
+void BE_WorldInit(BE_World* world);
+void BE_WorldFree(BE_World* world);
+
+/**
+ * @brief Adds a component type to the world
+ * @return The component id. -1 once ECS_MAX_COMPONENTS are registered or if align is over ECS_COLUMN_ALIGN.
+ */
+int BE_WorldRegisterComponent(BE_World* world, const char* name, size_t size, size_t align);
+
+BE_Entity BE_WorldCreate(BE_World* world, BE_ComponentMask mask); // components start zeroed
+void BE_WorldDestroy(BE_World* world, BE_Entity entity);
+bool BE_WorldAlive(BE_World* world, BE_Entity entity);
+bool BE_WorldHas(BE_World* world, BE_Entity entity, int component);
+size_t BE_WorldCount(BE_World* world); // live entities
+
+// Pointers stay valid until the next structural change (create, destroy, add, remove)
+const void* BE_WorldGet(BE_World* world, BE_Entity entity, int component); // NULL if missing
+void* BE_WorldWrite(BE_World* world, BE_Entity entity, int component);     // marks the column changed
+void* BE_WorldAdd(BE_World* world, BE_Entity entity, int component);       // zeroed if it was missing
+void BE_WorldSet(BE_World* world, BE_Entity entity, int component, const void* value);
+void BE_WorldRemove(BE_World* world, BE_Entity entity, int component);
+
+void BE_EcsQueryInit(BE_EcsQuery* query, BE_ComponentMask all, BE_ComponentMask none);
+void BE_EcsQueryFree(BE_EcsQuery* query);
+void BE_EcsQueryRefresh(BE_World* world, BE_EcsQuery* query);
+size_t BE_EcsQueryCount(BE_World* world, BE_EcsQuery* query);
+
+/**
+ * @brief Calls system once per non-empty chunk matching query
+ * @note Systems must not create, destroy, add or remove components while the query runs.
+ */
+void BE_WorldEach(BE_World* world, BE_EcsQuery* query, BE_EcsSystem system, void* arg);
+
+/**
+ * @brief Like BE_WorldEach, with chunks spread over the job system's workers
+ * @note Runs serially when jobs is NULL. Systems only touch the chunk they are given.
+ */
+void BE_WorldEachParallel(BE_World* world, BE_EcsQuery* query, BE_Jobs* jobs, BE_EcsSystem system, void* arg);
+
+uint32_t BE_WorldFindArchetype(BE_World* world, BE_ComponentMask mask);
+void BE_ArchetypeInit(BE_World* world, BE_Archetype* archetype, BE_ComponentMask mask);
+void BE_ArchetypeFree(BE_Archetype* archetype);
+size_t BE_ArchetypeAddRow(BE_World* world, BE_Archetype* archetype, BE_Entity entity);
+void BE_ArchetypeRemoveRow(BE_World* world, BE_Archetype* archetype, size_t row);
+void BE_WorldMoveEntity(BE_World* world, BE_Entity entity, uint32_t archetype);
+bool BE_EcsQueryAccept(BE_EcsQuery* query, BE_Archetype* archetype, BE_EcsChunk* chunk);
+size_t BE_EcsQueryCollect(BE_World* world, BE_EcsQuery* query, uint32_t version);
+void BE_EcsEachJob(void* arg, size_t begin, size_t end);
+
+static inline void* BE_ArchetypeCell(BE_Archetype* archetype, size_t row, int column) {
+    BE_EcsChunk* chunk = &archetype->chunks[row / archetype->chunkCapacity];
+    return chunk->data + archetype->offsets[column] + (row % archetype->chunkCapacity) * archetype->sizes[column];
+}
+
+static inline BE_Entity* BE_ArchetypeEntity(BE_Archetype* archetype, size_t row) {
+    BE_EcsChunk* chunk = &archetype->chunks[row / archetype->chunkCapacity];
+    return (BE_Entity*)chunk->data + row % archetype->chunkCapacity;
+}
+
+#endif
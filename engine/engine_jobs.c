@@ -0,0 +1,438 @@
+#include "engine/engine_jobs.h"
+#include "engine/engine_memory.h"
+#include "engine/engine_profile.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// ==============================
+// Threads
+// ==============================
+
+#ifdef _WIN32
+
+DWORD WINAPI BE_ThreadEntry(LPVOID arg) {
+    BE_Thread* thread = (BE_Thread*)arg;
+    thread->function(thread->arg);
+    return 0;
+}
+
+bool BE_ThreadCreate(BE_Thread* thread, void (*function)(void*), void* arg) {
+    thread->function = function;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, BE_ThreadEntry, thread, 0, NULL);
+    return thread->handle != NULL;
+}
+
+void BE_ThreadJoin(BE_Thread* thread) {
+    WaitForSingleObject((HANDLE)thread->handle, INFINITE);
+    CloseHandle((HANDLE)thread->handle);
+    thread->handle = NULL;
+}
+
+void BE_ThreadYield() { SwitchToThread(); }
+
+int BE_ThreadHardwareCount() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return (int)info.dwNumberOfProcessors;
+}
+
+uint64_t BE_ThreadClockNs() {
+    static LARGE_INTEGER frequency;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    uint64_t seconds = (uint64_t)(counter.QuadPart / frequency.QuadPart);
+    uint64_t rest = (uint64_t)(counter.QuadPart % frequency.QuadPart);
+    return seconds * 1000000000ull + rest * 1000000000ull / (uint64_t)frequency.QuadPart;
+}
+
+void BE_MutexInit(BE_Mutex* mutex) { InitializeSRWLock((PSRWLOCK)&mutex->lock); }
+void BE_MutexLock(BE_Mutex* mutex) { AcquireSRWLockExclusive((PSRWLOCK)&mutex->lock); }
+void BE_MutexUnlock(BE_Mutex* mutex) { ReleaseSRWLockExclusive((PSRWLOCK)&mutex->lock); }
+void BE_MutexFree(BE_Mutex* mutex) { (void)mutex; }
+
+void BE_CondInit(BE_Cond* cond) { InitializeConditionVariable((PCONDITION_VARIABLE)&cond->cond); }
+void BE_CondWait(BE_Cond* cond, BE_Mutex* mutex) { SleepConditionVariableSRW((PCONDITION_VARIABLE)&cond->cond, (PSRWLOCK)&mutex->lock, INFINITE, 0); }
+void BE_CondBroadcast(BE_Cond* cond) { WakeAllConditionVariable((PCONDITION_VARIABLE)&cond->cond); }
+void BE_CondFree(BE_Cond* cond) { (void)cond; }
+
+#else
+
+void* BE_ThreadEntry(void* arg) {
+    BE_Thread* thread = (BE_Thread*)arg;
+    thread->function(thread->arg);
+    return NULL;
+}
+
+bool BE_ThreadCreate(BE_Thread* thread, void (*function)(void*), void* arg) {
+    thread->function = function;
+    thread->arg = arg;
+    return pthread_create(&thread->handle, NULL, BE_ThreadEntry, thread) == 0;
+}
+
+void BE_ThreadJoin(BE_Thread* thread) {
+    pthread_join(thread->handle, NULL);
+}
+
+void BE_ThreadYield() { sched_yield(); }
+
+int BE_ThreadHardwareCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+uint64_t BE_ThreadClockNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void BE_MutexInit(BE_Mutex* mutex) { pthread_mutex_init(&mutex->lock, NULL); }
+void BE_MutexLock(BE_Mutex* mutex) { pthread_mutex_lock(&mutex->lock); }
+void BE_MutexUnlock(BE_Mutex* mutex) { pthread_mutex_unlock(&mutex->lock); }
+void BE_MutexFree(BE_Mutex* mutex) { pthread_mutex_destroy(&mutex->lock); }
+
+void BE_CondInit(BE_Cond* cond) { pthread_cond_init(&cond->cond, NULL); }
+void BE_CondWait(BE_Cond* cond, BE_Mutex* mutex) { pthread_cond_wait(&cond->cond, &mutex->lock); }
+void BE_CondBroadcast(BE_Cond* cond) { pthread_cond_broadcast(&cond->cond); }
+void BE_CondFree(BE_Cond* cond) { pthread_cond_destroy(&cond->cond); }
+
+#endif
+
+// ==============================
+// Job Deque
+// ==============================
+
+// Chase-Lev deque with C11 atomics (Le et al. 2013). A thief copies the slot before its CAS on
+// top; the owner only rewrites that slot after top moved past it, so a torn copy always loses the CAS.
+
+bool BE_JobDequePush(BE_JobDeque* deque, BE_Job* job) {
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed);
+    long long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    if (b - t >= JOBS_DEQUE_SIZE) return false;
+
+    deque->jobs[b & (JOBS_DEQUE_SIZE - 1)] = *job;
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return true;
+}
+
+bool BE_JobDequePop(BE_JobDeque* deque, BE_Job* job) {
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_relaxed) - 1;
+    atomic_store_explicit(&deque->bottom, b, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long t = atomic_load_explicit(&deque->top, memory_order_relaxed);
+
+    if (t > b) {
+        atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+        return false;
+    }
+
+    *job = deque->jobs[b & (JOBS_DEQUE_SIZE - 1)];
+    if (t < b) return true;
+
+    // Last job, race the thieves for it
+    bool won = atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+    atomic_store_explicit(&deque->bottom, b + 1, memory_order_relaxed);
+    return won;
+}
+
+bool BE_JobDequeSteal(BE_JobDeque* deque, BE_Job* job) {
+    long long t = atomic_load_explicit(&deque->top, memory_order_acquire);
+    atomic_thread_fence(memory_order_seq_cst);
+    long long b = atomic_load_explicit(&deque->bottom, memory_order_acquire);
+    if (t >= b) return false;
+
+    BE_Job copy = deque->jobs[t & (JOBS_DEQUE_SIZE - 1)];
+    if (!atomic_compare_exchange_strong_explicit(&deque->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed)) return false;
+
+    *job = copy;
+    return true;
+}
+
+// ==============================
+// Jobs
+// ==============================
+
+BE_THREAD_LOCAL BE_JobWorker* g_jobWorker = NULL;
+BE_THREAD_LOCAL int g_jobDepth = 0; // jobs run from inside a job are already in the busy time
+
+BE_JobWorker* BE_JobsSelf(BE_Jobs* jobs) {
+    return g_jobWorker && g_jobWorker->jobs == jobs ? g_jobWorker : NULL;
+}
+
+bool BE_JobsInit(BE_Jobs* jobs, int workerCount) {
+    if (workerCount <= 0) workerCount = BE_ThreadHardwareCount();
+    if (workerCount > JOBS_MAX_WORKERS) workerCount = JOBS_MAX_WORKERS;
+    if (workerCount < 1) workerCount = 1;
+
+    jobs->workers = (BE_JobWorker*)BE_MemCalloc((size_t)workerCount, sizeof(BE_JobWorker), BE_MEMORY_GENERAL);
+    if (!jobs->workers) return false;
+
+    jobs->workerCount = workerCount;
+    BE_MutexInit(&jobs->mutex);
+    BE_CondInit(&jobs->cond);
+    atomic_init(&jobs->sleeping, 0);
+    atomic_init(&jobs->queued, 0);
+    atomic_init(&jobs->quit, false);
+    jobs->queueHead = 0;
+    atomic_init(&jobs->queueCount, 0);
+    jobs->statsStart = BE_ThreadClockNs();
+
+    for (int i = 0; i < workerCount; i++) {
+        BE_JobWorker* worker = &jobs->workers[i];
+        atomic_init(&worker->deque.top, 0);
+        atomic_init(&worker->deque.bottom, 0);
+        worker->jobs = jobs;
+        worker->index = i;
+        worker->seed = 0x9E3779B9u * (uint32_t)(i + 1);
+        atomic_init(&worker->executed, 0);
+        atomic_init(&worker->stolen, 0);
+        atomic_init(&worker->busyNs, 0);
+    }
+
+    g_jobWorker = &jobs->workers[0];
+
+    for (int i = 1; i < workerCount; i++) {
+        if (!BE_ThreadCreate(&jobs->workers[i].thread, BE_JobsWorkerMain, &jobs->workers[i])) {
+            // Keep the workers that did start
+            fprintf(stderr, "[Jobs] Failed to start worker %d, running with %d\n", i, i);
+            jobs->workerCount = i;
+            break;
+        }
+    }
+
+    return true;
+}
+
+void BE_JobsFree(BE_Jobs* jobs) {
+    BE_MutexLock(&jobs->mutex);
+    atomic_store(&jobs->quit, true);
+    BE_CondBroadcast(&jobs->cond);
+    BE_MutexUnlock(&jobs->mutex);
+
+    for (int i = 1; i < jobs->workerCount; i++) {
+        BE_ThreadJoin(&jobs->workers[i].thread);
+    }
+
+    if (g_jobWorker && g_jobWorker->jobs == jobs) g_jobWorker = NULL;
+
+    BE_CondFree(&jobs->cond);
+    BE_MutexFree(&jobs->mutex);
+    BE_MemFree(jobs->workers);
+    jobs->workers = NULL;
+    jobs->workerCount = 0;
+}
+
+void BE_JobsSubmit(BE_Jobs* jobs, BE_Job job) {
+    if (job.counter) atomic_fetch_add(&job.counter->pending, 1);
+
+    BE_JobWorker* self = BE_JobsSelf(jobs);
+    atomic_fetch_add(&jobs->queued, 1);
+
+    bool pushed = false;
+    if (self) {
+        pushed = BE_JobDequePush(&self->deque, &job);
+    } else {
+        BE_MutexLock(&jobs->mutex);
+        int count = atomic_load_explicit(&jobs->queueCount, memory_order_relaxed);
+        if (count < JOBS_QUEUE_SIZE) {
+            jobs->queue[(jobs->queueHead + (size_t)count) % JOBS_QUEUE_SIZE] = job;
+            atomic_store_explicit(&jobs->queueCount, count + 1, memory_order_relaxed);
+            pushed = true;
+        }
+        BE_MutexUnlock(&jobs->mutex);
+    }
+
+    if (!pushed) {
+        // Full, running it here keeps the queues bounded
+        atomic_fetch_sub(&jobs->queued, 1);
+        BE_JobsExecute(jobs, self, job, false);
+        return;
+    }
+
+    if (atomic_load(&jobs->sleeping) > 0) {
+        BE_MutexLock(&jobs->mutex);
+        BE_CondBroadcast(&jobs->cond);
+        BE_MutexUnlock(&jobs->mutex);
+    }
+}
+
+bool BE_JobsFind(BE_Jobs* jobs, BE_JobWorker* self, BE_Job* job, bool* stolen) {
+    *stolen = false;
+
+    if (self && BE_JobDequePop(&self->deque, job)) goto found;
+
+    if (atomic_load_explicit(&jobs->queueCount, memory_order_relaxed) > 0) {
+        bool taken = false;
+        BE_MutexLock(&jobs->mutex);
+        int count = atomic_load_explicit(&jobs->queueCount, memory_order_relaxed);
+        if (count > 0) {
+            *job = jobs->queue[jobs->queueHead];
+            jobs->queueHead = (jobs->queueHead + 1) % JOBS_QUEUE_SIZE;
+            atomic_store_explicit(&jobs->queueCount, count - 1, memory_order_relaxed);
+            taken = true;
+        }
+        BE_MutexUnlock(&jobs->mutex);
+        if (taken) goto found;
+    }
+
+    // Start at a random victim so thieves spread out
+    int start = 0;
+    if (self) {
+        self->seed ^= self->seed << 13;
+        self->seed ^= self->seed >> 17;
+        self->seed ^= self->seed << 5;
+        start = (int)(self->seed % (uint32_t)jobs->workerCount);
+    }
+    for (int i = 0; i < jobs->workerCount; i++) {
+        BE_JobWorker* victim = &jobs->workers[(start + i) % jobs->workerCount];
+        if (victim == self) continue;
+        if (BE_JobDequeSteal(&victim->deque, job)) {
+            *stolen = true;
+            goto found;
+        }
+    }
+    return false;
+
+found:
+    atomic_fetch_sub(&jobs->queued, 1);
+    return true;
+}
+
+void BE_JobsExecute(BE_Jobs* jobs, BE_JobWorker* self, BE_Job job, bool stolen) {
+    bool timed = self && g_jobDepth++ == 0;
+    uint64_t start = timed ? BE_ThreadClockNs() : 0;
+
+    // Hand off the upper halves so thieves take large pieces and split them further
+    while (job.grain && job.end - job.begin > job.grain) {
+        size_t pieces = (job.end - job.begin + job.grain - 1) / job.grain;
+        BE_Job upper = job;
+        upper.begin = job.begin + (pieces / 2) * job.grain;
+        job.end = upper.begin;
+        BE_JobsSubmit(jobs, upper);
+    }
+
+    job.function(job.arg, job.begin, job.end);
+
+    if (timed) atomic_fetch_add_explicit(&self->busyNs, BE_ThreadClockNs() - start, memory_order_relaxed);
+    if (self) g_jobDepth--;
+
+    if (self) {
+        atomic_fetch_add_explicit(&self->executed, 1, memory_order_relaxed);
+        if (stolen) atomic_fetch_add_explicit(&self->stolen, 1, memory_order_relaxed);
+    }
+
+    if (job.counter) atomic_fetch_sub_explicit(&job.counter->pending, 1, memory_order_release);
+}
+
+void BE_JobsWorkerMain(void* arg) {
+    BE_JobWorker* self = (BE_JobWorker*)arg;
+    BE_Jobs* jobs = self->jobs;
+    g_jobWorker = self;
+
+    char name[PROFILE_THREAD_NAME];
+    snprintf(name, sizeof(name), "worker %d", self->index);
+    BE_PROFILE_THREAD(name);
+
+    int spins = 0;
+    while (!atomic_load(&jobs->quit)) {
+        BE_Job job;
+        bool stolen;
+        if (BE_JobsFind(jobs, self, &job, &stolen)) {
+            BE_JobsExecute(jobs, self, job, stolen);
+            spins = 0;
+            continue;
+        }
+
+        if (++spins < JOBS_SPIN_COUNT) {
+            BE_ThreadYield();
+            continue;
+        }
+        spins = 0;
+
+        // Submitters read sleeping after bumping queued, so one of the two sides sees the other
+        BE_MutexLock(&jobs->mutex);
+        atomic_fetch_add(&jobs->sleeping, 1);
+        while (atomic_load(&jobs->queued) <= 0 && !atomic_load(&jobs->quit)) BE_CondWait(&jobs->cond, &jobs->mutex);
+        atomic_fetch_sub(&jobs->sleeping, 1);
+        BE_MutexUnlock(&jobs->mutex);
+    }
+
+    g_jobWorker = NULL;
+}
+
+// Runs other jobs until the counter drains, so waiting inside a job cannot deadlock the pool
+void BE_JobsWait(BE_Jobs* jobs, BE_JobCounter* counter) {
+    BE_JobWorker* self = BE_JobsSelf(jobs);
+
+    while (atomic_load_explicit(&counter->pending, memory_order_acquire) > 0) {
+        BE_Job job;
+        bool stolen;
+        if (BE_JobsFind(jobs, self, &job, &stolen)) BE_JobsExecute(jobs, self, job, stolen);
+        else BE_ThreadYield();
+    }
+}
+
+void BE_JobsParallelFor(BE_Jobs* jobs, size_t count, size_t grain, BE_JobFunction function, void* arg) {
+    if (count == 0) return;
+    if (grain == 0) grain = 1;
+
+    if (!jobs) {
+        function(arg, 0, count);
+        return;
+    }
+
+    // Inline as one unsplit job, still timed and counted when the caller is a worker
+    if (jobs->workerCount <= 1 || count <= grain) {
+        BE_JobsExecute(jobs, BE_JobsSelf(jobs), (BE_Job){function, arg, 0, count, 0, NULL}, false);
+        return;
+    }
+
+    BE_JobCounter counter;
+    atomic_init(&counter.pending, 1);
+
+    BE_Job job = {function, arg, 0, count, grain, &counter};
+    BE_JobsExecute(jobs, BE_JobsSelf(jobs), job, false);
+    BE_JobsWait(jobs, &counter);
+}
+
+int BE_JobsWorkerIndex(BE_Jobs* jobs) {
+    BE_JobWorker* self = BE_JobsSelf(jobs);
+    return self ? self->index : -1;
+}
+
+void BE_JobsGetStats(BE_Jobs* jobs, int worker, BE_JobStats* stats) {
+    memset(stats, 0, sizeof(BE_JobStats));
+    if (worker < 0 || worker >= jobs->workerCount) return;
+
+    BE_JobWorker* w = &jobs->workers[worker];
+    stats->executed = atomic_load_explicit(&w->executed, memory_order_relaxed);
+    stats->stolen = atomic_load_explicit(&w->stolen, memory_order_relaxed);
+    stats->busyNs = atomic_load_explicit(&w->busyNs, memory_order_relaxed);
+
+    uint64_t wall = BE_ThreadClockNs() - jobs->statsStart;
+    stats->utilization = wall ? (float)((double)stats->busyNs / (double)wall) : 0.0f;
+}
+
+void BE_JobsResetStats(BE_Jobs* jobs) {
+    for (int i = 0; i < jobs->workerCount; i++) {
+        atomic_store_explicit(&jobs->workers[i].executed, 0, memory_order_relaxed);
+        atomic_store_explicit(&jobs->workers[i].stolen, 0, memory_order_relaxed);
+        atomic_store_explicit(&jobs->workers[i].busyNs, 0, memory_order_relaxed);
+    }
+    jobs->statsStart = BE_ThreadClockNs();
+}
@@ -0,0 +1,153 @@
+#pragma once
+#ifndef ENGINE_JOBS_H
+#define ENGINE_JOBS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+// ==============================
+// Threads
+// ==============================
+
+// Thin wrappers over Win32 and pthreads. No GL or GLFW here, so tools and benchmarks
+// can link this module on its own.
+
+#ifdef _WIN32
+typedef struct { void* handle; void (*function)(void*); void* arg; } BE_Thread;
+typedef struct { void* lock; } BE_Mutex; // SRWLOCK
+typedef struct { void* cond; } BE_Cond;  // CONDITION_VARIABLE
+#else
+#include <pthread.h>
+typedef struct { pthread_t handle; void (*function)(void*); void* arg; } BE_Thread;
+typedef struct { pthread_mutex_t lock; } BE_Mutex;
+typedef struct { pthread_cond_t cond; } BE_Cond;
+#endif
+
+#if defined(_MSC_VER)
+#define BE_THREAD_LOCAL __declspec(thread)
+#else
+#define BE_THREAD_LOCAL __thread
+#endif
+
+bool BE_ThreadCreate(BE_Thread* thread, void (*function)(void*), void* arg);
+void BE_ThreadJoin(BE_Thread* thread);
+void BE_ThreadYield();
+int BE_ThreadHardwareCount();
+uint64_t BE_ThreadClockNs(); // monotonic
+void BE_MutexInit(BE_Mutex* mutex);
+void BE_MutexLock(BE_Mutex* mutex);
+void BE_MutexUnlock(BE_Mutex* mutex);
+void BE_MutexFree(BE_Mutex* mutex);
+void BE_CondInit(BE_Cond* cond);
+void BE_CondWait(BE_Cond* cond, BE_Mutex* mutex);
+void BE_CondBroadcast(BE_Cond* cond);
+void BE_CondFree(BE_Cond* cond);
+
+// ==============================
+// Jobs
+// ==============================
+
+// Fixed pool of workers with one Chase-Lev deque each. A worker pushes and pops at the bottom of
+// its own deque, idle workers steal from the top of others. Worker 0 is the thread that called
+// BE_JobsInit, it runs jobs while waiting on a counter. Threads outside the pool submit through
+// a locked queue and help the same way.
+
+#define JOBS_MAX_WORKERS 64
+#define JOBS_DEQUE_SIZE 4096  // power of two, a full deque runs new jobs inline
+#define JOBS_QUEUE_SIZE 1024  // shared queue for threads outside the pool
+#define JOBS_SPIN_COUNT 64    // failed searches before a worker sleeps
+
+// Runs [begin, end) of the range the job was submitted with
+typedef void (*BE_JobFunction)(void* arg, size_t begin, size_t end);
+
+// Counts unfinished jobs, zero once everything submitted with it has run
+typedef struct {
+    atomic_int pending;
+} BE_JobCounter;
+
+typedef struct {
+    BE_JobFunction function;
+    void* arg;
+    size_t begin, end;
+    size_t grain;           // 0 runs the range as one piece, otherwise halves are split off until it fits
+    BE_JobCounter* counter; // may be NULL
+} BE_Job;
+
+typedef struct {
+    atomic_llong top;
+    char pad0[64 - sizeof(atomic_llong)]; // thieves and the owner write different lines
+    atomic_llong bottom;
+    char pad1[64 - sizeof(atomic_llong)];
+    BE_Job jobs[JOBS_DEQUE_SIZE];
+} BE_JobDeque;
+
+typedef struct BE_Jobs BE_Jobs;
+
+typedef struct {
+    BE_JobDeque deque;
+    BE_Thread thread;
+    BE_Jobs* jobs;
+    int index;
+    uint32_t seed;          // victim selection
+
+    atomic_ullong executed;
+    atomic_ullong stolen;
+    atomic_ullong busyNs;
+} BE_JobWorker;
+
+typedef struct {
+    uint64_t executed;      // jobs run by this worker
+    uint64_t stolen;        // of those, taken from another worker
+    uint64_t busyNs;
+    float utilization;      // busy time over wall time since the last reset
+} BE_JobStats;
+
+struct BE_Jobs {
+    BE_JobWorker* workers;
+    int workerCount;
+
+    BE_Mutex mutex;
+    BE_Cond cond;
+    atomic_int sleeping;
+    atomic_int queued;      // jobs in any deque or the shared queue
+    atomic_bool quit;
+
+    BE_Job queue[JOBS_QUEUE_SIZE];
+    size_t queueHead;
+    atomic_int queueCount;
+
+    uint64_t statsStart;
+};
+
+/**
+ * @brief Starts the worker threads
+ * @param workerCount Workers including the calling thread. 0 uses one per hardware thread.
+ */
+bool BE_JobsInit(BE_Jobs* jobs, int workerCount);
+void BE_JobsFree(BE_Jobs* jobs);
+
+void BE_JobsSubmit(BE_Jobs* jobs, BE_Job job);
+void BE_JobsWait(BE_Jobs* jobs, BE_JobCounter* counter);
+
+/**
+ * @brief Runs function over [0, count) split into pieces of at most grain, returns when all are done
+ * @note Pieces start at multiples of grain. Runs inline when jobs is NULL or count fits in one piece.
+ */
+void BE_JobsParallelFor(BE_Jobs* jobs, size_t count, size_t grain, BE_JobFunction function, void* arg);
+
+int BE_JobsWorkerIndex(BE_Jobs* jobs); // -1 outside the pool
+void BE_JobsGetStats(BE_Jobs* jobs, int worker, BE_JobStats* stats);
+void BE_JobsResetStats(BE_Jobs* jobs);
+
+bool BE_JobDequePush(BE_JobDeque* deque, BE_Job* job);
+bool BE_JobDequePop(BE_JobDeque* deque, BE_Job* job);
+bool BE_JobDequeSteal(BE_JobDeque* deque, BE_Job* job);
+
+BE_JobWorker* BE_JobsSelf(BE_Jobs* jobs);
+void BE_JobsWorkerMain(void* arg);
+bool BE_JobsFind(BE_Jobs* jobs, BE_JobWorker* self, BE_Job* job, bool* stolen);
+void BE_JobsExecute(BE_Jobs* jobs, BE_JobWorker* self, BE_Job job, bool stolen);
+
+#endif
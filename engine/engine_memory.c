@@ -0,0 +1,427 @@
+#include "engine/engine_memory.h"
+
+#include "engine/engine_jobs.h"
+
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+
+// ==============================
+// Tracking
+// ==============================
+
+#define MEMORY_HEADER 16         // keeps malloc's alignment for the caller
+#define MEMORY_MAGIC 0xBE3E0000u
+
+typedef struct {
+    size_t size;
+    uint32_t tag;                // MEMORY_MAGIC | tag
+} BE_MemoryHeader;
+
+typedef struct {
+    atomic_size_t live;
+    atomic_size_t peak;
+    atomic_uint_fast64_t allocations;
+    atomic_size_t gpuLive;
+    atomic_size_t gpuPeak;
+} BE_MemoryCounters;
+
+static BE_MemoryCounters memoryCounters[BE_MEMORY_TAG_COUNT];
+static atomic_size_t memoryLive;
+static atomic_size_t memoryPeak;
+static atomic_uint_fast64_t memoryAllocations;
+static atomic_uint_fast64_t memoryBytes;
+
+static const char* memoryTagNames[BE_MEMORY_TAG_COUNT] = {
+    "general", "mesh", "texture", "shader", "audio", "scene", "render", "loader", "arena", "ui"
+};
+
+static void BE_MemoryRaisePeak(atomic_size_t* peak, size_t value) {
+    size_t current = atomic_load_explicit(peak, memory_order_relaxed);
+    while (value > current && !atomic_compare_exchange_weak_explicit(peak, &current, value, memory_order_relaxed, memory_order_relaxed));
+}
+
+static void BE_MemoryCount(BE_MemoryTag tag, size_t added, size_t removed) {
+    BE_MemoryCounters* counters = &memoryCounters[tag];
+    atomic_fetch_add_explicit(&counters->allocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&memoryAllocations, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&memoryBytes, added, memory_order_relaxed);
+
+    size_t live = atomic_fetch_add_explicit(&counters->live, added - removed, memory_order_relaxed) + added - removed;
+    BE_MemoryRaisePeak(&counters->peak, live);
+    size_t total = atomic_fetch_add_explicit(&memoryLive, added - removed, memory_order_relaxed) + added - removed;
+    BE_MemoryRaisePeak(&memoryPeak, total);
+}
+
+static BE_MemoryHeader* BE_MemoryHeaderOf(void* ptr) {
+    BE_MemoryHeader* header = (BE_MemoryHeader*)((unsigned char*)ptr - MEMORY_HEADER);
+    if ((header->tag & 0xFFFF0000u) != MEMORY_MAGIC) {
+        fprintf(stderr, "BE_Mem: %p was not allocated by BE_MemAlloc or was already freed\n", ptr);
+        abort();
+    }
+    return header;
+}
+
+void* BE_MemAlloc(size_t size, BE_MemoryTag tag) {
+    BE_MemoryHeader* header = (BE_MemoryHeader*)malloc(MEMORY_HEADER + size);
+    if (!header) return NULL;
+    header->size = size;
+    header->tag = MEMORY_MAGIC | (uint32_t)tag;
+    BE_MemoryCount(tag, size, 0);
+    return (unsigned char*)header + MEMORY_HEADER;
+}
+
+void* BE_MemCalloc(size_t count, size_t size, BE_MemoryTag tag) {
+    if (size && count > SIZE_MAX / size) return NULL;
+    void* ptr = BE_MemAlloc(count * size, tag);
+    if (ptr) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void* BE_MemRealloc(void* ptr, size_t size, BE_MemoryTag tag) {
+    if (!ptr) return BE_MemAlloc(size, tag);
+
+    BE_MemoryHeader* header = BE_MemoryHeaderOf(ptr);
+    size_t previous = header->size;
+    tag = (BE_MemoryTag)(header->tag & 0xFFFFu);
+
+    header = (BE_MemoryHeader*)realloc(header, MEMORY_HEADER + size);
+    if (!header) return NULL;
+    header->size = size;
+    BE_MemoryCount(tag, size, previous);
+    return (unsigned char*)header + MEMORY_HEADER;
+}
+
+char* BE_MemStrdup(const char* str, BE_MemoryTag tag) {
+    if (!str) return NULL;
+    size_t size = strlen(str) + 1;
+    char* copy = (char*)BE_MemAlloc(size, tag);
+    if (copy) memcpy(copy, str, size);
+    return copy;
+}
+
+void BE_MemFree(void* ptr) {
+    if (!ptr) return;
+    BE_MemoryHeader* header = BE_MemoryHeaderOf(ptr);
+    BE_MemoryTag tag = (BE_MemoryTag)(header->tag & 0xFFFFu);
+    atomic_fetch_sub_explicit(&memoryCounters[tag].live, header->size, memory_order_relaxed);
+    atomic_fetch_sub_explicit(&memoryLive, header->size, memory_order_relaxed);
+    header->tag = 0; // a second free trips the magic check
+    free(header);
+}
+
+void BE_GpuMemoryAlloc(BE_MemoryTag tag, size_t bytes) {
+    size_t live = atomic_fetch_add_explicit(&memoryCounters[tag].gpuLive, bytes, memory_order_relaxed) + bytes;
+    BE_MemoryRaisePeak(&memoryCounters[tag].gpuPeak, live);
+}
+
+void BE_GpuMemoryRelease(BE_MemoryTag tag, size_t bytes) {
+    atomic_fetch_sub_explicit(&memoryCounters[tag].gpuLive, bytes, memory_order_relaxed);
+}
+
+size_t BE_GpuTextureBytes(int width, int height, int layers, int bytesPerTexel, int mipLevels) {
+    size_t bytes = 0;
+    for (int level = 0; level < (mipLevels > 0 ? mipLevels : 1); level++) {
+        size_t w = (size_t)(width >> level), h = (size_t)(height >> level);
+        bytes += (w ? w : 1) * (h ? h : 1);
+    }
+    return bytes * (size_t)(layers > 0 ? layers : 1) * (size_t)bytesPerTexel;
+}
+
+void BE_MemoryGetStats(BE_MemoryStats* outStats) {
+    memset(outStats, 0, sizeof(BE_MemoryStats));
+    for (int i = 0; i < BE_MEMORY_TAG_COUNT; i++) {
+        BE_MemoryCounters* counters = &memoryCounters[i];
+        outStats->live[i] = atomic_load_explicit(&counters->live, memory_order_relaxed);
+        outStats->peak[i] = atomic_load_explicit(&counters->peak, memory_order_relaxed);
+        outStats->allocations[i] = atomic_load_explicit(&counters->allocations, memory_order_relaxed);
+        outStats->gpuLive[i] = atomic_load_explicit(&counters->gpuLive, memory_order_relaxed);
+        outStats->gpuPeak[i] = atomic_load_explicit(&counters->gpuPeak, memory_order_relaxed);
+        outStats->gpuTotal += outStats->gpuLive[i];
+    }
+    outStats->totalLive = atomic_load_explicit(&memoryLive, memory_order_relaxed);
+    outStats->totalPeak = atomic_load_explicit(&memoryPeak, memory_order_relaxed);
+    outStats->totalAllocations = atomic_load_explicit(&memoryAllocations, memory_order_relaxed);
+    outStats->totalBytes = atomic_load_explicit(&memoryBytes, memory_order_relaxed);
+}
+
+void BE_MemoryResetPeaks() {
+    for (int i = 0; i < BE_MEMORY_TAG_COUNT; i++) {
+        BE_MemoryCounters* counters = &memoryCounters[i];
+        atomic_store_explicit(&counters->peak, atomic_load_explicit(&counters->live, memory_order_relaxed), memory_order_relaxed);
+        atomic_store_explicit(&counters->gpuPeak, atomic_load_explicit(&counters->gpuLive, memory_order_relaxed), memory_order_relaxed);
+    }
+    atomic_store_explicit(&memoryPeak, atomic_load_explicit(&memoryLive, memory_order_relaxed), memory_order_relaxed);
+}
+
+uint64_t BE_MemoryAllocationCount() {
+    return atomic_load_explicit(&memoryAllocations, memory_order_relaxed);
+}
+
+uint64_t BE_MemoryAllocatedBytes() {
+    return atomic_load_explicit(&memoryBytes, memory_order_relaxed);
+}
+
+const char* BE_MemoryTagName(BE_MemoryTag tag) {
+    return tag < BE_MEMORY_TAG_COUNT ? memoryTagNames[tag] : "unknown";
+}
+
+// ==============================
+// Pools
+// ==============================
+
+// A slot is a POOL_ALIGN header holding the element's dense index, then the element
+#define POOL_FREE_SLOT SIZE_MAX
+
+void BE_PoolInit(BE_Pool* pool, size_t elementSize, size_t pageElements, BE_MemoryTag tag) {
+    memset(pool, 0, sizeof(BE_Pool));
+    pool->tag = tag;
+    pool->elementSize = elementSize;
+    pool->pageElements = pageElements ? pageElements : 1;
+
+    size_t body = (elementSize + POOL_ALIGN - 1) & ~(size_t)(POOL_ALIGN - 1);
+    pool->stride = POOL_ALIGN + (body ? body : POOL_ALIGN);
+}
+
+void BE_PoolFree(BE_Pool* pool) {
+    for (size_t i = 0; i < pool->pageCount; i++) {
+        BE_AlignedFree(pool->pages[i]);
+    }
+    BE_MemFree(pool->pages);
+    BE_MemFree(pool->dense);
+
+    size_t elementSize = pool->elementSize;
+    size_t pageElements = pool->pageElements;
+    BE_PoolInit(pool, elementSize, pageElements, pool->tag);
+}
+
+void* BE_PoolAlloc(BE_Pool* pool) {
+    unsigned char* slot;
+
+    if (pool->freeList) {
+        slot = (unsigned char*)pool->freeList - POOL_ALIGN;
+        pool->freeList = *(void**)pool->freeList;
+    } else {
+        size_t page = pool->used / pool->pageElements;
+        if (page >= pool->pageCount) {
+            if (pool->pageCount >= pool->pageCapacity) {
+                pool->pageCapacity = pool->pageCapacity ? pool->pageCapacity * 2 : 4;
+                pool->pages = (unsigned char**)BE_MemRealloc(pool->pages, sizeof(unsigned char*) * pool->pageCapacity, pool->tag);
+            }
+            pool->pages[pool->pageCount++] = (unsigned char*)BE_AlignedAlloc(pool->stride * pool->pageElements, POOL_PAGE_ALIGN, pool->tag);
+        }
+        slot = pool->pages[page] + (pool->used % pool->pageElements) * pool->stride;
+        pool->used++;
+    }
+
+    if (pool->size >= pool->denseCapacity) {
+        pool->denseCapacity = pool->denseCapacity ? pool->denseCapacity * 2 : pool->pageElements;
+        pool->dense = (void**)BE_MemRealloc(pool->dense, sizeof(void*) * pool->denseCapacity, pool->tag);
+    }
+
+    void* element = slot + POOL_ALIGN;
+    *(size_t*)slot = pool->size;
+    pool->dense[pool->size++] = element;
+    return element;
+}
+
+void BE_PoolRelease(BE_Pool* pool, void* element) {
+    size_t index = BE_PoolIndex(pool, element);
+    if (index == SIZE_MAX) return;
+
+    void* last = pool->dense[--pool->size];
+    pool->dense[index] = last;
+    *(size_t*)((unsigned char*)last - POOL_ALIGN) = index;
+
+    *(size_t*)((unsigned char*)element - POOL_ALIGN) = POOL_FREE_SLOT;
+    *(void**)element = pool->freeList;
+    pool->freeList = element;
+}
+
+size_t BE_PoolIndex(BE_Pool* pool, const void* element) {
+    if (!element) return SIZE_MAX;
+    size_t index = *(const size_t*)((const unsigned char*)element - POOL_ALIGN);
+    return index < pool->size && pool->dense[index] == element ? index : SIZE_MAX;
+}
+
+// ==============================
+// Vectors
+// ==============================
+
+void* BE_VectorGrow(void* data, size_t* capacity, size_t needed, size_t elementSize, size_t initial, unsigned growth, BE_MemoryTag tag) {
+    if (growth <= 100) growth = VECTOR_GROWTH;
+    size_t grown = *capacity ? *capacity : (initial ? initial : 1);
+    while (grown < needed) {
+        size_t step = grown * (growth - 100) / 100;
+        grown += step ? step : 1;
+    }
+    return BE_VectorResize(data, capacity, grown, elementSize, tag);
+}
+
+void* BE_VectorResize(void* data, size_t* capacity, size_t count, size_t elementSize, BE_MemoryTag tag) {
+    if (count == 0) {
+        BE_MemFree(data);
+        *capacity = 0;
+        return NULL;
+    }
+    void* resized = BE_MemRealloc(data, count * elementSize, tag);
+    if (!resized) {
+        fprintf(stderr, "BE_Vector: out of memory growing to %zu elements of %zu bytes\n", count, elementSize);
+        abort();
+    }
+    *capacity = count;
+    return resized;
+}
+
+// ==============================
+// Arenas
+// ==============================
+
+static BE_THREAD_LOCAL BE_Arena scratchArena;
+
+static size_t BE_ArenaHeader() {
+    return (sizeof(BE_ArenaBlock) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static unsigned char* BE_ArenaBlockData(BE_ArenaBlock* block) {
+    return (unsigned char*)block + BE_ArenaHeader();
+}
+
+static void BE_ArenaPoison(BE_ArenaBlock* block, size_t from) {
+#ifdef BE_ARENA_POISON
+    memset(BE_ArenaBlockData(block) + from, ARENA_POISON_BYTE, block->used - from);
+#else
+    (void)block; (void)from;
+#endif
+}
+
+static BE_ArenaBlock* BE_ArenaBlockInit(BE_Arena* arena, size_t capacity, BE_ArenaBlock* prev) {
+    BE_ArenaBlock* block = (BE_ArenaBlock*)BE_AlignedAlloc(BE_ArenaHeader() + capacity, ARENA_ALIGN, BE_MEMORY_ARENA);
+    if (!block) return NULL;
+    block->prev = prev;
+    block->capacity = capacity;
+    block->used = 0;
+    arena->blockAllocs++;
+    return block;
+}
+
+void BE_ArenaInit(BE_Arena* arena, size_t blockSize) {
+    memset(arena, 0, sizeof(BE_Arena));
+    arena->blockSize = blockSize > ARENA_MIN_BLOCK ? blockSize : ARENA_MIN_BLOCK;
+}
+
+void BE_ArenaFree(BE_Arena* arena) {
+    while (arena->block) {
+        BE_ArenaBlock* prev = arena->block->prev;
+        BE_AlignedFree(arena->block);
+        arena->block = prev;
+    }
+    arena->used = 0;
+}
+
+static size_t BE_ArenaOffset(BE_ArenaBlock* block, size_t align) {
+    uintptr_t start = (uintptr_t)BE_ArenaBlockData(block) + block->used;
+    return block->used + (((start + align - 1) & ~(uintptr_t)(align - 1)) - start);
+}
+
+void* BE_ArenaAlloc(BE_Arena* arena, size_t size, size_t align) {
+    if (align < ARENA_ALIGN) align = ARENA_ALIGN;
+
+    BE_ArenaBlock* block = arena->block;
+    if (!block || BE_ArenaOffset(block, align) + size > block->capacity) {
+        // Chain on a block big enough for the request, the tail of the full one is lost until reset
+        size_t capacity = arena->blockSize;
+        while (capacity < size + align) capacity *= 2;
+        if (block) {
+            arena->used += block->capacity - block->used;
+            block->used = block->capacity;
+        }
+
+        block = BE_ArenaBlockInit(arena, capacity, block);
+        if (!block) return NULL;
+        arena->block = block;
+    }
+
+    size_t offset = BE_ArenaOffset(block, align);
+    arena->used += offset + size - block->used;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+
+    block->used = offset + size;
+    return BE_ArenaBlockData(block) + offset;
+}
+
+void* BE_ArenaAllocZero(BE_Arena* arena, size_t size, size_t align) {
+    void* data = BE_ArenaAlloc(arena, size, align);
+    if (data) memset(data, 0, size);
+    return data;
+}
+
+char* BE_ArenaPrintf(BE_Arena* arena, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    va_list copy;
+    va_copy(copy, args);
+    int length = vsnprintf(NULL, 0, format, copy);
+    va_end(copy);
+
+    char* text = length >= 0 ? (char*)BE_ArenaAlloc(arena, (size_t)length + 1, 1) : NULL;
+    if (text) vsnprintf(text, (size_t)length + 1, format, args);
+    va_end(args);
+    return text;
+}
+
+void BE_ArenaReset(BE_Arena* arena) {
+    BE_ArenaBlock* block = arena->block;
+    if (!block) return;
+
+    if (block->prev || block->capacity < arena->peak) {
+        // Overflowed since the last reset, one block big enough for the peak replaces the chain
+        while (arena->blockSize < arena->peak) arena->blockSize *= 2;
+        BE_ArenaFree(arena);
+        arena->block = BE_ArenaBlockInit(arena, arena->blockSize, NULL);
+        return;
+    }
+
+    BE_ArenaPoison(block, 0);
+    block->used = 0;
+    arena->used = 0;
+}
+
+BE_ArenaMark BE_ArenaGetMark(BE_Arena* arena) {
+    BE_ArenaMark mark = {arena, arena->block, arena->block ? arena->block->used : 0, arena->used};
+    return mark;
+}
+
+void BE_ArenaRewind(BE_ArenaMark mark) {
+    BE_Arena* arena = mark.arena;
+
+    // Blocks chained on after the mark go back to the heap, the peak still remembers them
+    while (arena->block && arena->block != mark.block) {
+        BE_ArenaBlock* prev = arena->block->prev;
+        BE_AlignedFree(arena->block);
+        arena->block = prev;
+    }
+
+    if (arena->block) {
+        BE_ArenaPoison(arena->block, mark.blockUsed);
+        arena->block->used = mark.blockUsed;
+    }
+    arena->used = mark.used;
+}
+
+BE_ArenaMark BE_ScratchBegin() {
+    if (!scratchArena.blockSize) BE_ArenaInit(&scratchArena, 0);
+    return BE_ArenaGetMark(&scratchArena);
+}
+
+void BE_ScratchEnd(BE_ArenaMark mark) {
+    // Ending the outermost scope is a reset, which is where an overflowed chain gets merged
+    if (mark.used == 0) BE_ArenaReset(mark.arena);
+    else BE_ArenaRewind(mark);
+}
+
+void BE_ScratchFree() {
+    BE_ArenaFree(&scratchArena);
+    scratchArena.blockSize = 0;
+}
@@ -0,0 +1,236 @@
+#pragma once
+#ifndef ENGINE_MEMORY_H
+#define ENGINE_MEMORY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+// ==============================
+// Tracking
+// ==============================
+
+// Every engine allocation goes through BE_Mem* with a tag naming the subsystem that owns it.
+// A small header in front of each block remembers size and tag, so frees need no tag and the
+// per tag live, peak and call counts stay exact. GL objects can't be measured, their owners
+// report an estimate from format and dimensions instead.
+
+typedef enum {
+    BE_MEMORY_GENERAL,
+    BE_MEMORY_MESH,
+    BE_MEMORY_TEXTURE,
+    BE_MEMORY_SHADER,
+    BE_MEMORY_AUDIO,
+    BE_MEMORY_SCENE,         // scene objects, registries and entities
+    BE_MEMORY_RENDER,        // shadows, light clusters, sprite batches, streaming
+    BE_MEMORY_LOADER,
+    BE_MEMORY_ARENA,
+    BE_MEMORY_UI,
+    BE_MEMORY_TAG_COUNT
+} BE_MemoryTag;
+
+typedef struct {
+    size_t live[BE_MEMORY_TAG_COUNT];
+    size_t peak[BE_MEMORY_TAG_COUNT];
+    uint64_t allocations[BE_MEMORY_TAG_COUNT];  // calls since start, reallocs included
+    size_t gpuLive[BE_MEMORY_TAG_COUNT];
+    size_t gpuPeak[BE_MEMORY_TAG_COUNT];
+
+    size_t totalLive;
+    size_t totalPeak;
+    size_t gpuTotal;
+    uint64_t totalAllocations;
+    uint64_t totalBytes;                        // requested since start
+} BE_MemoryStats;
+
+void* BE_MemAlloc(size_t size, BE_MemoryTag tag);
+void* BE_MemCalloc(size_t count, size_t size, BE_MemoryTag tag);
+void* BE_MemRealloc(void* ptr, size_t size, BE_MemoryTag tag); // keeps the tag ptr was allocated with
+char* BE_MemStrdup(const char* str, BE_MemoryTag tag);
+void BE_MemFree(void* ptr);                                     // only for BE_Mem* blocks
+
+void BE_GpuMemoryAlloc(BE_MemoryTag tag, size_t bytes);
+void BE_GpuMemoryRelease(BE_MemoryTag tag, size_t bytes);
+size_t BE_GpuTextureBytes(int width, int height, int layers, int bytesPerTexel, int mipLevels);
+
+void BE_MemoryGetStats(BE_MemoryStats* outStats);
+void BE_MemoryResetPeaks();              // peaks restart from what is live now
+uint64_t BE_MemoryAllocationCount(); // cheap, for allocations per frame
+uint64_t BE_MemoryAllocatedBytes();
+const char* BE_MemoryTagName(BE_MemoryTag tag);
+
+static inline void* BE_AlignedAlloc(size_t size, size_t align, BE_MemoryTag tag) {
+    void* raw = BE_MemAlloc(size + align + sizeof(void*), tag);
+    if (!raw) return NULL;
+    uintptr_t aligned = ((uintptr_t)raw + sizeof(void*) + align - 1) & ~(uintptr_t)(align - 1);
+    ((void**)aligned)[-1] = raw;
+    return (void*)aligned;
+}
+
+static inline void BE_AlignedFree(void* ptr) {
+    if (ptr) BE_MemFree(((void**)ptr)[-1]);
+}
+
+// ==============================
+// Pools
+// ==============================
+
+// Paged slab for objects other code keeps pointers to. Pages are never moved or freed before
+// the pool is, so an element's address is stable for its whole life. Released slots go on a
+// free list, and a dense array of live elements keeps iteration a flat loop.
+
+#define POOL_ALIGN 32        // covers cglm's AVX aligned matrices
+#define POOL_PAGE_ALIGN 64
+
+typedef struct {
+    unsigned char** pages;
+    size_t pageCount;
+    size_t pageCapacity;
+    size_t pageElements;     // slots per page
+    size_t elementSize;
+    size_t stride;           // slot header plus element, a multiple of POOL_ALIGN
+    size_t used;             // slots ever handed out, the bump pointer across pages
+    BE_MemoryTag tag;
+
+    void* freeList;          // released slots, linked through their first bytes
+
+    void** dense;            // live elements, order changes when one is released
+    size_t size;
+    size_t denseCapacity;
+} BE_Pool;
+
+void BE_PoolInit(BE_Pool* pool, size_t elementSize, size_t pageElements, BE_MemoryTag tag);
+void BE_PoolFree(BE_Pool* pool);
+void* BE_PoolAlloc(BE_Pool* pool);                   // uninitialized, stays put until released
+void BE_PoolRelease(BE_Pool* pool, void* element);   // the last dense element takes its place
+size_t BE_PoolIndex(BE_Pool* pool, const void* element); // dense position, SIZE_MAX if not live
+
+static inline void* BE_PoolAt(BE_Pool* pool, size_t index) {
+    return pool->dense[index];
+}
+
+// ==============================
+// Vectors
+// ==============================
+
+// Growable arrays share one core. A vector type starts with BE_VECTOR_FIELDS and may carry
+// more fields after it, BE_VECTOR_DEFINE then generates the typed operations. Elements are
+// plain data, they are moved with memcpy and removal swaps the last one in, so order is only
+// kept by code that never removes.
+//     typedef struct { BE_VECTOR_FIELDS(int); } IntVector;
+//     BE_VECTOR_DEFINE(IntVector, int, 64, VECTOR_GROWTH, BE_MEMORY_GENERAL)
+
+#define VECTOR_GROWTH 200        // percent of the old capacity, at least 101
+
+#define BE_VECTOR_FIELDS(type) type* data; size_t size; size_t capacity
+
+void* BE_VectorGrow(void* data, size_t* capacity, size_t needed, size_t elementSize, size_t initial, unsigned growth, BE_MemoryTag tag);
+void* BE_VectorResize(void* data, size_t* capacity, size_t count, size_t elementSize, BE_MemoryTag tag); // exact, frees at 0
+
+#define BE_VECTOR_DEFINE(Name, type, initial, growth, tag)                                                \
+    /* Capacity for at least count elements, without the growth factor */                               \
+    static inline void Name##Reserve(Name* vec, size_t count) {                                         \
+        if (count > vec->capacity) {                                                                     \
+            vec->data = (type*)BE_VectorResize(vec->data, &vec->capacity, count, sizeof(type), tag);    \
+        }                                                                                                \
+    }                                                                                                    \
+    static inline void Name##Shrink(Name* vec) {                                                        \
+        if (vec->capacity > vec->size) {                                                                 \
+            vec->data = (type*)BE_VectorResize(vec->data, &vec->capacity, vec->size, sizeof(type), tag); \
+        }                                                                                                \
+    }                                                                                                    \
+    /* Appends count uninitialized elements and returns the first */                                    \
+    static inline type* Name##Emplace(Name* vec, size_t count) {                                        \
+        if (vec->size + count > vec->capacity) {                                                         \
+            vec->data = (type*)BE_VectorGrow(vec->data, &vec->capacity, vec->size + count, sizeof(type), \
+                                             initial, growth, tag);                                      \
+        }                                                                                                \
+        type* first = vec->data + vec->size;                                                             \
+        vec->size += count;                                                                              \
+        return first;                                                                                    \
+    }                                                                                                    \
+    static inline void Name##Append(Name* vec, const type* values, size_t count) {                      \
+        if (count) memcpy(Name##Emplace(vec, count), values, sizeof(type) * count);                      \
+    }                                                                                                    \
+    /* Replaces the contents, capacity only grows to what is needed */                                  \
+    static inline void Name##Assign(Name* vec, const type* values, size_t count) {                      \
+        Name##Reserve(vec, count);                                                                       \
+        if (count) memcpy(vec->data, values, sizeof(type) * count);                                      \
+        vec->size = count;                                                                               \
+    }                                                                                                    \
+    /* O(1), the last element moves into index */                                                      \
+    static inline void Name##RemoveSwap(Name* vec, size_t index) {                                      \
+        if (index >= vec->size) return;                                                                 \
+        if (index + 1 < vec->size) vec->data[index] = vec->data[vec->size - 1];                          \
+        vec->size--;                                                                                     \
+    }                                                                                                    \
+    static inline void Name##Clear(Name* vec) {                                                         \
+        vec->size = 0;                                                                                   \
+    }                                                                                                    \
+    /* SIZE_MAX unless element points into the vector */                                               \
+    static inline size_t Name##IndexOf(Name* vec, const type* element) {                                \
+        if (!element || element < vec->data || element >= vec->data + vec->size) return SIZE_MAX;       \
+        return (size_t)(element - vec->data);                                                            \
+    }
+
+// ==============================
+// Arenas
+// ==============================
+
+// Bump allocator for memory that dies all at once. Nothing is freed on its own, the arena is
+// reset or rewound to a mark. When a block fills up another one is chained on, and the next
+// reset swaps the chain for a single block as large as the high-water mark, so a workload
+// that repeats every frame stops touching the heap after the first few.
+
+#define ARENA_ALIGN 16
+#define ARENA_MIN_BLOCK (64 * 1024)
+#define ARENA_POISON_BYTE 0xCD
+
+// Debug builds fill released bytes so reads through stale pointers stand out
+#if !defined(NDEBUG) && !defined(BE_ARENA_NO_POISON)
+#define BE_ARENA_POISON
+#endif
+
+typedef struct BE_ArenaBlock {
+    struct BE_ArenaBlock* prev;
+    size_t capacity;
+    size_t used;
+} BE_ArenaBlock;               // data follows, ARENA_ALIGN aligned
+
+typedef struct {
+    BE_ArenaBlock* block;      // newest, older ones through prev, NULL until first use
+    size_t blockSize;          // capacity of the next block, grows to the peak on reset
+    size_t used;               // bytes handed out, padding included
+    size_t peak;               // high-water mark of used
+    size_t blockAllocs;        // heap allocations so far
+} BE_Arena;
+
+typedef struct {
+    BE_Arena* arena;
+    BE_ArenaBlock* block;
+    size_t blockUsed;
+    size_t used;
+} BE_ArenaMark;
+
+void BE_ArenaInit(BE_Arena* arena, size_t blockSize);
+void BE_ArenaFree(BE_Arena* arena);
+void* BE_ArenaAlloc(BE_Arena* arena, size_t size, size_t align); // uninitialized
+void* BE_ArenaAllocZero(BE_Arena* arena, size_t size, size_t align);
+char* BE_ArenaPrintf(BE_Arena* arena, const char* format, ...);
+void BE_ArenaReset(BE_Arena* arena);
+BE_ArenaMark BE_ArenaGetMark(BE_Arena* arena);
+void BE_ArenaRewind(BE_ArenaMark mark); // releases everything allocated after the mark
+
+#define BE_ARENA_NEW(arena, type, count) ((type*)BE_ArenaAlloc(arena, sizeof(type) * (count), _Alignof(type)))
+
+// One scratch arena per thread for temporaries inside a call, always paired:
+//     BE_ArenaMark scratch = BE_ScratchBegin();
+//     ... BE_ARENA_NEW(scratch.arena, ...) ...
+//     BE_ScratchEnd(scratch);
+BE_ArenaMark BE_ScratchBegin();
+void BE_ScratchEnd(BE_ArenaMark mark);
+void BE_ScratchFree(); // before a thread that used scratch memory exits
+
+#endif
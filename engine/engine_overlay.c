@@ -0,0 +1,147 @@
+#include "engine/engine_overlay.h"
+
+// Same options as include/nuklear/nuklear.c, which holds the implementation
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_STANDARD_IO
+#define NK_INCLUDE_STANDARD_VARARGS
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+#define NK_INCLUDE_FONT_BAKING
+#define NK_INCLUDE_DEFAULT_FONT
+#define NK_KEYSTATE_BASED_INPUT
+#include "nuklear/nuklear.h"
+#include "nuklear/nuklear_glfw_gl4.h"
+
+#include <stdio.h>
+
+// In include/nuklear/nuklear.c, where the backend's state is
+void nk_glfw3_new_frame_input(float deltaTime, int width, int height, int displayWidth, int displayHeight,
+                              int cursorX, int cursorY, const int buttons[3]);
+
+// ==============================
+// Overlay
+// ==============================
+
+static struct {
+    struct nk_context* context;
+    bool failed;
+    float costMs;
+} overlay;
+
+bool BE_OverlayInit(GLFWwindow* window) {
+    if (overlay.context) return true;
+    if (overlay.failed) return false;
+
+    if (!GLAD_GL_ARB_bindless_texture) {
+        BE_IMPL_Message(1, "Overlay", __FILE__, __LINE__, "GL_ARB_bindless_texture is not supported, the overlay is off");
+        overlay.failed = true;
+        return false;
+    }
+
+    // No callbacks, the engine keeps its own input handling
+    overlay.context = nk_glfw3_init(window, NK_GLFW3_DEFAULT, OVERLAY_VERTEX_BUFFER, OVERLAY_ELEMENT_BUFFER);
+    struct nk_font_atlas* atlas;
+    nk_glfw3_font_stash_begin(&atlas);
+    nk_glfw3_font_stash_end();
+    BE_GpuMemoryAlloc(BE_MEMORY_UI, OVERLAY_VERTEX_BUFFER + OVERLAY_ELEMENT_BUFFER);
+
+    overlay.context->style.window.fixed_background = nk_style_item_color(nk_rgba(20, 20, 20, 210));
+    return true;
+}
+
+void BE_OverlayShutdown() {
+    if (overlay.context) {
+        nk_glfw3_shutdown();
+        BE_GpuMemoryRelease(BE_MEMORY_UI, OVERLAY_VERTEX_BUFFER + OVERLAY_ELEMENT_BUFFER);
+    }
+    overlay.context = NULL;
+    overlay.failed = false;
+    overlay.costMs = 0.0f;
+}
+
+void BE_OverlayReadInput(GLFWwindow* window, BE_OverlayInput* input) {
+    double x, y;
+    glfwGetWindowSize(window, &input->width, &input->height);
+    glfwGetFramebufferSize(window, &input->displayWidth, &input->displayHeight);
+    glfwGetCursorPos(window, &x, &y);
+    input->cursor[0] = (int)x;
+    input->cursor[1] = (int)y;
+    input->buttons[0] = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_LEFT) == GLFW_PRESS;
+    input->buttons[1] = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_MIDDLE) == GLFW_PRESS;
+    input->buttons[2] = glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_RIGHT) == GLFW_PRESS;
+}
+
+float BE_OverlayCostMs() {
+    return overlay.costMs;
+}
+
+static void BE_OverlayFrameGraph(struct nk_context* ctx, BE_FrameStats* timer) {
+    int count = timer->frameTimeCount < OVERLAY_GRAPH_FRAMES ? timer->frameTimeCount : OVERLAY_GRAPH_FRAMES;
+    if (count == 0) return;
+
+    // Scaled to the slowest frame shown, at least a 60 Hz frame so a steady game reads flat
+    float maxMs = 1000.0f / 60;
+    int first = timer->frameTimeIndex - count + FRAME_TIME_HISTORY;
+    for (int i = 0; i < count; i++) {
+        float ms = timer->frameTimes[(first + i) % FRAME_TIME_HISTORY];
+        if (ms > maxMs) maxMs = ms;
+    }
+
+    nk_layout_row_dynamic(ctx, 60, 1);
+    if (nk_chart_begin(ctx, NK_CHART_LINES, count, 0.0f, maxMs)) {
+        for (int i = 0; i < count; i++) nk_chart_push(ctx, timer->frameTimes[(first + i) % FRAME_TIME_HISTORY]);
+        nk_chart_end(ctx);
+    }
+    nk_layout_row_dynamic(ctx, 14, 1);
+    nk_labelf(ctx, NK_TEXT_LEFT, "last %d frames, top %.1f ms", count, maxMs);
+}
+
+void BE_OverlayDraw(BE_Engine* engine) {
+    if (!BE_OverlayInit(engine->window)) return;
+    BE_PROFILE_FUNCTION();
+    BE_GPU_SCOPE(engine->gpuTimer, "Overlay");
+    uint64_t start = BE_ThreadClockNs();
+
+    struct nk_context* ctx = overlay.context;
+    BE_FrameStats* timer = &engine->timer;
+    BE_RenderStats* render = &timer->render;
+    BE_OverlayInput* input = &engine->overlayInput;
+    nk_glfw3_new_frame_input(timer->dt, input->width, input->height, input->displayWidth, input->displayHeight,
+                             input->cursor[0], input->cursor[1], input->buttons);
+
+    nk_flags flags = NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_TITLE | NK_WINDOW_MINIMIZABLE | NK_WINDOW_NO_SCROLLBAR;
+    if (nk_begin(ctx, "Performance", nk_rect(10, 10, 300, 560), flags)) {
+        nk_layout_row_dynamic(ctx, 16, 1);
+        nk_labelf(ctx, NK_TEXT_LEFT, "%.0f fps  %.2f ms", timer->fps, timer->ms);
+        nk_labelf(ctx, NK_TEXT_LEFT, "p50 %.2f  p95 %.2f  p99 %.2f ms", timer->frameTime.p50Ms, timer->frameTime.p95Ms, timer->frameTime.p99Ms);
+        BE_OverlayFrameGraph(ctx, timer);
+
+        nk_layout_row_dynamic(ctx, 16, 2);
+        nk_label(ctx, "Draw calls", NK_TEXT_LEFT);     nk_labelf(ctx, NK_TEXT_RIGHT, "%u", render->drawCalls);
+        nk_label(ctx, "Triangles", NK_TEXT_LEFT);      nk_labelf(ctx, NK_TEXT_RIGHT, "%llu", (unsigned long long)render->triangles);
+        nk_label(ctx, "State changes", NK_TEXT_LEFT);  nk_labelf(ctx, NK_TEXT_RIGHT, "%u", render->stateChanges);
+        nk_label(ctx, "Uniforms", NK_TEXT_LEFT);       nk_labelf(ctx, NK_TEXT_RIGHT, "%u", render->uniformUploads);
+        nk_label(ctx, "Texture binds", NK_TEXT_LEFT);  nk_labelf(ctx, NK_TEXT_RIGHT, "%u", render->textureBinds);
+        nk_label(ctx, "Shadow passes", NK_TEXT_LEFT);  nk_labelf(ctx, NK_TEXT_RIGHT, "%u", render->shadowPasses);
+        nk_label(ctx, "Visible/culled", NK_TEXT_LEFT); nk_labelf(ctx, NK_TEXT_RIGHT, "%u / %u", render->visibleObjects, render->culledObjects);
+
+        BE_GpuPassTime passes[GPU_TIMER_MAX_PASSES];
+        int passCount = BE_GpuTimerGetPasses(engine->gpuTimer, passes, GPU_TIMER_MAX_PASSES);
+        for (int i = 0; i < passCount; i++) {
+            nk_labelf(ctx, NK_TEXT_LEFT, "GPU %s", passes[i].name);
+            nk_labelf(ctx, NK_TEXT_RIGHT, "%.3f ms", passes[i].avgMs);
+        }
+
+        nk_label(ctx, "Heap", NK_TEXT_LEFT);     nk_labelf(ctx, NK_TEXT_RIGHT, "%.2f MB", (double)timer->cpuBytes / (1024.0 * 1024.0));
+        nk_label(ctx, "Heap peak", NK_TEXT_LEFT); nk_labelf(ctx, NK_TEXT_RIGHT, "%.2f MB", (double)timer->cpuPeakBytes / (1024.0 * 1024.0));
+        nk_label(ctx, "GPU (est.)", NK_TEXT_LEFT); nk_labelf(ctx, NK_TEXT_RIGHT, "%.2f MB", (double)timer->gpuBytes / (1024.0 * 1024.0));
+        nk_label(ctx, "Allocs/frame", NK_TEXT_LEFT); nk_labelf(ctx, NK_TEXT_RIGHT, "%llu", (unsigned long long)timer->frameAllocations);
+
+        // The GPU side of this shows up as the "Overlay" pass above
+        nk_label(ctx, "Overlay CPU", NK_TEXT_LEFT); nk_labelf(ctx, NK_TEXT_RIGHT, "%.3f ms", overlay.costMs);
+    }
+    nk_end(ctx);
+
+    nk_glfw3_render(NK_ANTI_ALIASING_ON);
+    overlay.costMs = (float)((double)(BE_ThreadClockNs() - start) * 1e-6);
+}
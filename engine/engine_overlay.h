@@ -0,0 +1,28 @@
+#pragma once
+#ifndef ENGINE_OVERLAY_H
+#define ENGINE_OVERLAY_H
+
+#include <engine/engine.h>
+
+// ==============================
+// Overlay
+// ==============================
+
+// Live performance window drawn with the bundled Nuklear over the finished frame: frame time
+// graph, the previous frame's render counters, GPU pass times and memory. It runs on the
+// thread that owns the context right before the swap, and reports what it cost itself so the
+// numbers it shows can be read without it. Input is read on the main thread in BE_BeginFrame, so
+// drawing works from the render thread too. The Nuklear GL4 backend samples its font through
+// bindless textures, without GL_ARB_bindless_texture the overlay stays off.
+
+#define OVERLAY_VERTEX_BUFFER (512 * 1024)
+#define OVERLAY_ELEMENT_BUFFER (128 * 1024)
+#define OVERLAY_GRAPH_FRAMES 120
+
+bool BE_OverlayInit(GLFWwindow* window); // false if the backend can't run, only reports that once
+void BE_OverlayShutdown();
+void BE_OverlayReadInput(GLFWwindow* window, BE_OverlayInput* input); // main thread only
+void BE_OverlayDraw(BE_Engine* engine);  // initializes on first use
+float BE_OverlayCostMs();                // CPU time of the last draw, building and submitting
+
+#endif
@@ -0,0 +1,213 @@
+#include "engine/engine_profile.h"
+#include "engine/engine_memory.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// ==============================
+// Profiler
+// ==============================
+
+BE_THREAD_LOCAL BE_ProfileThread* g_profileThread = NULL;
+BE_THREAD_LOCAL uint32_t g_profileGeneration = 0;
+atomic_uint g_profileCurrentGeneration = 1;    // bumped by shutdown so cached rings are dropped
+atomic_bool g_profilePaused = false;
+
+static BE_THREAD_LOCAL uint64_t profileFrameTicks;
+
+// Registration and capture only, recording never takes it
+static atomic_flag profileLock = ATOMIC_FLAG_INIT;
+static BE_ProfileThread* profileThreads[PROFILE_MAX_THREADS];
+static int profileThreadCount;
+
+static uint64_t profileBaseTicks, profileBaseNs;
+
+static void BE_ProfileLock() {
+    while (atomic_flag_test_and_set_explicit(&profileLock, memory_order_acquire)) BE_ThreadYield();
+}
+
+static void BE_ProfileUnlock() {
+    atomic_flag_clear_explicit(&profileLock, memory_order_release);
+}
+
+void BE_ProfileInit() {
+    BE_ProfileLock();
+    if (!profileBaseNs) {
+        profileBaseTicks = BE_ProfileTicks();
+        profileBaseNs = BE_ThreadClockNs();
+    }
+    BE_ProfileUnlock();
+}
+
+void BE_ProfileShutdown() {
+    BE_ProfileLock();
+    for (int i = 0; i < profileThreadCount; i++) {
+        BE_MemFree(profileThreads[i]);
+        profileThreads[i] = NULL;
+    }
+    profileThreadCount = 0;
+    atomic_fetch_add(&g_profileCurrentGeneration, 1);
+    BE_ProfileUnlock();
+
+    g_profileThread = NULL;
+    profileFrameTicks = 0;
+}
+
+BE_ProfileThread* BE_ProfileRegisterThread() {
+    uint32_t generation = atomic_load(&g_profileCurrentGeneration);
+    if (g_profileThread && g_profileGeneration == generation) return g_profileThread;
+
+    BE_ProfileInit();
+    BE_ProfileLock();
+    BE_ProfileThread* thread = NULL;
+    if (profileThreadCount < PROFILE_MAX_THREADS) {
+        thread = (BE_ProfileThread*)BE_MemAlloc(sizeof(BE_ProfileThread), BE_MEMORY_GENERAL);
+    }
+    if (thread) {
+        atomic_init(&thread->head, 0);
+        thread->nanoseconds = false;
+        thread->id = (uint32_t)profileThreadCount + 1;
+        snprintf(thread->name, sizeof(thread->name), "thread %u", thread->id);
+        profileThreads[profileThreadCount++] = thread;
+    }
+    BE_ProfileUnlock();
+
+    // Over the limit the thread's zones are dropped
+    g_profileThread = thread;
+    g_profileGeneration = generation;
+    return thread;
+}
+
+void BE_ProfileThreadName(const char* name) {
+    BE_ProfileThread* thread = BE_ProfileRegisterThread();
+    if (!thread || !name) return;
+    BE_ProfileLock();
+    snprintf(thread->name, sizeof(thread->name), "%s", name);
+    BE_ProfileUnlock();
+}
+
+void BE_ProfileSetPaused(bool paused) {
+    atomic_store(&g_profilePaused, paused);
+}
+
+void BE_ProfileFrameMark() {
+    uint64_t now = BE_ProfileTicks();
+    if (profileFrameTicks) {
+        BE_ProfileZone zone = BE_ProfileBegin("Frame");
+        zone.start = profileFrameTicks;
+        BE_ProfileEnd(&zone);
+    }
+    profileFrameTicks = now;
+}
+
+BE_ProfileThread* BE_ProfileAddTrack(const char* name) {
+#ifndef BE_PROFILE_ENABLED
+    (void)name;
+    return NULL;
+#else
+    BE_ProfileInit();
+    BE_ProfileLock();
+    BE_ProfileThread* track = NULL;
+    if (profileThreadCount < PROFILE_MAX_THREADS) {
+        track = (BE_ProfileThread*)BE_MemAlloc(sizeof(BE_ProfileThread), BE_MEMORY_GENERAL);
+    }
+    if (track) {
+        atomic_init(&track->head, 0);
+        track->nanoseconds = true;
+        track->id = (uint32_t)profileThreadCount + 1;
+        snprintf(track->name, sizeof(track->name), "%s", name ? name : "track");
+        profileThreads[profileThreadCount++] = track;
+    }
+    BE_ProfileUnlock();
+    return track;
+#endif
+}
+
+void BE_ProfileTrackEvent(BE_ProfileThread* track, const char* name, uint64_t startNs, uint64_t endNs) {
+    if (!track || atomic_load_explicit(&g_profilePaused, memory_order_relaxed)) return;
+    uint64_t head = atomic_load_explicit(&track->head, memory_order_relaxed);
+    BE_ProfileEvent* event = &track->events[head & (PROFILE_RING_EVENTS - 1)];
+    event->name = name;
+    event->start = startNs;
+    event->end = endNs;
+    atomic_store_explicit(&track->head, head + 1, memory_order_release);
+}
+
+// The counter rate comes from the time since init, waits until that is long enough to be exact
+static double BE_ProfileNsPerTick() {
+#ifdef BE_PROFILE_TSC
+    uint64_t nowNs = BE_ThreadClockNs();
+    while (nowNs - profileBaseNs < 1000000) nowNs = BE_ThreadClockNs();
+    return (double)(nowNs - profileBaseNs) / (double)(BE_ProfileTicks() - profileBaseTicks);
+#else
+    return 1.0;
+#endif
+}
+
+static uint64_t BE_ProfileConvert(uint64_t ticks, double nsPerTick) {
+    return (uint64_t)((double)profileBaseNs + (double)(int64_t)(ticks - profileBaseTicks) * nsPerTick);
+}
+
+uint64_t BE_ProfileTicksToNs(uint64_t ticks) {
+    BE_ProfileInit();
+    return BE_ProfileConvert(ticks, BE_ProfileNsPerTick());
+}
+
+#ifdef BE_PROFILE_ENABLED
+static void BE_ProfileWriteName(FILE* file, const char* name) {
+    fputc('"', file);
+    for (const char* c = name; *c; c++) {
+        if (*c == '"' || *c == '\\') fputc('\\', file);
+        fputc((unsigned char)*c < 0x20 ? ' ' : *c, file);
+    }
+    fputc('"', file);
+}
+#endif
+
+bool BE_ProfileWriteTrace(const char* path, uint64_t sinceNs) {
+#ifndef BE_PROFILE_ENABLED
+    (void)path;
+    (void)sinceNs;
+    return false;
+#else
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    BE_ProfileInit();
+    double nsPerTick = BE_ProfileNsPerTick();
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+
+    BE_ProfileLock();
+    for (int t = 0; t < profileThreadCount; t++) {
+        BE_ProfileThread* thread = profileThreads[t];
+
+        fprintf(file, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", first ? "" : ",\n", thread->id);
+        BE_ProfileWriteName(file, thread->name);
+        fprintf(file, "}}");
+        first = false;
+
+        // The owner keeps writing while this reads. An entry is only kept if the head shows
+        // it could not have been overwritten by the time it was copied.
+        uint64_t head = atomic_load_explicit(&thread->head, memory_order_acquire);
+        uint64_t oldest = head > PROFILE_RING_EVENTS ? head - PROFILE_RING_EVENTS : 0;
+        for (uint64_t i = oldest; i < head; i++) {
+            BE_ProfileEvent event = thread->events[i & (PROFILE_RING_EVENTS - 1)];
+            if (i + PROFILE_RING_EVENTS <= atomic_load_explicit(&thread->head, memory_order_acquire)) continue;
+
+            uint64_t start = thread->nanoseconds ? event.start : BE_ProfileConvert(event.start, nsPerTick);
+            uint64_t end = thread->nanoseconds ? event.end : BE_ProfileConvert(event.end, nsPerTick);
+            if (end < sinceNs) continue;
+
+            fprintf(file, ",\n{\"name\":");
+            BE_ProfileWriteName(file, event.name);
+            fprintf(file, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", thread->id,
+                    (double)(int64_t)(start - profileBaseNs) * 1e-3, (double)(end > start ? end - start : 0) * 1e-3);
+        }
+    }
+    BE_ProfileUnlock();
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+#endif
+}
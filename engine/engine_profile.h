@@ -0,0 +1,135 @@
+#pragma once
+#ifndef ENGINE_PROFILE_H
+#define ENGINE_PROFILE_H
+
+#include <engine/engine_jobs.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// ==============================
+// Profiler
+// ==============================
+
+// Instrumented CPU zones. A zone reads the timestamp counter when it opens and writes one
+// record when its scope closes, into a ring owned by the calling thread, so recording takes
+// no locks and never allocates. Rings keep the newest PROFILE_RING_EVENTS zones per thread
+// and are turned into Chrome Trace Event JSON on demand, which Perfetto and chrome://tracing
+// open directly.
+//     void BE_Something() {
+//         BE_PROFILE_SCOPE("BE_Something");
+//         ...
+//     }
+// Zones compile to nothing in release builds, define BE_PROFILE to keep them with NDEBUG or
+// BE_NO_PROFILE to drop them from a debug build.
+
+#if defined(BE_PROFILE) || (!defined(NDEBUG) && !defined(BE_NO_PROFILE))
+#define BE_PROFILE_ENABLED
+#endif
+
+#define PROFILE_RING_EVENTS (16 * 1024) // per thread, power of two
+#define PROFILE_MAX_THREADS 128
+#define PROFILE_THREAD_NAME 32
+
+typedef struct {
+    const char* name;          // not copied, string literals or names that outlive the capture
+    uint64_t start;            // ticks
+    uint64_t end;
+} BE_ProfileEvent;
+
+typedef struct {
+    BE_ProfileEvent events[PROFILE_RING_EVENTS];
+    atomic_ullong head;        // events ever written, only the owning thread stores
+    uint32_t id;
+    bool nanoseconds;          // a track fed with BE_ThreadClockNs() times instead of ticks
+    char name[PROFILE_THREAD_NAME];
+} BE_ProfileThread;
+
+typedef struct {
+    const char* name;          // NULL if the zone opened while capture was paused
+    uint64_t start;
+} BE_ProfileZone;
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define BE_PROFILE_TSC
+#endif
+
+// Raw ticks, converted to time when a capture is written
+static inline uint64_t BE_ProfileTicks() {
+#ifdef BE_PROFILE_TSC
+    return __builtin_ia32_rdtsc();
+#else
+    return BE_ThreadClockNs();
+#endif
+}
+
+void BE_ProfileInit();
+void BE_ProfileShutdown();             // frees every thread's ring, later zones register again
+void BE_ProfileThreadName(const char* name); // registers the calling thread, call before a frame that may not allocate
+void BE_ProfileSetPaused(bool paused); // zones opened while paused are dropped
+BE_ProfileThread* BE_ProfileRegisterThread();
+void BE_ProfileFrameMark();            // records a "Frame" zone from the previous mark to now on this thread
+
+// Extra rows in the trace for work timed elsewhere, like the GPU. Events come in already
+// measured, one thread writes a track at a time. NULL when profiling is compiled out or
+// every slot is taken, the track is freed by BE_ProfileShutdown.
+BE_ProfileThread* BE_ProfileAddTrack(const char* name);
+void BE_ProfileTrackEvent(BE_ProfileThread* track, const char* name, uint64_t startNs, uint64_t endNs);
+
+/**
+ * @brief Writes the recorded zones as Chrome Trace Event JSON
+ * @param sinceNs Only zones that end after this BE_ThreadClockNs() time, 0 for everything still in the rings.
+ * @return false if the file could not be written or profiling is compiled out.
+ */
+bool BE_ProfileWriteTrace(const char* path, uint64_t sinceNs);
+
+uint64_t BE_ProfileTicksToNs(uint64_t ticks);
+
+extern BE_THREAD_LOCAL BE_ProfileThread* g_profileThread;
+extern BE_THREAD_LOCAL uint32_t g_profileGeneration;
+extern atomic_uint g_profileCurrentGeneration;
+extern atomic_bool g_profilePaused;
+
+static inline BE_ProfileZone BE_ProfileBegin(const char* name) {
+    BE_ProfileZone zone = { NULL, 0 };
+    if (atomic_load_explicit(&g_profilePaused, memory_order_relaxed)) return zone;
+    zone.name = name;
+    zone.start = BE_ProfileTicks();
+    return zone;
+}
+
+static inline void BE_ProfileEnd(BE_ProfileZone* zone) {
+    if (!zone->name) return;
+    uint64_t end = BE_ProfileTicks();
+
+    BE_ProfileThread* thread = g_profileThread;
+    if (!thread || g_profileGeneration != atomic_load_explicit(&g_profileCurrentGeneration, memory_order_relaxed)) {
+        thread = BE_ProfileRegisterThread();
+        if (!thread) return;
+    }
+
+    uint64_t head = atomic_load_explicit(&thread->head, memory_order_relaxed);
+    BE_ProfileEvent* event = &thread->events[head & (PROFILE_RING_EVENTS - 1)];
+    event->name = zone->name;
+    event->start = zone->start;
+    event->end = end;
+    atomic_store_explicit(&thread->head, head + 1, memory_order_release);
+}
+
+#define BE_PROFILE_CONCAT_(a, b) a##b
+#define BE_PROFILE_CONCAT(a, b) BE_PROFILE_CONCAT_(a, b)
+
+#ifdef BE_PROFILE_ENABLED
+#define BE_PROFILE_SCOPE(name) \
+    BE_ProfileZone BE_PROFILE_CONCAT(beProfileZone, __LINE__) __attribute__((cleanup(BE_ProfileEnd))) = BE_ProfileBegin(name)
+#define BE_PROFILE_FUNCTION() BE_PROFILE_SCOPE(__func__)
+#define BE_PROFILE_THREAD(name) BE_ProfileThreadName(name)
+#define BE_PROFILE_FRAME() BE_ProfileFrameMark()
+#else
+#define BE_PROFILE_SCOPE(name) ((void)0)
+#define BE_PROFILE_FUNCTION() ((void)0)
+#define BE_PROFILE_THREAD(name) ((void)0)
+#define BE_PROFILE_FRAME() ((void)0)
+#endif
+
+#endif
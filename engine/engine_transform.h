@@ -0,0 +1,270 @@
+#pragma once
+#ifndef ENGINE_TRANSFORM_H
+#define ENGINE_TRANSFORM_H
+
+#include <engine/cglm/cglm.h>
+#include <engine/engine_memory.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// ==============================
+// Transform Store
+// ==============================
+
+// Batch TRS composition over structure-of-arrays transforms. Only depends on cglm,
+// so tools and benchmarks can use it without a GL context.
+
+#define BE_TRANSFORM_SIMD_SCALAR 0
+#define BE_TRANSFORM_SIMD_SSE 1
+#define BE_TRANSFORM_SIMD_AVX 2
+
+// Override with -DBE_TRANSFORM_SIMD=BE_TRANSFORM_SIMD_SCALAR etc.
+#ifndef BE_TRANSFORM_SIMD
+    #if defined(__AVX__)
+        #define BE_TRANSFORM_SIMD BE_TRANSFORM_SIMD_AVX
+    #elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+        #define BE_TRANSFORM_SIMD BE_TRANSFORM_SIMD_SSE
+    #else
+        #define BE_TRANSFORM_SIMD BE_TRANSFORM_SIMD_SCALAR
+    #endif
+#endif
+
+#if BE_TRANSFORM_SIMD == BE_TRANSFORM_SIMD_AVX
+    #include <immintrin.h>
+#elif BE_TRANSFORM_SIMD == BE_TRANSFORM_SIMD_SSE
+    #include <xmmintrin.h>
+#endif
+
+#define BE_TRANSFORM_ALIGN 64
+#define BE_TRANSFORM_LANES 8 // capacity is kept a multiple of this so kernels never need a tail
+
+typedef struct {
+    float* px; float* py; float* pz;
+    float* qx; float* qy; float* qz; float* qw;
+    float* sx; float* sy; float* sz;
+    mat4* world;
+
+    size_t size;
+    size_t capacity;
+} BE_TransformStore;
+
+static inline void BE_TransformStoreInit(BE_TransformStore* store) {
+    memset(store, 0, sizeof(BE_TransformStore));
+}
+
+static inline void BE_TransformStoreFree(BE_TransformStore* store) {
+    float** streams[10] = {&store->px, &store->py, &store->pz, &store->qx, &store->qy, &store->qz, &store->qw, &store->sx, &store->sy, &store->sz};
+    for (int i = 0; i < 10; i++) {
+        BE_AlignedFree(*streams[i]);
+        *streams[i] = NULL;
+    }
+    BE_AlignedFree(store->world);
+    store->world = NULL;
+    store->size = 0;
+    store->capacity = 0;
+}
+
+static inline void BE_TransformStoreReserve(BE_TransformStore* store, size_t count) {
+    if (count <= store->capacity) return;
+
+    size_t capacity = store->capacity ? store->capacity : 64;
+    while (capacity < count) capacity *= 2;
+    capacity = (capacity + BE_TRANSFORM_LANES - 1) & ~(size_t)(BE_TRANSFORM_LANES - 1);
+
+    float** streams[10] = {&store->px, &store->py, &store->pz, &store->qx, &store->qy, &store->qz, &store->qw, &store->sx, &store->sy, &store->sz};
+    for (int i = 0; i < 10; i++) {
+        float* data = (float*)BE_AlignedAlloc(sizeof(float) * capacity, BE_TRANSFORM_ALIGN, BE_MEMORY_SCENE);
+        if (store->size) memcpy(data, *streams[i], sizeof(float) * store->size);
+        // Padding lanes hold an identity transform so kernels can run past size (qw and scale are 1)
+        float fill = i >= 6 ? 1.0f : 0.0f;
+        for (size_t k = store->size; k < capacity; k++) data[k] = fill;
+        BE_AlignedFree(*streams[i]);
+        *streams[i] = data;
+    }
+
+    mat4* world = (mat4*)BE_AlignedAlloc(sizeof(mat4) * capacity, BE_TRANSFORM_ALIGN, BE_MEMORY_SCENE);
+    if (store->size) memcpy(world, store->world, sizeof(mat4) * store->size);
+    BE_AlignedFree(store->world);
+    store->world = world;
+
+    store->capacity = capacity;
+}
+
+static inline size_t BE_TransformStorePush(BE_TransformStore* store, vec3 position, versor orientation, vec3 scale) {
+    BE_TransformStoreReserve(store, store->size + 1);
+    size_t i = store->size++;
+    store->px[i] = position[0]; store->py[i] = position[1]; store->pz[i] = position[2];
+    store->qx[i] = orientation[0]; store->qy[i] = orientation[1]; store->qz[i] = orientation[2]; store->qw[i] = orientation[3];
+    store->sx[i] = scale[0]; store->sy[i] = scale[1]; store->sz[i] = scale[2];
+    return i;
+}
+
+// Drops the contents but keeps the allocation, padding lanes are reset to identity
+static inline void BE_TransformStoreClear(BE_TransformStore* store) {
+    for (size_t i = 0; i < store->size; i++) {
+        store->px[i] = store->py[i] = store->pz[i] = 0.0f;
+        store->qx[i] = store->qy[i] = store->qz[i] = 0.0f;
+        store->qw[i] = 1.0f;
+        store->sx[i] = store->sy[i] = store->sz[i] = 1.0f;
+    }
+    store->size = 0;
+}
+
+// world = Translation * Rotation * Scale, same result as BE_TransformUpdateMatrix
+static inline void BE_TransformStoreComposeScalar(BE_TransformStore* store, size_t first, size_t count) {
+    for (size_t i = first; i < first + count; i++) {
+        float x = store->qx[i], y = store->qy[i], z = store->qz[i], w = store->qw[i];
+        float xx = x * x, yy = y * y, zz = z * z;
+        float xy = x * y, xz = x * z, yz = y * z;
+        float wx = w * x, wy = w * y, wz = w * z;
+        float* m = (float*)store->world[i];
+
+        m[0]  = (1.0f - 2.0f * (yy + zz)) * store->sx[i];
+        m[1]  = 2.0f * (xy + wz) * store->sx[i];
+        m[2]  = 2.0f * (xz - wy) * store->sx[i];
+        m[3]  = 0.0f;
+        m[4]  = 2.0f * (xy - wz) * store->sy[i];
+        m[5]  = (1.0f - 2.0f * (xx + zz)) * store->sy[i];
+        m[6]  = 2.0f * (yz + wx) * store->sy[i];
+        m[7]  = 0.0f;
+        m[8]  = 2.0f * (xz + wy) * store->sz[i];
+        m[9]  = 2.0f * (yz - wx) * store->sz[i];
+        m[10] = (1.0f - 2.0f * (xx + yy)) * store->sz[i];
+        m[11] = 0.0f;
+        m[12] = store->px[i];
+        m[13] = store->py[i];
+        m[14] = store->pz[i];
+        m[15] = 1.0f;
+    }
+}
+
+#if BE_TRANSFORM_SIMD == BE_TRANSFORM_SIMD_SSE
+
+// 4 transforms per iteration, matrix elements are built across lanes then transposed into columns
+static inline void BE_TransformStoreComposeSSE(BE_TransformStore* store, size_t first, size_t count) {
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 two = _mm_set1_ps(2.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    size_t end = first + count;
+    size_t i = first;
+    for (; i < end && (i & 3); i++) BE_TransformStoreComposeScalar(store, i, 1);
+
+    for (; i < end; i += 4) {
+        __m128 x = _mm_load_ps(store->qx + i), y = _mm_load_ps(store->qy + i);
+        __m128 z = _mm_load_ps(store->qz + i), w = _mm_load_ps(store->qw + i);
+        __m128 sx = _mm_load_ps(store->sx + i), sy = _mm_load_ps(store->sy + i), sz = _mm_load_ps(store->sz + i);
+
+        __m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+        __m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+        __m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+        __m128 c0[4], c1[4], c2[4], c3[4];
+        c0[0] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+        c0[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+        c0[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+        c0[3] = zero;
+        c1[0] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+        c1[1] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+        c1[2] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+        c1[3] = zero;
+        c2[0] = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+        c2[1] = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+        c2[2] = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+        c2[3] = zero;
+        c3[0] = _mm_load_ps(store->px + i);
+        c3[1] = _mm_load_ps(store->py + i);
+        c3[2] = _mm_load_ps(store->pz + i);
+        c3[3] = one;
+
+        _MM_TRANSPOSE4_PS(c0[0], c0[1], c0[2], c0[3]);
+        _MM_TRANSPOSE4_PS(c1[0], c1[1], c1[2], c1[3]);
+        _MM_TRANSPOSE4_PS(c2[0], c2[1], c2[2], c2[3]);
+        _MM_TRANSPOSE4_PS(c3[0], c3[1], c3[2], c3[3]);
+
+        for (int k = 0; k < 4; k++) {
+            float* m = (float*)store->world[i + k];
+            _mm_store_ps(m, c0[k]);
+            _mm_store_ps(m + 4, c1[k]);
+            _mm_store_ps(m + 8, c2[k]);
+            _mm_store_ps(m + 12, c3[k]);
+        }
+    }
+}
+
+#endif
+
+#if BE_TRANSFORM_SIMD == BE_TRANSFORM_SIMD_AVX
+
+// 8 transforms per iteration, each 128-bit half transposes its own 4 objects
+static inline void BE_TransformStoreComposeAVX(BE_TransformStore* store, size_t first, size_t count) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 two = _mm256_set1_ps(2.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    size_t end = first + count;
+    size_t i = first;
+    for (; i < end && (i & 7); i++) BE_TransformStoreComposeScalar(store, i, 1);
+
+    for (; i < end; i += 8) {
+        __m256 x = _mm256_load_ps(store->qx + i), y = _mm256_load_ps(store->qy + i);
+        __m256 z = _mm256_load_ps(store->qz + i), w = _mm256_load_ps(store->qw + i);
+        __m256 sx = _mm256_load_ps(store->sx + i), sy = _mm256_load_ps(store->sy + i), sz = _mm256_load_ps(store->sz + i);
+
+        __m256 xx = _mm256_mul_ps(x, x), yy = _mm256_mul_ps(y, y), zz = _mm256_mul_ps(z, z);
+        __m256 xy = _mm256_mul_ps(x, y), xz = _mm256_mul_ps(x, z), yz = _mm256_mul_ps(y, z);
+        __m256 wx = _mm256_mul_ps(w, x), wy = _mm256_mul_ps(w, y), wz = _mm256_mul_ps(w, z);
+
+        __m256 cols[4][4];
+        cols[0][0] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(yy, zz))), sx);
+        cols[0][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xy, wz)), sx);
+        cols[0][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xz, wy)), sx);
+        cols[0][3] = zero;
+        cols[1][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(xy, wz)), sy);
+        cols[1][1] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, zz))), sy);
+        cols[1][2] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(yz, wx)), sy);
+        cols[1][3] = zero;
+        cols[2][0] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_add_ps(xz, wy)), sz);
+        cols[2][1] = _mm256_mul_ps(_mm256_mul_ps(two, _mm256_sub_ps(yz, wx)), sz);
+        cols[2][2] = _mm256_mul_ps(_mm256_sub_ps(one, _mm256_mul_ps(two, _mm256_add_ps(xx, yy))), sz);
+        cols[2][3] = zero;
+        cols[3][0] = _mm256_load_ps(store->px + i);
+        cols[3][1] = _mm256_load_ps(store->py + i);
+        cols[3][2] = _mm256_load_ps(store->pz + i);
+        cols[3][3] = one;
+
+        for (int c = 0; c < 4; c++) {
+            __m256 t0 = _mm256_unpacklo_ps(cols[c][0], cols[c][1]);
+            __m256 t1 = _mm256_unpackhi_ps(cols[c][0], cols[c][1]);
+            __m256 t2 = _mm256_unpacklo_ps(cols[c][2], cols[c][3]);
+            __m256 t3 = _mm256_unpackhi_ps(cols[c][2], cols[c][3]);
+            __m256 r[4];
+            r[0] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            r[1] = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            r[2] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            r[3] = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+            for (int k = 0; k < 4; k++) {
+                _mm_store_ps((float*)store->world[i + k] + c * 4, _mm256_castps256_ps128(r[k]));
+                _mm_store_ps((float*)store->world[i + k + 4] + c * 4, _mm256_extractf128_ps(r[k], 1));
+            }
+        }
+    }
+}
+
+#endif
+
+// Composes world matrices for [first, first + count) with the kernel picked at compile time.
+// Rounding count up to a multiple of BE_TRANSFORM_LANES is always safe.
+static inline void BE_TransformStoreCompose(BE_TransformStore* store, size_t first, size_t count) {
+#if BE_TRANSFORM_SIMD == BE_TRANSFORM_SIMD_AVX
+    BE_TransformStoreComposeAVX(store, first, count);
+#elif BE_TRANSFORM_SIMD == BE_TRANSFORM_SIMD_SSE
+    BE_TransformStoreComposeSSE(store, first, count);
+#else
+    BE_TransformStoreComposeScalar(store, first, count);
+#endif
+}
+
+#endif
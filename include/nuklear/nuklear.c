@@ -0,0 +1,41 @@
+// Nuklear and its GLFW/GL4 backend, compiled once. The options must match engine/engine_overlay.c
+#include <engine/glad/glad.h>
+#include <engine/GLFW/glfw3.h>
+
+#define MAX_VERTEX_BUFFER 512 * 1024
+#define MAX_ELEMENT_BUFFER 128 * 1024
+#define NK_INCLUDE_FIXED_TYPES
+#define NK_INCLUDE_STANDARD_IO
+#define NK_INCLUDE_STANDARD_VARARGS
+#define NK_INCLUDE_DEFAULT_ALLOCATOR
+#define NK_INCLUDE_VERTEX_BUFFER_OUTPUT
+#define NK_INCLUDE_FONT_BAKING
+#define NK_INCLUDE_DEFAULT_FONT
+#define NK_IMPLEMENTATION
+#define NK_GLFW_GL4_IMPLEMENTATION
+#define NK_KEYSTATE_BASED_INPUT
+#include "nuklear/nuklear.h"
+#include "nuklear/nuklear_glfw_gl4.h"
+
+// nk_glfw3_new_frame without calling GLFW, which only allows input and window queries on the main
+// thread. The caller reads those there and passes them in, so the frame can be built on any thread.
+void nk_glfw3_new_frame_input(float deltaTime, int width, int height, int displayWidth, int displayHeight,
+                              int cursorX, int cursorY, const int buttons[3])
+{
+    struct nk_context *ctx = &glfw.ctx;
+    glfw.ctx.delta_time_seconds = deltaTime;
+
+    glfw.width = width > 0 ? width : 1;
+    glfw.height = height > 0 ? height : 1;
+    glfw.display_width = displayWidth;
+    glfw.display_height = displayHeight;
+    glfw.fb_scale.x = (float)glfw.display_width/(float)glfw.width;
+    glfw.fb_scale.y = (float)glfw.display_height/(float)glfw.height;
+
+    nk_input_begin(ctx);
+    nk_input_motion(ctx, cursorX, cursorY);
+    nk_input_button(ctx, NK_BUTTON_LEFT, cursorX, cursorY, buttons[0]);
+    nk_input_button(ctx, NK_BUTTON_MIDDLE, cursorX, cursorY, buttons[1]);
+    nk_input_button(ctx, NK_BUTTON_RIGHT, cursorX, cursorY, buttons[2]);
+    nk_input_end(ctx);
+}
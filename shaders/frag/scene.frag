@@ -21,40 +21,36 @@ struct DirectLight {
     mat4 lightSpaceMatrix;
 };
 
-struct PointLight {
-    vec3 position;
+struct Light {
+    vec4 position;
+    vec4 direction;
     vec4 color;
-    float a;
-    float b;
-    float specular;
-
-    mat4 lightSpaceMatrix;
-};
-
-struct SpotLight {
-    vec3 position;
-    vec3 direction;
-    vec4 color;
-
-    float innerCone;
-    float outerCone;
-    float specular;
-
+    vec4 params;
+    vec4 shadowRect;
     mat4 lightSpaceMatrix;
+    int type;
+    int shadowIndex;
+    float farPlane;
+    float pad;
 };
 
 uniform int numDirects;
 uniform DirectLight directlights[10];
 uniform sampler2DArray directShadowMapArray;
 
-uniform int numPoints;
-uniform PointLight pointlights[10];
-uniform sampler2DArray pointShadowMapArray;
+uniform samplerCubeArray pointShadowMapArray;
 
-uniform int numSpots;
-uniform SpotLight spotlights[10];
 uniform sampler2DArray spotShadowMapArray;
 
+layout (std430, binding = 0) readonly buffer LightBuffer { Light lights[]; };
+layout (std430, binding = 1) readonly buffer ClusterGrid { uvec2 clusterGrid[]; };
+layout (std430, binding = 2) readonly buffer ClusterIndices { uint clusterIndices[]; };
+uniform mat4 viewMatrix;
+uniform vec2 clusterScreen;
+uniform float clusterNear;
+uniform float clusterFar;
+const uvec3 clusterDims = uvec3(16, 9, 24);
+
 vec3 calcDirectLight(DirectLight light, vec3 normal, vec3 viewDirection, int index) {
 
     vec3 lightDirection = normalize(-light.direction);
@@ -97,35 +93,58 @@ vec3 calcDirectLight(DirectLight light, vec3 normal, vec3 viewDirection, int ind
     return (texture(diffuse0, texCoord) * diffuse * (1.0f - shadow) + texture(specular0, texCoord).r * specular * (1.0f - shadow)) * light.color;
 }
 
-vec3 calcPointLight(PointLight light, vec3 normal, vec3 viewDirection, int index) {
+vec3 calcPointLight(Light light, vec3 normal, vec3 viewDirection) {
     
-    float dist = length(light.position - crntPos);
-    float inten = 1.0f / (light.a * dist * dist + light.b * dist + 1.0f); 
+    float dist = length(light.position.xyz - crntPos);
+    float inten = 1.0f / (light.params.x * dist * dist + light.params.y * dist + 1.0f); 
 
-    vec3 lightDirection = normalize(light.position - crntPos);
+    vec3 lightDirection = normalize(light.position.xyz - crntPos);
     float diffuse = max(dot(normal, lightDirection), 0.0f);
 
     float specular = 0.0f;
     if (diffuse != 0.0f) {
-		float specularLight = light.specular;
-        vec3 reflectionDirection = reflect(-light.position, normal);
+		float specularLight = light.params.w;
+        vec3 reflectionDirection = reflect(-light.position.xyz, normal);
         vec3 halfwayVec = normalize(viewDirection + lightDirection);
         float specAmount = pow(max(dot(normal, halfwayVec), 0.0f), 16);
         specular = specAmount * specularLight;
     };
 
-    return (texture(diffuse0, texCoord) * (diffuse * inten) + texture(specular0, texCoord).r * specular * inten) * light.color;
+    // Cube maps store distance to the light divided by the far plane
+    float shadow = 0.0f;
+    vec3 fragToLight = crntPos - light.position.xyz;
+    float currentDepth = length(fragToLight);
+    if (light.shadowIndex >= 0 && currentDepth < light.farPlane) {
+        float bias = max(0.05f * (1.0f - dot(normal, lightDirection)), 0.005f);
+        float texelSize = 2.0 * currentDepth / float(textureSize(pointShadowMapArray, 0).x);
+
+        for (int z = -sampleRadius; z <= sampleRadius; z++) {
+            for (int y = -sampleRadius; y <= sampleRadius; y++) {
+                for (int x = -sampleRadius; x <= sampleRadius; x++) {
+                    vec3 sampleDir = fragToLight + vec3(x, y, z) * texelSize;
+                    float closestDepth = texture(pointShadowMapArray, vec4(sampleDir, light.shadowIndex)).r * light.farPlane;
+                    if (currentDepth > closestDepth + bias) {
+                        shadow += 1.0f;
+                    }
+                }
+            }
+        }
+
+        shadow /= pow((sampleRadius * 2. + 1.), 3);
+    }
+
+    return (texture(diffuse0, texCoord) * (diffuse * (1.0f - shadow) * inten) + texture(specular0, texCoord).r * specular * (1.0f - shadow) * inten) * light.color;
 }
 
-vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 viewDirection, int index) { 
+vec3 calcSpotLight(Light light, vec3 normal, vec3 viewDirection) { 
     
-    vec3 lightDirection = normalize(light.position - crntPos);
+    vec3 lightDirection = normalize(light.position.xyz - crntPos);
 
     float diffuse = max(dot(normal, lightDirection), 0.0f);
 
     float specular = 0.0f;
     if (diffuse != 0.0f) {
-        float specularLight = light.specular;
+        float specularLight = light.params.w;
 
 
         vec3 halfwayVec = normalize(viewDirection + lightDirection);
@@ -133,24 +152,29 @@ vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 viewDirection, int index)
         specular = specAmount * specularLight;
     };
 
-    float angle = dot(normalize(-light.direction), lightDirection);
-    float inten = clamp((angle - light.outerCone) / (light.outerCone - light.innerCone), 0.0f, 1.0f);
+    float angle = dot(normalize(-light.direction.xyz), lightDirection);
+    float inten = clamp((angle - light.direction.w) / (light.direction.w - light.params.z), 0.0f, 1.0f);
     
     vec4 fragPosLight = light.lightSpaceMatrix * vec4(crntPos, 1.0);
 
     float shadow = 0.0f;
     vec3 lightCoords = fragPosLight.xyz / fragPosLight.w;
-    if(lightCoords.z <= 1.0f) {
+    if(lightCoords.z <= 1.0f && light.shadowRect.z > 0.0f) {
         lightCoords = (lightCoords + 1.0f) / 2.0f;
 
-        float closestDepth = texture(spotShadowMapArray, vec3(lightCoords.xy, index)).r;
         float currentDepth = lightCoords.z;
         float bias = max(0.005f * (1.0f - dot(normal, lightDirection)), 0.002f);
 
-        vec2 pixelSize = 1.0 / vec2(textureSize(spotShadowMapArray, index).xy);
+        // Keep filter taps inside this light's tile of the atlas
+        vec2 pixelSize = 1.0 / vec2(textureSize(spotShadowMapArray, 0).xy);
+        vec2 tileMin = light.shadowRect.xy + pixelSize * 0.5;
+        vec2 tileMax = light.shadowRect.xy + light.shadowRect.zw - pixelSize * 0.5;
+        vec2 atlasCoords = light.shadowRect.xy + clamp(lightCoords.xy, 0.0, 1.0) * light.shadowRect.zw;
+
         for (int y = -sampleRadius; y <= sampleRadius; y++) {
             for (int x = -sampleRadius; x <= sampleRadius; x++) {
-                float closestDepth = texture(spotShadowMapArray, vec3(lightCoords.xy + vec2(x, y) * pixelSize, index)).r;
+                vec2 sampleCoords = clamp(atlasCoords + vec2(x, y) * pixelSize, tileMin, tileMax);
+                float closestDepth = texture(spotShadowMapArray, vec3(sampleCoords, 0)).r;
                 if (currentDepth > closestDepth + bias) {
                     shadow += 1.0f;
                 }
@@ -163,8 +187,7 @@ vec3 calcSpotLight(SpotLight light, vec3 normal, vec3 viewDirection, int index)
 
     // return (texture(diffuse0, texCoord) * diffuse * (1.0f - shadow) + texture(specular0, texCoord).r * specular * (1.0f - shadow)) * light.color;
 
-    // return (texture(diffuse0, texCoord) * (diffuse * (1.0f - shadow) * inten) + texture(specular0, texCoord).r * specular * (1.0f - shadow) * inten) * light.color;
-    return (texture(diffuse0, texCoord) * (diffuse * inten) + texture(specular0, texCoord).r * specular * inten) * light.color;
+    return (texture(diffuse0, texCoord) * (diffuse * (1.0f - shadow) * inten) + texture(specular0, texCoord).r * specular * (1.0f - shadow) * inten) * light.color;
 }
 
 float near = 0.1f;
@@ -191,12 +214,19 @@ void main() {
         result += calcDirectLight(directlights[i], normal, viewDir, i);   
     }
 
-    for (int i = 0; i < numPoints; i++) {
-        result += calcPointLight(pointlights[i], normal, viewDir, i);   
-    }
-    
-    for (int i = 0; i < numSpots; i++) {
-        result += calcSpotLight(spotlights[i], normal, viewDir, i); 
+    // Only the point and spot lights binned into this fragment's cluster are evaluated
+    float viewDepth = -(viewMatrix * vec4(crntPos, 1.0)).z;
+    uvec2 tile = uvec2(clamp(gl_FragCoord.xy / clusterScreen, 0.0, 0.999) * vec2(clusterDims.xy));
+    uint slice = uint(clamp(log(max(viewDepth, clusterNear) / clusterNear) / log(clusterFar / clusterNear), 0.0, 0.999) * float(clusterDims.z));
+    uvec2 cluster = clusterGrid[tile.x + tile.y * clusterDims.x + slice * clusterDims.x * clusterDims.y];
+
+    for (uint i = 0; i < cluster.y; i++) {
+        Light light = lights[clusterIndices[cluster.x + i]];
+        if (light.type == 1) {
+            result += calcPointLight(light, normal, viewDir);
+        } else {
+            result += calcSpotLight(light, normal, viewDir);
+        }
     }
     
     FragColor = vec4(result, 1.0);
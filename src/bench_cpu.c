@@ -0,0 +1,363 @@
+// CPU hot path microbenchmarks, builds without GL, a window or FMOD: make bench_cpu
+//     bench_cpu [kernel]
+// Each kernel runs over synthetic inputs of a few sizes. A measurement does some untimed warmup
+// runs, then times every repetition on its own and reports min, median, mean with standard
+// deviation and max per run, and the median per item. Inputs come from a fixed seed so numbers
+// from two builds can be compared directly.
+
+#include "engine/engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#define BENCH_WARMUP 3
+#define BENCH_REPS 15
+#define BENCH_MAX_REPS 64
+#define BENCH_OBJ_PATH "bench_cpu.obj"
+#define BENCH_MTL_PATH "bench_cpu.mtl"
+
+typedef void (*BenchKernel)(void* arg);
+
+static volatile double benchSink; // keeps results from being optimized away
+
+static int BenchCompareDouble(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+static float BenchRandom() {
+    return (float)rand() / (float)RAND_MAX;
+}
+
+static void BenchMeasure(const char* kernel, const char* size, size_t items, int reps, BenchKernel function, void* arg) {
+    if (reps > BENCH_MAX_REPS) reps = BENCH_MAX_REPS;
+    for (int i = 0; i < BENCH_WARMUP; i++) function(arg);
+
+    double samples[BENCH_MAX_REPS];
+    for (int r = 0; r < reps; r++) {
+        uint64_t start = BE_ThreadClockNs();
+        function(arg);
+        samples[r] = (double)(BE_ThreadClockNs() - start) * 1e-3;
+    }
+
+    qsort(samples, reps, sizeof(double), BenchCompareDouble);
+    double sum = 0.0, squares = 0.0;
+    for (int r = 0; r < reps; r++) sum += samples[r];
+    double mean = sum / reps;
+    for (int r = 0; r < reps; r++) squares += (samples[r] - mean) * (samples[r] - mean);
+    double stddev = reps > 1 ? sqrt(squares / (reps - 1)) : 0.0;
+    double median = reps % 2 ? samples[reps / 2] : (samples[reps / 2 - 1] + samples[reps / 2]) * 0.5;
+
+    printf("  %-14s %-16s %9.1f %9.1f %9.1f ±%7.1f %9.1f  %10.1f ns/item\n", kernel, size, samples[0], median, mean, stddev,
+           samples[reps - 1], median * 1e3 / (double)(items ? items : 1));
+}
+
+// ==============================
+// OBJ and MTL parsing
+// ==============================
+
+// A side x side grid of quads with positions, uvs and one shared normal, like an exported terrain
+static void BenchWriteGridOBJ(const char* path, int side) {
+    FILE* file = fopen(path, "w");
+    for (int z = 0; z <= side; z++) {
+        for (int x = 0; x <= side; x++) fprintf(file, "v %f %f %f\n", (float)x, BenchRandom() * 0.1f, (float)z);
+    }
+    for (int z = 0; z <= side; z++) {
+        for (int x = 0; x <= side; x++) fprintf(file, "vt %f %f\n", (float)x / side, (float)z / side);
+    }
+    fprintf(file, "vn 0 1 0\n");
+    for (int z = 0; z < side; z++) {
+        for (int x = 0; x < side; x++) {
+            int a = z * (side + 1) + x + 1, b = a + 1, c = a + side + 2, d = a + side + 1;
+            fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, b, b, c, c, d, d);
+        }
+    }
+    fclose(file);
+}
+
+static void BenchParseOBJ(void* arg) {
+    BE_OBJData data;
+    if (!BE_ParseOBJ((const char*)arg, &data)) exit(1);
+    benchSink += data.verticesCount + data.indicesCount;
+    // BE_OBJDataFree also frees the image, which lives with the GL half of the engine
+    BE_MemFree(data.vertices);
+    BE_MemFree(data.indices);
+    BE_MemFree(data.texturePath);
+    BE_MemFree(data.textureType);
+}
+
+static void BenchWriteMTL(const char* path, int maps) {
+    FILE* file = fopen(path, "w");
+    for (int i = 0; i < maps; i++) fprintf(file, "%s textures/material_%d.png\n", i % 2 ? "map_Ks" : "map_Kd", i / 2);
+    fclose(file);
+}
+
+static void BenchParseMTL(void* arg) {
+    int count = 0;
+    const char** textures = BE_LoadMTLTextures((const char*)arg, &count);
+    for (int i = 0; i < count; i++) BE_MemFree((void*)textures[i]);
+    BE_MemFree(textures);
+    benchSink += count;
+}
+
+static void BenchRunImport(const char* kernel) {
+    static const int sides[] = { 8, 32, 64 };
+    bool all = !kernel;
+    if (all || strcmp(kernel, "obj") == 0) {
+        for (int i = 0; i < 3; i++) {
+            BenchWriteGridOBJ(BENCH_OBJ_PATH, sides[i]);
+            char size[32];
+            snprintf(size, sizeof(size), "%dx%d quads", sides[i], sides[i]);
+            BenchMeasure("obj", size, (size_t)sides[i] * sides[i], sides[i] > 32 ? 5 : BENCH_REPS, BenchParseOBJ, BENCH_OBJ_PATH);
+        }
+        remove(BENCH_OBJ_PATH);
+    }
+
+    // The loader keeps room for 50 entries, two per map
+    static const int maps[] = { 2, 8, 24 };
+    if (all || strcmp(kernel, "mtl") == 0) {
+        for (int i = 0; i < 3; i++) {
+            BenchWriteMTL(BENCH_MTL_PATH, maps[i]);
+            char size[32];
+            snprintf(size, sizeof(size), "%d maps", maps[i]);
+            BenchMeasure("mtl", size, (size_t)maps[i], BENCH_REPS, BenchParseMTL, BENCH_MTL_PATH);
+        }
+        remove(BENCH_MTL_PATH);
+    }
+}
+
+// ==============================
+// Vertex dedup
+// ==============================
+
+typedef struct {
+    BE_Vertex* stream;  // six corners per quad, in the order the OBJ parser emits them
+    int streamCount;
+    BE_Vertex* unique;
+} BenchDedup;
+
+static void BenchDedupRun(void* arg) {
+    BenchDedup* bench = (BenchDedup*)arg;
+    int count = 0;
+    for (int i = 0; i < bench->streamCount; i++) benchSink += BE_FindOrAddVertex(bench->unique, &count, bench->stream[i]);
+}
+
+static void BenchRunDedup() {
+    static const int sides[] = { 16, 32, 64 };
+    for (int s = 0; s < 3; s++) {
+        int side = sides[s];
+        BenchDedup bench;
+        bench.streamCount = side * side * 6;
+        bench.stream = (BE_Vertex*)calloc(bench.streamCount, sizeof(BE_Vertex));
+        bench.unique = (BE_Vertex*)calloc(bench.streamCount, sizeof(BE_Vertex));
+
+        static const int corners[6][2] = { {1, 0}, {0, 0}, {1, 1}, {1, 1}, {0, 0}, {0, 1} };
+        int n = 0;
+        for (int z = 0; z < side; z++) {
+            for (int x = 0; x < side; x++) {
+                for (int k = 0; k < 6; k++) {
+                    BE_Vertex* v = &bench.stream[n++];
+                    glm_vec3_copy((vec3){(float)(x + corners[k][0]), 0.0f, (float)(z + corners[k][1])}, v->position);
+                    glm_vec3_copy((vec3){0.0f, 1.0f, 0.0f}, v->normal);
+                    glm_vec3_copy((vec3){1.0f, 1.0f, 1.0f}, v->color);
+                    v->texUV[0] = (float)(x + corners[k][0]) / side;
+                    v->texUV[1] = (float)(z + corners[k][1]) / side;
+                }
+            }
+        }
+
+        char size[32];
+        snprintf(size, sizeof(size), "%d unique", (side + 1) * (side + 1));
+        BenchMeasure("dedup", size, (size_t)bench.streamCount, side > 32 ? 5 : BENCH_REPS, BenchDedupRun, &bench);
+        free(bench.stream);
+        free(bench.unique);
+    }
+}
+
+// ==============================
+// Transforms, cameras and lights
+// ==============================
+
+typedef struct {
+    BE_Transform* transforms;
+    mat4* matrices;
+    size_t count;
+} BenchTransforms;
+
+static void BenchTransformRun(void* arg) {
+    BenchTransforms* bench = (BenchTransforms*)arg;
+    for (size_t i = 0; i < bench->count; i++) BE_TransformUpdateMatrix(&bench->transforms[i], bench->matrices[i]);
+    benchSink += bench->matrices[bench->count - 1][3][0];
+}
+
+static void BenchCameraRun(void* arg) {
+    BE_CameraVector* cameras = (BE_CameraVector*)arg;
+    BE_CameraVectorUpdateMatrix(cameras, 1280, 720);
+    benchSink += BE_CameraVectorAt(cameras, 0)->projPersp[0][0];
+}
+
+typedef struct {
+    BE_LightVector vec;
+    BE_GPULight* packed;
+} BenchLights;
+
+static void BenchLightRun(void* arg) {
+    BenchLights* bench = (BenchLights*)arg;
+    for (size_t i = 0; i < bench->vec.size; i++) BE_LightPackGPU(&bench->vec, &bench->vec.data[i], &bench->packed[i]);
+    benchSink += bench->packed[bench->vec.size - 1].position[3];
+}
+
+static void BenchRunMath(const char* kernel) {
+    bool all = !kernel;
+    char size[32];
+
+    static const size_t transformCounts[] = { 1024, 16384, 262144 };
+    if (all || strcmp(kernel, "transform") == 0) {
+        for (int s = 0; s < 3; s++) {
+            BenchTransforms bench = { (BE_Transform*)malloc(sizeof(BE_Transform) * transformCounts[s]),
+                                      (mat4*)malloc(sizeof(mat4) * transformCounts[s]), transformCounts[s] };
+            for (size_t i = 0; i < bench.count; i++) {
+                vec3 euler = { BenchRandom() * 6.28f, BenchRandom() * 6.28f, BenchRandom() * 6.28f };
+                bench.transforms[i] = BE_TransformInit((vec3){BenchRandom() * 100.0f, BenchRandom() * 100.0f, BenchRandom() * 100.0f},
+                                                       euler, (vec3){1.0f, 1.0f + BenchRandom(), 1.0f});
+            }
+            snprintf(size, sizeof(size), "%zu", bench.count);
+            BenchMeasure("transform", size, bench.count, BENCH_REPS, BenchTransformRun, &bench);
+            free(bench.transforms);
+            free(bench.matrices);
+        }
+    }
+
+    static const int cameraCounts[] = { 1, 16, 256 };
+    if (all || strcmp(kernel, "camera") == 0) {
+        for (int s = 0; s < 3; s++) {
+            BE_CameraVector cameras;
+            BE_CameraVectorInit(&cameras);
+            for (int i = 0; i < cameraCounts[s]; i++) {
+                char name[32];
+                snprintf(name, sizeof(name), "camera%d", i);
+                vec3 direction = { BenchRandom() - 0.5f, BenchRandom() - 0.5f, -1.0f };
+                BE_CameraVectorPush(&cameras, BE_CameraInit(name, 1280, 720, 45.0f, 0.1f, 100.0f,
+                                                            (vec3){BenchRandom() * 10.0f, 2.0f, BenchRandom() * 10.0f}, direction));
+            }
+            snprintf(size, sizeof(size), "%d", cameraCounts[s]);
+            BenchMeasure("camera", size, (size_t)cameraCounts[s], BENCH_REPS, BenchCameraRun, &cameras);
+            for (size_t i = 0; i < cameras.pool.size; i++) BE_MemFree(BE_CameraVectorAt(&cameras, i)->name);
+            BE_CameraVectorFree(&cameras);
+        }
+    }
+
+    static const size_t lightCounts[] = { 64, 1024, 16384 };
+    if (all || strcmp(kernel, "light") == 0) {
+        for (int s = 0; s < 3; s++) {
+            // Only the shadow layout is read besides the lights themselves
+            BenchLights bench;
+            memset(&bench.vec, 0, sizeof(BE_LightVector));
+            bench.vec.pointShadowFBO.layers = 8 * 6;
+            bench.vec.spotAtlas.size = 4096;
+            bench.vec.data = (BE_Light*)calloc(lightCounts[s], sizeof(BE_Light));
+            bench.vec.size = lightCounts[s];
+            bench.packed = (BE_GPULight*)malloc(sizeof(BE_GPULight) * lightCounts[s]);
+            for (size_t i = 0; i < bench.vec.size; i++) {
+                BE_Light* light = &bench.vec.data[i];
+                light->type = i % 3 ? BE_LIGHT_POINT : BE_LIGHT_SPOT;
+                glm_vec3_copy((vec3){BenchRandom() * 50.0f, BenchRandom() * 5.0f, BenchRandom() * 50.0f}, light->position);
+                glm_vec3_copy((vec3){0.0f, -1.0f, BenchRandom() - 0.5f}, light->direction);
+                glm_vec4_copy((vec4){BenchRandom(), BenchRandom(), BenchRandom(), 1.0f}, light->color);
+                light->a = 0.1f + BenchRandom();
+                light->b = 0.05f;
+                light->innerCone = 0.95f;
+                light->outerCone = 0.9f;
+                light->shadowLayer = (int)(i % 16) - 4;
+                for (int k = 0; k < 4; k++) light->shadowTile[k] = (int)(i * 64) % 4096;
+            }
+            snprintf(size, sizeof(size), "%zu", lightCounts[s]);
+            BenchMeasure("light pack", size, lightCounts[s], BENCH_REPS, BenchLightRun, &bench);
+            free(bench.vec.data);
+            free(bench.packed);
+        }
+    }
+}
+
+// ==============================
+// Name lookups
+// ==============================
+
+typedef struct {
+    BE_CameraVector cameras;
+    char** names;
+    int count;
+} BenchLookup;
+
+static void BenchLookupRun(void* arg) {
+    BenchLookup* bench = (BenchLookup*)arg;
+    size_t found = 0;
+    for (int i = 0; i < bench->count; i++) found += BE_FindCameraPtr(&bench->cameras, bench->names[i]) != NULL;
+    benchSink += (double)found;
+}
+
+static void BenchRunLookups() {
+    static const int counts[] = { 16, 1024, 65536 };
+    for (int s = 0; s < 3; s++) {
+        BenchLookup bench;
+        bench.count = counts[s];
+        BE_CameraVectorInit(&bench.cameras);
+        for (int i = 0; i < bench.count; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "object %d", i);
+            BE_CameraVectorPush(&bench.cameras, BE_CameraInit(name, 1, 1, 45.0f, 0.1f, 100.0f, (vec3){0.0f, 0.0f, 0.0f}, (vec3){0.0f, 0.0f, -1.0f}));
+        }
+
+        // Hits in a shuffled order so the probe isn't helped by insertion order, then as many misses
+        bench.names = (char**)malloc(sizeof(char*) * bench.count);
+        for (int i = 0; i < bench.count; i++) bench.names[i] = BE_CameraVectorAt(&bench.cameras, i)->name;
+        for (int i = bench.count - 1; i > 0; i--) {
+            int j = rand() % (i + 1);
+            char* name = bench.names[i];
+            bench.names[i] = bench.names[j];
+            bench.names[j] = name;
+        }
+        char size[32];
+        snprintf(size, sizeof(size), "%d hit", bench.count);
+        BenchMeasure("find", size, (size_t)bench.count, BENCH_REPS, BenchLookupRun, &bench);
+
+        for (int i = 0; i < bench.count; i++) {
+            char name[32];
+            snprintf(name, sizeof(name), "missing %d", i);
+            bench.names[i] = BE_MemStrdup(name, BE_MEMORY_GENERAL);
+        }
+        snprintf(size, sizeof(size), "%d miss", bench.count);
+        BenchMeasure("find", size, (size_t)bench.count, BENCH_REPS, BenchLookupRun, &bench);
+
+        for (int i = 0; i < bench.count; i++) {
+            BE_MemFree(bench.names[i]);
+            BE_MemFree(BE_CameraVectorAt(&bench.cameras, i)->name);
+        }
+        free(bench.names);
+        BE_CameraVectorFree(&bench.cameras);
+    }
+}
+
+int main(int argc, char** argv) {
+
+    const char* kernel = argc > 1 ? argv[1] : NULL;
+    static const char* kernels[] = { "obj", "mtl", "dedup", "transform", "camera", "light", "find" };
+    bool known = !kernel;
+    for (int i = 0; i < 7 && !known; i++) known = strcmp(kernel, kernels[i]) == 0;
+    if (!known) {
+        fprintf(stderr, "usage: %s [obj|mtl|dedup|transform|camera|light|find]\n", argv[0]);
+        return 2;
+    }
+
+    srand(1);
+    printf("%d warmup runs, %d timed (5 for the largest quadratic inputs), microseconds per run\n", BENCH_WARMUP, BENCH_REPS);
+    printf("  %-14s %-16s %9s %9s %9s %8s %9s\n", "kernel", "size", "min", "median", "mean", "stddev", "max");
+
+    if (!kernel || strcmp(kernel, "obj") == 0 || strcmp(kernel, "mtl") == 0) BenchRunImport(kernel);
+    if (!kernel || strcmp(kernel, "dedup") == 0) BenchRunDedup();
+    if (!kernel || strcmp(kernel, "transform") == 0 || strcmp(kernel, "camera") == 0 || strcmp(kernel, "light") == 0) BenchRunMath(kernel);
+    if (!kernel || strcmp(kernel, "find") == 0) BenchRunLookups();
+
+    return 0;
+}
@@ -0,0 +1,95 @@
+// ECS iteration benchmark, builds without GL: make bench_ecs
+// Streams position += velocity * dt over 1M entities and compares the rate against a plain
+// memory copy of the same bytes, serial and on every hardware thread.
+
+#include "engine/engine_ecs.h"
+
+#include <stdio.h>
+
+#define BENCH_ENTITIES (1 << 20)
+#define BENCH_ROUNDS 20
+
+typedef struct { float x, y, z; } BenchPosition;
+typedef struct { float x, y, z; } BenchVelocity;
+typedef struct { int value; } BenchTag;
+
+static int positionId, velocityId;
+
+static void BenchMoveSystem(BE_EcsView* view, void* arg) {
+    float dt = *(float*)arg;
+    BenchPosition* position = BE_ECS_COLUMN(view, BenchPosition, positionId);
+    BenchVelocity* velocity = BE_ECS_COLUMN(view, BenchVelocity, velocityId);
+    for (size_t i = 0; i < view->count; i++) {
+        position[i].x += velocity[i].x * dt;
+        position[i].y += velocity[i].y * dt;
+        position[i].z += velocity[i].z * dt;
+    }
+}
+
+static double BenchEach(BE_World* world, BE_EcsQuery* query, BE_Jobs* jobs) {
+    float dt = 0.016f;
+    BE_WorldEachParallel(world, query, jobs, BenchMoveSystem, &dt); // warm up
+
+    uint64_t start = BE_ThreadClockNs();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        BE_WorldEachParallel(world, query, jobs, BenchMoveSystem, &dt);
+    }
+    return (double)(BE_ThreadClockNs() - start) * 1e-6 / BENCH_ROUNDS;
+}
+
+int main() {
+
+    BE_World world;
+    BE_WorldInit(&world);
+    positionId = BE_WorldRegisterComponent(&world, "position", sizeof(BenchPosition), _Alignof(BenchPosition));
+    velocityId = BE_WorldRegisterComponent(&world, "velocity", sizeof(BenchVelocity), _Alignof(BenchVelocity));
+    int tagId = BE_WorldRegisterComponent(&world, "tag", sizeof(BenchTag), _Alignof(BenchTag));
+
+    // A quarter carry an extra component so the query spans two archetypes
+    BE_ComponentMask moving = BE_COMPONENT_BIT(positionId) | BE_COMPONENT_BIT(velocityId);
+    for (size_t i = 0; i < BENCH_ENTITIES; i++) {
+        BE_Entity entity = BE_WorldCreate(&world, (i & 3) ? moving : moving | BE_COMPONENT_BIT(tagId));
+        BenchVelocity* velocity = (BenchVelocity*)BE_WorldWrite(&world, entity, velocityId);
+        velocity->x = (float)(i % 7);
+        velocity->y = 1.0f;
+        velocity->z = -1.0f;
+    }
+
+    BE_EcsQuery query;
+    BE_EcsQueryInit(&query, moving, 0);
+    query.write = BE_COMPONENT_BIT(positionId);
+
+    // Reference: the system reads position and velocity and writes position back, a copy of
+    // half as many bytes moves the same amount through memory
+    size_t bytes = (size_t)BENCH_ENTITIES * (sizeof(BenchPosition) * 2 + sizeof(BenchVelocity));
+    unsigned char* src = (unsigned char*)malloc(bytes);
+    unsigned char* dst = (unsigned char*)malloc(bytes);
+    memset(src, 1, bytes);
+    memcpy(dst, src, bytes);
+    uint64_t start = BE_ThreadClockNs();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        memcpy(dst, src, bytes / 2);
+        src[r] = dst[r]; // keeps the copies from being merged
+    }
+    double copyMs = (double)(BE_ThreadClockNs() - start) * 1e-6 / BENCH_ROUNDS;
+
+    int hardware = BE_ThreadHardwareCount();
+    BE_Jobs* jobs = (BE_Jobs*)malloc(sizeof(BE_Jobs));
+    BE_JobsInit(jobs, hardware);
+
+    double serialMs = BenchEach(&world, &query, NULL);
+    double parallelMs = BenchEach(&world, &query, jobs);
+
+    printf("ecs: %zu entities, %zu archetypes, %d rounds\n", BE_EcsQueryCount(&world, &query), world.archetypeCount, BENCH_ROUNDS);
+    printf("  memcpy          %8.2f ms  %6.2f GB/s\n", copyMs, bytes / (copyMs * 1e6));
+    printf("  each (1 thread) %8.2f ms  %6.2f GB/s\n", serialMs, bytes / (serialMs * 1e6));
+    printf("  each (%2d)       %8.2f ms  %6.2f GB/s\n", jobs->workerCount, parallelMs, bytes / (parallelMs * 1e6));
+
+    BE_JobsFree(jobs);
+    free(jobs);
+    free(src);
+    free(dst);
+    BE_EcsQueryFree(&query);
+    BE_WorldFree(&world);
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Job system scaling benchmark, builds without GL: make bench_jobs
+// Runs the same parallel_for workloads with 1, 2, 4 ... workers and reports speedup against one.
+
+#include "engine/engine_jobs.h"
+#include "engine/engine_transform.h"
+
+#include <stdio.h>
+
+#define BENCH_ITEMS (1 << 20)
+#define BENCH_TRANSFORMS (1 << 18)
+#define BENCH_ROUNDS 10
+
+typedef struct {
+    float* values;
+} BenchCompute;
+
+// Compute bound, no shared writes
+static void BenchComputeJob(void* arg, size_t begin, size_t end) {
+    BenchCompute* bench = (BenchCompute*)arg;
+    for (size_t i = begin; i < end; i++) {
+        float x = (float)i * 0.001f;
+        for (int k = 0; k < 64; k++) x = x * 0.999f + sinf(x) * 0.01f;
+        bench->values[i] = x;
+    }
+}
+
+static void BenchComposeJob(void* arg, size_t begin, size_t end) {
+    BE_TransformStoreCompose((BE_TransformStore*)arg, begin, end - begin);
+}
+
+static double BenchRun(BE_Jobs* jobs, size_t count, size_t grain, BE_JobFunction function, void* arg) {
+    BE_JobsParallelFor(jobs, count, grain, function, arg); // warm up
+
+    uint64_t start = BE_ThreadClockNs();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        BE_JobsParallelFor(jobs, count, grain, function, arg);
+    }
+    return (double)(BE_ThreadClockNs() - start) * 1e-6 / BENCH_ROUNDS;
+}
+
+int main() {
+
+    BenchCompute compute = {(float*)malloc(sizeof(float) * BENCH_ITEMS)};
+
+    BE_TransformStore store;
+    BE_TransformStoreInit(&store);
+    for (size_t i = 0; i < BENCH_TRANSFORMS; i++) {
+        versor q;
+        glm_quatv(q, (float)i * 0.01f, (vec3){0.0f, 1.0f, 0.0f});
+        BE_TransformStorePush(&store, (vec3){(float)i, 0.0f, 0.0f}, q, (vec3){1.0f, 1.0f, 1.0f});
+    }
+
+    int hardware = BE_ThreadHardwareCount();
+    double computeBase = 0.0, composeBase = 0.0;
+
+    printf("jobs: %d hardware threads, %d rounds\n", hardware, BENCH_ROUNDS);
+    printf("  workers  compute ms  speedup  compose ms  speedup  utilization\n");
+
+    for (int workers = 1; ; workers *= 2) {
+        if (workers > hardware) workers = hardware;
+
+        BE_Jobs* jobs = (BE_Jobs*)malloc(sizeof(BE_Jobs));
+        BE_JobsInit(jobs, workers);
+
+        double computeMs = BenchRun(jobs, BENCH_ITEMS, 1024, BenchComputeJob, &compute);
+        BE_JobsResetStats(jobs);
+        double composeMs = BenchRun(jobs, BENCH_TRANSFORMS, 512, BenchComposeJob, &store);
+
+        float utilization = 0.0f;
+        for (int i = 0; i < jobs->workerCount; i++) {
+            BE_JobStats stats;
+            BE_JobsGetStats(jobs, i, &stats);
+            utilization += stats.utilization;
+        }
+        utilization /= (float)jobs->workerCount;
+
+        if (workers == 1) {
+            computeBase = computeMs;
+            composeBase = composeMs;
+        }
+
+        printf("  %7d  %10.2f  %6.2fx  %10.2f  %6.2fx  %10.0f%%\n", jobs->workerCount,
+               computeMs, computeBase / computeMs, composeMs, composeBase / composeMs, utilization * 100.0f);
+
+        BE_JobsFree(jobs);
+        free(jobs);
+
+        if (workers == hardware) break;
+    }
+
+    BE_TransformStoreFree(&store);
+    free(compute.values);
+    return 0;
+}
@@ -0,0 +1,443 @@
+// Scene benchmark runner, renders headless so it runs on build machines: make bench
+//     bench_scenes [--out report.json] [--compare baseline.json] [--threshold percent] scene.bench...
+// Each script is loaded into a fresh engine and rendered for a fixed number of frames with the
+// camera on an orbit that depends only on the frame index, so two runs draw the same frames.
+// The report has frame time percentiles, load times, the memory the scene added, render counters
+// and GPU pass times per scene. With --compare the report is checked against an earlier one and
+// the exit code is 1 if anything got worse by more than the threshold.
+//
+// Scripts hold one command per line, # starts a comment:
+//     frames 600                      measured frames, at most FRAME_TIME_HISTORY
+//     warmup 60                       frames rendered before measuring
+//     size 1280 720
+//     shadows on                      or off
+//     renderthread on                 replay frames on the render thread, off by default
+//     orbit 0 0.5 0  6 2  1           center xyz, radius, height, turns over the run
+//     mesh scene res/models/scene.obj
+//     texture box res/textures/box.png
+//     model name mesh x y z
+//     grid mesh 6 6 6                 columns, rows, spacing, models centered on the origin
+//     light sun direct 0.3 -0.8 0.2   direction for direct lights, position otherwise
+
+#include "engine/engine.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BENCH_MAX_LINES 256
+#define BENCH_MAX_LOADS 64
+#define BENCH_NAME 64
+#define BENCH_DEFAULT_THRESHOLD 10.0
+
+typedef struct {
+    char name[BENCH_NAME];
+    double ms;
+} BenchLoad;
+
+typedef struct {
+    char name[BENCH_NAME];
+    const char* path;
+    int frames, warmup;
+    int width, height;
+    bool shadows;
+    bool renderThread;
+    vec3 orbitCenter;
+    float orbitRadius, orbitHeight, orbitTurns;
+
+    char* lines[BENCH_MAX_LINES];
+    int lineNumbers[BENCH_MAX_LINES];
+    int lineCount;
+} BenchScene;
+
+// Checked by --compare, everything is worse when it grows. Timings get a little absolute
+// slack so sub-millisecond noise on a fast scene doesn't count as a regression.
+typedef struct {
+    const char* section;
+    const char* key;
+    double slack;
+} BenchMetric;
+
+static const BenchMetric benchMetrics[] = {
+    { "frameMs", "p50", 0.05 },
+    { "frameMs", "p95", 0.05 },
+    { "frameMs", "p99", 0.05 },
+    { "loadMs", "total", 1.0 },
+    { "memory", "cpuPeakBytes", 0.0 },
+    { "memory", "gpuBytes", 0.0 },
+    { "render", "drawCalls", 0.0 },
+    { "render", "triangles", 0.0 },
+    { "render", "stateChanges", 0.0 },
+    { "render", "textureBinds", 0.0 },
+    { "gpuMs", "Frame", 0.05 },
+};
+
+static char* BenchReadFile(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) return NULL;
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    char* text = (char*)malloc((size_t)size + 1);
+    size_t read = fread(text, 1, (size_t)size, file);
+    text[read] = '\0';
+    fclose(file);
+    return text;
+}
+
+// Names end up in the report unescaped, so only plain characters are kept
+static void BenchCopyName(char* dest, const char* src) {
+    int n = 0;
+    for (const char* c = src; *c && n < BENCH_NAME - 1; c++) {
+        bool plain = (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') || (*c >= '0' && *c <= '9') || *c == '_' || *c == '-' || *c == '.';
+        dest[n++] = plain ? *c : '_';
+    }
+    dest[n] = '\0';
+}
+
+// Settings are read up front, the engine has to start at the right size before anything loads
+static bool BenchParse(BenchScene* scene, char* text) {
+    const char* base = strrchr(scene->path, '/');
+    BenchCopyName(scene->name, base ? base + 1 : scene->path);
+    char* dot = strrchr(scene->name, '.');
+    if (dot && dot != scene->name) *dot = '\0';
+
+    int number = 0;
+    for (char* next = text; next;) {
+        char* line = next;
+        next = strchr(line, '\n');
+        if (next) *next++ = '\0';
+        number++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+        char command[32], flag[8];
+        if (sscanf(line, "%31s", command) != 1) continue;
+
+        if (strcmp(command, "frames") == 0) sscanf(line, "%*s %d", &scene->frames);
+        else if (strcmp(command, "warmup") == 0) sscanf(line, "%*s %d", &scene->warmup);
+        else if (strcmp(command, "size") == 0) sscanf(line, "%*s %d %d", &scene->width, &scene->height);
+        else if (strcmp(command, "shadows") == 0 && sscanf(line, "%*s %7s", flag) == 1) scene->shadows = strcmp(flag, "off") != 0;
+        else if (strcmp(command, "renderthread") == 0 && sscanf(line, "%*s %7s", flag) == 1) scene->renderThread = strcmp(flag, "off") != 0;
+        else if (strcmp(command, "orbit") == 0) {
+            if (sscanf(line, "%*s %f %f %f %f %f %f", &scene->orbitCenter[0], &scene->orbitCenter[1], &scene->orbitCenter[2],
+                       &scene->orbitRadius, &scene->orbitHeight, &scene->orbitTurns) != 6) {
+                fprintf(stderr, "%s:%d: orbit needs center xyz, radius, height and turns\n", scene->path, number);
+                return false;
+            }
+        } else if (scene->lineCount < BENCH_MAX_LINES) {
+            scene->lineNumbers[scene->lineCount] = number;
+            scene->lines[scene->lineCount++] = line;
+        } else {
+            fprintf(stderr, "%s: more than %d commands\n", scene->path, BENCH_MAX_LINES);
+            return false;
+        }
+    }
+
+    if (scene->frames <= 0 || scene->width <= 0 || scene->height <= 0 || scene->warmup < 0) {
+        fprintf(stderr, "%s: frames and size must be positive\n", scene->path);
+        return false;
+    }
+    if (scene->frames > FRAME_TIME_HISTORY) {
+        fprintf(stderr, "%s: %d frames measured, the engine keeps %d for percentiles\n", scene->path, scene->frames, FRAME_TIME_HISTORY);
+        scene->frames = FRAME_TIME_HISTORY;
+    }
+    return true;
+}
+
+static bool BenchFileExists(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (file) fclose(file);
+    return file != NULL;
+}
+
+static bool BenchLoadCommand(BenchScene* scene, int index, BenchLoad* loads, int* loadCount) {
+    const char* line = scene->lines[index];
+    int number = scene->lineNumbers[index];
+    char command[32], name[BENCH_NAME], arg[BENCH_NAME], path[256];
+    float x, y, z;
+    int columns, rows;
+    sscanf(line, "%31s", command);
+
+    uint64_t start = BE_ThreadClockNs();
+    if (strcmp(command, "mesh") == 0 || strcmp(command, "texture") == 0) {
+        if (sscanf(line, "%*s %63s %255s", name, path) != 2) goto usage;
+        if (!BenchFileExists(path)) { fprintf(stderr, "%s:%d: can't open '%s'\n", scene->path, number, path); return false; }
+        if (command[0] == 'm') BE_LoadMesh(name, path);
+        else BE_LoadTexture(name, path);
+    } else if (strcmp(command, "model") == 0) {
+        if (sscanf(line, "%*s %63s %63s %f %f %f", name, arg, &x, &y, &z) != 5) goto usage;
+        BE_AddModel(name, arg);
+        BE_SetModelPosition(name, BE_vec3(x, y, z));
+    } else if (strcmp(command, "grid") == 0) {
+        if (sscanf(line, "%*s %40s %d %d %f", arg, &columns, &rows, &x) != 4) goto usage;
+        for (int r = 0; r < rows; r++) {
+            for (int c = 0; c < columns; c++) {
+                char model[BENCH_NAME + 32];
+                snprintf(model, sizeof(model), "%s_%d_%d", arg, c, r);
+                BE_AddModel(model, arg);
+                BE_SetModelPosition(model, BE_vec3((c - (columns - 1) * 0.5f) * x, 0.0f, (r - (rows - 1) * 0.5f) * x));
+            }
+        }
+        snprintf(name, sizeof(name), "grid %.40s", arg);
+    } else if (strcmp(command, "light") == 0) {
+        if (sscanf(line, "%*s %63s %63s %f %f %f", name, arg, &x, &y, &z) != 5) goto usage;
+        BE_LightType type = strcmp(arg, "direct") == 0 ? BE_LIGHT_DIRECT : strcmp(arg, "spot") == 0 ? BE_LIGHT_SPOT : BE_LIGHT_POINT;
+        BE_AddLight(name, type);
+        BE_Light* light = BE_GetLight(BE_GetLightHandle(name));
+        if (!light) return false;
+        if (type == BE_LIGHT_DIRECT) glm_vec3_copy(BE_vec3(x, y, z), light->direction);
+        else glm_vec3_copy(BE_vec3(x, y, z), light->position);
+    } else {
+        fprintf(stderr, "%s:%d: unknown command '%s'\n", scene->path, number, command);
+        return false;
+    }
+
+    if (*loadCount < BENCH_MAX_LOADS) {
+        BenchCopyName(loads[*loadCount].name, name);
+        loads[(*loadCount)++].ms = (double)(BE_ThreadClockNs() - start) * 1e-6;
+    }
+    return true;
+
+usage:
+    fprintf(stderr, "%s:%d: bad arguments for '%s'\n", scene->path, number, command);
+    return false;
+}
+
+static void BenchPlaceCamera(const BenchScene* scene, int frame, int total) {
+    BE_Camera* camera = g_engine->activeScene->activeCamera;
+    float angle = 2.0f * GLM_PIf * scene->orbitTurns * (float)frame / (float)total;
+    camera->position[0] = scene->orbitCenter[0] + cosf(angle) * scene->orbitRadius;
+    camera->position[1] = scene->orbitCenter[1] + scene->orbitHeight;
+    camera->position[2] = scene->orbitCenter[2] + sinf(angle) * scene->orbitRadius;
+
+    vec3 direction;
+    glm_vec3_sub((float*)scene->orbitCenter, camera->position, direction);
+    glm_vec3_normalize(direction);
+    glm_quat_from_vecs((vec3){0.0f, 0.0f, -1.0f}, direction, camera->orientation);
+}
+
+static size_t BenchGrowth(size_t now, size_t start) {
+    return now > start ? now - start : 0;
+}
+
+static bool BenchRun(BenchScene* scene, FILE* out, bool first) {
+    BenchLoad loads[BENCH_MAX_LOADS];
+    int loadCount = 0;
+
+    // Engines don't free every resource on shutdown, so memory is reported relative to this scene's start
+    BE_MemoryStats before;
+    BE_MemoryGetStats(&before);
+    BE_MemoryResetPeaks();
+
+    uint64_t start = BE_ThreadClockNs();
+    BE_Engine engine = BE_StartEngineHeadless(scene->name, scene->width, scene->height);
+    BE_BindEngine(&engine);
+    double startMs = (double)(BE_ThreadClockNs() - start) * 1e-6;
+
+    double assetsMs = 0.0;
+    for (int i = 0; i < scene->lineCount; i++) {
+        if (!BenchLoadCommand(scene, i, loads, &loadCount)) {
+            BE_ShutdownEngine(&engine);
+            return false;
+        }
+    }
+    for (int i = 0; i < loadCount; i++) assetsMs += loads[i].ms;
+    if (scene->renderThread) BE_StartRenderThread();
+
+    // Counters arrive one frame late, so the last measured frame's are left out
+    BE_RenderStats render = {0};
+    double allocations = 0.0;
+    int counted = 0;
+    int total = scene->warmup + scene->frames;
+    for (int frame = 0; frame < total; frame++) {
+        if (frame == scene->warmup) BE_ResetFrameTimes();
+        BE_BeginFrame();
+        if (frame > scene->warmup) {
+            BE_RenderStats* last = &g_engine->timer.render;
+            render.drawCalls += last->drawCalls;
+            render.triangles += last->triangles;
+            render.stateChanges += last->stateChanges;
+            render.uniformUploads += last->uniformUploads;
+            render.textureBinds += last->textureBinds;
+            render.shadowPasses += last->shadowPasses;
+            render.visibleObjects += last->visibleObjects;
+            render.culledObjects += last->culledObjects;
+            allocations += (double)g_engine->timer.frameAllocations;
+            counted++;
+        }
+
+        BenchPlaceCamera(scene, frame, total);
+        BE_MakeShadows(scene->shadows);
+        BE_BeginRender();
+        BE_DrawModels(NULL);
+        BE_DrawLights(NULL);
+        BE_EndFrame();
+    }
+
+    BE_FrameTimeSummary frames = BE_GetFrameTimes();
+    BE_GpuPassTime passes[GPU_TIMER_MAX_PASSES];
+    int passCount = BE_GetGpuTimes(passes, GPU_TIMER_MAX_PASSES);
+    BE_MemoryStats memory;
+    BE_MemoryGetStats(&memory);
+    double n = counted > 0 ? (double)counted : 1.0;
+
+    fprintf(out, "%s    {\n", first ? "" : ",\n");
+    fprintf(out, "      \"scene\": \"%s\",\n", scene->name);
+    fprintf(out, "      \"frames\": %d,\n", frames.count);
+    fprintf(out, "      \"size\": [%d, %d],\n", scene->width, scene->height);
+    fprintf(out, "      \"frameMs\": { \"min\": %.4f, \"avg\": %.4f, \"p50\": %.4f, \"p95\": %.4f, \"p99\": %.4f, \"max\": %.4f },\n",
+            frames.minMs, frames.avgMs, frames.p50Ms, frames.p95Ms, frames.p99Ms, frames.maxMs);
+    fprintf(out, "      \"loadMs\": { \"start\": %.3f, \"assets\": %.3f, \"total\": %.3f },\n", startMs, assetsMs, startMs + assetsMs);
+    fprintf(out, "      \"loads\": [");
+    for (int i = 0; i < loadCount; i++) fprintf(out, "%s{ \"asset\": \"%s\", \"ms\": %.3f }", i ? ", " : "", loads[i].name, loads[i].ms);
+    fprintf(out, "],\n");
+    fprintf(out, "      \"memory\": { \"cpuLiveBytes\": %zu, \"cpuPeakBytes\": %zu, \"gpuBytes\": %zu, \"allocationsPerFrame\": %.2f },\n",
+            BenchGrowth(memory.totalLive, before.totalLive), BenchGrowth(memory.totalPeak, before.totalLive),
+            BenchGrowth(memory.gpuTotal, before.gpuTotal), allocations / n);
+    fprintf(out, "      \"render\": { \"drawCalls\": %.2f, \"triangles\": %.2f, \"stateChanges\": %.2f, \"uniformUploads\": %.2f, "
+                 "\"textureBinds\": %.2f, \"shadowPasses\": %.2f, \"visibleObjects\": %.2f, \"culledObjects\": %.2f },\n",
+            render.drawCalls / n, (double)render.triangles / n, render.stateChanges / n, render.uniformUploads / n,
+            render.textureBinds / n, render.shadowPasses / n, render.visibleObjects / n, render.culledObjects / n);
+    fprintf(out, "      \"gpuMs\": {");
+    for (int i = 0; i < passCount; i++) fprintf(out, "%s \"%s\": %.4f", i ? "," : "", passes[i].name, passes[i].avgMs);
+    fprintf(out, " }\n    }");
+
+    printf("%-20s p50 %7.3f  p95 %7.3f  p99 %7.3f ms  load %8.1f ms  %6.0f draws/frame\n", scene->name,
+           frames.p50Ms, frames.p95Ms, frames.p99Ms, startMs + assetsMs, render.drawCalls / n);
+
+    BE_ShutdownEngine(&engine);
+    return true;
+}
+
+// Reads a number back out of a report this runner wrote, it is not a general JSON parser
+static bool BenchReportValue(const char* report, const char* scene, const char* section, const char* key, double* out) {
+    char pattern[128];
+    snprintf(pattern, sizeof(pattern), "\"scene\": \"%s\"", scene);
+    const char* begin = strstr(report, pattern);
+    if (!begin) return false;
+    const char* next = strstr(begin + 1, "\"scene\": ");
+
+    snprintf(pattern, sizeof(pattern), "\"%s\": {", section);
+    const char* object = strstr(begin, pattern);
+    if (!object || (next && object > next)) return false;
+    const char* close = strchr(object, '}');
+
+    snprintf(pattern, sizeof(pattern), "\"%s\": ", key);
+    const char* value = strstr(object, pattern);
+    if (!value || value > close) return false;
+    *out = strtod(value + strlen(pattern), NULL);
+    return true;
+}
+
+static int BenchCompare(const char* reportPath, const char* baselinePath, BenchScene* scenes, int sceneCount, double threshold) {
+    char* report = BenchReadFile(reportPath);
+    char* baseline = BenchReadFile(baselinePath);
+    if (!report || !baseline) {
+        fprintf(stderr, "can't read '%s'\n", report ? baselinePath : reportPath);
+        free(report);
+        free(baseline);
+        return 2;
+    }
+
+    int regressions = 0;
+    printf("\nAgainst %s, worse by more than %.1f%% is a regression:\n", baselinePath, threshold);
+    for (int s = 0; s < sceneCount; s++) {
+        for (size_t m = 0; m < sizeof(benchMetrics) / sizeof(benchMetrics[0]); m++) {
+            const BenchMetric* metric = &benchMetrics[m];
+            double before, after;
+            if (!BenchReportValue(report, scenes[s].name, metric->section, metric->key, &after)) continue;
+            if (!BenchReportValue(baseline, scenes[s].name, metric->section, metric->key, &before)) {
+                printf("  %-20s %s.%s not in baseline\n", scenes[s].name, metric->section, metric->key);
+                continue;
+            }
+
+            double change = before > 0.0 ? (after - before) / before * 100.0 : (after > 0.0 ? 100.0 : 0.0);
+            bool regressed = change > threshold && after - before > metric->slack;
+            regressions += regressed;
+            char label[64];
+            snprintf(label, sizeof(label), "%s.%s", metric->section, metric->key);
+            printf("  %-20s %-26s %14.3f -> %14.3f  %+7.1f%%%s\n", scenes[s].name, label, before, after, change,
+                   regressed ? "  REGRESSION" : "");
+        }
+    }
+    printf("%d regression%s\n", regressions, regressions == 1 ? "" : "s");
+
+    free(report);
+    free(baseline);
+    return regressions > 0 ? 1 : 0;
+}
+
+int main(int argc, char** argv) {
+
+    const char* outPath = "bench_report.json";
+    const char* baselinePath = NULL;
+    double threshold = BENCH_DEFAULT_THRESHOLD;
+    const char* paths[BENCH_MAX_LINES];
+    int pathCount = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) outPath = argv[++i];
+        else if (strcmp(argv[i], "--compare") == 0 && i + 1 < argc) baselinePath = argv[++i];
+        else if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) threshold = atof(argv[++i]);
+        else if (argv[i][0] == '-' || pathCount == BENCH_MAX_LINES) {
+            fprintf(stderr, "usage: %s [--out report.json] [--compare baseline.json] [--threshold percent] scene.bench...\n", argv[0]);
+            return 2;
+        } else paths[pathCount++] = argv[i];
+    }
+    if (pathCount == 0) {
+        fprintf(stderr, "no scenes given\n");
+        return 2;
+    }
+
+#ifndef _WIN32
+    // Mesa's software rasterizer reports 4.5 only for missing SPIR-V support and runs the
+    // engine's 4.6 shaders fine. Values set by the caller are kept.
+    setenv("MESA_GL_VERSION_OVERRIDE", "4.6", 0);
+    setenv("MESA_GLSL_VERSION_OVERRIDE", "460", 0);
+#endif
+
+    FILE* out = fopen(outPath, "w");
+    if (!out) {
+        fprintf(stderr, "can't write '%s'\n", outPath);
+        return 2;
+    }
+    fprintf(out, "{\n  \"scenes\": [\n");
+
+    BenchScene* scenes = (BenchScene*)calloc(pathCount, sizeof(BenchScene));
+    char** texts = (char**)calloc(pathCount, sizeof(char*));
+    int ran = 0;
+    bool failed = false;
+    for (int i = 0; i < pathCount; i++) {
+        BenchScene* scene = &scenes[ran];
+        *scene = (BenchScene){0}; // a scene that failed may have left its lines here
+        scene->path = paths[i];
+        scene->frames = 600;
+        scene->warmup = 60;
+        scene->width = 1280;
+        scene->height = 720;
+        scene->shadows = true;
+        scene->orbitRadius = 6.0f;
+        scene->orbitHeight = 2.0f;
+        scene->orbitTurns = 1.0f;
+
+        texts[i] = BenchReadFile(paths[i]);
+        if (!texts[i]) { fprintf(stderr, "can't read '%s'\n", paths[i]); failed = true; continue; }
+        if (!BenchParse(scene, texts[i]) || !BenchRun(scene, out, ran == 0)) { failed = true; continue; }
+        ran++;
+    }
+
+    fprintf(out, "\n  ]\n}\n");
+    fclose(out);
+    printf("Wrote %s\n", outPath);
+
+    int result = failed ? 2 : 0;
+    if (baselinePath && ran > 0) {
+        int compared = BenchCompare(outPath, baselinePath, scenes, ran, threshold);
+        if (compared > result) result = compared;
+    }
+
+    for (int i = 0; i < pathCount; i++) free(texts[i]);
+    free(texts);
+    free(scenes);
+    return result;
+}
@@ -0,0 +1,86 @@
+// Transform composition microbenchmark, builds without GL: make bench_transforms
+// Compare kernels with -DBE_TRANSFORM_SIMD=BE_TRANSFORM_SIMD_SCALAR / _SSE / _AVX (AVX needs -mavx).
+
+#include "engine/engine_transform.h"
+
+#include <stdio.h>
+#include <time.h>
+
+#define BENCH_COUNT 16384
+#define BENCH_ROUNDS 2000
+
+static double BenchNow() {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void BenchTRS(versor q, vec3 p, vec3 s, mat4 dest) {
+    mat4 rot, scale, trans;
+    glm_quat_mat4(q, rot);
+    glm_scale_make(scale, s);
+    glm_translate_make(trans, p);
+    glm_mat4_mul(rot, scale, dest);
+    glm_mat4_mul(trans, dest, dest);
+}
+
+int main() {
+
+    const char* kernels[] = {"scalar", "sse", "avx"};
+
+    BE_TransformStore store;
+    BE_TransformStoreInit(&store);
+
+    srand(1);
+    for (size_t i = 0; i < BENCH_COUNT; i++) {
+        vec3 position = {rand() / (float)RAND_MAX * 100.0f, rand() / (float)RAND_MAX * 100.0f, rand() / (float)RAND_MAX * 100.0f};
+        vec3 axis = {rand() / (float)RAND_MAX - 0.5f, rand() / (float)RAND_MAX, rand() / (float)RAND_MAX - 0.5f};
+        vec3 scale = {0.5f + rand() / (float)RAND_MAX, 0.5f + rand() / (float)RAND_MAX, 0.5f + rand() / (float)RAND_MAX};
+        versor q;
+        glm_vec3_normalize(axis);
+        glm_quatv(q, rand() / (float)RAND_MAX * 6.28f, axis);
+        BE_TransformStorePush(&store, position, q, scale);
+    }
+
+    // Check the selected kernel against cglm before timing it
+    BE_TransformStoreCompose(&store, 0, store.size);
+    float maxError = 0.0f;
+    for (size_t i = 0; i < store.size; i++) {
+        mat4 expected;
+        BenchTRS((versor){store.qx[i], store.qy[i], store.qz[i], store.qw[i]}, (vec3){store.px[i], store.py[i], store.pz[i]}, (vec3){store.sx[i], store.sy[i], store.sz[i]}, expected);
+        for (int e = 0; e < 16; e++) {
+            float error = fabsf(((float*)expected)[e] - ((float*)store.world[i])[e]);
+            if (error > maxError) maxError = error;
+        }
+    }
+
+    double start = BenchNow();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        BE_TransformStoreCompose(&store, 0, store.size);
+    }
+    double simd = BenchNow() - start;
+
+    start = BenchNow();
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        BE_TransformStoreComposeScalar(&store, 0, store.size);
+    }
+    double scalar = BenchNow() - start;
+
+    // AoS reference, what BE_TransformUpdateMatrix costs per model
+    start = BenchNow();
+    for (int r = 0; r < BENCH_ROUNDS / 10; r++) {
+        for (size_t i = 0; i < store.size; i++) {
+            BenchTRS((versor){store.qx[i], store.qy[i], store.qz[i], store.qw[i]}, (vec3){store.px[i], store.py[i], store.pz[i]}, (vec3){store.sx[i], store.sy[i], store.sz[i]}, store.world[i]);
+        }
+    }
+    double aos = (BenchNow() - start) * 10.0;
+
+    double total = (double)BENCH_COUNT * BENCH_ROUNDS;
+    printf("transforms: %d x %d rounds, single thread\n", BENCH_COUNT, BENCH_ROUNDS);
+    printf("  kernel %-6s %8.2f Mtransforms/s  %6.2f ns each  (max error %g)\n", kernels[BE_TRANSFORM_SIMD], total / simd * 1e-6, simd / total * 1e9, maxError);
+    printf("  scalar SoA   %8.2f Mtransforms/s  %6.2f ns each\n", total / scalar * 1e-6, scalar / total * 1e9);
+    printf("  cglm AoS     %8.2f Mtransforms/s  %6.2f ns each\n", total / aos * 1e-6, aos / total * 1e9);
+
+    BE_TransformStoreFree(&store);
+    return maxError < 1e-4f ? 0 : 1;
+}
@@ -17,6 +17,8 @@ int main() {
 
     BE_AddLight("sun", BE_LIGHT_DIRECT);
     BE_AddLight("rainbow light", BE_LIGHT_POINT);
+    BE_Handle sun = BE_GetLightHandle("sun");
+    BE_Handle rainbow = BE_GetLightHandle("rainbow light");
 
     BE_LoadSound("music1", "res/sounds/breakout.wav");
     BE_AddEmitter("speaker1", true);
@@ -35,11 +37,11 @@ int main() {
 
         if (g_engine->timer.frameCountFPS == 1) printf("%f FPS %f MS\n", g_engine->timer.fps, g_engine->timer.ms);
 
-        BE_Light* rainlight = BE_FindLight("rainbow light");
+        BE_Light* rainlight = BE_GetLight(rainbow);
         glm_vec4_copy(BE_vec4(sinf(glfwGetTime()*0.5f) * 0.5f + 0.5f, sinf(glfwGetTime()*0.5f + 2.0943951f) * 0.5f + 0.5f, sinf(glfwGetTime()*0.5f + 4.1887902f) * 0.5f + 0.5f, 1.0f), rainlight->color);
         glm_vec3_copy(BE_vec3(sin(glfwGetTime()), 0.5, cos(glfwGetTime())), rainlight->position);
         
-        BE_Light* sunlight = BE_FindLight("sun");
+        BE_Light* sunlight = BE_GetLight(sun);
         glm_vec3_copy(BE_vec3(cosf(glfwGetTime()/25), -0.4f, sinf(glfwGetTime()/25)), sunlight->direction);
 
         // vec3 vec;